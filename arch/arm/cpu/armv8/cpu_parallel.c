@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Running functions on the secondary CPUs, which are started through PSCI
+ */
+
+#include <common.h>
+#include <cpu_func.h>
+#include <dm.h>
+#include <log.h>
+#include <malloc.h>
+#include <time.h>
+#include <watchdog.h>
+#include <asm/cache.h>
+#include <asm/global_data.h>
+#include <asm/system.h>
+#include <linux/compiler.h>
+#include <linux/psci.h>
+#include <linux/sizes.h>
+#include "cpu_parallel.h"
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define CPU_PARALLEL_MAX		8
+#define CPU_PARALLEL_STACK_SIZE		SZ_16K
+#define CPU_PARALLEL_OFF_TIMEOUT_MS	100
+
+/* MPIDR affinity fields, as used in the device tree and by PSCI */
+#define MPIDR_HWID_MASK			0xff00ffffffUL
+
+void __noreturn cpu_parallel_main(struct cpu_parallel *cp);
+
+static bool cpu_parallel_have_psci(void)
+{
+	struct udevice *dev;
+
+	if (current_el() == 3)
+		return false;
+
+	/* probing the device selects the PSCI calling method */
+	return !uclass_get_device_by_driver(UCLASS_FIRMWARE,
+					    DM_DRIVER_GET(psci), &dev);
+}
+
+/* Find the CPUs other than this one, returning the number found */
+static int cpu_parallel_find(u64 mpidr[], int max)
+{
+	u64 self = read_mpidr() & MPIDR_HWID_MASK;
+	const fdt32_t *reg;
+	const char *type;
+	ofnode node;
+	int count = 0;
+	int len;
+	u64 val;
+
+	ofnode_for_each_subnode(node, ofnode_path("/cpus")) {
+		type = ofnode_read_string(node, "device_type");
+		if (!type || strcmp(type, "cpu") || !ofnode_is_enabled(node))
+			continue;
+		reg = ofnode_get_property(node, "reg", &len);
+		if (!reg || (len != 4 && len != 8))
+			continue;
+		val = fdt32_to_cpu(reg[0]);
+		if (len == 8)
+			val = val << 32 | fdt32_to_cpu(reg[1]);
+		if (val == self || count == max)
+			continue;
+		mpidr[count++] = val;
+	}
+
+	return count;
+}
+
+static void cpu_parallel_read_mmu(struct cpu_parallel *cp)
+{
+	if (current_el() == 2) {
+		asm volatile("mrs %0, ttbr0_el2" : "=r" (cp->ttbr));
+		asm volatile("mrs %0, tcr_el2" : "=r" (cp->tcr));
+		asm volatile("mrs %0, mair_el2" : "=r" (cp->mair));
+		asm volatile("mrs %0, vbar_el2" : "=r" (cp->vbar));
+	} else {
+		asm volatile("mrs %0, ttbr0_el1" : "=r" (cp->ttbr));
+		asm volatile("mrs %0, tcr_el1" : "=r" (cp->tcr));
+		asm volatile("mrs %0, mair_el1" : "=r" (cp->mair));
+		asm volatile("mrs %0, vbar_el1" : "=r" (cp->vbar));
+	}
+	cp->sctlr = get_sctlr();
+}
+
+/* Called by cpu_parallel_entry() on the secondary CPU */
+void cpu_parallel_main(struct cpu_parallel *cp)
+{
+	cp->func(cp->arg);
+	dsb();
+	WRITE_ONCE(cp->done, true);
+	dsb();
+
+	invoke_psci_fn(PSCI_0_2_FN_CPU_OFF, 0, 0, 0);
+	for (;;)
+		wfi();
+}
+
+int cpu_parallel_count(void)
+{
+	u64 mpidr[CPU_PARALLEL_MAX - 1];
+
+	if (!cpu_parallel_have_psci())
+		return 1;
+
+	return 1 + cpu_parallel_find(mpidr, ARRAY_SIZE(mpidr));
+}
+
+int cpu_run_parallel(void (*func)(void *arg), void *const args[], int count)
+{
+	u64 mpidr[CPU_PARALLEL_MAX - 1];
+	bool started[CPU_PARALLEL_MAX] = {};
+	struct cpu_parallel *cps, *cp;
+	bool still_on = false;
+	int avail = 0;
+	ulong start;
+	void *stacks;
+	int i, ret;
+
+	if (count < 1)
+		return -EINVAL;
+	if (count > 1 && cpu_parallel_have_psci())
+		avail = min(cpu_parallel_find(mpidr, ARRAY_SIZE(mpidr)),
+			    count - 1);
+
+	cps = memalign(ARCH_DMA_MINALIGN,
+		       ALIGN(sizeof(*cps) * count, ARCH_DMA_MINALIGN));
+	stacks = memalign(16, CPU_PARALLEL_STACK_SIZE * count);
+	if (!cps || !stacks) {
+		free(cps);
+		free(stacks);
+		return -ENOMEM;
+	}
+
+	cpu_parallel_read_mmu(&cps[0]);
+	for (i = 1; i <= avail; i++) {
+		cp = &cps[i];
+		*cp = cps[0];
+		cp->sp = (ulong)stacks + CPU_PARALLEL_STACK_SIZE * (i + 1);
+		cp->gd = (ulong)gd;
+		cp->func = func;
+		cp->arg = args[i];
+		cp->mpidr = mpidr[i - 1];
+		cp->done = false;
+	}
+
+	/* the secondary CPUs read this with their caches off */
+	flush_dcache_range((ulong)cps, (ulong)cps +
+			   ALIGN(sizeof(*cps) * count, ARCH_DMA_MINALIGN));
+
+	for (i = 1; i <= avail; i++) {
+		ret = invoke_psci_fn(PSCI_0_2_FN64_CPU_ON, cps[i].mpidr,
+				     (ulong)cpu_parallel_entry, (ulong)&cps[i]);
+		if (ret)
+			log_debug("CPU %llx did not start (err=%d)\n",
+				  cps[i].mpidr, ret);
+		else
+			started[i] = true;
+	}
+
+	func(args[0]);
+	for (i = 1; i < count; i++) {
+		if (i > avail || !started[i])
+			func(args[i]);
+	}
+
+	for (i = 1; i <= avail; i++) {
+		if (!started[i])
+			continue;
+		while (!READ_ONCE(cps[i].done))
+			WATCHDOG_RESET();
+
+		/* it is still using its stack until it is off */
+		start = get_timer(0);
+		while (invoke_psci_fn(PSCI_0_2_FN64_AFFINITY_INFO,
+				      cps[i].mpidr, 0, 0) !=
+		       PSCI_0_2_AFFINITY_LEVEL_OFF) {
+			if (get_timer(start) > CPU_PARALLEL_OFF_TIMEOUT_MS) {
+				log_warning("CPU %llx did not switch off\n",
+					    cps[i].mpidr);
+				still_on = true;
+				break;
+			}
+		}
+	}
+	dsb();
+
+	if (!still_on) {
+		free(stacks);
+		free(cps);
+	}
+
+	return 0;
+}
@@ -0,0 +1,58 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Shared between cpu_parallel.c and cpu_parallel_entry.S
+ */
+
+#ifndef __ARMV8_CPU_PARALLEL_H
+#define __ARMV8_CPU_PARALLEL_H
+
+/* Offsets of the fields in struct cpu_parallel used by the entry code */
+#define CPU_PARALLEL_SP		0
+#define CPU_PARALLEL_GD		8
+#define CPU_PARALLEL_TTBR	16
+#define CPU_PARALLEL_TCR	24
+#define CPU_PARALLEL_MAIR	32
+#define CPU_PARALLEL_SCTLR	40
+#define CPU_PARALLEL_VBAR	48
+
+#ifndef __ASSEMBLY__
+
+#include <linux/types.h>
+
+/**
+ * struct cpu_parallel - work for one secondary CPU
+ *
+ * The secondary CPU starts with its MMU off, so this must be flushed to memory
+ * before the CPU is switched on.
+ *
+ * @sp: Initial stack pointer
+ * @gd: Global data pointer
+ * @ttbr: Translation table base, as used by the boot CPU
+ * @tcr: Translation control register, as used by the boot CPU
+ * @mair: Memory attributes, as used by the boot CPU
+ * @sctlr: System control register, as used by the boot CPU
+ * @vbar: Exception vector base, as used by the boot CPU
+ * @func: Function to call
+ * @arg: Argument to pass to @func
+ * @mpidr: Affinity of the CPU
+ * @done: Set to true once @func has returned
+ */
+struct cpu_parallel {
+	u64 sp;
+	u64 gd;
+	u64 ttbr;
+	u64 tcr;
+	u64 mair;
+	u64 sctlr;
+	u64 vbar;
+	void (*func)(void *arg);
+	void *arg;
+	u64 mpidr;
+	bool done;
+};
+
+void cpu_parallel_entry(struct cpu_parallel *cp);
+
+#endif /* __ASSEMBLY__ */
+
+#endif /* __ARMV8_CPU_PARALLEL_H */
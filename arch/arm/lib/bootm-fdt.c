@@ -58,21 +58,27 @@ int arch_fixup_fdt(void *blob)
 #endif
 
 #ifdef CONFIG_ARMV8_SPIN_TABLE
-	ret = spin_table_update_dt(blob);
+	ret = fdt_txn_sync(blob);
+	if (!ret)
+		ret = spin_table_update_dt(blob);
 	if (ret)
 		return ret;
 #endif
 
 #if defined(CONFIG_ARMV7_NONSEC) || defined(CONFIG_ARMV8_PSCI) || \
 	CONFIG_IS_ENABLED(SEC_FIRMWARE_ARMV8_PSCI)
-	ret = psci_update_dt(blob);
+	ret = fdt_txn_sync(blob);
+	if (!ret)
+		ret = psci_update_dt(blob);
 	if (ret)
 		return ret;
 #endif
 #endif
 
 #ifdef CONFIG_FMAN_ENET
-	ret = fdt_update_ethernet_dt(blob);
+	ret = fdt_txn_sync(blob);
+	if (!ret)
+		ret = fdt_update_ethernet_dt(blob);
 	if (ret)
 		return ret;
 #endif
@@ -33,6 +33,7 @@ __weak void reset_misc(void)
 int do_reset(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 {
 	puts ("resetting ...\n");
+	flush();
 
 	mdelay(50);				/* wait 50 ms */
 
@@ -40,6 +40,16 @@ void sandbox_exit(void)
 	os_exit(0);
 }
 
+int cpu_parallel_count(void)
+{
+	return os_get_cpu_count();
+}
+
+int cpu_run_parallel(void (*func)(void *arg), void *const args[], int count)
+{
+	return os_run_threads(func, args, count);
+}
+
 /* delay x useconds */
 void __udelay(unsigned long usec)
 {
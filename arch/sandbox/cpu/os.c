@@ -198,6 +198,21 @@ err:
 	return ret;
 }
 
+int os_persistent_file(char *buf, int maxsize, const char *fname)
+{
+	const char *dirname = getenv("U_BOOT_PERSISTENT_DATA_DIR");
+	int len;
+
+	if (dirname && *fname != '/')
+		len = snprintf(buf, maxsize, "%s/%s", dirname, fname);
+	else
+		len = snprintf(buf, maxsize, "%s", fname);
+	if (len >= maxsize)
+		return -ENOSPC;
+
+	return 0;
+}
+
 int os_map_file(const char *pathname, int os_flags, void **bufp, int *sizep)
 {
 	void *ptr;
@@ -942,6 +957,57 @@ void os_set_time_offset(long offset)
 		       ENV_TIME_OFFSET);
 }
 
+int os_get_cpu_count(void)
+{
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return count > 0 ? count : 1;
+}
+
+struct os_thread {
+	pthread_t tid;
+	void (*func)(void *arg);
+	void *arg;
+};
+
+static void *os_thread_start(void *ptr)
+{
+	struct os_thread *thread = ptr;
+
+	thread->func(thread->arg);
+
+	return NULL;
+}
+
+int os_run_threads(void (*func)(void *arg), void *const args[], int count)
+{
+	struct os_thread *threads;
+	int i, started;
+
+	threads = os_malloc(sizeof(*threads) * count);
+	if (!threads)
+		return -ENOMEM;
+
+	/* The first call runs in this thread */
+	for (started = 1; started < count; started++) {
+		threads[started].func = func;
+		threads[started].arg = args[started];
+		if (pthread_create(&threads[started].tid, NULL, os_thread_start,
+				   &threads[started]))
+			break;
+	}
+
+	/* Make the first call and any which did not get a thread here */
+	func(args[0]);
+	for (i = started; i < count; i++)
+		func(args[i]);
+	for (i = 1; i < started; i++)
+		pthread_join(threads[i].tid, NULL);
+	os_free(threads);
+
+	return 0;
+}
+
 void os_localtime(struct rtc_time *rt)
 {
 	time_t t = time(NULL);
@@ -38,6 +38,15 @@ size_t sandbox_serial_written(void);
  */
 void sandbox_serial_endisable(bool enabled);
 
+/**
+ * sandbox_serial_set_busy() - Make the serial port refuse output
+ * @busy: true to refuse output as a UART with a full FIFO does, false to
+ * accept it again
+ *
+ * This allows tests to check what happens while the UART is busy.
+ */
+void sandbox_serial_set_busy(bool busy);
+
 /**
  * struct sandbox_serial_priv - Private data for this driver
  *
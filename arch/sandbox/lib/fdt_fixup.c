@@ -11,6 +11,9 @@ int arch_fixup_fdt(void *blob)
 {
 	int ret;
 
+	ret = fdt_txn_sync(blob);
+	if (ret < 0)
+		goto err;
 	ret = fdt_find_or_add_subnode(blob, 0, "chosen");;
 	if (ret < 0)
 		goto err;
@@ -11,6 +11,7 @@
 #include <efi.h>
 #include <efi_loader.h>
 #include <env_internal.h>
+#include <fdt_support.h>
 #include <init.h>
 #include <led.h>
 #include <os.h>
@@ -114,6 +115,9 @@ int board_init(void)
 int ft_board_setup(void *fdt, struct bd_info *bd)
 {
 	/* Create an arbitrary reservation to allow testing OF_BOARD_SETUP.*/
+	if (fdt_txn_root(fdt))
+		return fdt_txn_add_mem_rsv(fdt, 0x00d02000, 0x4000);
+
 	return fdt_add_mem_rsv(fdt, 0x00d02000, 0x4000);
 }
 
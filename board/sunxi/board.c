@@ -919,7 +919,9 @@ int ft_board_setup(void *blob, struct bd_info *bd)
 	bluetooth_dt_fixup(blob);
 
 #ifdef CONFIG_VIDEO_DT_SIMPLEFB
-	r = sunxi_simplefb_setup(blob);
+	r = fdt_txn_sync(blob);
+	if (!r)
+		r = sunxi_simplefb_setup(blob);
 	if (r)
 		return r;
 #endif
@@ -448,6 +448,20 @@ int bootdev_get_bootflow(struct udevice *dev, struct bootflow_iter *iter,
 	return ops->get_bootflow(dev, iter, bflow);
 }
 
+int bootdev_start(struct udevice *dev)
+{
+	const struct bootdev_ops *ops = bootdev_get_ops(dev);
+	int ret;
+
+	if (!ops->start)
+		return 0;
+	ret = device_probe(dev);
+	if (ret)
+		return log_msg_ret("probe", ret);
+
+	return ops->start(dev);
+}
+
 void bootdev_clear_bootflows(struct udevice *dev)
 {
 	struct bootdev_uc_plat *ucp = dev_get_uclass_plat(dev);
@@ -617,6 +631,16 @@ int bootdev_setup_iter_order(struct bootflow_iter *iter, struct udevice **devp)
 	iter->dev_order = order;
 	iter->cur_dev = 0;
 
+	/* Get slow media ready in the background while others are scanned */
+	if (IS_ENABLED(CONFIG_BOOTDEV_START_ALL)) {
+		for (i = 0; i < iter->num_devs; i++) {
+			ret = bootdev_start(order[i]);
+			if (ret)
+				log_debug("Cannot start bootdev '%s' (err=%d)\n",
+					  order[i]->name, ret);
+		}
+	}
+
 	dev = *order;
 	ret = device_probe(dev);
 	if (ret)
@@ -397,6 +397,41 @@ static int handle_decomp_error(int comp_type, size_t uncomp_size,
 #endif
 
 #ifndef USE_HOSTCC
+/**
+ * bootm_inplace_len() - Check if the OS image can be decompressed in place
+ *
+ * This is possible when the compressed data lies towards the end of the
+ * window which it is decompressed into, with enough of a margin after it
+ * for the compression type. Any part of the image in front of the data is
+ * overwritten, so that must only be a legacy header, which has been copied.
+ *
+ * @images: Images information
+ * Return: maximum number of bytes to decompress, or 0 if the image cannot be
+ *	decompressed in place
+ */
+static ulong bootm_inplace_len(bootm_headers_t *images)
+{
+	image_info_t *os = &images->os;
+	ulong image_end = os->image_start + os->image_len;
+	ulong avail, margin, len;
+
+	if (os->image_start <= os->load ||
+	    os->image_start >= os->load + CONFIG_SYS_BOOTM_LEN)
+		return 0;
+	avail = image_end - os->load;
+	margin = image_decomp_margin(os->comp, os->image_len, avail);
+	if (!margin || margin >= avail)
+		return 0;
+	len = min_t(ulong, avail - margin, CONFIG_SYS_BOOTM_LEN);
+
+	if (os->start < os->image_start && os->start < os->load + len &&
+	    !(images->legacy_hdr_valid &&
+	      image_get_type(&images->legacy_hdr_os_copy) != IH_TYPE_MULTI))
+		return 0;
+
+	return len;
+}
+
 static int bootm_load_os(bootm_headers_t *images, int boot_progress)
 {
 	image_info_t os = images->os;
@@ -407,18 +442,26 @@ static int bootm_load_os(bootm_headers_t *images, int boot_progress)
 	ulong image_start = os.image_start;
 	ulong image_len = os.image_len;
 	ulong flush_start = ALIGN_DOWN(load, ARCH_DMA_MINALIGN);
+	ulong unc_len = CONFIG_SYS_BOOTM_LEN;
+	ulong inplace_len;
 	bool no_overlap;
 	void *load_buf, *image_buf;
 	int err;
 
+	inplace_len = bootm_inplace_len(images);
+	if (inplace_len) {
+		debug("   decompressing in place, up to 0x%lx bytes\n",
+		      inplace_len);
+		unc_len = inplace_len;
+	}
+
 	load_buf = map_sysmem(load, 0);
 	image_buf = map_sysmem(os.image_start, image_len);
 	err = image_decomp(os.comp, load, os.image_start, os.type,
-			   load_buf, image_buf, image_len,
-			   CONFIG_SYS_BOOTM_LEN, &load_end);
+			   load_buf, image_buf, image_len, unc_len, &load_end);
 	if (err) {
-		err = handle_decomp_error(os.comp, load_end - load,
-					  CONFIG_SYS_BOOTM_LEN, err);
+		err = handle_decomp_error(os.comp, load_end - load, unc_len,
+					  err);
 		bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
 		return err;
 	}
@@ -432,7 +475,15 @@ static int bootm_load_os(bootm_headers_t *images, int boot_progress)
 
 	no_overlap = (os.comp == IH_COMP_NONE && load == image_start);
 
-	if (!no_overlap && load < blob_end && load_end > blob_start) {
+	/*
+	 * Decompressing in place overwrites the compressed data, which is
+	 * fine, so only check what lies in front of it
+	 */
+	if (inplace_len)
+		blob_end = image_start;
+
+	if (!no_overlap && blob_start < blob_end && load < blob_end &&
+	    load_end > blob_start) {
 		debug("images.os.start = 0x%lX, images.os.end = 0x%lx\n",
 		      blob_start, blob_end);
 		debug("images.os.load = 0x%lx, load_end = 0x%lx\n", load,
@@ -451,6 +502,11 @@ static int bootm_load_os(bootm_headers_t *images, int boot_progress)
 		}
 	}
 
+	/*
+	 * Only the decompressed image is reserved. When it was decompressed in
+	 * place, the rest of the window, with what is left of the compressed
+	 * data, is free for the ramdisk and device tree.
+	 */
 	lmb_reserve(&images->lmb, images->os.load, (load_end -
 						    images->os.load));
 	return 0;
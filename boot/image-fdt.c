@@ -9,6 +9,7 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
 #include <fdt_support.h>
 #include <fdtdec.h>
 #include <env.h>
@@ -24,9 +25,6 @@
 #include <dm/ofnode.h>
 #include <tee/optee.h>
 
-/* adding a ramdisk needs 0x44 bytes in version 2008.10 */
-#define FDT_RAMDISK_OVERHEAD	0x80
-
 DECLARE_GLOBAL_DATA_PTR;
 
 static void fdt_error(const char *msg)
@@ -609,6 +607,11 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 	ulong *initrd_end = &images->initrd_end;
 	int ret = -EPERM;
 	int fdt_ret;
+	int span;
+
+	/* Make the fixups in a live tree if enabled, see fdt_txn_begin() */
+	span = bootstage_span_start(BOOTSTAGE_SPAN_GENERAL, "fdt_fixup");
+	fdt_txn_begin(blob);
 
 	if (fdt_root(blob) < 0) {
 		printf("ERROR: root node setup failed\n");
@@ -649,7 +652,11 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 		if (skip_board_fixup && ((int)simple_strtol(skip_board_fixup, NULL, 10) == 1)) {
 			printf("skip board fdt fixup\n");
 		} else {
-			fdt_ret = ft_board_setup(blob, gd->bd);
+			fdt_ret = 0;
+			if (!IS_ENABLED(CONFIG_OF_BOARD_SETUP_TXN))
+				fdt_ret = fdt_txn_sync(blob);
+			if (!fdt_ret)
+				fdt_ret = ft_board_setup(blob, gd->bd);
 			if (fdt_ret) {
 				printf("ERROR: board-specific fdt fixup failed: %s\n",
 				       fdt_strerror(fdt_ret));
@@ -658,7 +665,9 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 		}
 	}
 	if (IS_ENABLED(CONFIG_OF_SYSTEM_SETUP)) {
-		fdt_ret = ft_system_setup(blob, gd->bd);
+		fdt_ret = fdt_txn_sync(blob);
+		if (!fdt_ret)
+			fdt_ret = ft_system_setup(blob, gd->bd);
 		if (fdt_ret) {
 			printf("ERROR: system-specific fdt fixup failed: %s\n",
 			       fdt_strerror(fdt_ret));
@@ -676,6 +685,16 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 		}
 	}
 
+	fdt_initrd(blob, *initrd_start, *initrd_end);
+
+	fdt_ret = fdt_txn_commit(blob);
+	if (fdt_ret) {
+		printf("ERROR: writing fdt fixups failed: %s\n",
+		       fdt_strerror(fdt_ret));
+		ret = -ENOSPC;
+		goto err;
+	}
+
 	/* Delete the old LMB reservation */
 	if (lmb)
 		lmb_free(lmb, (phys_addr_t)(u32)(uintptr_t)blob,
@@ -686,15 +705,10 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 		goto err;
 	of_size = ret;
 
-	if (*initrd_start && *initrd_end) {
-		of_size += FDT_RAMDISK_OVERHEAD;
-		fdt_set_totalsize(blob, of_size);
-	}
 	/* Create a new LMB reservation */
 	if (lmb)
 		lmb_reserve(lmb, (ulong)blob, of_size);
 
-	fdt_initrd(blob, *initrd_start, *initrd_end);
 	if (!ft_verify_fdt(blob))
 		goto err;
 
@@ -702,9 +716,12 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 	if (IS_ENABLED(CONFIG_OF_BOARD_SETUP))
 		ft_board_setup_ex(blob, gd->bd);
 #endif
+	bootstage_span_end(span);
 
 	return 0;
 err:
+	fdt_txn_abort(blob);
+	bootstage_span_end(span);
 	printf(" - must RESET the board to recover.\n\n");
 
 	return ret;
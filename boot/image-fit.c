@@ -2323,11 +2323,13 @@ int boot_get_fdt_fit(bootm_headers_t *images, ulong addr,
 	ulong load, len;
 #ifdef CONFIG_OF_LIBFDT_OVERLAY
 	ulong image_start, image_end;
-	ulong ovload, ovlen, ovcopylen;
+	ulong ovload, ovlen, ovcopylen, ovtotal = 0;
 	const char *uconfig;
 	const char *uname;
-	void *base, *ov, *ovcopy = NULL;
+	void *base = NULL, *ov, *ovcopy = NULL;
 	int i, err, noffset, ov_noffset;
+	int span = 0;
+	bool live;
 #endif
 
 	fit_uname = fit_unamep ? *fit_unamep : NULL;
@@ -2381,6 +2383,13 @@ int boot_get_fdt_fit(bootm_headers_t *images, ulong addr,
 
 	base = map_sysmem(load, len);
 
+	/* Merge the overlays in a live tree if enabled, see fdt_txn_begin() */
+	span = bootstage_span_start(BOOTSTAGE_SPAN_GENERAL, "fdt_overlay");
+	fdt_txn_begin(base);
+	live = fdt_txn_root(base);
+	if (!live)
+		fdt_txn_abort(base);
+
 	/* apply extra configs in FIT first, followed by args */
 	for (i = 1; ; i++) {
 		if (i < count) {
@@ -2440,17 +2449,37 @@ int boot_get_fdt_fit(bootm_headers_t *images, ulong addr,
 			goto out;
 		}
 
-		base = map_sysmem(load, len + ovlen);
-		err = fdt_open_into(base, base, len + ovlen);
+		if (live) {
+			/* The live tree is written out once, below */
+			ovtotal += ovlen;
+		} else {
+			base = map_sysmem(load, len + ovlen);
+			err = fdt_open_into(base, base, len + ovlen);
+			if (err < 0) {
+				printf("failed on fdt_open_into\n");
+				fdt_noffset = err;
+				goto out;
+			}
+		}
+
+		/* the verbose method prints out messages on error */
+		err = fdt_overlay_apply_verbose(base, ovcopy);
 		if (err < 0) {
-			printf("failed on fdt_open_into\n");
 			fdt_noffset = err;
 			goto out;
 		}
+		if (!live) {
+			fdt_pack(base);
+			len = fdt_totalsize(base);
+		}
+	}
 
-		/* the verbose method prints out messages on error */
-		err = fdt_overlay_apply_verbose(base, ovcopy);
+	if (live) {
+		fdt_set_totalsize(base, len + ovtotal);
+		err = fdt_txn_commit(base);
 		if (err < 0) {
+			printf("failed to write FDT with overlays: %s\n",
+			       fdt_strerror(err));
 			fdt_noffset = err;
 			goto out;
 		}
@@ -2473,6 +2502,8 @@ out:
 		*fit_uname_configp = fit_uname_config;
 
 #ifdef CONFIG_OF_LIBFDT_OVERLAY
+	fdt_txn_abort(base);
+	bootstage_span_end(span);
 	free(ovcopy);
 #endif
 	free(fit_uname_config_copy);
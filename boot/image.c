@@ -430,15 +430,12 @@ int image_decomp_type(const unsigned char *buf, ulong len)
 	return cmagic->comp_id;
 }
 
-int image_decomp(int comp, ulong load, ulong image_start, int type,
-		 void *load_buf, void *image_buf, ulong image_len,
-		 uint unc_len, ulong *load_end)
+int image_decomp_data(int comp, void *load_buf, void *image_buf,
+		      ulong *lenp, uint unc_len)
 {
+	ulong image_len = *lenp;
 	int ret = -ENOSYS;
 
-	*load_end = load;
-	print_decomp_msg(comp, type, load == image_start);
-
 	/*
 	 * Load the image to the right place, decompressing if needed. After
 	 * this, image_len will be set to the number of uncompressed bytes
@@ -447,7 +444,7 @@ int image_decomp(int comp, ulong load, ulong image_start, int type,
 	switch (comp) {
 	case IH_COMP_NONE:
 		ret = 0;
-		if (load == image_start)
+		if (load_buf == image_buf)
 			break;
 		if (image_len <= unc_len)
 			memmove_wd(load_buf, image_buf, image_len, CHUNKSZ);
@@ -511,6 +508,23 @@ int image_decomp(int comp, ulong load, ulong image_start, int type,
 		}
 		break;
 	}
+	if (!ret)
+		*lenp = image_len;
+
+	return ret;
+}
+
+int image_decomp(int comp, ulong load, ulong image_start, int type,
+		 void *load_buf, void *image_buf, ulong image_len,
+		 uint unc_len, ulong *load_end)
+{
+	int ret;
+
+	*load_end = load;
+	print_decomp_msg(comp, type, load == image_start);
+
+	ret = image_decomp_data(comp, load_buf, image_buf, &image_len,
+				unc_len);
 	if (ret == -ENOSYS) {
 		printf("Unimplemented compression type %d\n", comp);
 		return ret;
@@ -523,6 +537,30 @@ int image_decomp(int comp, ulong load, ulong image_start, int type,
 	return 0;
 }
 
+ulong image_decomp_margin(int comp, ulong image_len, ulong unc_len)
+{
+	switch (comp) {
+	case IH_COMP_LZ4:
+		/*
+		 * LZ4 needs (image_len >> 8) + 32 bytes for each block. Blocks
+		 * are at least 64KiB and each has a 4-byte header and perhaps
+		 * a 4-byte checksum, which an uncompressed block adds to the
+		 * data. Allow for the end mark and content checksum too.
+		 */
+		return (image_len >> 8) + 32 + 8 * (unc_len / 0x10000 + 1) + 8;
+	case IH_COMP_ZSTD:
+		/*
+		 * Each block, of up to ZSTD_BLOCKSIZE_ABSOLUTEMAX bytes, is
+		 * written in one go once its input has been read, and may add
+		 * a 3-byte header to the data
+		 */
+		return ZSTD_FRAMEHEADERSIZE_MAX + 4 + ZSTD_BLOCKSIZE_ABSOLUTEMAX +
+			3 * (unc_len / ZSTD_BLOCKSIZE_ABSOLUTEMAX + 1) + 32;
+	default:
+		return 0;
+	}
+}
+
 const table_entry_t *get_table_entry(const table_entry_t *table, int id)
 {
 	for (; table->id >= 0; ++table) {
@@ -5,6 +5,7 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
 #include <command.h>
 #include <dm.h>
 #include <env.h>
@@ -393,6 +394,8 @@ static void label_boot_fdtoverlay(struct pxe_context *ctx,
 	char *fdtoverlay_addr_env;
 	ulong fdtoverlay_addr;
 	ulong fdt_addr;
+	bool live;
+	int span;
 	int err;
 
 	/* Get the main fdt and map it */
@@ -411,6 +414,13 @@ static void label_boot_fdtoverlay(struct pxe_context *ctx,
 
 	fdtoverlay_addr = hextoul(fdtoverlay_addr_env, NULL);
 
+	/* Merge the overlays in a live tree if enabled, see fdt_txn_begin() */
+	span = bootstage_span_start(BOOTSTAGE_SPAN_GENERAL, "fdt_overlay");
+	fdt_txn_begin(working_fdt);
+	live = fdt_txn_root(working_fdt);
+	if (!live)
+		fdt_txn_abort(working_fdt);
+
 	/* Cycle over the overlay files and apply them in order */
 	do {
 		struct fdt_header *blob;
@@ -444,7 +454,8 @@ static void label_boot_fdtoverlay(struct pxe_context *ctx,
 		}
 
 		/* Resize main fdt */
-		fdt_shrink_to_minimum(working_fdt, 8192);
+		if (!live)
+			fdt_shrink_to_minimum(working_fdt, 8192);
 
 		blob = map_sysmem(fdtoverlay_addr, 0);
 		err = fdt_check_header(blob);
@@ -454,6 +465,12 @@ static void label_boot_fdtoverlay(struct pxe_context *ctx,
 			goto skip_overlay;
 		}
 
+		/* Leave room for the overlay when the live tree is written */
+		if (live)
+			fdt_set_totalsize(working_fdt,
+					  fdt_totalsize(working_fdt) +
+					  fdt_totalsize(blob));
+
 		err = fdt_overlay_apply_verbose(working_fdt, blob);
 		if (err) {
 			printf("Failed to apply overlay %s, skipping\n",
@@ -465,6 +482,17 @@ skip_overlay:
 		if (end)
 			free(overlayfile);
 	} while ((fdtoverlay = strstr(fdtoverlay, " ")));
+
+	if (live) {
+		fdt_set_totalsize(working_fdt,
+				  fdt_totalsize(working_fdt) + 8192);
+		err = fdt_txn_commit(working_fdt);
+		if (err)
+			printf("Failed to write fdt with overlays: %s\n",
+			       fdt_strerror(err));
+		fdt_shrink_to_minimum(working_fdt, 8192);
+	}
+	bootstage_span_end(span);
 }
 #endif
 
@@ -228,10 +228,42 @@ int do_avb_get_uuid(struct cmd_tbl *cmdtp, int flag,
 	return CMD_RET_FAILURE;
 }
 
+/*
+ * Set avb_<partition>_addr and avb_<partition>_size for each partition which
+ * was verified in the preload area, or clear them if @out_data is NULL
+ */
+static void avb_set_partition_env(const char * const *partitions,
+				  AvbSlotVerifyData *out_data)
+{
+	AvbPartitionData *part;
+	char name[40];
+	size_t i;
+
+	for (; *partitions; partitions++) {
+		snprintf(name, sizeof(name), "avb_%s_addr", *partitions);
+		env_set(name, NULL);
+		snprintf(name, sizeof(name), "avb_%s_size", *partitions);
+		env_set(name, NULL);
+	}
+
+	for (i = 0; out_data && i < out_data->num_loaded_partitions; i++) {
+		part = &out_data->loaded_partitions[i];
+		if (!part->preloaded)
+			continue;
+		snprintf(name, sizeof(name), "avb_%s_addr",
+			 part->partition_name);
+		env_set_hex(name, map_to_sysmem(part->data));
+		snprintf(name, sizeof(name), "avb_%s_size",
+			 part->partition_name);
+		env_set_hex(name, part->data_size);
+	}
+}
+
 int do_avb_verify_part(struct cmd_tbl *cmdtp, int flag,
 		       int argc, char *const argv[])
 {
-	const char * const requested_partitions[] = {"boot", NULL};
+	const char * const default_partitions[] = {"boot", NULL};
+	const char * const *requested_partitions = default_partitions;
 	AvbSlotVerifyResult slot_result;
 	AvbSlotVerifyData *out_data;
 	char *cmdline;
@@ -246,12 +278,16 @@ int do_avb_verify_part(struct cmd_tbl *cmdtp, int flag,
 		return CMD_RET_FAILURE;
 	}
 
-	if (argc < 1 || argc > 2)
+	if (argc < 1)
 		return CMD_RET_USAGE;
 
-	if (argc == 2)
+	if (argc >= 2)
 		slot_suffix = argv[1];
 
+	/* argv[] is NULL-terminated, so can be used as the list directly */
+	if (argc > 2)
+		requested_partitions = (const char * const *)argv + 2;
+
 	printf("## Android Verified Boot 2.0 version %s\n",
 	       avb_version_string());
 
@@ -261,6 +297,8 @@ int do_avb_verify_part(struct cmd_tbl *cmdtp, int flag,
 		return CMD_RET_FAILURE;
 	}
 
+	avb_set_partition_env(requested_partitions, NULL);
+	avb_preload_reset(avb_ops);
 	slot_result =
 		avb_slot_verify(avb_ops,
 				requested_partitions,
@@ -288,6 +326,7 @@ int do_avb_verify_part(struct cmd_tbl *cmdtp, int flag,
 			cmdline = out_data->cmdline;
 
 		env_set(AVB_BOOTARGS, cmdline);
+		avb_set_partition_env(requested_partitions, out_data);
 
 		res = CMD_RET_SUCCESS;
 		break;
@@ -427,7 +466,8 @@ static struct cmd_tbl cmd_avb[] = {
 	U_BOOT_CMD_MKENT(read_part, 5, 0, do_avb_read_part, "", ""),
 	U_BOOT_CMD_MKENT(read_part_hex, 4, 0, do_avb_read_part_hex, "", ""),
 	U_BOOT_CMD_MKENT(write_part, 5, 0, do_avb_write_part, "", ""),
-	U_BOOT_CMD_MKENT(verify, 2, 0, do_avb_verify_part, "", ""),
+	U_BOOT_CMD_MKENT(verify, CONFIG_SYS_MAXARGS, 0, do_avb_verify_part, "",
+			 ""),
 #ifdef CONFIG_OPTEE_TA_AVB
 	U_BOOT_CMD_MKENT(read_pvalue, 3, 0, do_avb_read_pvalue, "", ""),
 	U_BOOT_CMD_MKENT(write_pvalue, 3, 0, do_avb_write_pvalue, "", ""),
@@ -470,7 +510,8 @@ U_BOOT_CMD(
 	"avb read_pvalue <name> <bytes> - read a persistent value <name>\n"
 	"avb write_pvalue <name> <value> - write a persistent value <name>\n"
 #endif
-	"avb verify [slot_suffix] - run verification process using hash data\n"
-	"    from vbmeta structure\n"
+	"avb verify [slot_suffix [partition...]] - run verification process\n"
+	"    using hash data from vbmeta structure\n"
 	"    [slot_suffix] - _a, _b, etc (if vbmeta partition is slotted)\n"
+	"    [partition...] - partitions to verify (default boot)\n"
 	);
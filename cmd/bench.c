@@ -0,0 +1,468 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Microbenchmarks for the primitives that U-Boot spends its boot time in
+ *
+ * Each case runs a primitive a number of times and reports the elapsed time,
+ * along with the throughput in MB/s (for cases which process data) and the
+ * rate in operations per second. The output is either text or JSON, the
+ * latter being easy to collect from CI runs on sandbox and on boards.
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <command.h>
+#include <cpu_func.h>
+#include <div64.h>
+#include <dm.h>
+#include <env.h>
+#include <fs.h>
+#include <gzip.h>
+#include <hash.h>
+#include <image.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <time.h>
+#include <asm/cache.h>
+#include <asm/global_data.h>
+#include <dm/of.h>
+#include <dm/root.h>
+#include <dm/uclass-internal.h>
+#include <linux/list.h>
+#include <linux/sizes.h>
+#include <u-boot/crc.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Cases which do not process a buffer run this many times more often */
+#define BENCH_OPS_SCALE		1024
+
+#define BENCH_ENV_VAR		"bench_var"
+
+/**
+ * struct bench_ctx - state for a bench run
+ *
+ * @json: true to write JSON, false for text
+ * @count: Number of results written so far
+ * @size: Number of bytes to process in each call
+ * @loops: Number of calls in each case
+ * @buf: Buffer of 2 * @size bytes, aligned for DMA
+ * @fs_ifname: Interface to read from in the fs case, NULL to skip it
+ * @fs_dev_part: Device and partition to read from
+ * @fs_file: File to read
+ */
+struct bench_ctx {
+	bool json;
+	int count;
+	ulong size;
+	uint loops;
+	u8 *buf;
+	const char *fs_ifname;
+	const char *fs_dev_part;
+	const char *fs_file;
+};
+
+static void bench_report(struct bench_ctx *ctx, const char *name, u64 bytes,
+			 ulong ops, ulong us)
+{
+	ulong mbps, ops_per_sec;
+
+	us = max(us, 1UL);
+	mbps = lldiv(bytes, us);
+	ops_per_sec = lldiv(ops * 1000000ULL, us);
+
+	if (ctx->json) {
+		printf("%s\n  {\"name\": \"%s\", \"bytes\": %llu, \"ops\": %lu, \"us\": %lu, \"mb_per_s\": %lu, \"ops_per_s\": %lu}",
+		       ctx->count ? "," : "[", name, bytes, ops, us, mbps,
+		       ops_per_sec);
+	} else if (bytes) {
+		printf("%-24s %10lu us %8lu MB/s %10lu ops/s\n", name, us,
+		       mbps, ops_per_sec);
+	} else {
+		printf("%-24s %10lu us %8s      %10lu ops/s\n", name, us, "",
+		       ops_per_sec);
+	}
+	ctx->count++;
+}
+
+static int bench_memcpy(struct bench_ctx *ctx)
+{
+	u8 *src = ctx->buf, *dst = ctx->buf + ctx->size;
+	ulong start;
+	uint i;
+
+	memset(src, 0xa5, ctx->size);
+	start = timer_get_us();
+	for (i = 0; i < ctx->loops; i++)
+		memcpy(dst, src, ctx->size);
+	bench_report(ctx, "memcpy", (u64)ctx->size * ctx->loops, ctx->loops,
+		     timer_get_us() - start);
+
+	return 0;
+}
+
+static int bench_memset(struct bench_ctx *ctx)
+{
+	ulong start;
+	uint i;
+
+	start = timer_get_us();
+	for (i = 0; i < ctx->loops; i++)
+		memset(ctx->buf, i, ctx->size);
+	bench_report(ctx, "memset", (u64)ctx->size * ctx->loops, ctx->loops,
+		     timer_get_us() - start);
+
+	return 0;
+}
+
+static int bench_flush(struct bench_ctx *ctx)
+{
+	ulong addr = (ulong)ctx->buf;
+	ulong start;
+	uint i;
+
+	start = timer_get_us();
+	for (i = 0; i < ctx->loops; i++) {
+		/* dirty the lines again so that there is something to write */
+		memset(ctx->buf, i, ctx->size);
+		flush_dcache_range(addr, addr + ctx->size);
+	}
+	bench_report(ctx, "memset+flush_dcache", (u64)ctx->size * ctx->loops,
+		     ctx->loops, timer_get_us() - start);
+
+	return 0;
+}
+
+static int bench_crc(struct bench_ctx *ctx)
+{
+	ulong start;
+	uint i;
+
+	start = timer_get_us();
+	for (i = 0; i < ctx->loops; i++)
+		crc32(0, ctx->buf, ctx->size);
+	bench_report(ctx, "crc32", (u64)ctx->size * ctx->loops, ctx->loops,
+		     timer_get_us() - start);
+
+	if (IS_ENABLED(CONFIG_CRC32C)) {
+		start = timer_get_us();
+		for (i = 0; i < ctx->loops; i++)
+			crc32c(~0, ctx->buf, ctx->size);
+		bench_report(ctx, "crc32c", (u64)ctx->size * ctx->loops,
+			     ctx->loops, timer_get_us() - start);
+	}
+
+	return 0;
+}
+
+static int bench_hash(struct bench_ctx *ctx)
+{
+	u8 output[HASH_MAX_DIGEST_SIZE];
+	struct hash_algo *algo;
+	char name[32];
+	ulong start;
+	uint j;
+	int i;
+
+	if (!CONFIG_IS_ENABLED(HASH))
+		return 0;
+
+	for (i = 0; !hash_get_algo(i, &algo); i++) {
+		start = timer_get_us();
+		for (j = 0; j < ctx->loops; j++)
+			algo->hash_func_ws(ctx->buf, ctx->size, output,
+					   algo->chunk_size);
+		snprintf(name, sizeof(name), "hash:%s", algo->name);
+		bench_report(ctx, name, (u64)ctx->size * ctx->loops,
+			     ctx->loops, timer_get_us() - start);
+	}
+
+	return 0;
+}
+
+static int bench_decomp_one(struct bench_ctx *ctx, int comp, void *src,
+			    ulong src_len)
+{
+	u8 *dst = ctx->buf + ctx->size;
+	char name[32];
+	ulong start, len;
+	uint i;
+	int ret;
+
+	start = timer_get_us();
+	for (i = 0; i < ctx->loops; i++) {
+		len = src_len;
+		ret = image_decomp_data(comp, dst, src, &len, ctx->size);
+		if (ret)
+			return ret;
+	}
+	snprintf(name, sizeof(name), "decomp:%s",
+		 genimg_get_comp_short_name(comp));
+	bench_report(ctx, name, (u64)ctx->size * ctx->loops, ctx->loops,
+		     timer_get_us() - start);
+	if (len != ctx->size || memcmp(dst, ctx->buf, len)) {
+		printf("%s: data mismatch\n", name);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static int bench_decomp(struct bench_ctx *ctx)
+{
+	ulong i, len;
+	u8 *comp;
+	int ret;
+
+	/* Something more compressible than random, less than a constant */
+	for (i = 0; i < ctx->size; i++)
+		ctx->buf[i] = (i >> 4) ^ (i % 251);
+
+	ret = bench_decomp_one(ctx, IH_COMP_NONE, ctx->buf, ctx->size);
+	if (ret)
+		return ret;
+
+	/* U-Boot can only compress with gzip, so the others need an image */
+	if (!CONFIG_IS_ENABLED(GZIP_COMPRESSED) || !CONFIG_IS_ENABLED(GZIP))
+		return 0;
+	len = ctx->size + SZ_4K;
+	comp = malloc(len);
+	if (!comp)
+		return -ENOMEM;
+	ret = gzip(comp, &len, ctx->buf, ctx->size);
+	if (!ret)
+		ret = bench_decomp_one(ctx, IH_COMP_GZIP, comp, len);
+	free(comp);
+
+	return ret;
+}
+
+static int bench_blk(struct bench_ctx *ctx)
+{
+	struct blk_desc *desc;
+	struct udevice *dev;
+	char name[32];
+	lbaint_t blks;
+	ulong start;
+	uint i;
+
+	uclass_foreach_dev_probe(UCLASS_BLK, dev) {
+		desc = dev_get_uclass_plat(dev);
+		if (!desc->blksz || !desc->lba)
+			continue;
+		blks = min_t(lbaint_t, ctx->size / desc->blksz, desc->lba);
+		if (!blks)
+			continue;
+
+		start = timer_get_us();
+		for (i = 0; i < ctx->loops; i++) {
+			if (blk_dread(desc, 0, blks, ctx->buf) != blks)
+				break;
+		}
+		if (i != ctx->loops) {
+			printf("%s: read failed\n", dev->name);
+			continue;
+		}
+		snprintf(name, sizeof(name), "blk:%s", dev->name);
+		bench_report(ctx, name, (u64)blks * desc->blksz * ctx->loops,
+			     ctx->loops, timer_get_us() - start);
+	}
+
+	return 0;
+}
+
+static int bench_fs(struct bench_ctx *ctx)
+{
+	ulong addr = map_to_sysmem(ctx->buf);
+	loff_t total = 0, actread;
+	char name[32];
+	ulong start;
+	uint i;
+	int ret;
+
+	if (!ctx->fs_ifname)
+		return 0;
+
+	start = timer_get_us();
+	for (i = 0; i < ctx->loops; i++) {
+		ret = fs_set_blk_dev(ctx->fs_ifname, ctx->fs_dev_part,
+				     FS_TYPE_ANY);
+		if (ret)
+			return ret;
+		if (!i)
+			snprintf(name, sizeof(name), "fs:%s",
+				 fs_get_type_name());
+
+		/* fs_read() closes the filesystem again */
+		ret = fs_read(ctx->fs_file, addr, 0, ctx->size, &actread);
+		if (ret)
+			return ret;
+		total += actread;
+	}
+	bench_report(ctx, name, total, ctx->loops, timer_get_us() - start);
+
+	return 0;
+}
+
+static int bench_env(struct bench_ctx *ctx)
+{
+	uint i, loops = ctx->loops * BENCH_OPS_SCALE;
+	ulong start;
+	int ret;
+
+	ret = env_set(BENCH_ENV_VAR, "1");
+	if (ret)
+		return ret;
+	start = timer_get_us();
+	for (i = 0; i < loops; i++)
+		env_get(BENCH_ENV_VAR);
+	bench_report(ctx, "env_get", 0, loops, timer_get_us() - start);
+
+	return env_set(BENCH_ENV_VAR, NULL);
+}
+
+/*
+ * Bind a second driver-model tree from the device tree, then throw it away.
+ * The devices are not probed, since that would touch the hardware behind the
+ * back of the drivers already using it. This is only done on sandbox: on a
+ * real board, bind() and the uclass init() and destroy() methods can have
+ * side effects beyond the tree, and dm_init() would fix up the driver
+ * pointers a second time where NEEDS_MANUAL_RELOC is set.
+ */
+static int bench_dm(struct bench_ctx *ctx)
+{
+	struct udevice *saved_root = gd->dm_root;
+	struct list_head saved_uclass_root_s = gd->uclass_root_s;
+	struct list_head *saved_uclass_root = gd->uclass_root;
+	struct list_head saved_dmtag_list = gd->dmtag_list;
+	struct uclass *uc, *next;
+	ulong start, us = 0;
+	uint i;
+	int ret = 0;
+
+	if (!IS_ENABLED(CONFIG_SANDBOX) ||
+	    CONFIG_IS_ENABLED(OF_PLATDATA_INST) ||
+	    !CONFIG_IS_ENABLED(DM_DEVICE_REMOVE) ||
+	    !CONFIG_IS_ENABLED(OF_REAL))
+		return 0;
+
+	for (i = 0; !ret && i < ctx->loops; i++) {
+		gd->dm_root = NULL;
+		start = timer_get_us();
+		ret = dm_init(of_live_active());
+		if (!ret)
+			ret = dm_scan_fdt(false);
+		us += timer_get_us() - start;
+
+		if (gd->dm_root)
+			dm_uninit();
+		list_for_each_entry_safe(uc, next, gd->uclass_root,
+					 sibling_node)
+			uclass_destroy(uc);
+
+		gd->dm_root = saved_root;
+		gd->uclass_root_s = saved_uclass_root_s;
+		gd->uclass_root = saved_uclass_root;
+		gd->dmtag_list = saved_dmtag_list;
+	}
+	if (ret)
+		return ret;
+	bench_report(ctx, "dm_bind", 0, ctx->loops, us);
+
+	return 0;
+}
+
+static const struct bench_case {
+	const char *name;
+	int (*run)(struct bench_ctx *ctx);
+} bench_cases[] = {
+	{ "memcpy", bench_memcpy },
+	{ "memset", bench_memset },
+	{ "flush", bench_flush },
+	{ "crc32", bench_crc },
+	{ "hash", bench_hash },
+	{ "decomp", bench_decomp },
+	{ "blk", bench_blk },
+	{ "fs", bench_fs },
+	{ "env", bench_env },
+	{ "dm", bench_dm },
+};
+
+static const struct bench_case *bench_find_case(const char *name)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bench_cases); i++) {
+		if (!strcmp(name, bench_cases[i].name))
+			return &bench_cases[i];
+	}
+
+	return NULL;
+}
+
+static int do_bench(struct cmd_tbl *cmdtp, int flag, int argc,
+		    char *const argv[])
+{
+	struct bench_ctx ctx = {
+		.size	= SZ_1M,
+		.loops	= 16,
+	};
+	const struct bench_case *bcase;
+	int i, ret = 0;
+
+	for (argc--, argv++; argc && *argv[0] == '-'; argc--, argv++) {
+		if (!strcmp(argv[0], "-j")) {
+			ctx.json = true;
+		} else if (!strcmp(argv[0], "-s") && argc > 1) {
+			ctx.size = hextoul(argv[1], NULL);
+			argc--, argv++;
+		} else if (!strcmp(argv[0], "-n") && argc > 1) {
+			ctx.loops = dectoul(argv[1], NULL);
+			argc--, argv++;
+		} else if (!strcmp(argv[0], "-f") && argc > 3) {
+			ctx.fs_ifname = argv[1];
+			ctx.fs_dev_part = argv[2];
+			ctx.fs_file = argv[3];
+			argc -= 3, argv += 3;
+		} else {
+			return CMD_RET_USAGE;
+		}
+	}
+	if (!ctx.size || !ctx.loops)
+		return CMD_RET_USAGE;
+	for (i = 0; i < argc; i++) {
+		if (!bench_find_case(argv[i])) {
+			printf("Unknown case '%s'\n", argv[i]);
+			return CMD_RET_USAGE;
+		}
+	}
+
+	ctx.buf = memalign(ARCH_DMA_MINALIGN, ctx.size * 2);
+	if (!ctx.buf) {
+		printf("Cannot allocate %#lx bytes\n", ctx.size * 2);
+		return CMD_RET_FAILURE;
+	}
+
+	for (i = 0; i < (argc ? argc : ARRAY_SIZE(bench_cases)); i++) {
+		bcase = argc ? bench_find_case(argv[i]) : &bench_cases[i];
+		ret = bcase->run(&ctx);
+		if (ret) {
+			printf("%s: failed (err=%d)\n", bcase->name, ret);
+			break;
+		}
+	}
+	if (ctx.json)
+		printf("%s]\n", ctx.count ? "\n" : "[");
+	free(ctx.buf);
+
+	return ret ? CMD_RET_FAILURE : 0;
+}
+
+U_BOOT_CMD(
+	bench,	CONFIG_SYS_MAXARGS,	1,	do_bench,
+	"measure the speed of common operations",
+	"[-j] [-s size] [-n count] [-f interface dev[:part] file] [case...]\n"
+	"    - run each case (default all) count times over size bytes (hex)\n"
+	"      -j  write the results as JSON\n"
+	"      -f  read this file in the 'fs' case\n"
+	"    cases: memcpy memset flush crc32 hash decomp blk fs env dm"
+);
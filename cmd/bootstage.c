@@ -15,6 +15,14 @@ static int do_bootstage_report(struct cmd_tbl *cmdtp, int flag, int argc,
 	return 0;
 }
 
+static int do_bootstage_tree(struct cmd_tbl *cmdtp, int flag, int argc,
+			     char *const argv[])
+{
+	bootstage_tree();
+
+	return 0;
+}
+
 static int get_base_size(int argc, char *const argv[], ulong *basep,
 			 ulong *sizep)
 {
@@ -61,6 +69,7 @@ static int do_bootstage_stash(struct cmd_tbl *cmdtp, int flag, int argc,
 
 static struct cmd_tbl cmd_bootstage_sub[] = {
 	U_BOOT_CMD_MKENT(report, 2, 1, do_bootstage_report, "", ""),
+	U_BOOT_CMD_MKENT(tree, 2, 1, do_bootstage_tree, "", ""),
 	U_BOOT_CMD_MKENT(stash, 4, 0, do_bootstage_stash, "", ""),
 	U_BOOT_CMD_MKENT(unstash, 4, 0, do_bootstage_stash, "", ""),
 };
@@ -91,6 +100,7 @@ U_BOOT_CMD(bootstage, 4, 1, do_boostage,
 	"Boot stage command",
 	" - check boot progress and timing\n"
 	"report                      - Print a report\n"
+	"tree                        - Print nested spans by inclusive time\n"
 	"stash [<start> [<size>]]    - Stash data into memory\n"
 	"unstash [<start> [<size>]]  - Unstash data from memory"
 );
@@ -9,8 +9,28 @@
  */
 #include <common.h>
 #include <command.h>
+#include <dm.h>
+#include <serial.h>
 #include <stdio_dev.h>
 
+/* Show how much waiting the TX buffer of a serial console has saved */
+static void show_tx_stats(struct stdio_dev *dev)
+{
+	struct serial_tx_stats stats;
+	ulong reclaimed;
+
+	if (!CONFIG_IS_ENABLED(SERIAL_TX_BUFFER) ||
+	    !(dev->flags & DEV_FLAGS_DM) ||
+	    device_get_uclass_id(dev->priv) != UCLASS_SERIAL ||
+	    serial_get_tx_stats(dev->priv, &stats, &reclaimed))
+		return;
+
+	printf("         TX buffer: %lu chars, %lu sent while idle, ",
+	       stats.queued, stats.idle);
+	printf("%lu ms waited, ~%lu ms reclaimed\n", stats.wait_us / 1000,
+	       reclaimed / 1000);
+}
+
 extern void _do_coninfo (void);
 static int do_coninfo(struct cmd_tbl *cmd, int flag, int argc,
 		      char *const argv[])
@@ -39,6 +59,7 @@ static int do_coninfo(struct cmd_tbl *cmd, int flag, int argc,
 			}
 		}
 		putc ('\n');
+		show_tx_stats(dev);
 	}
 	return 0;
 }
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Show statistics for the malloc() pool
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+
+static int do_malloc_info(struct cmd_tbl *cmdtp, int flag, int argc,
+			  char *const argv[])
+{
+	struct malloc_class_info cls;
+	struct malloc_info info;
+	ulong free_bins;
+	int i;
+
+	if (argc > 2)
+		return CMD_RET_USAGE;
+	if (argc == 2) {
+		if (strcmp(argv[1], "flush"))
+			return CMD_RET_USAGE;
+		printf("Released %d cached chunks\n", malloc_cache_flush());
+		return 0;
+	}
+
+	malloc_get_info(&info);
+	free_bins = info.free - info.top_size;
+	printf("Pool size:     %lu\n", info.pool_size);
+	printf("Arena:         %lu (high-water %lu)\n", info.arena,
+	       info.max_arena);
+	printf("In use:        %lu\n", info.arena - info.free - info.cached);
+	printf("Free:          %lu (top %lu, %lu in %lu chunks)\n", info.free,
+	       info.top_size, free_bins, info.free_chunks);
+	printf("Largest free:  %lu\n", info.largest_free);
+	/* Share of free memory which cannot satisfy the largest request */
+	printf("Fragmentation: %lu%%\n", info.free ?
+	       100 - info.largest_free * 100 / info.free : 0);
+	if (malloc_cache_class(0, &cls))
+		return 0;
+
+	printf("Cached:        %lu (%lu chunks)\n\n", info.cached,
+	       info.cached_chunks);
+	printf("%6s %10s %10s %6s %6s\n", "Size", "Requests", "Hits", "Hit%",
+	       "Cached");
+	for (i = 0; !malloc_cache_class(i, &cls); i++) {
+		if (!cls.requests && !cls.cached)
+			continue;
+		printf("%6lu %10lu %10lu %5lu%% %6lu\n", cls.size, cls.requests,
+		       cls.hits, cls.requests ? cls.hits * 100 / cls.requests : 0,
+		       cls.cached);
+	}
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	malloc_info,	2,	1,	do_malloc_info,
+	"show malloc() pool statistics",
+	"\n    - show pool usage, fragmentation and size-class cache counters\n"
+	"malloc_info flush\n    - return all cached chunks to the allocator"
+);
@@ -16,13 +16,17 @@
 #include <cli.h>
 #include <command.h>
 #include <console.h>
+#include <cpu_func.h>
 #include <display_options.h>
+#include <div64.h>
 #ifdef CONFIG_MTD_NOR_FLASH
 #include <flash.h>
 #endif
 #include <hash.h>
 #include <log.h>
+#include <malloc.h>
 #include <mapmem.h>
+#include <memtest.h>
 #include <rand.h>
 #include <watchdog.h>
 #include <asm/global_data.h>
@@ -1060,6 +1064,87 @@ static ulong mem_test_quick(vu_long *buf, ulong start_addr, ulong end_addr,
 	return errs;
 }
 
+/*
+ * Test from start to end on all the CPUs that cpu_run_parallel() can use,
+ * giving each one an equal part of the range. Returns the number of errors,
+ * or -1 if the test could not run.
+ */
+static ulong mem_test_parallel(vu_long *buf, ulong start, ulong end,
+			       ulong pattern, int iteration)
+{
+	ulong base = ALIGN(start, MEMTEST_ALIGN);
+	ulong top = ALIGN_DOWN(end, MEMTEST_ALIGN);
+	struct memtest_job *jobs, *job;
+	struct memtest_err *err;
+	ulong part, errs = 0;
+	bool stop = false;
+	ulong start_ms, ms;
+	u64 bytes = 0;
+	void **args;
+	int count, i, j, ret;
+
+	if (top <= base) {
+		printf("Refusing to do empty test\n");
+		return -1UL;
+	}
+	count = cpu_parallel_count();
+	part = ALIGN_DOWN((top - base) / count, MEMTEST_ALIGN);
+	if (!part)
+		count = 1;
+
+	jobs = calloc(count, sizeof(*jobs));
+	args = calloc(count, sizeof(*args));
+	if (!jobs || !args) {
+		printf("Out of memory\n");
+		errs = -1UL;
+		goto out;
+	}
+	for (i = 0; i < count; i++) {
+		job = &jobs[i];
+		job->buf = (u64 *)((ulong)buf + base - start + part * i);
+		job->size = i == count - 1 ? top - base - part * i : part;
+		job->tests = MEMTEST_ALL;
+		job->pattern = pattern;
+		job->primary = !i;
+		job->stop = &stop;
+		args[i] = job;
+	}
+
+	start_ms = get_timer(0);
+	ret = cpu_run_parallel(memtest_run, args, count);
+	ms = max(get_timer(start_ms), 1UL);
+	if (ret) {
+		printf("Cannot run test (err=%d)\n", ret);
+		errs = -1UL;
+		goto out;
+	}
+	if (stop) {
+		errs = -1UL;
+		goto out;
+	}
+
+	for (i = 0; i < count; i++) {
+		job = &jobs[i];
+		bytes += job->bytes;
+		errs += job->errors;
+		for (j = 0; j < min_t(ulong, job->errors, MEMTEST_MAX_ERRS);
+		     j++) {
+			err = &job->err[j];
+			printf("FAILURE (CPU %d) at %08lx: expected %016llx, actual %016llx\n",
+			       i, start + ((ulong)err->addr - (ulong)buf),
+			       err->expect, err->actual);
+		}
+	}
+	printf("Iteration: %6d: %d CPU(s), %lu MB/s, %lu errors\n", iteration,
+	       count, (ulong)lldiv(bytes, ms * 1000), errs);
+
+out:
+	free(args);
+	free(jobs);
+
+	return errs;
+}
+
 /*
  * Perform a memory test. A more complete alternative test can be
  * configured using CONFIG_SYS_ALT_MEMTEST. The complete test loops until
@@ -1075,11 +1160,19 @@ static int do_mem_mtest(struct cmd_tbl *cmdtp, int flag, int argc,
 	ulong count = 0;
 	ulong errs = 0;	/* number of errors, or -1 if interrupted */
 	ulong pattern = 0;
+	bool parallel = false;
 	int iteration;
 
 	start = CONFIG_SYS_MEMTEST_START;
 	end = CONFIG_SYS_MEMTEST_END;
 
+	if (IS_ENABLED(CONFIG_CMD_MEMTEST_PARALLEL) && argc > 1 &&
+	    !strcmp(argv[1], "-p")) {
+		parallel = true;
+		argc--;
+		argv++;
+	}
+
 	if (argc > 1)
 		if (strict_strtoul(argv[1], 16, &start) < 0)
 			return CMD_RET_USAGE;
@@ -1114,6 +1207,15 @@ static int do_mem_mtest(struct cmd_tbl *cmdtp, int flag, int argc,
 			break;
 		}
 
+		if (IS_ENABLED(CONFIG_CMD_MEMTEST_PARALLEL) && parallel) {
+			errs = mem_test_parallel(buf, start, end, pattern,
+						 iteration + 1);
+			if (errs == -1UL)
+				break;
+			count += errs;
+			continue;
+		}
+
 		printf("Iteration: %6d\r", iteration + 1);
 		debug("\n");
 		if (IS_ENABLED(CONFIG_SYS_ALT_MEMTEST)) {
@@ -1421,9 +1523,14 @@ U_BOOT_CMD(
 
 #ifdef CONFIG_CMD_MEMTEST
 U_BOOT_CMD(
-	mtest,	5,	1,	do_mem_mtest,
+	mtest,	6,	1,	do_mem_mtest,
 	"simple RAM read/write test",
+#ifdef CONFIG_CMD_MEMTEST_PARALLEL
+	"[-p] [start [end [pattern [iterations]]]]\n"
+	"    -p: test on all CPUs at once, with wide accesses"
+#else
 	"[start [end [pattern [iterations]]]]"
+#endif
 );
 #endif	/* CONFIG_CMD_MEMTEST */
 
@@ -489,6 +489,12 @@ void fdt_fixup_pstore(void *blob)
 	u32 addr_cells;
 	u32 size_cells;
 
+	nodeoffset = fdt_txn_sync(blob);
+	if (nodeoffset < 0) {
+		log_err("fdt_txn_sync() returned %s\n", fdt_strerror(nodeoffset));
+		return;
+	}
+
 	nodeoffset = fdt_path_offset(blob, "/");
 	if (nodeoffset < 0) {
 		/* Not found or something else bad happened. */
@@ -72,6 +72,15 @@ static void display_ubi_info(struct ubi_device *ubi)
 	ubi_msg("number of PEBs reserved for bad PEB handling: %d",
 			ubi->beb_rsvd_pebs);
 	ubi_msg("max/mean erase counter: %d/%d", ubi->max_ec, ubi->mean_ec);
+	ubi_msg("attached by:                %s%s",
+			ubi->attach_stats.fastmap ? "fastmap" : "scanning",
+			ubi->attach_stats.fastmap_written ?
+			" (fastmap written)" : "");
+	ubi_msg("attach time:                %lu ms",
+			ubi->attach_stats.time_us / 1000);
+	ubi_msg("PEBs scanned when attaching: %d (%d merged header reads)",
+			ubi->attach_stats.scanned_pebs,
+			ubi->attach_stats.merged_reads);
 }
 
 static int ubi_info(int layout)
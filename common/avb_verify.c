@@ -12,6 +12,8 @@
 #include <part.h>
 #include <tee.h>
 #include <tee/optee_ta_avb.h>
+#include <asm/cache.h>
+#include <linux/kernel.h>
 
 static const unsigned char avb_root_pub[1032] = {
 	0x0, 0x0, 0x10, 0x0, 0x55, 0xd9, 0x4, 0xad, 0xd8, 0x4,
@@ -396,6 +398,7 @@ static AvbIOResult mmc_byte_io(AvbOps *ops,
 	u64 start_offset, start_sector, sectors, residue;
 	u8 *tmp_buf;
 	size_t io_cnt = 0;
+	AvbIOResult res = AVB_IO_RESULT_OK;
 
 	if (!partition || !buffer || io_type > IO_WRITE)
 		return AVB_IO_RESULT_ERROR_IO;
@@ -404,8 +407,10 @@ static AvbIOResult mmc_byte_io(AvbOps *ops,
 	if (!part)
 		return AVB_IO_RESULT_ERROR_NO_SUCH_PARTITION;
 
-	if (!part->info.blksz)
-		return AVB_IO_RESULT_ERROR_IO;
+	if (!part->info.blksz) {
+		res = AVB_IO_RESULT_ERROR_IO;
+		goto out;
+	}
 
 	start_offset = calc_offset(part, offset);
 	while (num_bytes) {
@@ -433,7 +438,8 @@ static AvbIOResult mmc_byte_io(AvbOps *ops,
 				if (ret != 1) {
 					printf("%s: read error (%ld, %lld)\n",
 					       __func__, ret, start_sector);
-					return AVB_IO_RESULT_ERROR_IO;
+					res = AVB_IO_RESULT_ERROR_IO;
+					goto out;
 				}
 				/*
 				 * if this is not aligned at sector start,
@@ -450,7 +456,8 @@ static AvbIOResult mmc_byte_io(AvbOps *ops,
 				if (ret != 1) {
 					printf("%s: read error (%ld, %lld)\n",
 					       __func__, ret, start_sector);
-					return AVB_IO_RESULT_ERROR_IO;
+					res = AVB_IO_RESULT_ERROR_IO;
+					goto out;
 				}
 				memcpy((void *)tmp_buf +
 					start_offset % part->info.blksz,
@@ -461,7 +468,8 @@ static AvbIOResult mmc_byte_io(AvbOps *ops,
 				if (ret != 1) {
 					printf("%s: write error (%ld, %lld)\n",
 					       __func__, ret, start_sector);
-					return AVB_IO_RESULT_ERROR_IO;
+					res = AVB_IO_RESULT_ERROR_IO;
+					goto out;
 				}
 			}
 
@@ -487,7 +495,8 @@ static AvbIOResult mmc_byte_io(AvbOps *ops,
 
 			if (!ret) {
 				printf("%s: sector read error\n", __func__);
-				return AVB_IO_RESULT_ERROR_IO;
+				res = AVB_IO_RESULT_ERROR_IO;
+				goto out;
 			}
 
 			io_cnt += ret * part->info.blksz;
@@ -501,7 +510,10 @@ static AvbIOResult mmc_byte_io(AvbOps *ops,
 	if (io_type == IO_READ && out_num_read)
 		*out_num_read = io_cnt;
 
-	return AVB_IO_RESULT_OK;
+out:
+	free(part);
+
+	return res;
 }
 
 /**
@@ -539,6 +551,40 @@ static AvbIOResult read_from_partition(AvbOps *ops,
 			   num_bytes, buffer, out_num_read, IO_READ);
 }
 
+/**
+ * get_preload_buffer() - finds room for a partition in the preload area
+ *
+ * libavb reads the partition straight into the area at
+ * CONFIG_AVB_PRELOAD_ADDR, after any partitions loaded before it, and hashes
+ * it as it goes. Once verified it can be booted from there.
+ *
+ * @ops: contains AVB ops handlers
+ * @partition_name: partition name, NUL-terminated UTF-8 string
+ * @num_bytes: size of the partition data to load
+ * @out_pointer: returns the address to load to, or NULL if it does not fit
+ *
+ * @return:
+ *      AVB_IO_RESULT_OK
+ */
+static AvbIOResult get_preload_buffer(AvbOps *ops,
+				      const char *partition_name,
+				      size_t num_bytes,
+				      u8 **out_pointer)
+{
+	struct AvbOpsData *data = ops->user_data;
+	size_t start = ALIGN(data->preload_used, ARCH_DMA_MINALIGN);
+
+	*out_pointer = NULL;
+	if (start > CONFIG_AVB_PRELOAD_SIZE ||
+	    num_bytes > CONFIG_AVB_PRELOAD_SIZE - start)
+		return AVB_IO_RESULT_OK;
+
+	data->preload_used = start + num_bytes;
+	*out_pointer = map_sysmem(CONFIG_AVB_PRELOAD_ADDR + start, num_bytes);
+
+	return AVB_IO_RESULT_OK;
+}
+
 /**
  * write_to_partition() - writes N bytes to a partition identified by a string
  * name
@@ -999,11 +1045,20 @@ AvbOps *avb_ops_alloc(int boot_device)
 	ops_data->ops.read_persistent_value = read_persistent_value;
 #endif
 	ops_data->ops.get_size_of_partition = get_size_of_partition;
+	if (CONFIG_AVB_PRELOAD_SIZE)
+		ops_data->ops.get_preload_buffer = get_preload_buffer;
 	ops_data->mmc_dev = boot_device;
 
 	return &ops_data->ops;
 }
 
+void avb_preload_reset(AvbOps *ops)
+{
+	struct AvbOpsData *ops_data = ops->user_data;
+
+	ops_data->preload_used = 0;
+}
+
 void avb_ops_free(AvbOps *ops)
 {
 	struct AvbOpsData *ops_data;
@@ -421,8 +421,37 @@ static int reserve_trace(void)
 	return 0;
 }
 
+/*
+ * Check whether U-Boot can stay where it was loaded, below the memory which is
+ * reserved at the top of RAM. It then 'relocates' to its own address, so that
+ * relocate_code() has nothing to copy or fix up.
+ *
+ * Return: address to run U-Boot at, or 0 to relocate it as usual
+ */
+static ulong reloc_in_place(void)
+{
+#ifdef CONFIG_RELOC_IN_PLACE
+	ulong start = (ulong)__image_copy_start;
+
+	if (start >= gd->ram_base && start + gd->mon_len <= gd->relocaddr)
+		return start;
+#endif
+	return 0;
+}
+
 static int reserve_uboot(void)
 {
+	ulong addr;
+
+	addr = reloc_in_place();
+	if (!(gd->flags & GD_FLG_SKIP_RELOC) && addr) {
+		gd->start_addr_sp = gd->relocaddr;
+		gd->relocaddr = addr;
+		debug("Running U-Boot in place at: %08lx\n", gd->relocaddr);
+
+		return 0;
+	}
+
 	if (!(gd->flags & GD_FLG_SKIP_RELOC)) {
 		/*
 		 * reserve memory for U-Boot code, data & bss
@@ -699,12 +728,22 @@ static int setup_reloc(void)
 
 	if (gd->flags & GD_FLG_SKIP_RELOC) {
 		debug("Skipping relocation due to flag\n");
+	} else if (IS_ENABLED(CONFIG_RELOC_IN_PLACE) && !gd->reloc_off) {
+		/* the stack and everything else reserved must be above us */
+		if (gd->relocaddr + gd->mon_len > gd->start_addr_sp) {
+			printf("U-Boot at %08lx overlaps reserved memory at %08lx\n",
+			       gd->relocaddr, gd->start_addr_sp);
+			return -ENOSPC;
+		}
+		debug("Not relocating, new gd at %08lx, sp at %08lx\n",
+		      (ulong)map_to_sysmem(gd->new_gd), gd->start_addr_sp);
 	} else {
 		debug("Relocation Offset is: %08lx\n", gd->reloc_off);
 		debug("Relocating to %08lx, new gd at %08lx, sp at %08lx\n",
 		      gd->relocaddr, (ulong)map_to_sysmem(gd->new_gd),
 		      gd->start_addr_sp);
 	}
+	bootstage_mark_name(BOOTSTAGE_ID_RELOCATE, "relocate");
 
 	return 0;
 }
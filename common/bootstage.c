@@ -26,6 +26,8 @@ DECLARE_GLOBAL_DATA_PTR;
 
 enum {
 	RECORD_COUNT = CONFIG_VAL(BOOTSTAGE_RECORD_COUNT),
+	SPAN_COUNT = CONFIG_VAL(BOOTSTAGE_SPAN_COUNT),
+	SPAN_NAME_LEN = 32,
 };
 
 struct bootstage_record {
@@ -36,10 +38,42 @@ struct bootstage_record {
 	enum bootstage_id id;
 };
 
+/**
+ * struct bootstage_span - a nested span of activity
+ *
+ * @start_us: Time when the span started
+ * @time_us: Duration of the span, or 0 if it is still in progress
+ * @parent: Index of the enclosing span, or -1 if none
+ * @depth: Nesting depth, 0 for a top-level span
+ * @type: Type of span (enum bootstage_span_t)
+ * @name: Name of the span
+ */
+struct bootstage_span {
+	uint32_t start_us;
+	uint32_t time_us;
+	int parent;
+	u8 depth;
+	u8 type;
+	char name[SPAN_NAME_LEN];
+};
+
 struct bootstage_data {
 	uint rec_count;
 	uint next_id;
 	struct bootstage_record record[RECORD_COUNT];
+
+	/* Nested spans, allocated after relocation when first used */
+	struct bootstage_span *span;
+	uint span_count;	/* Number of spans recorded */
+	uint span_dropped;	/* Number of spans which did not fit */
+	int cur_span;		/* Index of innermost open span, -1 if none */
+};
+
+static const char *const span_type_name[BOOTSTAGE_SPAN_TYPE_COUNT] = {
+	[BOOTSTAGE_SPAN_GENERAL]	= "",
+	[BOOTSTAGE_SPAN_BIND]		= "bind",
+	[BOOTSTAGE_SPAN_OF_TO_PLAT]	= "of_to_plat",
+	[BOOTSTAGE_SPAN_PROBE]		= "probe",
 };
 
 enum {
@@ -218,6 +252,68 @@ uint32_t bootstage_accum(enum bootstage_id id)
 	return duration;
 }
 
+int bootstage_span_start(enum bootstage_span_t type, const char *name)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_span *span, *parent = NULL;
+
+	/* The span table is allocated with malloc(), so wait for relocation */
+	if (!SPAN_COUNT || !data || !(gd->flags & GD_FLG_RELOC))
+		return 0;
+	if (!data->span) {
+		data->span = calloc(SPAN_COUNT, sizeof(*data->span));
+		if (!data->span)
+			return 0;
+		data->span_count = 0;
+		data->cur_span = -1;
+	}
+	if (data->cur_span >= 0)
+		parent = &data->span[data->cur_span];
+	if (data->span_count == SPAN_COUNT ||
+	    (parent && parent->depth == U8_MAX)) {
+		data->span_dropped++;
+		return 0;
+	}
+
+	span = &data->span[data->span_count];
+	span->start_us = timer_get_boot_us();
+	span->time_us = 0;
+	span->parent = data->cur_span;
+	span->depth = parent ? parent->depth + 1 : 0;
+	span->type = type;
+	strlcpy(span->name, name, sizeof(span->name));
+	data->cur_span = data->span_count++;
+
+	return data->cur_span + 1;
+}
+
+void bootstage_span_end(int id)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_span *span;
+
+	if (!id || !data || !data->span || id > data->span_count)
+		return;
+	span = &data->span[id - 1];
+	span->time_us = max((uint32_t)timer_get_boot_us() - span->start_us,
+			    1U);
+	data->cur_span = span->parent;
+}
+
+/**
+ * span_time() - get the duration of a span
+ *
+ * @span:	Span to check
+ * Return: duration of the span, or the time so far if still in progress
+ */
+static uint32_t span_time(const struct bootstage_span *span)
+{
+	if (span->time_us)
+		return span->time_us;
+
+	return (uint32_t)timer_get_boot_us() - span->start_us;
+}
+
 /**
  * Get a record name as a printable string
  *
@@ -262,6 +358,98 @@ static int h_compare_record(const void *r1, const void *r2)
 	return rec1->time_us > rec2->time_us ? 1 : -1;
 }
 
+static int h_compare_span(const void *p1, const void *p2)
+{
+	const struct bootstage_data *data = gd->bootstage;
+	const struct bootstage_span *span1 = &data->span[*(const int *)p1];
+	const struct bootstage_span *span2 = &data->span[*(const int *)p2];
+	uint32_t time1, time2;
+
+	if (span1->parent != span2->parent)
+		return span1->parent - span2->parent;
+	time1 = span_time(span1);
+	time2 = span_time(span2);
+	if (time1 != time2)
+		return time1 < time2 ? 1 : -1;
+
+	return span1->start_us > span2->start_us ? 1 : -1;
+}
+
+/**
+ * print_span_tree() - print a span and the spans nested within it
+ *
+ * @order:	Span indexes, sorted by parent and then by decreasing time
+ * @first:	For each span index plus one, the position in @order of its
+ *		first child (the entry for index 0 is for top-level spans)
+ * @parent:	Span whose children should be printed, -1 for top level
+ */
+static void print_span_tree(const int *order, const int *first, int parent)
+{
+	struct bootstage_data *data = gd->bootstage;
+	int pos;
+
+	for (pos = first[parent + 1];
+	     pos < data->span_count && data->span[order[pos]].parent == parent;
+	     pos++) {
+		const struct bootstage_span *span = &data->span[order[pos]];
+		uint32_t incl = span_time(span), child = 0;
+		int cpos;
+
+		for (cpos = first[order[pos] + 1];
+		     cpos < data->span_count &&
+		     data->span[order[cpos]].parent == order[pos]; cpos++)
+			child += span_time(&data->span[order[cpos]]);
+
+		print_grouped_ull(incl, BOOTSTAGE_DIGITS);
+		print_grouped_ull(incl > child ? incl - child : 0,
+				  BOOTSTAGE_DIGITS);
+		printf("  %*s%s%s%s%s\n", span->depth * 2, "",
+		       span_type_name[span->type],
+		       span->type != BOOTSTAGE_SPAN_GENERAL ? " " : "",
+		       span->name, span->time_us ? "" : " (in progress)");
+		print_span_tree(order, first, order[pos]);
+	}
+}
+
+void bootstage_tree(void)
+{
+	struct bootstage_data *data = gd->bootstage;
+	int *order, *first;
+	int i;
+
+	if (!data->span || !data->span_count) {
+		printf("No spans recorded\n");
+		return;
+	}
+
+	order = malloc(data->span_count * sizeof(*order));
+	first = malloc((data->span_count + 1) * sizeof(*first));
+	if (!order || !first) {
+		printf("Out of memory\n");
+		goto done;
+	}
+	for (i = 0; i < data->span_count; i++)
+		order[i] = i;
+	qsort(order, data->span_count, sizeof(*order), h_compare_span);
+
+	/* Spans without children point past the end */
+	for (i = 0; i <= data->span_count; i++)
+		first[i] = data->span_count;
+	for (i = data->span_count - 1; i >= 0; i--)
+		first[data->span[order[i]].parent + 1] = i;
+
+	printf("Span tree in microseconds (%d spans):\n", data->span_count);
+	printf("%11s%11s  %s\n", "Inclusive", "Exclusive", "Span");
+	print_span_tree(order, first, -1);
+	if (data->span_dropped)
+		printf("Dropped %d spans, please increase CONFIG_BOOTSTAGE_SPAN_COUNT\n",
+		       data->span_dropped);
+
+done:
+	free(first);
+	free(order);
+}
+
 #ifdef CONFIG_OF_LIBFDT
 /**
  * Add all bootstage timings to a device tree.
@@ -315,6 +503,35 @@ static int add_bootstages_devicetree(struct fdt_header *blob)
 			return -EINVAL;
 	}
 
+	/*
+	 * Add the spans after the records, numbering them onwards from there.
+	 * Each has an 'accum' time like an accumulated record, as well as its
+	 * start time, type, depth and the node number of its parent, if any.
+	 */
+	for (recnum = 0; data->span && recnum < data->span_count; recnum++) {
+		struct bootstage_span *span = &data->span[recnum];
+		int node;
+
+		node = fdt_add_subnode(blob, bootstage,
+				       simple_itoa(data->rec_count + recnum));
+		if (node < 0)
+			break;
+
+		if (fdt_setprop_string(blob, node, "name", span->name) ||
+		    fdt_setprop_cell(blob, node, "accum", span_time(span)) ||
+		    fdt_setprop_cell(blob, node, "start", span->start_us) ||
+		    fdt_setprop_cell(blob, node, "depth", span->depth))
+			return -EINVAL;
+		if (span->type != BOOTSTAGE_SPAN_GENERAL &&
+		    fdt_setprop_string(blob, node, "type",
+				       span_type_name[span->type]))
+			return -EINVAL;
+		if (span->parent >= 0 &&
+		    fdt_setprop_cell(blob, node, "parent",
+				     data->rec_count + span->parent))
+			return -EINVAL;
+	}
+
 	return 0;
 }
 
@@ -357,6 +574,9 @@ void bootstage_report(void)
 		if (rec->start_us)
 			prev = print_time_record(rec, -1);
 	}
+	if (data->span_count)
+		printf("\n%d spans recorded, see 'bootstage tree'\n",
+		       data->span_count);
 }
 
 /**
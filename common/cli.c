@@ -44,7 +44,7 @@ int run_command(const char *cmd, int flag)
 	int hush_flags = FLAG_PARSE_SEMICOLON | FLAG_EXIT_FROM_LOOP;
 
 	if (flag & CMD_FLAG_ENV)
-		hush_flags |= FLAG_CONT_ON_NEWLINE;
+		hush_flags |= FLAG_CONT_ON_NEWLINE | FLAG_CACHE_PARSE;
 	return parse_string_outer(cmd, hush_flags);
 #endif
 }
@@ -105,7 +105,8 @@ int run_command_list(const char *cmd, int len, int flag)
 		buff[len] = '\0';
 	}
 #ifdef CONFIG_HUSH_PARSER
-	rcode = parse_string_outer(buff, FLAG_PARSE_SEMICOLON);
+	rcode = parse_string_outer(buff,
+				   FLAG_PARSE_SEMICOLON | FLAG_CACHE_PARSE);
 #else
 	/*
 	 * This function will overwrite any \n it sees with a \0, which
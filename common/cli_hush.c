@@ -477,7 +477,9 @@ static int parse_string(o_string *dest, struct p_context *ctx, const char *src);
 #endif
 static int parse_stream(o_string *dest, struct p_context *ctx, struct in_str *input0, int end_trigger);
 /*   setup: */
-static int parse_stream_outer(struct in_str *inp, int flag);
+struct parse_cache;
+static int parse_stream_outer(struct in_str *inp, int flag,
+			      struct parse_cache *cache);
 #ifndef __U_BOOT__
 static int parse_string_outer(const char *s, int flag);
 static int parse_file_outer(FILE *f);
@@ -1539,6 +1541,7 @@ static int run_pipe_real(struct pipe *pi)
 	struct child_prog *child;
 	struct built_in_command *x;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1551,6 +1554,7 @@ static int run_pipe_real(struct pipe *pi)
 	int flag = do_repeat ? CMD_FLAG_REPEAT : 0;
 	struct child_prog *child;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1617,6 +1621,8 @@ static int run_pipe_real(struct pipe *pi)
 			}
 			return EXIT_SUCCESS;   /* don't worry about errors in set_local_var() yet */
 		}
+		/* Count in a copy, as the parsed command may run again */
+		sp = child->sp;
 		for (i = 0; is_assignment(child->argv[i]); i++) {
 			p = insert_var_value(child->argv[i]);
 #ifndef __U_BOOT__
@@ -1625,11 +1631,11 @@ static int run_pipe_real(struct pipe *pi)
 			set_local_var(p, 0);
 #endif
 			if (p != child->argv[i]) {
-				child->sp--;
+				sp--;
 				free(p);
 			}
 		}
-		if (child->sp) {
+		if (sp) {
 			char * str = NULL;
 
 			str = make_string(child->argv + i,
@@ -1762,6 +1768,9 @@ static int run_list_real(struct pipe *pi)
 	char *save_name = NULL;
 	char **list = NULL;
 	char **save_list = NULL;
+#ifdef __U_BOOT__
+	struct pipe *for_pipe = NULL;
+#endif
 	struct pipe *rpipe;
 	int flag_rep = 0;
 #ifndef __U_BOOT__
@@ -1801,7 +1810,8 @@ static int run_list_real(struct pipe *pi)
 				/* check Ctrl-C */
 				ctrlc();
 				if ((had_ctrlc())) {
-					return 1;
+					rcode = 1;
+					goto out;
 				}
 #endif
 				flag_restore = 0;
@@ -1832,6 +1842,9 @@ static int run_list_real(struct pipe *pi)
 				save_list = list;
 				save_name = pi->progs->argv[0];
 				pi->progs->argv[0] = NULL;
+#ifdef __U_BOOT__
+				for_pipe = pi;
+#endif
 				flag_rep = 1;
 			}
 			if (!(*list)) {
@@ -1900,7 +1913,8 @@ static int run_list_real(struct pipe *pi)
 #else
 		if (rcode < -1) {
 			last_return_code = -rcode - 2;
-			return -2;	/* exit */
+			rcode = -2;	/* exit */
+			goto out;
 		}
 		last_return_code=(rcode == 0) ? 0 : 1;
 #endif
@@ -1920,6 +1934,20 @@ static int run_list_real(struct pipe *pi)
 		checkjobs(NULL);
 #endif
 	}
+#ifdef __U_BOOT__
+out:
+	/*
+	 * When leaving a "for" loop early, put its variable name back, so
+	 * that the parsed loop can run again
+	 */
+	if (list) {
+		free(for_pipe->progs->argv[0]);
+		while (*list)
+			free(*list++);
+		free(save_list);
+		for_pipe->progs->argv[0] = save_name;
+	}
+#endif
 	return rcode;
 }
 
@@ -3169,9 +3197,129 @@ static void update_ifs_map(void)
 	mapset(ifs, 2);            /* also flow through if quoted */
 }
 
+#if CONFIG_IS_ENABLED(HUSH_PARSE_CACHE)
+/*
+ * Parsed scripts kept for running them again. A script is looked up by its
+ * text, so a changed variable never runs a stale tree. The statements are
+ * recorded while the script runs for the first time, which keeps the usual
+ * interleaving of parsing and running; a script that stops early (exit,
+ * syntax error) is not kept, as the rest of it was never parsed.
+ */
+struct parse_cache {
+	char *text;
+	uint hash;
+	int flag;
+	struct pipe **list;	/* parsed statements, in order */
+	int count;
+	bool busy;		/* being recorded or run */
+	bool failed;		/* recording stopped early */
+	ulong used;
+};
+
+static struct parse_cache parse_cache[CONFIG_HUSH_PARSE_CACHE_ENTRIES];
+static ulong parse_cache_uses;
+
+static uint parse_cache_hash(const char *s)
+{
+	uint hash = 5381;
+
+	while (*s)
+		hash = hash * 33 + (uchar)*s++;
+
+	return hash;
+}
+
+static void parse_cache_free(struct parse_cache *cache)
+{
+	int i;
+
+	for (i = 0; i < cache->count; i++)
+		free_pipe_list(cache->list[i], 0);
+	free(cache->list);
+	free(cache->text);
+	memset(cache, '\0', sizeof(*cache));
+}
+
+/*
+ * Find the entry for a script. This returns either an entry to run again
+ * (count > 0) or an empty one to record into, or NULL to not use the cache.
+ */
+static struct parse_cache *parse_cache_get(const char *s, int flag)
+{
+	struct parse_cache *cache, *victim = NULL;
+	uint hash = parse_cache_hash(s);
+
+	/* IFS changes the parsing, so leave scripts using it alone */
+	if (env_get("IFS") || strstr(s, "IFS"))
+		return NULL;
+
+	for (cache = parse_cache;
+	     cache < parse_cache + ARRAY_SIZE(parse_cache); cache++) {
+		if (cache->text && cache->hash == hash &&
+		    cache->flag == flag && !strcmp(cache->text, s)) {
+			/* A script running itself is simply parsed again */
+			if (cache->busy)
+				return NULL;
+			cache->used = ++parse_cache_uses;
+			return cache;
+		}
+		if (!cache->busy && (!victim || cache->used < victim->used))
+			victim = cache;
+	}
+	if (!victim)
+		return NULL;
+
+	parse_cache_free(victim);
+	victim->text = strdup(s);
+	if (!victim->text)
+		return NULL;
+	victim->hash = hash;
+	victim->flag = flag;
+	victim->used = ++parse_cache_uses;
+
+	return victim;
+}
+
+static void parse_cache_add(struct parse_cache *cache, struct pipe *pi)
+{
+	struct pipe **list;
+
+	list = realloc(cache->list, (cache->count + 1) * sizeof(*list));
+	if (!list) {
+		free_pipe_list(pi, 0);
+		cache->failed = true;
+		return;
+	}
+	cache->list = list;
+	cache->list[cache->count++] = pi;
+}
+
+/* Run a script recorded earlier, just as parse_stream_outer() would */
+static int parse_cache_run(struct parse_cache *cache)
+{
+	int code = 1;
+	int i;
+
+	cache->busy = true;
+	for (i = 0; i < cache->count; i++) {
+		code = run_list_real(cache->list[i]);
+		if (code == -2) {	/* exit */
+			code = 0;
+			break;
+		}
+		if (code == -1)
+			flag_repeat = 0;
+	}
+	cache->busy = false;
+
+	return (code != 0) ? 1 : 0;
+}
+#endif
+
 /* most recursion does not come through here, the exeception is
  * from builtin_source() */
-static int parse_stream_outer(struct in_str *inp, int flag)
+static int parse_stream_outer(struct in_str *inp, int flag,
+			      struct parse_cache *cache)
 {
 
 	struct p_context ctx;
@@ -3203,8 +3351,18 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 #ifndef __U_BOOT__
 			run_list(ctx.list_head);
 #else
+#if CONFIG_IS_ENABLED(HUSH_PARSE_CACHE)
+			if (cache) {
+				code = run_list_real(ctx.list_head);
+				parse_cache_add(cache, ctx.list_head);
+			} else
+#endif
 			code = run_list(ctx.list_head);
 			if (code == -2) {	/* exit */
+#if CONFIG_IS_ENABLED(HUSH_PARSE_CACHE)
+				if (cache)
+					cache->failed = true;
+#endif
 				b_free(&temp);
 				code = 0;
 				/* XXX hackish way to not allow exit from main loop */
@@ -3225,6 +3383,10 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 #ifdef __U_BOOT__
 			if (inp->__promptme == 0) printf("<INTERRUPT>\n");
 			inp->__promptme = 1;
+#if CONFIG_IS_ENABLED(HUSH_PARSE_CACHE)
+			if (cache)
+				cache->failed = true;
+#endif
 #endif
 			temp.nonnull = 0;
 			temp.quote = 0;
@@ -3250,26 +3412,45 @@ int parse_string_outer(const char *s, int flag)
 {
 	struct in_str input;
 #ifdef __U_BOOT__
+	struct parse_cache *cache = NULL;
 	char *p = NULL;
 	int rcode;
 	if (!s)
 		return 1;
 	if (!*s)
 		return 0;
+#if CONFIG_IS_ENABLED(HUSH_PARSE_CACHE)
+	if (flag & FLAG_CACHE_PARSE) {
+		flag &= ~FLAG_CACHE_PARSE;
+		cache = parse_cache_get(s, flag);
+		if (cache && cache->count)
+			return parse_cache_run(cache);
+		if (cache)
+			cache->busy = true;
+	}
+#endif
 	if (!(p = strchr(s, '\n')) || *++p) {
 		p = xmalloc(strlen(s) + 2);
 		strcpy(p, s);
 		strcat(p, "\n");
 		setup_string_in_str(&input, p);
-		rcode = parse_stream_outer(&input, flag);
+		rcode = parse_stream_outer(&input, flag, cache);
 		free(p);
-		return rcode;
 	} else {
+		setup_string_in_str(&input, s);
+		rcode = parse_stream_outer(&input, flag, cache);
+	}
+#if CONFIG_IS_ENABLED(HUSH_PARSE_CACHE)
+	if (cache) {
+		cache->busy = false;
+		if (cache->failed || !cache->count)
+			parse_cache_free(cache);
+	}
 #endif
+	return rcode;
+#else
 	setup_string_in_str(&input, s);
-	return parse_stream_outer(&input, flag);
-#ifdef __U_BOOT__
-	}
+	return parse_stream_outer(&input, flag, NULL);
 #endif
 }
 
@@ -3286,7 +3467,7 @@ int parse_file_outer(void)
 #else
 	setup_file_in_str(&input);
 #endif
-	rcode = parse_stream_outer(&input, FLAG_PARSE_SEMICOLON);
+	rcode = parse_stream_outer(&input, FLAG_PARSE_SEMICOLON, NULL);
 	return rcode;
 }
 
@@ -14,6 +14,8 @@
 #include <console.h>
 #include <env.h>
 #include <log.h>
+#include <malloc.h>
+#include <sort.h>
 #include <asm/global_data.h>
 #include <linux/ctype.h>
 
@@ -87,6 +89,85 @@ int _do_help(struct cmd_tbl *cmd_start, int cmd_items, struct cmd_tbl *cmdtp,
 	return rcode;
 }
 
+#ifdef CONFIG_CMDLINE
+/* Command linker list sorted by name, NULL until it is built */
+static struct cmd_tbl **cmd_index;
+
+static int cmd_index_cmp(const void *a, const void *b)
+{
+	const struct cmd_tbl *const *cmd_a = a;
+	const struct cmd_tbl *const *cmd_b = b;
+
+	return strcmp((*cmd_a)->name, (*cmd_b)->name);
+}
+
+/**
+ * cmd_get_index() - Get the sorted index of the command linker list
+ *
+ * The index is built on first use after relocation, when malloc() is up.
+ *
+ * @table: Start of the command linker list
+ * @table_len: Number of commands in the list
+ * Return: index, or NULL if it is not available
+ */
+static struct cmd_tbl **cmd_get_index(struct cmd_tbl *table, int table_len)
+{
+	int i;
+
+	if (cmd_index || !(gd->flags & GD_FLG_RELOC))
+		return cmd_index;
+
+	cmd_index = malloc(table_len * sizeof(*cmd_index));
+	if (!cmd_index)
+		return NULL;
+	for (i = 0; i < table_len; i++)
+		cmd_index[i] = table + i;
+	qsort(cmd_index, table_len, sizeof(*cmd_index), cmd_index_cmp);
+
+	return cmd_index;
+}
+
+/**
+ * find_cmd_index() - Look up a command in the sorted index
+ *
+ * This matches exactly the commands that the linear search in find_cmd_tbl()
+ * finds, but with a binary search.
+ *
+ * @index: Sorted index
+ * @count: Number of entries in @index
+ * @cmd: Command name to look for
+ * @len: Number of characters of @cmd to compare
+ * Return: command, or NULL if not found or ambiguous
+ */
+static struct cmd_tbl *find_cmd_index(struct cmd_tbl **index, int count,
+				      const char *cmd, int len)
+{
+	int lo = 0, hi = count;
+
+	/* Find the first command not sorting before @cmd */
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (strncmp(index[mid]->name, cmd, len) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == count || strncmp(index[lo]->name, cmd, len))
+		return NULL;
+
+	/* A full match sorts before all longer names starting with it */
+	if (strlen(index[lo]->name) == len)
+		return index[lo];
+
+	/* Otherwise @cmd is an abbreviation, which must be unique */
+	if (lo + 1 < count && !strncmp(index[lo + 1]->name, cmd, len))
+		return NULL;
+
+	return index[lo];
+}
+#endif /* CONFIG_CMDLINE */
+
 /* find command table entry for a command */
 struct cmd_tbl *find_cmd_tbl(const char *cmd, struct cmd_tbl *table,
 			     int table_len)
@@ -94,6 +175,7 @@ struct cmd_tbl *find_cmd_tbl(const char *cmd, struct cmd_tbl *table,
 #ifdef CONFIG_CMDLINE
 	struct cmd_tbl *cmdtp;
 	struct cmd_tbl *cmdtp_temp = table;	/* Init value */
+	struct cmd_tbl **index;
 	const char *p;
 	int len;
 	int n_found = 0;
@@ -106,6 +188,14 @@ struct cmd_tbl *find_cmd_tbl(const char *cmd, struct cmd_tbl *table,
 	 */
 	len = ((p = strchr(cmd, '.')) == NULL) ? strlen (cmd) : (p - cmd);
 
+	/* The main command table has a sorted index; sub-commands do not */
+	if (table == ll_entry_start(struct cmd_tbl, cmd) &&
+	    table_len == ll_entry_count(struct cmd_tbl, cmd)) {
+		index = cmd_get_index(table, table_len);
+		if (index)
+			return find_cmd_index(index, table_len, cmd, len);
+	}
+
 	for (cmdtp = table; cmdtp != table + table_len; cmdtp++) {
 		if (strncmp(cmd, cmdtp->name, len) == 0) {
 			if (len == strlen(cmdtp->name))
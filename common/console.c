@@ -364,6 +364,17 @@ static void console_puts(int file, const char *s)
 	}
 }
 
+static void console_flush(int file)
+{
+	int i;
+	struct stdio_dev *dev;
+
+	for_each_console_dev(i, file, dev) {
+		if (dev->flush != NULL)
+			dev->flush(dev);
+	}
+}
+
 #if CONFIG_IS_ENABLED(SYS_CONSOLE_IS_IN_ENV)
 static inline void console_doenv(int file, struct stdio_dev *dev)
 {
@@ -413,6 +424,12 @@ static inline void console_puts(int file, const char *s)
 	stdio_devices[file]->puts(stdio_devices[file], s);
 }
 
+static inline void console_flush(int file)
+{
+	if (stdio_devices[file]->flush)
+		stdio_devices[file]->flush(stdio_devices[file]);
+}
+
 #if CONFIG_IS_ENABLED(SYS_CONSOLE_IS_IN_ENV)
 static inline void console_doenv(int file, struct stdio_dev *dev)
 {
@@ -526,6 +543,12 @@ void fputs(int file, const char *s)
 		console_puts(file, s);
 }
 
+void fflush(int file)
+{
+	if (file < MAX_FILES)
+		console_flush(file);
+}
+
 int fprintf(int file, const char *fmt, ...)
 {
 	va_list args;
@@ -740,6 +763,23 @@ void puts(const char *s)
 	}
 }
 
+void flush(void)
+{
+	if (!gd)
+		return;
+
+	/* Output is only buffered once the serial console is up */
+	if (!(gd->flags & GD_FLG_SERIAL_READY) || !gd->have_console)
+		return;
+
+	if (gd->flags & GD_FLG_DEVINIT) {
+		fflush(stdout);
+		fflush(stderr);
+	} else {
+		serial_flush();
+	}
+}
+
 #ifdef CONFIG_CONSOLE_RECORD
 int console_record_init(void)
 {
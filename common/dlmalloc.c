@@ -18,6 +18,7 @@
 
 #include <malloc.h>
 #include <asm/io.h>
+#include <linux/errno.h>
 #include <valgrind/memcheck.h>
 
 #ifdef DEBUG
@@ -591,6 +592,7 @@ static inline void malloc_bin_reloc(void) {}
 #ifdef CONFIG_SYS_MALLOC_DEFAULT_TO_INIT
 static void malloc_init(void);
 #endif
+static void malloc_cache_init(void);
 
 ulong mem_malloc_start = 0;
 ulong mem_malloc_end = 0;
@@ -632,6 +634,7 @@ void mem_malloc_init(ulong start, ulong size)
 	memset((void *)mem_malloc_start, 0x0, size);
 #endif
 	malloc_bin_reloc();
+	malloc_cache_init();
 }
 
 /* field-extraction macros */
@@ -902,6 +905,180 @@ static void do_check_malloced_chunk(p, s) mchunkptr p; INTERNAL_SIZE_T s;
 
 
 
+/*
+  Size-class cache
+
+    Small chunks released by free() are kept on per-size-class LIFO
+    lists and handed straight back to the next malloc() of the same
+    padded size, skipping both the bin search in malloc() and the
+    coalescing in free(). Driver model allocates and releases large
+    numbers of small, identically-sized objects, which is the case this
+    is aimed at.
+
+    Cached chunks keep their in-use bit, so the rest of the allocator
+    (realloc, coalescing of neighbours, mallinfo) simply treats them as
+    allocated. Each list holds at most CONFIG_SYS_MALLOC_CACHE_DEPTH
+    chunks; further frees take the normal path. If malloc() runs out of
+    memory the lists are drained back into the bins and the request is
+    retried.
+*/
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_CACHE)
+
+#define MALLOC_CACHE_MAX      512
+#define MALLOC_CACHE_CLASSES  ((MALLOC_CACHE_MAX - MINSIZE) / MALLOC_ALIGNMENT + 1)
+#define cache_index(sz)       (((sz) - MINSIZE) / MALLOC_ALIGNMENT)
+#define in_cache_range(sz)    ((unsigned long)(sz) <= MALLOC_CACHE_MAX)
+
+struct malloc_cache {
+	mchunkptr head;		/* most recently cached chunk */
+	unsigned int count;	/* number of chunks on the list */
+	ulong requests;		/* malloc() calls mapping to this class */
+	ulong hits;		/* ... of which were served from the list */
+};
+
+static struct malloc_cache malloc_cache[MALLOC_CACHE_CLASSES];
+static bool malloc_cache_disabled;
+
+static void malloc_cache_init(void)
+{
+	memset(malloc_cache, '\0', sizeof(malloc_cache));
+}
+
+static mchunkptr malloc_cache_get(INTERNAL_SIZE_T nb)
+{
+	struct malloc_cache *mc = &malloc_cache[cache_index(nb)];
+	mchunkptr p = mc->head;
+
+	if (malloc_cache_disabled)
+		return NULL;
+
+	mc->requests++;
+	if (!p)
+		return NULL;
+
+	mc->head = p->fd;
+	mc->count--;
+	mc->hits++;
+	check_inuse_chunk(p);
+
+	return p;
+}
+
+static bool malloc_cache_put(mchunkptr p)
+{
+	INTERNAL_SIZE_T sz = chunksize(p);
+	struct malloc_cache *mc;
+
+	if (!in_cache_range(sz) || malloc_cache_disabled)
+		return false;
+
+	mc = &malloc_cache[cache_index(sz)];
+	if (mc->count >= CONFIG_SYS_MALLOC_CACHE_DEPTH)
+		return false;
+
+	p->fd = mc->head;
+	mc->head = p;
+	mc->count++;
+
+	return true;
+}
+
+/* Number of bytes held by the cache, setting *chunks to the chunk count */
+static ulong malloc_cache_size(ulong *chunks)
+{
+	ulong size = 0;
+	int i;
+
+	*chunks = 0;
+	for (i = 0; i < MALLOC_CACHE_CLASSES; i++) {
+		*chunks += malloc_cache[i].count;
+		size += malloc_cache[i].count * (MINSIZE + i * MALLOC_ALIGNMENT);
+	}
+
+	return size;
+}
+
+int malloc_cache_flush(void)
+{
+	bool disabled = malloc_cache_disabled;
+	struct malloc_cache *mc;
+	mchunkptr p;
+	int count = 0;
+
+	malloc_cache_disabled = true;
+	for (mc = malloc_cache; mc < malloc_cache + MALLOC_CACHE_CLASSES; mc++) {
+		while (mc->head) {
+			p = mc->head;
+			mc->head = p->fd;
+			mc->count--;
+			VALGRIND_MALLOCLIKE_BLOCK(chunk2mem(p), 0, SIZE_SZ, false);
+			fREe(chunk2mem(p));
+			count++;
+		}
+	}
+	malloc_cache_disabled = disabled;
+
+	return count;
+}
+
+bool malloc_cache_enable(bool enable)
+{
+	bool old = !malloc_cache_disabled;
+
+	if (!enable)
+		malloc_cache_flush();
+	malloc_cache_disabled = !enable;
+
+	return old;
+}
+
+int malloc_cache_class(int idx, struct malloc_class_info *info)
+{
+	struct malloc_cache *mc;
+
+	if (idx < 0 || idx >= MALLOC_CACHE_CLASSES)
+		return -ENOENT;
+
+	mc = &malloc_cache[idx];
+	info->size = MINSIZE + idx * MALLOC_ALIGNMENT;
+	info->requests = mc->requests;
+	info->hits = mc->hits;
+	info->cached = mc->count;
+
+	return 0;
+}
+
+#else
+
+static inline void malloc_cache_init(void) {}
+
+static inline ulong malloc_cache_size(ulong *chunks)
+{
+	*chunks = 0;
+
+	return 0;
+}
+
+int malloc_cache_flush(void)
+{
+	return 0;
+}
+
+bool malloc_cache_enable(bool enable)
+{
+	return false;
+}
+
+int malloc_cache_class(int idx, struct malloc_class_info *info)
+{
+	return -ENOENT;
+}
+
+#endif /* SYS_MALLOC_CACHE */
+
+
+
 /*
   Macro-based internal utilities
 */
@@ -1317,6 +1494,14 @@ Void_t* mALLOc(bytes) size_t bytes;
 
   nb = request2size(bytes);  /* padded request size; */
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_CACHE)
+  if (in_cache_range(nb) && (victim = malloc_cache_get(nb)))
+  {
+    VALGRIND_MALLOCLIKE_BLOCK(chunk2mem(victim), bytes, SIZE_SZ, false);
+    return chunk2mem(victim);
+  }
+#endif
+
   /* Check for exact match in a bin */
 
   if (is_small_request(nb))  /* Faster version for small requests */
@@ -1523,7 +1708,14 @@ Void_t* mALLOc(bytes) size_t bytes;
     /* Try to extend */
     malloc_extend_top(nb);
     if ( (remainder_size = chunksize(top) - nb) < (long)MINSIZE)
+    {
+#if CONFIG_IS_ENABLED(SYS_MALLOC_CACHE)
+      /* Give the cached chunks back to the bins and try again */
+      if (malloc_cache_flush())
+	return mALLOc(bytes);
+#endif
       return NULL; /* propagate failure */
+    }
   }
 
   victim = top;
@@ -1602,6 +1794,14 @@ void fREe(mem) Void_t* mem;
 
   check_inuse_chunk(p);
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_CACHE)
+  if (malloc_cache_put(p))
+  {
+    VALGRIND_FREELIKE_BLOCK(mem, SIZE_SZ);
+    return;
+  }
+#endif
+
   sz = hd & ~PREV_INUSE;
   next = chunk_at_offset(p, sz);
   nextsz = chunksize(next);
@@ -2343,6 +2543,7 @@ static void malloc_update_mallinfo()
 
   INTERNAL_SIZE_T avail = chunksize(top);
   int   navail = ((long)(avail) >= (long)MINSIZE)? 1 : 0;
+  ulong ncached;
 
   for (i = 1; i < NAV; ++i)
   {
@@ -2361,7 +2562,10 @@ static void malloc_update_mallinfo()
     }
   }
 
-  current_mallinfo.ordblks = navail;
+  /* Chunks held by the size-class cache are free as far as callers care */
+  avail += malloc_cache_size(&ncached);
+
+  current_mallinfo.ordblks = navail + ncached;
   current_mallinfo.uordblks = sbrked_mem - avail;
   current_mallinfo.fordblks = avail;
   current_mallinfo.hblks = n_mmaps;
@@ -2405,6 +2609,48 @@ void malloc_stats()
 }
 #endif	/* DEBUG */
 
+/*
+  malloc_get_info:
+
+    Fills in a summary of the state of the pool without the consistency
+    checks done by malloc_update_mallinfo(), so that it can be used in
+    non-debug builds. Chunks held by the size-class cache are counted
+    separately from the free chunks in the bins.
+*/
+
+void malloc_get_info(struct malloc_info *info)
+{
+  int i;
+  mbinptr b;
+  mchunkptr p;
+  INTERNAL_SIZE_T sz;
+
+  memset(info, '\0', sizeof(*info));
+  info->pool_size = mem_malloc_end - mem_malloc_start;
+  info->arena = sbrked_mem;
+  info->max_arena = max_total_mem;
+  if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+    return;
+
+  info->top_size = chunksize(top);
+  info->free = info->top_size;
+  info->largest_free = info->top_size;
+  for (i = 1; i < NAV; ++i)
+  {
+    b = bin_at(i);
+    for (p = last(b); p != b; p = p->bk)
+    {
+      sz = chunksize(p);
+      info->free += sz;
+      info->free_chunks++;
+      if (sz > info->largest_free)
+	info->largest_free = sz;
+    }
+  }
+
+  info->cached = malloc_cache_size(&info->cached_chunks);
+}
+
 /*
   mallinfo returns a copy of updated current mallinfo.
 */
@@ -21,6 +21,7 @@
 #include <exports.h>
 #include <fdtdec.h>
 #include <version.h>
+#include <dm/of_access.h>
 
 /**
  * fdt_getprop_u32_default_node - Return a node's property or a default
@@ -76,6 +77,73 @@ u32 fdt_getprop_u32_default(const void *fdt, const char *path,
 	return fdt_getprop_u32_default_node(fdt, off, 0, prop, dflt);
 }
 
+/*
+ * Fixups below work on the live tree of an FDT transaction when there is one
+ * open on the blob (see fdt_txn_begin()) and on the flat tree otherwise. A
+ * node is then a device_node or an offset in the blob. Without
+ * CONFIG_OF_FDT_TXN the device_node is always NULL.
+ */
+struct fixup_node {
+	void *fdt;
+	struct device_node *np;
+	int offset;
+};
+
+static int fixup_path(void *fdt, const char *path, struct fixup_node *node)
+{
+	struct device_node *root = fdt_txn_root(fdt);
+
+	node->fdt = fdt;
+	node->np = NULL;
+	if (root) {
+		node->np = fdt_txn_find_node(root, path);
+		return node->np ? 0 : -FDT_ERR_NOTFOUND;
+	}
+	node->offset = fdt_path_offset(fdt, path);
+
+	return node->offset < 0 ? node->offset : 0;
+}
+
+/* Find or create a subnode of the root node */
+static int fixup_root_subnode(void *fdt, const char *name,
+			      struct fixup_node *node)
+{
+	struct device_node *root = fdt_txn_root(fdt);
+
+	node->fdt = fdt;
+	node->np = NULL;
+	if (root) {
+		node->np = fdt_txn_add_subnode(root, name);
+		if (!node->np) {
+			printf("%s: %s: %s\n", __func__, name,
+			       fdt_strerror(-FDT_ERR_NOSPACE));
+			return -FDT_ERR_NOSPACE;
+		}
+		return 0;
+	}
+	node->offset = fdt_find_or_add_subnode(fdt, 0, name);
+
+	return node->offset < 0 ? node->offset : 0;
+}
+
+static const void *fixup_getprop(struct fixup_node *node, const char *name,
+				 int *lenp)
+{
+	if (CONFIG_IS_ENABLED(OF_FDT_TXN) && node->np)
+		return of_get_property(node->np, name, lenp);
+
+	return fdt_getprop(node->fdt, node->offset, name, lenp);
+}
+
+static int fixup_setprop(struct fixup_node *node, const char *name,
+			 const void *val, int len)
+{
+	if (CONFIG_IS_ENABLED(OF_FDT_TXN) && node->np)
+		return fdt_txn_setprop(node->np, name, val, len);
+
+	return fdt_setprop(node->fdt, node->offset, name, val, len);
+}
+
 /**
  * fdt_find_and_setprop: Find a node and set it's property
  *
@@ -91,15 +159,17 @@ u32 fdt_getprop_u32_default(const void *fdt, const char *path,
 int fdt_find_and_setprop(void *fdt, const char *node, const char *prop,
 			 const void *val, int len, int create)
 {
-	int nodeoff = fdt_path_offset(fdt, node);
+	struct fixup_node fnode;
+	int err;
 
-	if (nodeoff < 0)
-		return nodeoff;
+	err = fixup_path(fdt, node, &fnode);
+	if (err)
+		return err;
 
-	if ((!create) && (fdt_get_property(fdt, nodeoff, prop, NULL) == NULL))
+	if ((!create) && (fixup_getprop(&fnode, prop, NULL) == NULL))
 		return 0; /* create flag not set; so exit quietly */
 
-	return fdt_setprop(fdt, nodeoff, prop, val, len);
+	return fixup_setprop(&fnode, prop, val, len);
 }
 
 /**
@@ -128,10 +198,10 @@ int fdt_find_or_add_subnode(void *fdt, int parentoffset, const char *name)
 }
 
 #if defined(CONFIG_OF_STDOUT_VIA_ALIAS) && defined(CONFIG_CONS_INDEX)
-static int fdt_fixup_stdout(void *fdt, int chosenoff)
+static int fdt_fixup_stdout(struct fixup_node *chosen)
 {
 	int err;
-	int aliasoff;
+	struct fixup_node aliases;
 	char sername[9] = { 0 };
 	const void *path;
 	int len;
@@ -139,13 +209,11 @@ static int fdt_fixup_stdout(void *fdt, int chosenoff)
 
 	sprintf(sername, "serial%d", CONFIG_CONS_INDEX - 1);
 
-	aliasoff = fdt_path_offset(fdt, "/aliases");
-	if (aliasoff < 0) {
-		err = aliasoff;
+	err = fixup_path(chosen->fdt, "/aliases", &aliases);
+	if (err)
 		goto noalias;
-	}
 
-	path = fdt_getprop(fdt, aliasoff, sername, &len);
+	path = fixup_getprop(&aliases, sername, &len);
 	if (!path) {
 		err = len;
 		goto noalias;
@@ -154,7 +222,7 @@ static int fdt_fixup_stdout(void *fdt, int chosenoff)
 	/* fdt_setprop may break "path" so we copy it to tmp buffer */
 	memcpy(tmp, path, len);
 
-	err = fdt_setprop(fdt, chosenoff, "linux,stdout-path", tmp, len);
+	err = fixup_setprop(chosen, "linux,stdout-path", tmp, len);
 	if (err < 0)
 		printf("WARNING: could not set linux,stdout-path %s.\n",
 		       fdt_strerror(err));
@@ -168,19 +236,22 @@ noalias:
 	return 0;
 }
 #else
-static int fdt_fixup_stdout(void *fdt, int chosenoff)
+static int fdt_fixup_stdout(struct fixup_node *chosen)
 {
 	return 0;
 }
 #endif
 
-static inline int fdt_setprop_uxx(void *fdt, int nodeoffset, const char *name,
+static inline int fdt_setprop_uxx(struct fixup_node *node, const char *name,
 				  uint64_t val, int is_u64)
 {
+	fdt64_t tmp64 = cpu_to_fdt64(val);
+	fdt32_t tmp32 = cpu_to_fdt32(val);
+
 	if (is_u64)
-		return fdt_setprop_u64(fdt, nodeoffset, name, val);
+		return fixup_setprop(node, name, &tmp64, sizeof(tmp64));
 	else
-		return fdt_setprop_u32(fdt, nodeoffset, name, (uint32_t)val);
+		return fixup_setprop(node, name, &tmp32, sizeof(tmp32));
 }
 
 int fdt_root(void *fdt)
@@ -196,8 +267,12 @@ int fdt_root(void *fdt)
 
 	serial = env_get("serial#");
 	if (serial) {
-		err = fdt_setprop(fdt, 0, "serial-number", serial,
-				  strlen(serial) + 1);
+		struct fixup_node root;
+
+		err = fixup_path(fdt, "/", &root);
+		if (!err)
+			err = fixup_setprop(&root, "serial-number", serial,
+					    strlen(serial) + 1);
 
 		if (err < 0) {
 			printf("WARNING: could not set serial-number %s.\n",
@@ -211,7 +286,8 @@ int fdt_root(void *fdt)
 
 int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end)
 {
-	int   nodeoffset;
+	struct device_node *root = fdt_txn_root(fdt);
+	struct fixup_node chosen;
 	int   err, j, total;
 	int is_u64;
 	uint64_t addr, size;
@@ -221,33 +297,43 @@ int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end)
 		return 0;
 
 	/* find or create "/chosen" node. */
-	nodeoffset = fdt_find_or_add_subnode(fdt, 0, "chosen");
-	if (nodeoffset < 0)
-		return nodeoffset;
+	err = fixup_root_subnode(fdt, "chosen", &chosen);
+	if (err)
+		return err;
 
-	total = fdt_num_mem_rsv(fdt);
+	if (root) {
+		fdt_txn_del_mem_rsv(fdt, initrd_start);
+		err = fdt_txn_add_mem_rsv(fdt, initrd_start,
+					  initrd_end - initrd_start);
+	} else {
+		total = fdt_num_mem_rsv(fdt);
 
-	/*
-	 * Look for an existing entry and update it.  If we don't find
-	 * the entry, we will j be the next available slot.
-	 */
-	for (j = 0; j < total; j++) {
-		err = fdt_get_mem_rsv(fdt, j, &addr, &size);
-		if (addr == initrd_start) {
-			fdt_del_mem_rsv(fdt, j);
-			break;
+		/*
+		 * Look for an existing entry and update it.  If we don't find
+		 * the entry, we will j be the next available slot.
+		 */
+		for (j = 0; j < total; j++) {
+			err = fdt_get_mem_rsv(fdt, j, &addr, &size);
+			if (addr == initrd_start) {
+				fdt_del_mem_rsv(fdt, j);
+				break;
+			}
 		}
-	}
 
-	err = fdt_add_mem_rsv(fdt, initrd_start, initrd_end - initrd_start);
+		err = fdt_add_mem_rsv(fdt, initrd_start,
+				      initrd_end - initrd_start);
+	}
 	if (err < 0) {
 		printf("fdt_initrd: %s\n", fdt_strerror(err));
 		return err;
 	}
 
-	is_u64 = (fdt_address_cells(fdt, 0) == 2);
+	if (root)
+		is_u64 = (fdt_txn_address_cells(root) == 2);
+	else
+		is_u64 = (fdt_address_cells(fdt, 0) == 2);
 
-	err = fdt_setprop_uxx(fdt, nodeoffset, "linux,initrd-start",
+	err = fdt_setprop_uxx(&chosen, "linux,initrd-start",
 			      (uint64_t)initrd_start, is_u64);
 
 	if (err < 0) {
@@ -256,7 +342,7 @@ int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end)
 		return err;
 	}
 
-	err = fdt_setprop_uxx(fdt, nodeoffset, "linux,initrd-end",
+	err = fdt_setprop_uxx(&chosen, "linux,initrd-end",
 			      (uint64_t)initrd_end, is_u64);
 
 	if (err < 0) {
@@ -281,7 +367,7 @@ __weak char *board_fdt_chosen_bootargs(void)
 int fdt_chosen(void *fdt)
 {
 	struct abuf buf = {};
-	int   nodeoffset;
+	struct fixup_node chosen;
 	int   err;
 	char  *str;		/* used to set string properties */
 
@@ -292,13 +378,13 @@ int fdt_chosen(void *fdt)
 	}
 
 	/* find or create "/chosen" node. */
-	nodeoffset = fdt_find_or_add_subnode(fdt, 0, "chosen");
-	if (nodeoffset < 0)
-		return nodeoffset;
+	err = fixup_root_subnode(fdt, "chosen", &chosen);
+	if (err)
+		return err;
 
 	if (IS_ENABLED(CONFIG_BOARD_RNG_SEED) && !board_rng_seed(&buf)) {
-		err = fdt_setprop(fdt, nodeoffset, "rng-seed",
-				  abuf_data(&buf), abuf_size(&buf));
+		err = fixup_setprop(&chosen, "rng-seed",
+				    abuf_data(&buf), abuf_size(&buf));
 		abuf_uninit(&buf);
 		if (err < 0) {
 			printf("WARNING: could not set rng-seed %s.\n",
@@ -310,8 +396,8 @@ int fdt_chosen(void *fdt)
 	str = board_fdt_chosen_bootargs();
 
 	if (str) {
-		err = fdt_setprop(fdt, nodeoffset, "bootargs", str,
-				  strlen(str) + 1);
+		err = fixup_setprop(&chosen, "bootargs", str,
+				    strlen(str) + 1);
 		if (err < 0) {
 			printf("WARNING: could not set bootargs %s.\n",
 			       fdt_strerror(err));
@@ -320,15 +406,15 @@ int fdt_chosen(void *fdt)
 	}
 
 	/* add u-boot version */
-	err = fdt_setprop(fdt, nodeoffset, "u-boot,version", PLAIN_VERSION,
-			  strlen(PLAIN_VERSION) + 1);
+	err = fixup_setprop(&chosen, "u-boot,version", PLAIN_VERSION,
+			    strlen(PLAIN_VERSION) + 1);
 	if (err < 0) {
 		printf("WARNING: could not set u-boot,version %s.\n",
 		       fdt_strerror(err));
 		return err;
 	}
 
-	return fdt_fixup_stdout(fdt, nodeoffset);
+	return fdt_fixup_stdout(&chosen);
 }
 
 void do_fixup_by_path(void *fdt, const char *path, const char *prop,
@@ -359,6 +445,7 @@ void do_fixup_by_prop(void *fdt,
 		      const char *prop, const void *val, int len,
 		      int create)
 {
+	struct device_node *root, *np;
 	int off;
 #if defined(DEBUG)
 	int i;
@@ -367,6 +454,21 @@ void do_fixup_by_prop(void *fdt,
 		debug(" %.2x", *(u8*)(val+i));
 	debug("\n");
 #endif
+	root = fdt_txn_root(fdt);
+	if (root) {
+		for (np = root; np; np = of_find_all_nodes(np)) {
+			const void *p;
+			int p_len;
+
+			p = of_get_property(np, pname, &p_len);
+			if (!p || p_len != plen || memcmp(p, pval, plen))
+				continue;
+			if (create || of_find_property(np, prop, NULL))
+				fdt_txn_setprop(np, prop, val, len);
+		}
+		return;
+	}
+
 	off = fdt_node_offset_by_prop_value(fdt, -1, pname, pval, plen);
 	while (off != -FDT_ERR_NOTFOUND) {
 		if (create || (fdt_get_property(fdt, off, prop, NULL) != NULL))
@@ -386,6 +488,7 @@ void do_fixup_by_prop_u32(void *fdt,
 void do_fixup_by_compat(void *fdt, const char *compat,
 			const char *prop, const void *val, int len, int create)
 {
+	struct device_node *root, *np;
 	int off = -1;
 #if defined(DEBUG)
 	int i;
@@ -394,6 +497,22 @@ void do_fixup_by_compat(void *fdt, const char *compat,
 		debug(" %.2x", *(u8*)(val+i));
 	debug("\n");
 #endif
+	root = fdt_txn_root(fdt);
+	if (root) {
+		for (np = root; np; np = of_find_all_nodes(np)) {
+			const char *list;
+			int list_len;
+
+			list = of_get_property(np, "compatible", &list_len);
+			if (!list ||
+			    !fdt_stringlist_contains(list, list_len, compat))
+				continue;
+			if (create || of_find_property(np, prop, NULL))
+				fdt_txn_setprop(np, prop, val, len);
+		}
+		return;
+	}
+
 	fdt_for_each_node_by_compatible(off, fdt, -1, compat)
 		if (create || (fdt_get_property(fdt, off, prop, NULL) != NULL))
 			fdt_setprop(fdt, off, prop, val, len);
@@ -413,11 +532,19 @@ void do_fixup_by_compat_u32(void *fdt, const char *compat,
 static int fdt_pack_reg(const void *fdt, void *buf, u64 *address, u64 *size,
 			int n)
 {
+	struct device_node *root = fdt_txn_root(fdt);
 	int i;
-	int address_cells = fdt_address_cells(fdt, 0);
-	int size_cells = fdt_size_cells(fdt, 0);
+	int address_cells, size_cells;
 	char *p = buf;
 
+	if (root) {
+		address_cells = fdt_txn_address_cells(root);
+		size_cells = fdt_txn_size_cells(root);
+	} else {
+		address_cells = fdt_address_cells(fdt, 0);
+		size_cells = fdt_size_cells(fdt, 0);
+	}
+
 	for (i = 0; i < n; i++) {
 		if (address_cells == 2)
 			*(fdt64_t *)p = cpu_to_fdt64(address[i]);
@@ -460,7 +587,8 @@ static int fdt_pack_reg(const void *fdt, void *buf, u64 *address, u64 *size,
  */
 int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 {
-	int err, nodeoffset;
+	struct fixup_node memory;
+	int err;
 	int len, i;
 	u8 tmp[MEMORY_BANKS_MAX * 16]; /* Up to 64-bit address + 64-bit size */
 
@@ -478,12 +606,12 @@ int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 	}
 
 	/* find or create "/memory" node. */
-	nodeoffset = fdt_find_or_add_subnode(blob, 0, "memory");
-	if (nodeoffset < 0)
-			return nodeoffset;
+	err = fixup_root_subnode(blob, "memory", &memory);
+	if (err)
+		return err;
 
-	err = fdt_setprop(blob, nodeoffset, "device_type", "memory",
-			sizeof("memory"));
+	err = fixup_setprop(&memory, "device_type", "memory",
+			    sizeof("memory"));
 	if (err < 0) {
 		printf("WARNING: could not set %s %s.\n", "device_type",
 				fdt_strerror(err));
@@ -502,7 +630,7 @@ int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 
 	len = fdt_pack_reg(blob, tmp, start, size, banks);
 
-	err = fdt_setprop(blob, nodeoffset, "reg", tmp, len);
+	err = fixup_setprop(&memory, "reg", tmp, len);
 	if (err < 0) {
 		printf("WARNING: could not set %s %s.\n",
 				"reg", fdt_strerror(err));
@@ -513,7 +641,8 @@ int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks)
 
 int fdt_set_usable_memory(void *blob, u64 start[], u64 size[], int areas)
 {
-	int err, nodeoffset;
+	struct fixup_node memory;
+	int err;
 	int len;
 	u8 tmp[8 * 16]; /* Up to 64-bit address + 64-bit size */
 
@@ -530,13 +659,13 @@ int fdt_set_usable_memory(void *blob, u64 start[], u64 size[], int areas)
 	}
 
 	/* find or create "/memory" node. */
-	nodeoffset = fdt_find_or_add_subnode(blob, 0, "memory");
-	if (nodeoffset < 0)
-		return nodeoffset;
+	err = fixup_root_subnode(blob, "memory", &memory);
+	if (err)
+		return err;
 
 	len = fdt_pack_reg(blob, tmp, start, size, areas);
 
-	err = fdt_setprop(blob, nodeoffset, "linux,usable-memory", tmp, len);
+	err = fixup_setprop(&memory, "linux,usable-memory", tmp, len);
 	if (err < 0) {
 		printf("WARNING: could not set %s %s.\n",
 		       "reg", fdt_strerror(err));
@@ -560,29 +689,39 @@ void fdt_fixup_ethernet(void *fdt)
 	const char *path;
 	unsigned char mac_addr[ARP_HLEN];
 	int offset;
+	struct fixup_node aliases;
+	const struct property *pp = NULL;
 #ifdef FDT_SEQ_MACADDR_FROM_ENV
-	int nodeoff;
-	const struct fdt_property *fdt_prop;
+	struct fixup_node node;
+	const char *status;
 #endif
 
-	if (fdt_path_offset(fdt, "/aliases") < 0)
+	if (fixup_path(fdt, "/aliases", &aliases))
 		return;
 
 	/* Cycle through all aliases */
 	for (prop = 0; ; prop++) {
 		const char *name;
 
-		/* FDT might have been edited, recompute the offset */
-		offset = fdt_first_property_offset(fdt,
-			fdt_path_offset(fdt, "/aliases"));
-		/* Select property number 'prop' */
-		for (j = 0; j < prop; j++)
-			offset = fdt_next_property_offset(fdt, offset);
+		if (CONFIG_IS_ENABLED(OF_FDT_TXN) && aliases.np) {
+			pp = pp ? pp->next : aliases.np->properties;
+			if (!pp)
+				break;
+			name = pp->name;
+			path = pp->value;
+		} else {
+			/* FDT might have been edited, recompute the offset */
+			offset = fdt_first_property_offset(fdt,
+				fdt_path_offset(fdt, "/aliases"));
+			/* Select property number 'prop' */
+			for (j = 0; j < prop; j++)
+				offset = fdt_next_property_offset(fdt, offset);
 
-		if (offset < 0)
-			break;
+			if (offset < 0)
+				break;
 
-		path = fdt_getprop_by_offset(fdt, offset, &name, NULL);
+			path = fdt_getprop_by_offset(fdt, offset, &name, NULL);
+		}
 		if (!strncmp(name, "ethernet", 8)) {
 			/* Treat plain "ethernet" same as "ethernet0". */
 			if (!strcmp(name, "ethernet")
@@ -604,10 +743,10 @@ void fdt_fixup_ethernet(void *fdt)
 				continue;
 			}
 #ifdef FDT_SEQ_MACADDR_FROM_ENV
-			nodeoff = fdt_path_offset(fdt, path);
-			fdt_prop = fdt_get_property(fdt, nodeoff, "status",
-						    NULL);
-			if (fdt_prop && !strcmp(fdt_prop->data, "disabled"))
+			status = NULL;
+			if (!fixup_path(fdt, path, &node))
+				status = fixup_getprop(&node, "status", NULL);
+			if (status && !strcmp(status, "disabled"))
 				continue;
 			i++;
 #endif
@@ -1065,7 +1204,7 @@ void fdt_del_node_and_alias(void *blob, const char *alias)
 
 /* Max address size we deal with */
 #define OF_MAX_ADDR_CELLS	4
-#define OF_BAD_ADDR	FDT_ADDR_T_NONE
+#define FDT_BAD_ADDR	FDT_ADDR_T_NONE
 #define OF_CHECK_COUNTS(na, ns)	((na) > 0 && (na) <= OF_MAX_ADDR_CELLS && \
 			(ns) > 0)
 
@@ -1153,7 +1292,7 @@ static u64 of_bus_default_map(fdt32_t *addr, const fdt32_t *range,
 	debug("OF: default map, cp=%llx, s=%llx, da=%llx\n", cp, s, da);
 
 	if (da < cp || da >= (cp + s))
-		return OF_BAD_ADDR;
+		return FDT_BAD_ADDR;
 	return da - cp;
 }
 
@@ -1199,7 +1338,7 @@ static u64 of_bus_isa_map(fdt32_t *addr, const fdt32_t *range,
 
 	/* Check address type match */
 	if ((addr[0] ^ range[0]) & cpu_to_be32(1))
-		return OF_BAD_ADDR;
+		return FDT_BAD_ADDR;
 
 	cp = fdt_read_number(range + 1, na - 1);
 	s  = fdt_read_number(range + na + pna, ns);
@@ -1208,7 +1347,7 @@ static u64 of_bus_isa_map(fdt32_t *addr, const fdt32_t *range,
 	debug("OF: ISA map, cp=%llx, s=%llx, da=%llx\n", cp, s, da);
 
 	if (da < cp || da >= (cp + s))
-		return OF_BAD_ADDR;
+		return FDT_BAD_ADDR;
 	return da - cp;
 }
 
@@ -1271,7 +1410,7 @@ static int of_translate_one(const void *blob, int parent, struct of_bus *bus,
 	const fdt32_t *ranges;
 	int rlen;
 	int rone;
-	u64 offset = OF_BAD_ADDR;
+	u64 offset = FDT_BAD_ADDR;
 
 	/* Normally, an absence of a "ranges" property means we are
 	 * crossing a non-translatable boundary, and thus the addresses
@@ -1300,10 +1439,10 @@ static int of_translate_one(const void *blob, int parent, struct of_bus *bus,
 	rone = na + pna + ns;
 	for (; rlen >= rone; rlen -= rone, ranges += rone) {
 		offset = bus->map(addr, ranges, na, ns, pna);
-		if (offset != OF_BAD_ADDR)
+		if (offset != FDT_BAD_ADDR)
 			break;
 	}
-	if (offset == OF_BAD_ADDR) {
+	if (offset == FDT_BAD_ADDR) {
 		debug("OF: not found !\n");
 		return 1;
 	}
@@ -1334,7 +1473,7 @@ static u64 __of_translate_address(const void *blob, int node_offset,
 	struct of_bus *bus, *pbus;
 	fdt32_t addr[OF_MAX_ADDR_CELLS];
 	int na, ns, pna, pns;
-	u64 result = OF_BAD_ADDR;
+	u64 result = FDT_BAD_ADDR;
 
 	debug("OF: ** translation for device %s **\n",
 		fdt_get_name(blob, node_offset, NULL));
@@ -1826,7 +1965,7 @@ u64 fdt_get_base_address(const void *fdt, int node)
 
 	prop = fdt_getprop(fdt, node, "reg", &size);
 
-	return prop ? fdt_translate_address(fdt, node, prop) : OF_BAD_ADDR;
+	return prop ? fdt_translate_address(fdt, node, prop) : FDT_BAD_ADDR;
 }
 
 /*
@@ -2040,13 +2179,19 @@ int fdt_fixup_display(void *blob, const char *path, const char *display)
  */
 int fdt_overlay_apply_verbose(void *fdt, void *fdto)
 {
+	struct device_node *root = fdt_txn_root(fdt);
 	int err;
 	bool has_symbols;
 
-	err = fdt_path_offset(fdt, "/__symbols__");
-	has_symbols = err >= 0;
+	if (root) {
+		has_symbols = fdt_txn_find_node(root, "/__symbols__");
+		err = fdt_txn_overlay_apply(fdt, fdto);
+	} else {
+		err = fdt_path_offset(fdt, "/__symbols__");
+		has_symbols = err >= 0;
 
-	err = fdt_overlay_apply(fdt, fdto);
+		err = fdt_overlay_apply(fdt, fdto);
+	}
 	if (err < 0) {
 		printf("failed on fdt_overlay_apply(): %s\n",
 				fdt_strerror(err));
@@ -0,0 +1,886 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Batching of the device-tree fixups made before booting an OS
+ *
+ * Each property or node which libfdt adds to a flat tree moves the rest of
+ * the tree along, so a boot which applies many fixups to a large tree spends
+ * most of that time moving memory. A transaction instead expands the tree
+ * into a live tree on first use, lets the fixups edit that and writes the
+ * flat tree out once when it is committed.
+ *
+ * Property values and names of the unflattened tree point into the blob, so
+ * the blob must not be written with libfdt while the live tree exists. Code
+ * which only knows about the flat tree calls fdt_txn_sync() first.
+ */
+
+#define LOG_CATEGORY	LOGC_BOOT
+
+#include <common.h>
+#include <bootstage.h>
+#include <fdt_support.h>
+#include <log.h>
+#include <malloc.h>
+#include <of_live.h>
+#include <dm/of_access.h>
+#include <linux/libfdt.h>
+
+/**
+ * struct fdt_txn_alloc - header of a block allocated for the live tree
+ *
+ * Nodes and property values added to the live tree are allocated one by
+ * one and freed together when the transaction ends.
+ *
+ * @next: Next block
+ */
+struct fdt_txn_alloc {
+	struct fdt_txn_alloc *next;
+};
+
+/**
+ * struct fdt_txn - state of the FDT transaction
+ *
+ * @blob: Flat tree the transaction is open on, or NULL if none
+ * @root: Live tree, or NULL if it has not been unflattened yet
+ * @allocs: Blocks allocated for the live tree
+ * @rsv: Memory-reservation entries of the tree
+ * @rsv_count: Number of entries in @rsv
+ * @rsv_max: Number of entries allocated for @rsv
+ * @dirty: true if the live tree or @rsv were changed
+ * @failed: true if the live tree could not be used, so that fixups work on
+ *	the flat tree
+ */
+static struct fdt_txn {
+	void *blob;
+	struct device_node *root;
+	struct fdt_txn_alloc *allocs;
+	struct fdt_reserve_entry *rsv;
+	int rsv_count;
+	int rsv_max;
+	bool dirty;
+	bool failed;
+} txn;
+
+static void *txn_alloc(int size)
+{
+	struct fdt_txn_alloc *alloc;
+
+	alloc = malloc(sizeof(*alloc) + size);
+	if (!alloc)
+		return NULL;
+	alloc->next = txn.allocs;
+	txn.allocs = alloc;
+
+	return alloc + 1;
+}
+
+/* Free the live tree, keeping the transaction open */
+static void txn_drop(void)
+{
+	struct fdt_txn_alloc *alloc, *next;
+
+	for (alloc = txn.allocs; alloc; alloc = next) {
+		next = alloc->next;
+		free(alloc);
+	}
+	txn.allocs = NULL;
+	free(txn.root);
+	txn.root = NULL;
+	free(txn.rsv);
+	txn.rsv = NULL;
+	txn.rsv_count = 0;
+	txn.rsv_max = 0;
+	txn.dirty = false;
+}
+
+static int txn_unflatten(void)
+{
+	u64 addr, size;
+	int span, ret, i;
+
+	span = bootstage_span_start(BOOTSTAGE_SPAN_GENERAL, "fdt_unflatten");
+	ret = fdt_num_mem_rsv(txn.blob);
+	if (ret < 0)
+		goto out;
+	txn.rsv_count = ret;
+	txn.rsv_max = ret + 4;
+	txn.rsv = malloc(txn.rsv_max * sizeof(*txn.rsv));
+	if (!txn.rsv) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	for (i = 0; i < txn.rsv_count; i++) {
+		fdt_get_mem_rsv(txn.blob, i, &addr, &size);
+		txn.rsv[i].address = cpu_to_fdt64(addr);
+		txn.rsv[i].size = cpu_to_fdt64(size);
+	}
+
+	ret = unflatten_device_tree(txn.blob, &txn.root);
+out:
+	bootstage_span_end(span);
+	if (ret) {
+		log_debug("Cannot unflatten FDT (err=%d), fixing up flat tree\n",
+			  ret);
+		txn_drop();
+		txn.failed = true;
+	}
+
+	return ret;
+}
+
+static int txn_flatten(void)
+{
+	int size = fdt_totalsize(txn.blob);
+	int span, ret;
+	void *buf;
+
+	/* Names and values of the live tree may point into the blob */
+	buf = malloc(size);
+	if (!buf)
+		return -FDT_ERR_NOSPACE;
+
+	span = bootstage_span_start(BOOTSTAGE_SPAN_GENERAL, "fdt_flatten");
+	ret = of_live_flatten(txn.root, txn.blob, txn.rsv, txn.rsv_count, buf,
+			      size);
+	if (!ret)
+		memcpy(txn.blob, buf,
+		       fdt_off_dt_strings(buf) + fdt_size_dt_strings(buf));
+	bootstage_span_end(span);
+	free(buf);
+	if (ret) {
+		printf("Cannot write FDT fixups (err=%d)\n", ret);
+		return -FDT_ERR_NOSPACE;
+	}
+
+	return 0;
+}
+
+void fdt_txn_begin(void *blob)
+{
+	if (txn.blob) {
+		log_warning("Dropping unfinished FDT transaction on %p\n",
+			    txn.blob);
+		fdt_txn_abort(txn.blob);
+	}
+	txn.blob = blob;
+	txn.failed = false;
+}
+
+struct device_node *fdt_txn_root(const void *blob)
+{
+	if (!blob || blob != txn.blob || txn.failed)
+		return NULL;
+	if (!txn.root && txn_unflatten())
+		return NULL;
+
+	return txn.root;
+}
+
+int fdt_txn_sync(void *blob)
+{
+	int ret = 0;
+
+	if (!blob || blob != txn.blob || !txn.root)
+		return 0;
+	if (txn.dirty)
+		ret = txn_flatten();
+	txn_drop();
+
+	return ret;
+}
+
+int fdt_txn_commit(void *blob)
+{
+	int ret;
+
+	if (!blob || blob != txn.blob)
+		return 0;
+	ret = fdt_txn_sync(blob);
+	txn.blob = NULL;
+
+	return ret;
+}
+
+void fdt_txn_abort(void *blob)
+{
+	if (!blob || blob != txn.blob)
+		return;
+	txn_drop();
+	txn.blob = NULL;
+}
+
+/* Check a node name against a path component, as fdt_subnode_offset() does */
+static bool txn_name_eq(const struct device_node *np, const char *name,
+			int len)
+{
+	const char *p = strrchr(np->full_name, '/') + 1;
+
+	if (strncmp(p, name, len))
+		return false;
+
+	return !p[len] || (p[len] == '@' && !memchr(name, '@', len));
+}
+
+static struct device_node *txn_find_child(struct device_node *parent,
+					  const char *name, int len)
+{
+	struct device_node *np;
+
+	for (np = parent->child; np; np = np->sibling) {
+		if (txn_name_eq(np, name, len))
+			return np;
+	}
+
+	return NULL;
+}
+
+struct device_node *fdt_txn_find_node(struct device_node *root,
+				      const char *path)
+{
+	const char *end = path + strlen(path);
+	struct device_node *np = root;
+	const char *p = path;
+	const char *q;
+
+	if (*path != '/') {
+		const struct property *pp = NULL;
+		struct device_node *aliases;
+
+		/* The path starts with an alias, as with fdt_path_offset() */
+		q = strchrnul(path, '/');
+		aliases = txn_find_child(root, "aliases", strlen("aliases"));
+		if (aliases)
+			pp = aliases->properties;
+		for (; pp; pp = pp->next) {
+			if (!strncmp(pp->name, path, q - path) &&
+			    !pp->name[q - path])
+				break;
+		}
+		np = pp ? fdt_txn_find_node(root, pp->value) : NULL;
+		if (!np)
+			return NULL;
+		p = q;
+	}
+
+	while (p < end) {
+		while (*p == '/') {
+			if (++p == end)
+				return np;
+		}
+		q = strchrnul(p, '/');
+		np = txn_find_child(np, p, q - p);
+		if (!np)
+			return NULL;
+		p = q;
+	}
+
+	return np;
+}
+
+struct device_node *fdt_txn_add_subnode(struct device_node *parent,
+					const char *name)
+{
+	int len = strlen(name);
+	struct device_node *np;
+	int plen, nlen;
+	char *fn;
+
+	np = txn_find_child(parent, name, len);
+	if (np)
+		return np;
+
+	/* Children of the root node have no leading path */
+	plen = parent->parent ? strlen(parent->full_name) : 0;
+	nlen = strchrnul(name, '@') - name;
+	np = txn_alloc(sizeof(*np) + plen + len + nlen + 3);
+	if (!np)
+		return NULL;
+	memset(np, '\0', sizeof(*np));
+	fn = (char *)(np + 1);
+	memcpy(fn, parent->full_name, plen);
+	fn[plen] = '/';
+	strcpy(fn + plen + 1, name);
+	np->full_name = fn;
+	fn += plen + len + 2;
+	memcpy(fn, name, nlen);
+	fn[nlen] = '\0';
+	np->name = fn;
+	np->type = "<NULL>";
+
+	/* libfdt adds new nodes before the existing ones */
+	np->parent = parent;
+	np->sibling = parent->child;
+	parent->child = np;
+	txn.dirty = true;
+
+	return np;
+}
+
+/*
+ * Add or replace a property, leaving its value for the caller to fill in.
+ * Like libfdt, new properties come before the existing ones.
+ */
+static int txn_setprop_placeholder(struct device_node *np, const char *name,
+				   int len, void **valp)
+{
+	struct property *pp;
+	void *value;
+
+	value = txn_alloc(len);
+	if (!value)
+		return -FDT_ERR_NOSPACE;
+
+	for (pp = np->properties; pp; pp = pp->next) {
+		if (!strcmp(pp->name, name))
+			break;
+	}
+	if (!pp) {
+		pp = txn_alloc(sizeof(*pp) + strlen(name) + 1);
+		if (!pp)
+			return -FDT_ERR_NOSPACE;
+		pp->name = (char *)(pp + 1);
+		strcpy(pp->name, name);
+		pp->next = np->properties;
+		np->properties = pp;
+	}
+	pp->value = value;
+	pp->length = len;
+	txn.dirty = true;
+	*valp = value;
+
+	return 0;
+}
+
+int fdt_txn_setprop(struct device_node *np, const char *name, const void *val,
+		    int len)
+{
+	void *value;
+	int ret;
+
+	ret = txn_setprop_placeholder(np, name, len, &value);
+	if (ret)
+		return ret;
+	if (len)
+		memcpy(value, val, len);
+
+	if (len == sizeof(fdt32_t) &&
+	    (!strcmp(name, "phandle") || !strcmp(name, "linux,phandle")))
+		np->phandle = fdt32_to_cpu(*(fdt32_t *)value);
+
+	return 0;
+}
+
+/* Read a #address-cells or #size-cells property, as fdt_cells() does */
+static int txn_cells(const struct device_node *np, const char *name)
+{
+	const fdt32_t *val;
+	int len;
+	u32 cells;
+
+	val = of_get_property(np, name, &len);
+	if (!val)
+		return len;
+	if (len != sizeof(*val))
+		return -FDT_ERR_BADNCELLS;
+	cells = fdt32_to_cpu(*val);
+	if (cells > FDT_MAX_NCELLS)
+		return -FDT_ERR_BADNCELLS;
+
+	return cells;
+}
+
+int fdt_txn_address_cells(const struct device_node *np)
+{
+	int cells = txn_cells(np, "#address-cells");
+
+	if (!cells)
+		return -FDT_ERR_BADNCELLS;
+	if (cells == -FDT_ERR_NOTFOUND)
+		return 2;
+
+	return cells;
+}
+
+int fdt_txn_size_cells(const struct device_node *np)
+{
+	int cells = txn_cells(np, "#size-cells");
+
+	if (cells == -FDT_ERR_NOTFOUND)
+		return 1;
+
+	return cells;
+}
+
+int fdt_txn_add_mem_rsv(void *blob, u64 address, u64 size)
+{
+	struct fdt_reserve_entry *rsv;
+
+	if (!fdt_txn_root(blob))
+		return -FDT_ERR_BADSTATE;
+	if (txn.rsv_count == txn.rsv_max) {
+		rsv = realloc(txn.rsv, (txn.rsv_max + 4) * sizeof(*rsv));
+		if (!rsv)
+			return -FDT_ERR_NOSPACE;
+		txn.rsv = rsv;
+		txn.rsv_max += 4;
+	}
+	rsv = &txn.rsv[txn.rsv_count++];
+	rsv->address = cpu_to_fdt64(address);
+	rsv->size = cpu_to_fdt64(size);
+	txn.dirty = true;
+
+	return 0;
+}
+
+int fdt_txn_del_mem_rsv(void *blob, u64 address)
+{
+	int i;
+
+	if (!fdt_txn_root(blob))
+		return -FDT_ERR_BADSTATE;
+	for (i = 0; i < txn.rsv_count; i++) {
+		if (fdt64_to_cpu(txn.rsv[i].address) == address) {
+			memmove(&txn.rsv[i], &txn.rsv[i + 1],
+				(txn.rsv_count - i - 1) * sizeof(*txn.rsv));
+			txn.rsv_count--;
+			txn.dirty = true;
+			return 0;
+		}
+	}
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+#ifdef CONFIG_OF_LIBFDT_OVERLAY
+/*
+ * The overlay code below follows fdt_overlay_apply() step by step. The
+ * overlay is still adjusted in place with libfdt, only the base tree is
+ * live.
+ */
+
+static struct device_node *txn_find_phandle(struct device_node *root,
+					    u32 phandle)
+{
+	struct device_node *np;
+
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		if (np->phandle == phandle)
+			return np;
+	}
+
+	return NULL;
+}
+
+static int txn_overlay_phandle_add(void *fdto, int node, const char *name,
+				   u32 delta)
+{
+	const fdt32_t *val;
+	u32 adj_val;
+	int len;
+
+	val = fdt_getprop(fdto, node, name, &len);
+	if (!val)
+		return len == -FDT_ERR_NOTFOUND ? 0 : len;
+	if (len != sizeof(*val))
+		return -FDT_ERR_BADPHANDLE;
+
+	adj_val = fdt32_to_cpu(*val);
+	if (adj_val + delta < adj_val || adj_val + delta == (u32)-1)
+		return -FDT_ERR_NOPHANDLES;
+
+	return fdt_setprop_inplace_u32(fdto, node, name, adj_val + delta);
+}
+
+static int txn_overlay_adjust_phandles(void *fdto, u32 delta)
+{
+	int node, ret;
+
+	for (node = 0; node >= 0; node = fdt_next_node(fdto, node, NULL)) {
+		ret = txn_overlay_phandle_add(fdto, node, "phandle", delta);
+		if (!ret)
+			ret = txn_overlay_phandle_add(fdto, node,
+						      "linux,phandle", delta);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static int txn_overlay_update_refs(void *fdto, int tree_node, int fixup_node,
+				   u32 delta)
+{
+	int fixup_prop, fixup_child, tree_child;
+	int ret;
+
+	fdt_for_each_property_offset(fixup_prop, fdto, fixup_node) {
+		const fdt32_t *fixup_val;
+		const char *tree_val;
+		const char *name;
+		int fixup_len, tree_len, i;
+
+		fixup_val = fdt_getprop_by_offset(fdto, fixup_prop, &name,
+						  &fixup_len);
+		if (!fixup_val)
+			return fixup_len;
+		if (fixup_len % sizeof(u32))
+			return -FDT_ERR_BADOVERLAY;
+
+		tree_val = fdt_getprop(fdto, tree_node, name, &tree_len);
+		if (!tree_val)
+			return tree_len == -FDT_ERR_NOTFOUND ?
+				-FDT_ERR_BADOVERLAY : tree_len;
+
+		for (i = 0; i < fixup_len / sizeof(u32); i++) {
+			u32 poffset = fdt32_to_cpu(fixup_val[i]);
+			fdt32_t adj_val;
+
+			if (poffset + sizeof(adj_val) > tree_len)
+				return -FDT_ERR_BADOVERLAY;
+
+			/* phandles to fix up can be unaligned */
+			memcpy(&adj_val, tree_val + poffset, sizeof(adj_val));
+			adj_val = cpu_to_fdt32(fdt32_to_cpu(adj_val) + delta);
+			ret = fdt_setprop_inplace_namelen_partial(fdto,
+					tree_node, name, strlen(name), poffset,
+					&adj_val, sizeof(adj_val));
+			if (ret)
+				return ret;
+		}
+	}
+
+	fdt_for_each_subnode(fixup_child, fdto, fixup_node) {
+		tree_child = fdt_subnode_offset(fdto, tree_node,
+						fdt_get_name(fdto, fixup_child,
+							     NULL));
+		if (tree_child < 0)
+			return tree_child == -FDT_ERR_NOTFOUND ?
+				-FDT_ERR_BADOVERLAY : tree_child;
+		ret = txn_overlay_update_refs(fdto, tree_child, fixup_child,
+					      delta);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/* Resolve the phandles of one label in __fixups__ to the base tree */
+static int txn_overlay_fixup_phandle(struct device_node *root,
+				     struct device_node *symbols, void *fdto,
+				     int property)
+{
+	const char *value, *label, *symbol_path;
+	struct device_node *np;
+	fdt32_t phandle;
+	int len;
+
+	value = fdt_getprop_by_offset(fdto, property, &label, &len);
+	if (!value)
+		return len == -FDT_ERR_NOTFOUND ? -FDT_ERR_INTERNAL : len;
+
+	symbol_path = symbols ? of_get_property(symbols, label, NULL) : NULL;
+	np = symbol_path ? fdt_txn_find_node(root, symbol_path) : NULL;
+	if (!np || !np->phandle)
+		return -FDT_ERR_NOTFOUND;
+	phandle = cpu_to_fdt32(np->phandle);
+
+	do {
+		const char *path, *name, *fixup_end, *sep;
+		int path_len, name_len, fixup_len;
+		int poffset, fixup_off, ret;
+		char *endptr;
+
+		/* Each entry is "<path>:<property>:<offset>" */
+		fixup_end = memchr(value, '\0', len);
+		if (!fixup_end)
+			return -FDT_ERR_BADOVERLAY;
+		fixup_len = fixup_end - value;
+		path = value;
+		len -= fixup_len + 1;
+		value += fixup_len + 1;
+
+		sep = memchr(path, ':', fixup_len);
+		if (!sep)
+			return -FDT_ERR_BADOVERLAY;
+		path_len = sep - path;
+		if (path_len == fixup_len - 1)
+			return -FDT_ERR_BADOVERLAY;
+
+		fixup_len -= path_len + 1;
+		name = sep + 1;
+		sep = memchr(name, ':', fixup_len);
+		if (!sep)
+			return -FDT_ERR_BADOVERLAY;
+		name_len = sep - name;
+		if (!name_len)
+			return -FDT_ERR_BADOVERLAY;
+
+		poffset = simple_strtoul(sep + 1, &endptr, 10);
+		if (*endptr || endptr <= sep + 1)
+			return -FDT_ERR_BADOVERLAY;
+
+		fixup_off = fdt_path_offset_namelen(fdto, path, path_len);
+		if (fixup_off < 0)
+			return fixup_off == -FDT_ERR_NOTFOUND ?
+				-FDT_ERR_BADOVERLAY : fixup_off;
+		ret = fdt_setprop_inplace_namelen_partial(fdto, fixup_off, name,
+							  name_len, poffset,
+							  &phandle,
+							  sizeof(phandle));
+		if (ret)
+			return ret;
+	} while (len > 0);
+
+	return 0;
+}
+
+static int txn_overlay_fixup_phandles(struct device_node *root, void *fdto)
+{
+	struct device_node *symbols;
+	int fixups, property, ret;
+
+	fixups = fdt_path_offset(fdto, "/__fixups__");
+	if (fixups == -FDT_ERR_NOTFOUND)
+		return 0;
+	if (fixups < 0)
+		return fixups;
+
+	symbols = fdt_txn_find_node(root, "/__symbols__");
+	fdt_for_each_property_offset(property, fdto, fixups) {
+		ret = txn_overlay_fixup_phandle(root, symbols, fdto, property);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/* Find the node in the base tree which a fragment applies to */
+static int txn_overlay_target(struct device_node *root, const void *fdto,
+			      int fragment, struct device_node **npp,
+			      const char **pathp)
+{
+	const char *path = NULL;
+	const fdt32_t *val;
+	u32 phandle = 0;
+	int len;
+
+	val = fdt_getprop(fdto, fragment, "target", &len);
+	if (val) {
+		if (len != sizeof(*val) || fdt32_to_cpu(*val) == (u32)-1)
+			return -FDT_ERR_BADPHANDLE;
+		phandle = fdt32_to_cpu(*val);
+	}
+
+	if (phandle) {
+		*npp = txn_find_phandle(root, phandle);
+	} else {
+		path = fdt_getprop(fdto, fragment, "target-path", &len);
+		if (!path)
+			return len == -FDT_ERR_NOTFOUND ?
+				-FDT_ERR_BADOVERLAY : len;
+		*npp = fdt_txn_find_node(root, path);
+	}
+	if (!*npp)
+		return -FDT_ERR_NOTFOUND;
+	if (pathp)
+		*pathp = path;
+
+	return 0;
+}
+
+static int txn_overlay_apply_node(struct device_node *target,
+				  const void *fdto, int node)
+{
+	struct device_node *np;
+	int property, subnode;
+	int len, ret;
+
+	fdt_for_each_property_offset(property, fdto, node) {
+		const char *name;
+		const void *val;
+
+		val = fdt_getprop_by_offset(fdto, property, &name, &len);
+		if (!val)
+			return len == -FDT_ERR_NOTFOUND ?
+				-FDT_ERR_INTERNAL : len;
+		ret = fdt_txn_setprop(target, name, val, len);
+		if (ret)
+			return ret;
+	}
+
+	fdt_for_each_subnode(subnode, fdto, node) {
+		np = fdt_txn_add_subnode(target,
+					 fdt_get_name(fdto, subnode, NULL));
+		if (!np)
+			return -FDT_ERR_NOSPACE;
+		ret = txn_overlay_apply_node(np, fdto, subnode);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static int txn_overlay_merge(struct device_node *root, const void *fdto)
+{
+	struct device_node *target;
+	int fragment, overlay, ret;
+
+	fdt_for_each_subnode(fragment, fdto, 0) {
+		/* Fragments without an __overlay__ node are not merged */
+		overlay = fdt_subnode_offset(fdto, fragment, "__overlay__");
+		if (overlay == -FDT_ERR_NOTFOUND)
+			continue;
+		if (overlay < 0)
+			return overlay;
+
+		ret = txn_overlay_target(root, fdto, fragment, &target, NULL);
+		if (ret)
+			return ret;
+		ret = txn_overlay_apply_node(target, fdto, overlay);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/* Add the overlay's symbols to the base tree, with their merged paths */
+static int txn_overlay_symbols(struct device_node *root, const void *fdto)
+{
+	struct device_node *symbols, *target;
+	const char *path, *name, *s, *e;
+	const char *frag_name, *rel_path, *target_path;
+	int ov_sym, prop, path_len, fragment;
+	int len, frag_name_len, rel_path_len, ret;
+	char *buf;
+
+	ov_sym = fdt_subnode_offset(fdto, 0, "__symbols__");
+	if (ov_sym < 0)
+		return 0;
+
+	symbols = fdt_txn_add_subnode(root, "__symbols__");
+	if (!symbols)
+		return -FDT_ERR_NOSPACE;
+
+	fdt_for_each_property_offset(prop, fdto, ov_sym) {
+		path = fdt_getprop_by_offset(fdto, prop, &name, &path_len);
+		if (!path)
+			return path_len;
+		if (path_len < 1 ||
+		    memchr(path, '\0', path_len) != &path[path_len - 1])
+			return -FDT_ERR_BADVALUE;
+		if (*path != '/')
+			return -FDT_ERR_BADVALUE;
+		e = path + path_len;
+
+		/* Only symbols within an __overlay__ end up in the tree */
+		s = strchr(path + 1, '/');
+		if (!s)
+			continue;
+		frag_name = path + 1;
+		frag_name_len = s - path - 1;
+
+		len = sizeof("/__overlay__/") - 1;
+		if (e - s > len && !memcmp(s, "/__overlay__/", len)) {
+			rel_path = s + len;
+			rel_path_len = e - rel_path;
+		} else if (e - s == len && !memcmp(s, "/__overlay__", len - 1)) {
+			rel_path = "";
+			rel_path_len = 1;
+		} else {
+			continue;
+		}
+
+		fragment = fdt_subnode_offset_namelen(fdto, 0, frag_name,
+						      frag_name_len);
+		if (fragment < 0 ||
+		    fdt_subnode_offset(fdto, fragment, "__overlay__") < 0)
+			return -FDT_ERR_BADOVERLAY;
+
+		ret = txn_overlay_target(root, fdto, fragment, &target,
+					 &target_path);
+		if (ret)
+			return ret;
+		if (!target_path)
+			target_path = target->full_name;
+
+		/* The root node is "/", so do not add another '/' after it */
+		len = strlen(target_path);
+		ret = txn_setprop_placeholder(symbols, name,
+					      len + (len > 1) + rel_path_len,
+					      (void **)&buf);
+		if (ret)
+			return ret;
+		if (len > 1)
+			memcpy(buf, target_path, len);
+		else
+			len--;
+		buf[len] = '/';
+		memcpy(buf + len + 1, rel_path, rel_path_len);
+	}
+
+	return 0;
+}
+
+int fdt_txn_overlay_apply(void *blob, void *fdto)
+{
+	struct device_node *root, *np;
+	u32 delta = 0;
+	int fixups, ret;
+
+	root = fdt_txn_root(blob);
+	if (!root)
+		return -FDT_ERR_BADSTATE;
+	ret = fdt_check_header(fdto);
+	if (ret)
+		return ret;
+
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		if (np->phandle == (u32)-1) {
+			ret = -FDT_ERR_BADPHANDLE;
+			goto err;
+		}
+		delta = max(delta, np->phandle);
+	}
+
+	ret = txn_overlay_adjust_phandles(fdto, delta);
+	if (ret)
+		goto err;
+
+	fixups = fdt_path_offset(fdto, "/__local_fixups__");
+	if (fixups >= 0)
+		ret = txn_overlay_update_refs(fdto, 0, fixups, delta);
+	else if (fixups != -FDT_ERR_NOTFOUND)
+		ret = fixups;
+	if (ret)
+		goto err;
+
+	ret = txn_overlay_fixup_phandles(root, fdto);
+	if (ret)
+		goto err;
+
+	ret = txn_overlay_merge(root, fdto);
+	if (ret)
+		goto err;
+
+	ret = txn_overlay_symbols(root, fdto);
+	if (ret)
+		goto err;
+
+	/* The overlay has been changed in place, so cannot be used again */
+	fdt_set_magic(fdto, ~0);
+
+	return 0;
+
+err:
+	/* As with fdt_overlay_apply(), neither tree can be trusted now */
+	fdt_set_magic(fdto, ~0);
+	txn_drop();
+	txn.failed = true;
+	fdt_set_magic(blob, ~0);
+
+	return ret;
+}
+#endif /* CONFIG_OF_LIBFDT_OVERLAY */
@@ -370,6 +370,17 @@ int hash_lookup_algo(const char *algo_name, struct hash_algo **algop)
 	return -EPROTONOSUPPORT;
 }
 
+int hash_get_algo(int index, struct hash_algo **algop)
+{
+	reloc_update();
+
+	if (index < 0 || index >= ARRAY_SIZE(hash_algo))
+		return -ENOENT;
+	*algop = &hash_algo[index];
+
+	return 0;
+}
+
 int hash_progressive_lookup_algo(const char *algo_name,
 				 struct hash_algo **algop)
 {
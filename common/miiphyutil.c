@@ -14,6 +14,7 @@
 #include <log.h>
 #include <miiphy.h>
 #include <phy.h>
+#include <time.h>
 #include <linux/delay.h>
 
 #include <asm/types.h>
@@ -151,9 +152,15 @@ void mdio_list_devices(void)
 				printf("%x - %s", i, phydev->drv->name);
 
 				if (phydev->dev)
-					printf(" <--> %s\n", phydev->dev->name);
-				else
-					printf("\n");
+					printf(" <--> %s", phydev->dev->name);
+
+				if (phy_poll_link(phydev) == -EINPROGRESS)
+					printf(", autoneg running for %lu ms",
+					       get_timer(phydev->aneg_start));
+				else if (phydev->aneg_time)
+					printf(", autoneg took %lu ms",
+					       phydev->aneg_time);
+				printf("\n");
 			}
 		}
 	}
@@ -232,7 +232,8 @@ void dev_print (struct blk_desc *dev_desc)
 
 #ifdef CONFIG_HAVE_BLOCK_DEVICE
 
-void part_init(struct blk_desc *dev_desc)
+/* Find the partition type, e.g. after selecting another hw partition */
+static void part_init_type(struct blk_desc *dev_desc)
 {
 	struct part_driver *drv =
 		ll_entry_start(struct part_driver, part_driver);
@@ -254,6 +255,13 @@ void part_init(struct blk_desc *dev_desc)
 	}
 }
 
+void part_init(struct blk_desc *dev_desc)
+{
+	/* The media may have changed, so read the GPT again */
+	gpt_cache_invalidate(dev_desc, 0, 0);
+	part_init_type(dev_desc);
+}
+
 static void print_part_header(const char *type, struct blk_desc *dev_desc)
 {
 #if CONFIG_IS_ENABLED(MAC_PARTITION) || \
@@ -428,10 +436,11 @@ int blk_get_device_by_str(const char *ifname, const char *dev_hwpart_str,
 	/*
 	 * Updates the partition table for the specified hw partition.
 	 * Always should be done, otherwise hw partition 0 will return stale
-	 * data after displaying a non-zero hw partition.
+	 * data after displaying a non-zero hw partition. A GPT is kept for
+	 * each hw partition, so it need not be read again.
 	 */
 	if ((*dev_desc)->if_type == IF_TYPE_MMC)
-		part_init(*dev_desc);
+		part_init_type(*dev_desc);
 #endif
 
 cleanup:
@@ -26,6 +26,7 @@
 #include <dm/ofnode.h>
 #include <linux/compiler.h>
 #include <linux/ctype.h>
+#include <linux/list.h>
 #include <u-boot/crc.h>
 
 #ifdef CONFIG_HAVE_BLOCK_DEVICE
@@ -61,6 +62,141 @@ static int is_pte_valid(gpt_entry * pte);
 static int find_valid_gpt(struct blk_desc *dev_desc, gpt_header *gpt_head,
 			  gpt_entry **pgpt_pte);
 
+#if CONFIG_IS_ENABLED(EFI_PARTITION_CACHE)
+/*
+ * Validated GPTs, one per device and hardware partition. Reading the table
+ * means reading and checking the CRC of up to 128 entries, which used to be
+ * done for every single partition lookup.
+ */
+struct gpt_cache_node {
+	struct list_head lh;
+	int iftype;
+	int devnum;
+	int hwpart;
+	gpt_header head;
+	gpt_entry *pte;
+};
+
+static LIST_HEAD(gpt_cache);
+static struct {
+	ulong hits;
+	ulong misses;
+} gpt_cache_stats;
+
+static struct gpt_cache_node *gpt_cache_find(struct blk_desc *dev_desc)
+{
+	struct gpt_cache_node *node;
+
+	list_for_each_entry(node, &gpt_cache, lh) {
+		if (node->iftype == dev_desc->if_type &&
+		    node->devnum == dev_desc->devnum &&
+		    node->hwpart == dev_desc->hwpart)
+			return node;
+	}
+
+	return NULL;
+}
+
+static void gpt_cache_drop(struct gpt_cache_node *node)
+{
+	list_del(&node->lh);
+	free(node->pte);
+	free(node);
+}
+
+void gpt_cache_invalidate(struct blk_desc *dev_desc, lbaint_t start,
+			  lbaint_t blkcnt)
+{
+	struct gpt_cache_node *node, *n;
+	lbaint_t end = start + blkcnt, pte_start, pte_end;
+
+	list_for_each_entry_safe(node, n, &gpt_cache, lh) {
+		if (node->iftype != dev_desc->if_type ||
+		    node->devnum != dev_desc->devnum)
+			continue;
+		if (blkcnt) {
+			if (node->hwpart != dev_desc->hwpart)
+				continue;
+			/* The tables live outside the usable blocks */
+			pte_start = le64_to_cpu(node->head.partition_entry_lba);
+			pte_end = pte_start + BLOCK_CNT(
+				le32_to_cpu(node->head.num_partition_entries) *
+				le32_to_cpu(node->head.sizeof_partition_entry),
+				dev_desc);
+			if (start >= le64_to_cpu(node->head.first_usable_lba) &&
+			    end <= le64_to_cpu(node->head.last_usable_lba) + 1 &&
+			    (end <= pte_start || start >= pte_end))
+				continue;
+		}
+		gpt_cache_drop(node);
+	}
+}
+
+/**
+ * gpt_get() - get the valid GPT header and PTEs of a device
+ *
+ * This is find_valid_gpt() with the result kept until the table is written
+ * or the device is initialised again.
+ *
+ * gpt is a GPT header ptr, filled on return.
+ * ptes is a PTEs ptr, filled on return; release it with gpt_put().
+ *
+ * Description: returns 1 if found a valid gpt,  0 on error.
+ */
+static int gpt_get(struct blk_desc *dev_desc, gpt_header *gpt_head,
+		   gpt_entry **pgpt_pte)
+{
+	struct gpt_cache_node *node;
+
+	node = gpt_cache_find(dev_desc);
+	if (node) {
+		gpt_cache_stats.hits++;
+		memcpy(gpt_head, &node->head, sizeof(node->head));
+		*pgpt_pte = node->pte;
+		return 1;
+	}
+
+	gpt_cache_stats.misses++;
+	if (find_valid_gpt(dev_desc, gpt_head, pgpt_pte) != 1)
+		return 0;
+
+	/* Without memory for the node, the caller simply owns the PTEs */
+	node = malloc(sizeof(*node));
+	if (node) {
+		node->iftype = dev_desc->if_type;
+		node->devnum = dev_desc->devnum;
+		node->hwpart = dev_desc->hwpart;
+		memcpy(&node->head, gpt_head, sizeof(node->head));
+		node->pte = *pgpt_pte;
+		list_add(&node->lh, &gpt_cache);
+	}
+
+	return 1;
+}
+
+static void gpt_put(gpt_entry *gpt_pte)
+{
+	struct gpt_cache_node *node;
+
+	list_for_each_entry(node, &gpt_cache, lh) {
+		if (node->pte == gpt_pte)
+			return;
+	}
+	free(gpt_pte);
+}
+#else
+static int gpt_get(struct blk_desc *dev_desc, gpt_header *gpt_head,
+		   gpt_entry **pgpt_pte)
+{
+	return find_valid_gpt(dev_desc, gpt_head, pgpt_pte);
+}
+
+static void gpt_put(gpt_entry *gpt_pte)
+{
+	free(gpt_pte);
+}
+#endif
+
 static char *print_efiname(gpt_entry *pte)
 {
 	static char name[PARTNAME_SZ + 1];
@@ -205,14 +341,14 @@ int get_disk_guid(struct blk_desc * dev_desc, char *guid)
 	unsigned char *guid_bin;
 
 	/* This function validates AND fills in the GPT header and PTE */
-	if (find_valid_gpt(dev_desc, gpt_head, &gpt_pte) != 1)
+	if (gpt_get(dev_desc, gpt_head, &gpt_pte) != 1)
 		return -EINVAL;
 
 	guid_bin = gpt_head->disk_guid.b;
 	uuid_bin_to_str(guid_bin, guid, UUID_STR_FORMAT_GUID);
 
-	/* Remember to free pte */
-	free(gpt_pte);
+	/* Remember to put pte */
+	gpt_put(gpt_pte);
 	return 0;
 }
 
@@ -224,7 +360,7 @@ void part_print_efi(struct blk_desc *dev_desc)
 	unsigned char *uuid;
 
 	/* This function validates AND fills in the GPT header and PTE */
-	if (find_valid_gpt(dev_desc, gpt_head, &gpt_pte) != 1)
+	if (gpt_get(dev_desc, gpt_head, &gpt_pte) != 1)
 		return;
 
 	debug("%s: gpt-entry at %p\n", __func__, gpt_pte);
@@ -253,8 +389,13 @@ void part_print_efi(struct blk_desc *dev_desc)
 		printf("\tguid:\t%pUl\n", uuid);
 	}
 
-	/* Remember to free pte */
-	free(gpt_pte);
+#if CONFIG_IS_ENABLED(EFI_PARTITION_CACHE)
+	log_debug("GPT cache: %lu hits, %lu misses\n", gpt_cache_stats.hits,
+		  gpt_cache_stats.misses);
+#endif
+
+	/* Remember to put pte */
+	gpt_put(gpt_pte);
 	return;
 }
 
@@ -271,14 +412,14 @@ int part_get_info_efi(struct blk_desc *dev_desc, int part,
 	}
 
 	/* This function validates AND fills in the GPT header and PTE */
-	if (find_valid_gpt(dev_desc, gpt_head, &gpt_pte) != 1)
+	if (gpt_get(dev_desc, gpt_head, &gpt_pte) != 1)
 		return -1;
 
 	if (part > le32_to_cpu(gpt_head->num_partition_entries) ||
 	    !is_pte_valid(&gpt_pte[part - 1])) {
 		debug("%s: *** ERROR: Invalid partition number %d ***\n",
 			__func__, part);
-		free(gpt_pte);
+		gpt_put(gpt_pte);
 		return -1;
 	}
 
@@ -305,8 +446,8 @@ int part_get_info_efi(struct blk_desc *dev_desc, int part,
 	debug("%s: start 0x" LBAF ", size 0x" LBAF ", name %s\n", __func__,
 	      info->start, info->size, info->name);
 
-	/* Remember to free pte */
-	free(gpt_pte);
+	/* Remember to put pte */
+	gpt_put(gpt_pte);
 	return 0;
 }
 
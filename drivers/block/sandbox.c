@@ -88,6 +88,51 @@ static unsigned long host_block_write(struct blk_desc *block_dev,
 	return -1;
 }
 
+/* Number of zeroed blocks written at a time by host_block_erase() */
+#define HOST_ERASE_BLKS		128
+
+#ifdef CONFIG_BLK
+static unsigned long host_block_erase(struct udevice *dev,
+				      unsigned long start, lbaint_t blkcnt)
+{
+	struct host_block_dev *host_dev = dev_get_plat(dev);
+	struct blk_desc *block_dev = dev_get_uclass_plat(dev);
+#else
+static unsigned long host_block_erase(struct blk_desc *block_dev,
+				      unsigned long start, lbaint_t blkcnt)
+{
+	int dev = block_dev->devnum;
+	struct host_block_dev *host_dev = find_host_device(dev);
+#endif
+	lbaint_t blks = 0, n;
+	ssize_t len;
+	void *zero;
+
+	/* Erased blocks read back as zeroes, like on the sandbox MMC */
+	zero = calloc(HOST_ERASE_BLKS, block_dev->blksz);
+	if (!zero)
+		return -1;
+
+	if (os_lseek(host_dev->fd, start * block_dev->blksz, OS_SEEK_SET) ==
+			-1) {
+		printf("ERROR: Invalid block %lx\n", start);
+		free(zero);
+		return -1;
+	}
+	while (blks < blkcnt) {
+		n = min_t(lbaint_t, blkcnt - blks, HOST_ERASE_BLKS);
+		len = os_write(host_dev->fd, zero, n * block_dev->blksz);
+		if (len < 0)
+			break;
+		blks += len / block_dev->blksz;
+		if (len != n * block_dev->blksz)
+			break;
+	}
+	free(zero);
+
+	return blks;
+}
+
 #ifdef CONFIG_BLK
 int host_dev_bind(int devnum, char *filename, bool removable)
 {
@@ -198,6 +243,7 @@ int host_dev_bind(int dev, char *filename, bool removable)
 	blk_dev->lba = os_lseek(host_dev->fd, 0, OS_SEEK_END) / blk_dev->blksz;
 	blk_dev->block_read = host_block_read;
 	blk_dev->block_write = host_block_write;
+	blk_dev->block_erase = host_block_erase;
 	blk_dev->devnum = dev;
 	blk_dev->part_type = PART_TYPE_UNKNOWN;
 	blk_dev->removable = removable;
@@ -251,6 +297,7 @@ int sandbox_host_unbind(struct udevice *dev)
 static const struct blk_ops sandbox_host_blk_ops = {
 	.read	= host_block_read,
 	.write	= host_block_write,
+	.erase	= host_block_erase,
 };
 
 U_BOOT_DRIVER(sandbox_host_blk) = {
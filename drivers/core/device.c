@@ -9,6 +9,7 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
 #include <cpu_func.h>
 #include <event.h>
 #include <log.h>
@@ -36,10 +37,25 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
-static int device_bind_common(struct udevice *parent, const struct driver *drv,
-			      const char *name, void *plat,
-			      ulong driver_data, ofnode node,
-			      uint of_plat_size, struct udevice **devp)
+/**
+ * dm_span_start() - start a bootstage span for a device operation
+ *
+ * @type:	Type of operation
+ * @name:	Name of the device
+ * Return: span ID to pass to bootstage_span_end()
+ */
+static int dm_span_start(enum bootstage_span_t type, const char *name)
+{
+	if (!CONFIG_IS_ENABLED(BOOTSTAGE_DM) || !name)
+		return 0;
+
+	return bootstage_span_start(type, name);
+}
+
+static int device_do_bind(struct udevice *parent, const struct driver *drv,
+			  const char *name, void *plat, ulong driver_data,
+			  ofnode node, uint of_plat_size,
+			  struct udevice **devp)
 {
 	struct udevice *dev;
 	struct uclass *uc;
@@ -236,6 +252,21 @@ fail_alloc1:
 	return ret;
 }
 
+static int device_bind_common(struct udevice *parent, const struct driver *drv,
+			      const char *name, void *plat,
+			      ulong driver_data, ofnode node,
+			      uint of_plat_size, struct udevice **devp)
+{
+	int span, ret;
+
+	span = dm_span_start(BOOTSTAGE_SPAN_BIND, name);
+	ret = device_do_bind(parent, drv, name, plat, driver_data, node,
+			     of_plat_size, devp);
+	bootstage_span_end(span);
+
+	return ret;
+}
+
 int device_bind_with_driver_data(struct udevice *parent,
 				 const struct driver *drv, const char *name,
 				 ulong driver_data, ofnode node,
@@ -385,7 +416,7 @@ static int device_alloc_priv(struct udevice *dev)
 	return 0;
 }
 
-int device_of_to_plat(struct udevice *dev)
+static int device_do_of_to_plat(struct udevice *dev)
 {
 	const struct driver *drv;
 	int ret;
@@ -477,7 +508,22 @@ static int device_get_dma_constraints(struct udevice *dev)
 	return 0;
 }
 
-int device_probe(struct udevice *dev)
+int device_of_to_plat(struct udevice *dev)
+{
+	int span, ret;
+
+	/* Only record a span if there is something to do */
+	if (!dev || dev_get_flags(dev) & DM_FLAG_PLATDATA_VALID)
+		return device_do_of_to_plat(dev);
+
+	span = dm_span_start(BOOTSTAGE_SPAN_OF_TO_PLAT, dev->name);
+	ret = device_do_of_to_plat(dev);
+	bootstage_span_end(span);
+
+	return ret;
+}
+
+static int device_do_probe(struct udevice *dev)
 {
 	const struct driver *drv;
 	int ret;
@@ -614,6 +660,21 @@ fail:
 	return ret;
 }
 
+int device_probe(struct udevice *dev)
+{
+	int span, ret;
+
+	/* Only record a span if there is something to do */
+	if (!dev || dev_get_flags(dev) & DM_FLAG_ACTIVATED)
+		return device_do_probe(dev);
+
+	span = dm_span_start(BOOTSTAGE_SPAN_PROBE, dev->name);
+	ret = device_do_probe(dev);
+	bootstage_span_end(span);
+
+	return ret;
+}
+
 void *dev_get_plat(const struct udevice *dev)
 {
 	if (!dev) {
@@ -149,7 +149,7 @@ struct device_node *of_find_all_nodes(struct device_node *prev)
 	struct device_node *np;
 
 	if (!prev) {
-		np = gd->of_root;
+		np = gd_of_root();
 	} else if (prev->child) {
 		np = prev->child;
 	} else {
@@ -352,7 +352,7 @@ struct device_node *of_find_node_opts_by_path(struct device_node *root,
 	const char *separator = strchr(path, ':');
 
 	if (!root)
-		root = gd->of_root;
+		root = gd_of_root();
 	if (opts)
 		*opts = separator ? separator + 1 : NULL;
 
@@ -365,7 +365,7 @@ struct device_node *of_find_node_opts_by_path(struct device_node *root,
 		const char *p = separator;
 
 		/* Only allow alias processing on the control FDT */
-		if (root != gd->of_root)
+		if (root != gd_of_root())
 			return NULL;
 		if (!p)
 			p = strchrnul(path, '/');
@@ -891,26 +891,22 @@ struct device_node *of_get_stdout(void)
 int of_write_prop(struct device_node *np, const char *propname, int len,
 		  const void *value)
 {
+	struct property **ppp;
 	struct property *pp;
-	struct property *pp_last = NULL;
 	struct property *new;
 
 	if (!np)
 		return -EINVAL;
 
-	for (pp = np->properties; pp; pp = pp->next) {
+	for (ppp = &np->properties; (pp = *ppp); ppp = &pp->next) {
 		if (strcmp(pp->name, propname) == 0) {
 			/* Property exists -> change value */
 			pp->value = (void *)value;
 			pp->length = len;
 			return 0;
 		}
-		pp_last = pp;
 	}
 
-	if (!pp_last)
-		return -ENOENT;
-
 	/* Property does not exist -> append new property */
 	new = malloc(sizeof(struct property));
 	if (!new)
@@ -926,7 +922,7 @@ int of_write_prop(struct device_node *np, const char *propname, int len,
 	new->length = len;
 	new->next = NULL;
 
-	pp_last->next = new;
+	*ppp = new;
 
 	return 0;
 }
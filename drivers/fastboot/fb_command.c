@@ -10,8 +10,11 @@
 #include <fastboot-internal.h>
 #include <fb_mmc.h>
 #include <fb_nand.h>
+#include <image-sparse.h>
+#include <malloc.h>
 #include <part.h>
 #include <stdlib.h>
+#include <asm/cache.h>
 
 /**
  * image_size - final fastboot image size
@@ -28,6 +31,45 @@ static u32 fastboot_bytes_received;
  */
 static u32 fastboot_bytes_expected;
 
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+/**
+ * FASTBOOT_STREAM_MAX_SIZE - largest download accepted while streaming
+ */
+#define FASTBOOT_STREAM_MAX_SIZE	0xfffff000
+
+/**
+ * struct fastboot_stream - state of a download written while it arrives
+ *
+ * The download buffer is split in two halves. Received data is copied into
+ * one half while the other, once full, is written to storage.
+ *
+ * @part: partition selected with "oem stream", empty if streaming is off
+ * @active: the current download is being streamed to @part
+ * @done: a streamed download has finished and @result holds its outcome
+ * @storage: storage backend for @part
+ * @sparse: parser for the sparse or raw image
+ * @buf: the two halves of the download buffer
+ * @half_size: size of each half
+ * @cur: index of the half being filled
+ * @fill: number of bytes in the half being filled
+ * @pending: the other half is full and waits to be written
+ * @result: fastboot response for the flash command
+ */
+static struct fastboot_stream {
+	char part[FASTBOOT_COMMAND_LEN];
+	bool active;
+	bool done;
+	struct sparse_storage storage;
+	struct sparse_stream sparse;
+	void *buf[2];
+	u32 half_size;
+	int cur;
+	u32 fill;
+	bool pending;
+	char result[FASTBOOT_RESPONSE_LEN];
+} stream;
+#endif
+
 static void okay(char *, char *);
 static void getvar(char *, char *);
 static void download(char *, char *);
@@ -47,6 +89,9 @@ static void oem_partconf(char *, char *);
 #if CONFIG_IS_ENABLED(FASTBOOT_CMD_OEM_BOOTBUS)
 static void oem_bootbus(char *, char *);
 #endif
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+static void oem_stream(char *, char *);
+#endif
 
 #if CONFIG_IS_ENABLED(FASTBOOT_UUU_SUPPORT)
 static void run_ucmd(char *, char *);
@@ -121,6 +166,12 @@ static const struct {
 		.dispatch = oem_bootbus,
 	},
 #endif
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+	[FASTBOOT_COMMAND_OEM_STREAM] = {
+		.command = "oem stream",
+		.dispatch = oem_stream,
+	},
+#endif
 #if CONFIG_IS_ENABLED(FASTBOOT_UUU_SUPPORT)
 	[FASTBOOT_COMMAND_UCMD] = {
 		.command = "UCmd",
@@ -192,6 +243,162 @@ static void getvar(char *cmd_parameter, char *response)
 	fastboot_getvar(cmd_parameter, response);
 }
 
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+/**
+ * fastboot_stream_open() - Set up the storage for a streamed download
+ *
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 if OK, -ve on error
+ */
+static int fastboot_stream_open(char *response)
+{
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_MMC)
+	return fastboot_mmc_stream_open(stream.part, &stream.storage,
+					response);
+#elif CONFIG_IS_ENABLED(FASTBOOT_FLASH_NAND)
+	return fastboot_nand_stream_open(stream.part, &stream.storage,
+					 response);
+#else
+	fastboot_fail("no flash device defined", response);
+	return -ENODEV;
+#endif
+}
+
+/**
+ * fastboot_stream_write() - Write a buffer to the streamed partition
+ *
+ * Errors are recorded in stream.result and reported once the download is
+ * complete; further data is then discarded.
+ *
+ * @buf: Pointer to data
+ * @len: Length of data
+ */
+static void fastboot_stream_write(const void *buf, u32 len)
+{
+	if (stream.result[0])
+		return;
+	sparse_stream_write(&stream.sparse, buf, len, stream.result);
+}
+
+/**
+ * fastboot_stream_start() - Start streaming a download, if requested
+ *
+ * @size: Size of the download in bytes
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 if OK or streaming is off, -ve on error
+ */
+static int fastboot_stream_start(u32 size, char *response)
+{
+	/* Drop the state of a download abandoned by the host */
+	if (stream.active)
+		sparse_stream_finish(&stream.sparse, stream.result);
+	stream.active = false;
+	stream.done = false;
+	if (!stream.part[0])
+		return 0;
+
+	if (fastboot_stream_open(response))
+		return -ENODEV;
+
+	stream.half_size = ALIGN_DOWN(fastboot_buf_size / 2,
+				      ARCH_DMA_MINALIGN);
+	stream.buf[0] = PTR_ALIGN(fastboot_buf_addr, ARCH_DMA_MINALIGN);
+	stream.buf[1] = stream.buf[0] + stream.half_size;
+	stream.cur = 0;
+	stream.fill = 0;
+	stream.pending = false;
+	stream.result[0] = '\0';
+	if (sparse_stream_init(&stream.sparse, &stream.storage, stream.part,
+			       size, response))
+		return -ENOMEM;
+	stream.active = true;
+
+	return 0;
+}
+
+/**
+ * fastboot_stream_data() - Add received data to the stream buffer
+ *
+ * @data: Pointer to received data
+ * @len: Length of received data
+ */
+static void fastboot_stream_data(const void *data, u32 len)
+{
+	u32 n;
+
+	while (len) {
+		n = min(len, stream.half_size - stream.fill);
+		memcpy(stream.buf[stream.cur] + stream.fill, data, n);
+		stream.fill += n;
+		data += n;
+		len -= n;
+		if (stream.fill < stream.half_size)
+			break;
+
+		/* This half is full; the other one must have been written */
+		fastboot_data_flush();
+		stream.pending = true;
+		stream.cur ^= 1;
+		stream.fill = 0;
+	}
+}
+
+/**
+ * fastboot_stream_complete() - Write out the rest of a streamed download
+ *
+ * @response: Pointer to fastboot response buffer
+ */
+static void fastboot_stream_complete(char *response)
+{
+	char msg[FASTBOOT_RESPONSE_LEN] = {0};
+	int ret;
+
+	fastboot_data_flush();
+	fastboot_stream_write(stream.buf[stream.cur], stream.fill);
+	ret = sparse_stream_finish(&stream.sparse, msg);
+	if (!stream.result[0]) {
+		if (ret)
+			strlcpy(stream.result, msg, sizeof(stream.result));
+		else
+			fastboot_okay(NULL, stream.result);
+	}
+	stream.active = false;
+	stream.done = true;
+
+	/* Report a failure straight away rather than on "flash" */
+	if (strncmp(stream.result, "OKAY", 4))
+		strlcpy(response, stream.result, FASTBOOT_RESPONSE_LEN);
+}
+
+void fastboot_data_flush(void)
+{
+	if (!stream.active || !stream.pending)
+		return;
+
+	fastboot_stream_write(stream.buf[stream.cur ^ 1], stream.half_size);
+	stream.pending = false;
+}
+
+u32 fastboot_data_max_size(void)
+{
+	return stream.part[0] ? FASTBOOT_STREAM_MAX_SIZE : fastboot_buf_size;
+}
+#else
+static inline int fastboot_stream_start(u32 size, char *response)
+{
+	return 0;
+}
+
+void fastboot_data_flush(void)
+{
+}
+
+u32 fastboot_data_max_size(void)
+{
+	return fastboot_buf_size;
+}
+#endif
+
 /**
  * fastboot_download() - Start a download transfer from the client
  *
@@ -218,8 +425,10 @@ static void download(char *cmd_parameter, char *response)
 	 *
 	 * where cmd_parameter is an 8 digit hexadecimal number
 	 */
-	if (fastboot_bytes_expected > fastboot_buf_size) {
+	if (fastboot_bytes_expected > fastboot_data_max_size()) {
 		fastboot_fail(cmd_parameter, response);
+	} else if (fastboot_stream_start(fastboot_bytes_expected, response)) {
+		fastboot_bytes_expected = 0;
 	} else {
 		printf("Starting download of %d bytes\n",
 		       fastboot_bytes_expected);
@@ -265,6 +474,11 @@ void fastboot_data_download(const void *fastboot_data,
 			      response);
 		return;
 	}
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+	if (stream.active)
+		fastboot_stream_data(fastboot_data, fastboot_data_len);
+	else
+#endif
 	/* Download data to fastboot_buf_addr */
 	memcpy(fastboot_buf_addr + fastboot_bytes_received,
 	       fastboot_data, fastboot_data_len);
@@ -293,6 +507,10 @@ void fastboot_data_complete(char *response)
 	/* Download complete. Respond with "OKAY" */
 	fastboot_okay(NULL, response);
 	printf("\ndownloading of %d bytes finished\n", fastboot_bytes_received);
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+	if (stream.active)
+		fastboot_stream_complete(response);
+#endif
 	image_size = fastboot_bytes_received;
 	env_set_hex("filesize", image_size);
 	fastboot_bytes_expected = 0;
@@ -311,6 +529,18 @@ void fastboot_data_complete(char *response)
  */
 static void flash(char *cmd_parameter, char *response)
 {
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+	if (stream.done) {
+		/* The image was written while it was downloaded */
+		stream.done = false;
+		if (strcmp(cmd_parameter, stream.part))
+			fastboot_fail("image was streamed to another partition",
+				      response);
+		else
+			strlcpy(response, stream.result, FASTBOOT_RESPONSE_LEN);
+		return;
+	}
+#endif
 #if CONFIG_IS_ENABLED(FASTBOOT_FLASH_MMC)
 	fastboot_mmc_flash_write(cmd_parameter, fastboot_buf_addr, image_size,
 				 response);
@@ -513,3 +743,29 @@ static void oem_bootbus(char *cmd_parameter, char *response)
 		fastboot_okay(NULL, response);
 }
 #endif
+
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+/**
+ * oem_stream() - Execute the OEM stream command
+ *
+ * @cmd_parameter: Pointer to command parameter
+ * @response: Pointer to fastboot response buffer
+ *
+ * Select the partition that following downloads are written to while they
+ * are received, so that images larger than the download buffer can be
+ * flashed. The following "flash" command for that partition just reports
+ * the result. Without a parameter, streaming is turned off again.
+ */
+static void oem_stream(char *cmd_parameter, char *response)
+{
+	if (!cmd_parameter || !*cmd_parameter) {
+		stream.part[0] = '\0';
+		fastboot_okay(NULL, response);
+		return;
+	}
+
+	strlcpy(stream.part, cmd_parameter, sizeof(stream.part));
+	printf("Streaming downloads to '%s'\n", stream.part);
+	fastboot_okay(NULL, response);
+}
+#endif
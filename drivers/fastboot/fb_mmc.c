@@ -167,6 +167,59 @@ static lbaint_t fb_mmc_sparse_reserve(struct sparse_storage *info,
 	return blkcnt;
 }
 
+static lbaint_t fb_mmc_sparse_erase(struct sparse_storage *info,
+		lbaint_t blk, lbaint_t blkcnt)
+{
+	struct fb_mmc_sparse *sparse = info->priv;
+
+	if (fastboot_progress_callback)
+		fastboot_progress_callback("erasing");
+
+	return blk_derase(sparse->dev_desc, blk, blkcnt);
+}
+
+/**
+ * fb_mmc_erased_zero() - Check whether erased blocks read back as zeroes
+ *
+ * @mmc: MMC device
+ * Return: true if erased blocks read as zeroes, false if as ones or unknown
+ */
+static bool fb_mmc_erased_zero(struct mmc *mmc)
+{
+	if (IS_SD(mmc))
+		return !(mmc->scr[0] & SD_DATA_STAT_AFTER_ERASE);
+
+	return mmc->ext_csd && !mmc->ext_csd[EXT_CSD_ERASED_MEM_CONT];
+}
+
+static void fb_mmc_sparse_init(struct sparse_storage *sparse,
+			       struct fb_mmc_sparse *sparse_priv,
+			       struct blk_desc *dev_desc,
+			       struct disk_partition *info)
+{
+	sparse_priv->dev_desc = dev_desc;
+
+	sparse->blksz = info->blksz;
+	sparse->start = info->start;
+	sparse->size = info->size;
+	sparse->write = fb_mmc_sparse_write;
+	sparse->reserve = fb_mmc_sparse_reserve;
+	sparse->erase = NULL;
+	sparse->mssg = fastboot_fail;
+	sparse->priv = sparse_priv;
+
+	if (CONFIG_IS_ENABLED(FASTBOOT_MMC_SPARSE_DISCARD) &&
+	    dev_desc->if_type == IF_TYPE_MMC) {
+		struct mmc *mmc = find_mmc_device(dev_desc->devnum);
+
+		if (mmc && mmc->erase_grp_size) {
+			sparse->erase = fb_mmc_sparse_erase;
+			sparse->erase_grp = mmc->erase_grp_size;
+			sparse->erase_zero = fb_mmc_erased_zero(mmc);
+		}
+	}
+}
+
 static void write_raw_image(struct blk_desc *dev_desc,
 			    struct disk_partition *info, const char *part_name,
 			    void *buffer, u32 download_bytes, char *response)
@@ -494,6 +547,45 @@ static struct blk_desc *fastboot_mmc_get_dev(char *response)
 	return ret;
 }
 
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+/**
+ * fastboot_mmc_stream_open() - Set up streaming an image to eMMC
+ *
+ * @cmd: Named partition to write image to
+ * @sparse: Returns the storage to pass to sparse_stream_init()
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 if OK, -ve if the partition cannot be used
+ */
+int fastboot_mmc_stream_open(const char *cmd, struct sparse_storage *sparse,
+			     char *response)
+{
+	static struct fb_mmc_sparse sparse_priv;
+	struct blk_desc *dev_desc;
+	struct disk_partition info = {0};
+
+#if CONFIG_IS_ENABLED(FASTBOOT_MMC_USER_SUPPORT)
+	if (strcmp(cmd, CONFIG_FASTBOOT_MMC_USER_NAME) == 0) {
+		dev_desc = fastboot_mmc_get_dev(response);
+		if (!dev_desc)
+			return -ENODEV;
+
+		strlcpy((char *)&info.name, cmd, sizeof(info.name));
+		info.size	= dev_desc->lba;
+		info.blksz	= dev_desc->blksz;
+	}
+#endif
+
+	if (!info.name[0] &&
+	    fastboot_mmc_get_part_info(cmd, &dev_desc, &info, response) < 0)
+		return -ENOENT;
+
+	fb_mmc_sparse_init(sparse, &sparse_priv, dev_desc, &info);
+	printf("Streaming image to offset " LBAFU "\n", sparse->start);
+
+	return 0;
+}
+#endif
+
 /**
  * fastboot_mmc_flash_write() - Write image to eMMC for fastboot
  *
@@ -609,19 +701,11 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 		struct sparse_storage sparse;
 		int err;
 
-		sparse_priv.dev_desc = dev_desc;
-
-		sparse.blksz = info.blksz;
-		sparse.start = info.start;
-		sparse.size = info.size;
-		sparse.write = fb_mmc_sparse_write;
-		sparse.reserve = fb_mmc_sparse_reserve;
-		sparse.mssg = fastboot_fail;
+		fb_mmc_sparse_init(&sparse, &sparse_priv, dev_desc, &info);
 
 		printf("Flashing sparse image at offset " LBAFU "\n",
 		       sparse.start);
 
-		sparse.priv = &sparse_priv;
 		err = write_sparse_image(&sparse, cmd, download_buffer,
 					 response);
 		if (!err)
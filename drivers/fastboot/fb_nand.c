@@ -146,6 +146,23 @@ static lbaint_t fb_nand_sparse_reserve(struct sparse_storage *info,
 	return blkcnt + bad_blocks;
 }
 
+static void fb_nand_sparse_init(struct sparse_storage *sparse,
+				struct fb_nand_sparse *sparse_priv,
+				struct mtd_info *mtd, struct part_info *part)
+{
+	sparse_priv->mtd = mtd;
+	sparse_priv->part = part;
+
+	sparse->blksz = mtd->writesize;
+	sparse->start = part->offset / sparse->blksz;
+	sparse->size = part->size / sparse->blksz;
+	sparse->write = fb_nand_sparse_write;
+	sparse->reserve = fb_nand_sparse_reserve;
+	sparse->erase = NULL;
+	sparse->mssg = fastboot_fail;
+	sparse->priv = sparse_priv;
+}
+
 /**
  * fastboot_nand_get_part_info() - Lookup NAND partion by name
  *
@@ -191,20 +208,11 @@ void fastboot_nand_flash_write(const char *cmd, void *download_buffer,
 		struct fb_nand_sparse sparse_priv;
 		struct sparse_storage sparse;
 
-		sparse_priv.mtd = mtd;
-		sparse_priv.part = part;
-
-		sparse.blksz = mtd->writesize;
-		sparse.start = part->offset / sparse.blksz;
-		sparse.size = part->size / sparse.blksz;
-		sparse.write = fb_nand_sparse_write;
-		sparse.reserve = fb_nand_sparse_reserve;
-		sparse.mssg = fastboot_fail;
+		fb_nand_sparse_init(&sparse, &sparse_priv, mtd, part);
 
 		printf("Flashing sparse image at offset " LBAFU "\n",
 		       sparse.start);
 
-		sparse.priv = &sparse_priv;
 		ret = write_sparse_image(&sparse, cmd, download_buffer,
 					 response);
 		if (!ret)
@@ -228,6 +236,43 @@ void fastboot_nand_flash_write(const char *cmd, void *download_buffer,
 	fastboot_okay(NULL, response);
 }
 
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+/**
+ * fastboot_nand_stream_open() - Set up streaming an image to NAND
+ *
+ * @cmd: Named device to write image to
+ * @sparse: Returns the storage to pass to sparse_stream_init()
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 if OK, -ve if the partition cannot be used
+ */
+int fastboot_nand_stream_open(const char *cmd, struct sparse_storage *sparse,
+			      char *response)
+{
+	static struct fb_nand_sparse sparse_priv;
+	struct part_info *part;
+	struct mtd_info *mtd = NULL;
+	int ret;
+
+	ret = fb_nand_lookup(cmd, &mtd, &part, response);
+	if (ret) {
+		pr_err("invalid NAND device");
+		fastboot_fail("invalid NAND device", response);
+		return ret;
+	}
+
+	ret = board_fastboot_write_partition_setup(part->name);
+	if (ret) {
+		fastboot_fail("cannot set up partition", response);
+		return ret;
+	}
+
+	fb_nand_sparse_init(sparse, &sparse_priv, mtd, part);
+	printf("Streaming image to offset 0x%llx\n", part->offset);
+
+	return 0;
+}
+#endif
+
 /**
  * fastboot_nand_flash_erase() - Erase NAND for fastboot
  *
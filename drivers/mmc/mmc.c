@@ -591,12 +591,13 @@ static int mmc_switch_voltage(struct mmc *mmc, int signal_voltage)
 }
 #endif
 
-static int sd_send_op_cond(struct mmc *mmc, bool uhs_en)
+static int sd_send_op_cond(struct mmc *mmc, bool uhs_en, bool defer)
 {
 	int timeout = 1000;
 	int err;
 	struct mmc_cmd cmd;
 
+	mmc->sd_op_cond_pending = 0;
 	while (1) {
 		cmd.cmdidx = MMC_CMD_APP_CMD;
 		cmd.resp_type = MMC_RSP_R1;
@@ -637,6 +638,13 @@ static int sd_send_op_cond(struct mmc *mmc, bool uhs_en)
 		if (timeout-- <= 0)
 			return -EOPNOTSUPP;
 
+		/* Let the card power up, mmc_complete_init() goes on polling */
+		if (defer) {
+			mmc->sd_op_cond_pending = 1;
+			mmc->sd_op_cond_uhs = uhs_en;
+			return 0;
+		}
+
 		udelay(1000);
 	}
 
@@ -2801,7 +2809,7 @@ static int mmc_power_cycle(struct mmc *mmc)
 	return mmc_power_on(mmc);
 }
 
-int mmc_get_op_cond(struct mmc *mmc, bool quiet)
+static int _mmc_get_op_cond(struct mmc *mmc, bool quiet, bool defer)
 {
 	bool uhs_en = supports_uhs(mmc->cfg->host_caps);
 	int err;
@@ -2864,7 +2872,7 @@ retry:
 	err = mmc_send_if_cond(mmc);
 
 	/* Now try to get the SD card's operating condition */
-	err = sd_send_op_cond(mmc, uhs_en);
+	err = sd_send_op_cond(mmc, uhs_en, defer);
 	if (err && uhs_en) {
 		uhs_en = false;
 		mmc_power_cycle(mmc);
@@ -2887,6 +2895,11 @@ retry:
 	return err;
 }
 
+int mmc_get_op_cond(struct mmc *mmc, bool quiet)
+{
+	return _mmc_get_op_cond(mmc, quiet, false);
+}
+
 int mmc_start_init(struct mmc *mmc)
 {
 	bool no_card;
@@ -2936,7 +2949,7 @@ int mmc_start_init(struct mmc *mmc)
 		return -ENOMEDIUM;
 	}
 
-	err = mmc_get_op_cond(mmc, false);
+	err = _mmc_get_op_cond(mmc, false, true);
 
 	if (!err)
 		mmc->init_in_progress = 1;
@@ -2949,7 +2962,13 @@ static int mmc_complete_init(struct mmc *mmc)
 	int err = 0;
 
 	mmc->init_in_progress = 0;
-	if (mmc->op_cond_pending)
+	if (mmc->sd_op_cond_pending) {
+		err = sd_send_op_cond(mmc, mmc->sd_op_cond_uhs, false);
+		/* Start again, which retries without UHS if need be */
+		if (err)
+			err = mmc_get_op_cond(mmc, false);
+	}
+	if (!err && mmc->op_cond_pending)
 		err = mmc_complete_op_cond(mmc);
 
 	if (!err)
@@ -35,6 +35,18 @@ static int mmc_get_bootflow(struct udevice *dev, struct bootflow_iter *iter,
 	return 0;
 }
 
+static int mmc_bootdev_start(struct udevice *dev)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev_get_parent(dev));
+
+	if (!mmc)
+		return -ENODEV;
+	if (mmc->has_init || mmc->init_in_progress || !mmc_getcd(mmc))
+		return 0;
+
+	return mmc_start_init(mmc);
+}
+
 static int mmc_bootdev_bind(struct udevice *dev)
 {
 	struct bootdev_uc_plat *ucp = dev_get_uclass_plat(dev);
@@ -46,6 +58,7 @@ static int mmc_bootdev_bind(struct udevice *dev)
 
 struct bootdev_ops mmc_bootdev_ops = {
 	.get_bootflow	= mmc_get_bootflow,
+	.start		= mmc_bootdev_start,
 };
 
 static const struct udevice_id mmc_bootdev_ids[] = {
@@ -24,11 +24,14 @@ struct sandbox_mmc_plat {
 #define MMC_BL_LEN_SHIFT	10
 #define MMC_BL_LEN		BIT(MMC_BL_LEN_SHIFT)
 #define SIZE_MULTIPLE		((1 << (MMC_CMULT + 2)) * MMC_BL_LEN)
+/* Number of ACMD41 commands after a reset which report the card as busy */
+#define MMC_POWERUP_POLLS	2
 
 struct sandbox_mmc_priv {
 	char *buf;
 	int csize;	/* CSIZE value to report */
 	int size;
+	int powerup;	/* number of ACMD41 still to report as busy */
 };
 
 /**
@@ -50,7 +53,9 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		break;
 	case SD_CMD_SEND_RELATIVE_ADDR:
 		cmd->response[0] = 0 << 16; /* mmc->rca */
+		break;
 	case MMC_CMD_GO_IDLE_STATE:
+		priv->powerup = MMC_POWERUP_POLLS;
 		break;
 	case SD_CMD_SEND_IF_COND:
 		cmd->response[0] = 0xaa;
@@ -100,7 +105,12 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		       (erase_end - erase_start + 1) * mmc->write_bl_len);
 		break;
 	case SD_CMD_APP_SEND_OP_COND:
-		cmd->response[0] = OCR_BUSY | OCR_HCS;
+		/* OCR_BUSY is set once the card has powered up */
+		cmd->response[0] = OCR_HCS;
+		if (priv->powerup)
+			priv->powerup--;
+		else
+			cmd->response[0] |= OCR_BUSY;
 		cmd->response[1] = 0;
 		cmd->response[2] = 0;
 		break;
@@ -165,11 +175,16 @@ static int sandbox_mmc_probe(struct udevice *dev)
 	int ret;
 
 	if (plat->fname) {
-		ret = os_map_file(plat->fname, OS_O_RDWR | OS_O_CREAT,
+		char fname[256];
+
+		ret = os_persistent_file(fname, sizeof(fname), plat->fname);
+		if (ret)
+			return ret;
+		ret = os_map_file(fname, OS_O_RDWR | OS_O_CREAT,
 				  (void **)&priv->buf, &priv->size);
 		if (ret) {
 			log_err("%s: Unable to map file '%s'\n", dev->name,
-				plat->fname);
+				fname);
 			return ret;
 		}
 		priv->csize = priv->size / SIZE_MULTIPLE - 1;
@@ -177,7 +192,8 @@ static int sandbox_mmc_probe(struct udevice *dev)
 		priv->csize = 0;
 		priv->size = (priv->csize + 1) * SIZE_MULTIPLE; /* 1 MiB */
 
-		priv->buf = malloc(priv->size);
+		/* Start with blank media, not what an earlier device left */
+		priv->buf = calloc(1, priv->size);
 		if (!priv->buf) {
 			log_err("%s: Not enough memory (%x bytes)\n",
 				dev->name, priv->size);
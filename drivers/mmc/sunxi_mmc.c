@@ -15,6 +15,7 @@
 #include <mmc.h>
 #include <clk.h>
 #include <reset.h>
+#include <serial.h>
 #include <asm/gpio.h>
 #include <asm/io.h>
 #include <asm/arch/clock.h>
@@ -373,6 +374,7 @@ static int mmc_rint_wait(struct sunxi_mmc_priv *priv, struct mmc *mmc,
 
 	do {
 		status = readl(&priv->reg->rint);
+		serial_tx_poll();
 		if ((get_timer(start) > timeout_msecs) ||
 		    (status & SUNXI_MMC_RINT_INTERRUPT_ERROR_BIT)) {
 			debug("%s timeout %x\n", what,
@@ -128,6 +128,7 @@ static int sandbox_sf_probe(struct udevice *dev)
 	struct udevice *bus = dev->parent;
 	const char *spec = NULL;
 	struct udevice *emul;
+	char fname[256];
 	int ret = 0;
 	int cs = -1;
 
@@ -171,10 +172,12 @@ static int sandbox_sf_probe(struct udevice *dev)
 	if (sandbox_sf_0xff[0] == 0x00)
 		memset(sandbox_sf_0xff, 0xff, sizeof(sandbox_sf_0xff));
 
-	sbsf->fd = os_open(pdata->filename, 02);
+	ret = os_persistent_file(fname, sizeof(fname), pdata->filename);
+	if (ret)
+		goto error;
+	sbsf->fd = os_open(fname, 02);
 	if (sbsf->fd == -1) {
-		printf("%s: unable to open file '%s'\n", __func__,
-		       pdata->filename);
+		printf("%s: unable to open file '%s'\n", __func__, fname);
 		ret = -EIO;
 		goto error;
 	}
@@ -79,6 +79,7 @@
 #include <u-boot/crc.h>
 #else
 #include <div64.h>
+#include <time.h>
 #include <linux/bug.h>
 #include <linux/err.h>
 #endif
@@ -802,6 +803,63 @@ out_unlock:
 	return err;
 }
 
+/**
+ * alloc_hdr_buf - allocate the buffer for reading both UBI headers at once.
+ * @ubi: UBI device description object
+ *
+ * The EC and VID headers live in the first min. I/O units of a PEB, so a
+ * single read covering both of them lets the MTD driver fetch the pages back
+ * to back instead of issuing one request per header. Failing to allocate the
+ * buffer is not an error, headers are then read one by one.
+ */
+static void alloc_hdr_buf(struct ubi_device *ubi)
+{
+	ubi->hdr_buf_pnum = -1;
+	ubi->hdr_buf_len = ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize;
+	ubi->hdr_buf = kmalloc(ubi->hdr_buf_len, GFP_KERNEL);
+	if (!ubi->hdr_buf)
+		ubi->hdr_buf_len = 0;
+}
+
+/**
+ * free_hdr_buf - free the buffer allocated by alloc_hdr_buf().
+ * @ubi: UBI device description object
+ */
+static void free_hdr_buf(struct ubi_device *ubi)
+{
+	kfree(ubi->hdr_buf);
+	ubi->hdr_buf = NULL;
+	ubi->hdr_buf_pnum = -1;
+	ubi->hdr_buf_len = 0;
+}
+
+/**
+ * read_hdrs - read both UBI headers of a PEB at once.
+ * @ubi: UBI device description object
+ * @pnum: the physical eraseblock number
+ *
+ * Following header reads of @pnum are served from @ubi->hdr_buf. If the read
+ * fails or reports bit-flips, the buffer is dropped and the headers are read
+ * separately, so that errors are attributed to the right header.
+ */
+static void read_hdrs(struct ubi_device *ubi, int pnum)
+{
+	size_t read;
+	int err;
+
+	ubi->hdr_buf_pnum = -1;
+	if (!ubi->hdr_buf)
+		return;
+
+	err = mtd_read(ubi->mtd, (loff_t)pnum * ubi->peb_size,
+		       ubi->hdr_buf_len, &read, ubi->hdr_buf);
+	if (err || read != ubi->hdr_buf_len)
+		return;
+
+	ubi->hdr_buf_pnum = pnum;
+	ubi->attach_stats.merged_reads += 1;
+}
+
 /**
  * scan_peb - scan and process UBI headers of a PEB.
  * @ubi: UBI device description object
@@ -832,6 +890,9 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		return 0;
 	}
 
+	ubi->attach_stats.scanned_pebs += 1;
+	read_hdrs(ubi, pnum);
+
 	err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
 	if (err < 0)
 		return err;
@@ -1241,6 +1302,7 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	if (!vidh)
 		goto out_ech;
 
+	alloc_hdr_buf(ubi);
 	for (pnum = start; pnum < ubi->peb_count; pnum++) {
 		cond_resched();
 
@@ -1249,6 +1311,7 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		if (err < 0)
 			goto out_vidh;
 	}
+	free_hdr_buf(ubi);
 
 	ubi_msg(ubi, "scanning is finished");
 
@@ -1293,6 +1356,7 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	return 0;
 
 out_vidh:
+	free_hdr_buf(ubi);
 	ubi_free_vid_hdr(ubi, vidh);
 out_ech:
 	kfree(ech);
@@ -1350,6 +1414,7 @@ static int scan_fast(struct ubi_device *ubi, struct ubi_attach_info **ai)
 	if (!vidh)
 		goto out_ech;
 
+	alloc_hdr_buf(ubi);
 	for (pnum = 0; pnum < UBI_FM_MAX_START; pnum++) {
 		int vol_id = -1;
 		unsigned long long sqnum = -1;
@@ -1366,6 +1431,7 @@ static int scan_fast(struct ubi_device *ubi, struct ubi_attach_info **ai)
 		}
 	}
 
+	free_hdr_buf(ubi);
 	ubi_free_vid_hdr(ubi, vidh);
 	kfree(ech);
 
@@ -1380,6 +1446,7 @@ static int scan_fast(struct ubi_device *ubi, struct ubi_attach_info **ai)
 	return ubi_scan_fastmap(ubi, *ai, fm_anchor);
 
 out_vidh:
+	free_hdr_buf(ubi);
 	ubi_free_vid_hdr(ubi, vidh);
 out_ech:
 	kfree(ech);
@@ -1401,7 +1468,9 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 {
 	int err;
 	struct ubi_attach_info *ai;
+	unsigned long start = timer_get_us();
 
+	memset(&ubi->attach_stats, 0, sizeof(ubi->attach_stats));
 	ai = alloc_ai();
 	if (!ai)
 		return -ENOMEM;
@@ -1455,6 +1524,16 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 	if (err)
 		goto out_wl;
 
+	ubi->attach_stats.time_us = timer_get_us() - start;
+#ifdef CONFIG_MTD_UBI_FASTMAP
+	ubi->attach_stats.fastmap = !!ubi->fm;
+#endif
+	ubi_msg(ubi, "attached by %s in %lu ms, %d PEBs scanned (%d with merged header reads)",
+		ubi->attach_stats.fastmap ? "fastmap" : "scanning",
+		ubi->attach_stats.time_us / 1000,
+		ubi->attach_stats.scanned_pebs,
+		ubi->attach_stats.merged_reads);
+
 #ifdef CONFIG_MTD_UBI_FASTMAP
 	if (ubi->fm && ubi_dbg_chk_fastmap(ubi)) {
 		struct ubi_attach_info *scan_ai;
@@ -1066,6 +1066,21 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
 
 	spin_unlock(&ubi->wl_lock);
 
+#ifdef CONFIG_MTD_UBI_FASTMAP
+	/*
+	 * The device had to be scanned because there is no usable fastmap.
+	 * Write one right away instead of waiting for the detach, which
+	 * usually never happens before the OS is booted, so that the next
+	 * attach does not have to scan all PEBs again. This is done once the
+	 * pending erasures have run, so that an anchor PEB is available.
+	 * Failing to write the fastmap is not fatal.
+	 */
+	if (!ubi->fm && !ubi->fm_disabled && !ubi->ro_mode) {
+		ubi_update_fastmap(ubi);
+		ubi->attach_stats.fastmap_written = !!ubi->fm;
+	}
+#endif
+
 	ubi_devices[ubi_num] = ubi;
 	ubi_notify_all(ubi, UBI_VOLUME_ADDED, NULL);
 	return ubi_num;
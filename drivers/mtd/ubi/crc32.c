@@ -30,6 +30,9 @@
 #include <linux/types.h>
 
 #include <asm/byteorder.h>
+#ifdef __UBOOT__
+#include <u-boot/crc.h>
+#endif
 
 #ifndef __UBOOT__
 #include <linux/slab.h>
@@ -61,7 +64,13 @@ MODULE_LICENSE("GPL");
  */
 u32  crc32_le(u32 crc, unsigned char const *p, size_t len);
 
-#if CRC_LE_BITS == 1
+#ifdef __UBOOT__
+/* Use the same code as crc32(), which can use the CRC32 instructions */
+u32 crc32_le(u32 crc, unsigned char const *p, size_t len)
+{
+	return crc32_no_comp(crc, p, len);
+}
+#elif CRC_LE_BITS == 1
 /*
  * In fact, the table-based code will work in this case, but it can be
  * simplified by inlining the table in ?: form.
@@ -136,6 +136,17 @@ int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
 	if (err)
 		return err;
 
+	/*
+	 * When attaching, both headers of the PEB being scanned may already
+	 * have been read in one go. Such a read is only kept if it returned
+	 * clean data, so bit-flips and ECC errors are still reported by the
+	 * regular path below.
+	 */
+	if (pnum == ubi->hdr_buf_pnum && offset + len <= ubi->hdr_buf_len) {
+		memcpy(buf, ubi->hdr_buf + offset, len);
+		return 0;
+	}
+
 	/*
 	 * Deliberately corrupt the buffer to improve robustness. Indeed, if we
 	 * do not do this, the following may happen:
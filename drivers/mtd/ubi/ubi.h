@@ -415,6 +415,22 @@ struct ubi_debug_info {
 	struct dentry *dfs_power_cut_max;
 };
 
+/**
+ * struct ubi_attach_stats - statistics of attaching an UBI device.
+ * @time_us: time spent attaching, in microseconds
+ * @scanned_pebs: count of physical eraseblocks whose headers were read
+ * @merged_reads: count of PEBs whose EC and VID headers were read at once
+ * @fastmap: non-zero if the device was attached using a fastmap
+ * @fastmap_written: non-zero if a fastmap was written after a full scan
+ */
+struct ubi_attach_stats {
+	unsigned long time_us;
+	int scanned_pebs;
+	int merged_reads;
+	int fastmap;
+	int fastmap_written;
+};
+
 /**
  * struct ubi_device - UBI device description structure
  * @dev: UBI device object to use the the Linux device model
@@ -523,6 +539,11 @@ struct ubi_debug_info {
  * @max_write_size: maximum amount of bytes the underlying flash can write at a
  *                  time (MTD write buffer size)
  * @mtd: MTD device descriptor
+ * @hdr_buf: both UBI headers of PEB @hdr_buf_pnum, read at once when attaching
+ * @hdr_buf_pnum: PEB the contents of @hdr_buf belong to, or %-1
+ * @hdr_buf_len: size of @hdr_buf (covers the EC and VID headers)
+ *
+ * @attach_stats: statistics of the last attach operation
  *
  * @peb_buf: a buffer of PEB size used for different purposes
  * @buf_mutex: protects @peb_buf
@@ -622,6 +643,11 @@ struct ubi_device {
 	unsigned int nor_flash:1;
 	int max_write_size;
 	struct mtd_info *mtd;
+	void *hdr_buf;
+	int hdr_buf_pnum;
+	int hdr_buf_len;
+
+	struct ubi_attach_stats attach_stats;
 
 	void *peb_buf;
 	struct mutex buf_mutex;
@@ -147,6 +147,37 @@ static int genphy_setup_forced(struct phy_device *phydev)
 	return err;
 }
 
+/* Note that autonegotiation has been (re)started by a reset or restart */
+static void phy_aneg_started(struct phy_device *phydev)
+{
+	phydev->aneg_start = get_timer(0) ? : 1;
+	phydev->aneg_time = 0;
+}
+
+/* Record how long autonegotiation took, the first time it is seen complete */
+static void phy_aneg_done(struct phy_device *phydev)
+{
+	if (phydev->aneg_start && !phydev->aneg_time)
+		phydev->aneg_time = get_timer(phydev->aneg_start) ? : 1;
+}
+
+int phy_poll_link(struct phy_device *phydev)
+{
+	int mii_reg;
+
+	if (phydev->autoneg != AUTONEG_ENABLE || !phydev->aneg_start)
+		return 0;
+
+	mii_reg = phy_read(phydev, MDIO_DEVAD_NONE, MII_BMSR);
+	if (mii_reg < 0)
+		return mii_reg;
+	if (!(mii_reg & BMSR_ANEGCOMPLETE))
+		return -EINPROGRESS;
+	phy_aneg_done(phydev);
+
+	return 0;
+}
+
 /**
  * genphy_restart_aneg - Enable and Restart Autonegotiation
  * @phydev: target phy_device struct
@@ -166,6 +197,8 @@ int genphy_restart_aneg(struct phy_device *phydev)
 	ctl &= ~(BMCR_ISOLATE);
 
 	ctl = phy_write(phydev, MDIO_DEVAD_NONE, MII_BMCR, ctl);
+	if (!ctl)
+		phy_aneg_started(phydev);
 
 	return ctl;
 }
@@ -241,15 +274,29 @@ int genphy_update_link(struct phy_device *phydev)
 
 	if ((phydev->autoneg == AUTONEG_ENABLE) &&
 	    !(mii_reg & BMSR_ANEGCOMPLETE)) {
+		ulong timeout = PHY_ANEG_TIMEOUT;
 		int i = 0;
 
+		/*
+		 * Autonegotiation has been running since the PHY was reset or
+		 * last restarted, so only wait for the time that is left. Once
+		 * that has run out, e.g. because the cable was plugged in
+		 * later, wait for the full time again.
+		 */
+		if (IS_ENABLED(CONFIG_PHY_ANEG_ASYNC) && phydev->aneg_start) {
+			ulong elapsed = get_timer(phydev->aneg_start);
+
+			if (elapsed < timeout)
+				timeout -= elapsed;
+		}
+
 		printf("%s Waiting for PHY auto negotiation to complete",
 		       phydev->dev->name);
 		while (!(mii_reg & BMSR_ANEGCOMPLETE)) {
 			/*
 			 * Timeout reached ?
 			 */
-			if (i > (PHY_ANEG_TIMEOUT / 50)) {
+			if (i > (timeout / 50)) {
 				printf(" TIMEOUT !\n");
 				phydev->link = 0;
 				return -ETIMEDOUT;
@@ -268,8 +315,12 @@ int genphy_update_link(struct phy_device *phydev)
 			mdelay(50);	/* 50 ms */
 		}
 		printf(" done\n");
+		phy_aneg_done(phydev);
 		phydev->link = 1;
 	} else {
+		if (mii_reg & BMSR_ANEGCOMPLETE)
+			phy_aneg_done(phydev);
+
 		/* Read the link a second time to clear the latched state */
 		mii_reg = phy_read(phydev, MDIO_DEVAD_NONE, MII_BMSR);
 
@@ -927,8 +978,9 @@ void phy_connect_dev(struct phy_device *phydev, struct eth_device *dev,
 		     phy_interface_t interface)
 #endif
 {
-	/* Soft Reset the PHY */
-	phy_reset(phydev);
+	/* Soft Reset the PHY, which also restarts autonegotiation */
+	if (!phy_reset(phydev))
+		phy_aneg_started(phydev);
 	if (phydev->dev && phydev->dev != dev) {
 		printf("%s:%d is connected to %s.  Reconnecting to %s\n",
 		       phydev->bus->name, phydev->addr,
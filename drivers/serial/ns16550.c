@@ -24,6 +24,8 @@ DECLARE_GLOBAL_DATA_PTR;
 #define UART_LCRVAL UART_LCR_8N1		/* 8 data, 1 stop, no parity */
 #define UART_MCRVAL (UART_MCR_DTR | \
 		     UART_MCR_RTS)		/* RTS/DTR */
+/* TX FIFO depth of a 16550A; later variants have at least as much */
+#define NS16550_TX_FIFO_SIZE	16
 
 #if !CONFIG_IS_ENABLED(DM_SERIAL)
 #ifdef CONFIG_SYS_NS16550_PORT_MAPPED
@@ -400,6 +402,29 @@ static int ns16550_serial_putc(struct udevice *dev, const char ch)
 	return 0;
 }
 
+static ssize_t ns16550_serial_puts(struct udevice *dev, const char *s,
+				   size_t len)
+{
+	struct ns16550 *const com_port = dev_get_priv(dev);
+	size_t i;
+
+	/* Once the transmitter is empty, the whole FIFO can be loaded */
+	if (!(serial_in(&com_port->lsr) & UART_LSR_THRE))
+		return -EAGAIN;
+	if (ns16550_getfcr(com_port) & UART_FCR_FIFO_EN)
+		len = min_t(size_t, len, NS16550_TX_FIFO_SIZE);
+	else
+		len = 1;
+	for (i = 0; i < len; i++) {
+		serial_out(s[i], &com_port->thr);
+		/* See ns16550_serial_putc() */
+		if (s[i] == '\n')
+			WATCHDOG_RESET();
+	}
+
+	return len;
+}
+
 static int ns16550_serial_pending(struct udevice *dev, bool input)
 {
 	struct ns16550 *const com_port = dev_get_priv(dev);
@@ -585,6 +610,7 @@ int ns16550_serial_of_to_plat(struct udevice *dev)
 
 const struct dm_serial_ops ns16550_serial_ops = {
 	.putc = ns16550_serial_putc,
+	.puts = ns16550_serial_puts,
 	.pending = ns16550_serial_pending,
 	.getc = ns16550_serial_getc,
 	.setbrg = ns16550_serial_setbrg,
@@ -25,6 +25,7 @@ DECLARE_GLOBAL_DATA_PTR;
 
 static size_t _sandbox_serial_written = 1;
 static bool sandbox_serial_enabled = true;
+static bool sandbox_serial_busy;
 
 size_t sandbox_serial_written(void)
 {
@@ -36,6 +37,11 @@ void sandbox_serial_endisable(bool enabled)
 	sandbox_serial_enabled = enabled;
 }
 
+void sandbox_serial_set_busy(bool busy)
+{
+	sandbox_serial_busy = busy;
+}
+
 /**
  * output_ansi_colour() - Output an ANSI colour code
  *
@@ -97,6 +103,8 @@ static int sandbox_serial_putc(struct udevice *dev, const char ch)
 {
 	struct sandbox_serial_priv *priv = dev_get_priv(dev);
 
+	if (sandbox_serial_busy)
+		return -EAGAIN;
 	if (ch == '\n')
 		priv->start_of_line = true;
 
@@ -114,6 +122,8 @@ static ssize_t sandbox_serial_puts(struct udevice *dev, const char *s,
 	struct sandbox_serial_priv *priv = dev_get_priv(dev);
 	ssize_t ret;
 
+	if (sandbox_serial_busy)
+		return -EAGAIN;
 	if (len && s[len - 1] == '\n')
 		priv->start_of_line = true;
 
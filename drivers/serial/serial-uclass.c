@@ -6,6 +6,7 @@
 #define LOG_CATEGORY UCLASS_SERIAL
 
 #include <common.h>
+#include <div64.h>
 #include <dm.h>
 #include <env_internal.h>
 #include <errno.h>
@@ -13,6 +14,7 @@
 #include <os.h>
 #include <serial.h>
 #include <stdio_dev.h>
+#include <time.h>
 #include <watchdog.h>
 #include <asm/global_data.h>
 #include <dm/lists.h>
@@ -185,11 +187,169 @@ int serial_initialize(void)
 	return serial_init();
 }
 
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+/* Check whether output to @dev should go through its TX buffer */
+static bool serial_tx_buffered(struct udevice *dev)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	/* Output from within the driver itself bypasses the buffer */
+	return upriv->tx_buf && !upriv->tx_busy;
+}
+
+/**
+ * serial_tx_send() - Send what the UART accepts from the TX buffer
+ *
+ * This does not wait for the UART. Drivers with a puts() method are handed
+ * as many characters as possible at once, so they can fill their FIFO.
+ *
+ * @dev: Serial device
+ * Return: number of characters sent
+ */
+static uint serial_tx_send(struct udevice *dev)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+	struct dm_serial_ops *ops = serial_get_ops(dev);
+	uint start = upriv->tx_tail;
+
+	if (upriv->tx_busy)
+		return 0;
+	upriv->tx_busy = true;
+	while (upriv->tx_head != upriv->tx_tail) {
+		uint pos = upriv->tx_tail % CONFIG_SERIAL_TX_BUFFER_SIZE;
+		ssize_t ret;
+
+		if (CONFIG_IS_ENABLED(SERIAL_PUTS) && ops->puts) {
+			/* Stop at the end of the buffer; the rest comes next */
+			ret = ops->puts(dev, upriv->tx_buf + pos,
+					min(upriv->tx_head - upriv->tx_tail,
+					    CONFIG_SERIAL_TX_BUFFER_SIZE - pos));
+		} else {
+			ret = ops->putc(dev, upriv->tx_buf[pos]);
+			if (!ret)
+				ret = 1;
+		}
+		if (ret == -EAGAIN || !ret)
+			break;
+		/* Drop the output on error, as the unbuffered path does */
+		if (ret < 0)
+			upriv->tx_tail = upriv->tx_head;
+		else
+			upriv->tx_tail += ret;
+	}
+	upriv->tx_busy = false;
+
+	return upriv->tx_tail - start;
+}
+
+/**
+ * serial_tx_wait() - Wait until the TX buffer holds at most @left characters
+ *
+ * @dev: Serial device
+ * @left: Number of characters which may stay in the buffer
+ */
+static void serial_tx_wait(struct udevice *dev, uint left)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+	ulong start;
+
+	if (upriv->tx_head - upriv->tx_tail <= left)
+		return;
+	start = timer_get_us();
+	while (upriv->tx_head - upriv->tx_tail > left && !upriv->tx_busy)
+		serial_tx_send(dev);
+	upriv->tx_stats.wait_us += timer_get_us() - start;
+}
+
+/* Put a character in the TX buffer, waiting for room if it is full */
+static void serial_tx_queue(struct udevice *dev, char ch)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	if (ch == '\n')
+		serial_tx_queue(dev, '\r');
+
+	serial_tx_wait(dev, CONFIG_SERIAL_TX_BUFFER_SIZE - 1);
+	upriv->tx_buf[upriv->tx_head++ % CONFIG_SERIAL_TX_BUFFER_SIZE] = ch;
+	upriv->tx_stats.queued++;
+}
+
+/* Send buffered output from a loop that would otherwise just spin */
+static void serial_tx_idle(struct udevice *dev)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	if (upriv->tx_head != upriv->tx_tail)
+		upriv->tx_stats.idle += serial_tx_send(dev);
+}
+
+/* Send all buffered output, e.g. before the UART is abandoned */
+static void serial_tx_flush(struct udevice *dev)
+{
+	serial_tx_wait(dev, 0);
+}
+
+void serial_tx_poll(void)
+{
+	if (gd->cur_serial_dev)
+		serial_tx_idle(gd->cur_serial_dev);
+}
+
+void serial_flush(void)
+{
+	if (gd->cur_serial_dev)
+		serial_tx_flush(gd->cur_serial_dev);
+}
+
+int serial_get_tx_stats(struct udevice *dev, struct serial_tx_stats *stats,
+			ulong *reclaimedp)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	if (!upriv->tx_buf)
+		return -ENOENT;
+	*stats = upriv->tx_stats;
+	/* Each character takes 10 bit times with 8n1 framing */
+	*reclaimedp = gd->baudrate ?
+		lldiv((u64)stats->idle * 10 * 1000000, gd->baudrate) : 0;
+
+	return 0;
+}
+#else
+static bool serial_tx_buffered(struct udevice *dev)
+{
+	return false;
+}
+
+static void serial_tx_queue(struct udevice *dev, char ch)
+{
+}
+
+static uint serial_tx_send(struct udevice *dev)
+{
+	return 0;
+}
+
+static void serial_tx_idle(struct udevice *dev)
+{
+}
+
+static void serial_tx_flush(struct udevice *dev)
+{
+}
+#endif /* CONFIG_IS_ENABLED(SERIAL_TX_BUFFER) */
+
 static void _serial_putc(struct udevice *dev, char ch)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
 	int err;
 
+	if (serial_tx_buffered(dev)) {
+		serial_tx_queue(dev, ch);
+		serial_tx_send(dev);
+		return;
+	}
+
 	if (ch == '\n')
 		_serial_putc(dev, '\r');
 
@@ -205,6 +365,8 @@ static int __serial_puts(struct udevice *dev, const char *str, size_t len)
 	do {
 		ssize_t written = ops->puts(dev, str, len);
 
+		if (written == -EAGAIN)
+			continue;
 		if (written < 0)
 			return written;
 		str += written;
@@ -218,6 +380,13 @@ static void _serial_puts(struct udevice *dev, const char *str)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
 
+	if (serial_tx_buffered(dev)) {
+		while (*str)
+			serial_tx_queue(dev, *str++);
+		serial_tx_send(dev);
+		return;
+	}
+
 	if (!CONFIG_IS_ENABLED(SERIAL_PUTS) || !ops->puts) {
 		while (*str)
 			_serial_putc(dev, *str++);
@@ -245,8 +414,10 @@ static int __serial_getc(struct udevice *dev)
 
 	do {
 		err = ops->getc(dev);
-		if (err == -EAGAIN)
+		if (err == -EAGAIN) {
+			serial_tx_idle(dev);
 			WATCHDOG_RESET();
+		}
 	} while (err == -EAGAIN);
 
 	return err >= 0 ? err : 0;
@@ -256,6 +427,9 @@ static int __serial_tstc(struct udevice *dev)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
 
+	/* Callers poll this while waiting for input, so send output meanwhile */
+	serial_tx_idle(dev);
+
 	if (ops->pending)
 		return ops->pending(dev, true);
 
@@ -407,6 +581,11 @@ static int serial_stub_tstc(struct stdio_dev *sdev)
 {
 	return _serial_tstc(sdev->priv);
 }
+
+static void serial_stub_flush(struct stdio_dev *sdev)
+{
+	serial_tx_flush(sdev->priv);
+}
 #endif
 #endif
 
@@ -522,11 +701,16 @@ static int serial_post_probe(struct udevice *dev)
 	sdev.puts = serial_stub_puts;
 	sdev.getc = serial_stub_getc;
 	sdev.tstc = serial_stub_tstc;
+	sdev.flush = serial_stub_flush;
 
 #if CONFIG_IS_ENABLED(SERIAL_RX_BUFFER)
 	/* Allocate the RX buffer */
 	upriv->buf = malloc(CONFIG_SERIAL_RX_BUFFER_SIZE);
 #endif
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+	/* Allocate the TX buffer; without it output is not buffered */
+	upriv->tx_buf = malloc(CONFIG_SERIAL_TX_BUFFER_SIZE);
+#endif
 
 	stdio_register_dev(&sdev, &upriv->sdev);
 #endif
@@ -541,6 +725,8 @@ static int serial_pre_remove(struct udevice *dev)
 	if (stdio_deregister_dev(upriv->sdev, true))
 		return -EPERM;
 #endif
+	/* Do not lose buffered output when the device goes away */
+	serial_tx_flush(dev);
 
 	return 0;
 }
@@ -400,10 +400,17 @@ static int sandbox_flash_probe(struct udevice *dev)
 {
 	struct sandbox_flash_plat *plat = dev_get_plat(dev);
 	struct sandbox_flash_priv *priv = dev_get_priv(dev);
-
-	priv->fd = os_open(plat->pathname, OS_O_RDONLY);
+	char fname[256];
+	int ret;
+
+	if (!plat->pathname)
+		return 0;
+	ret = os_persistent_file(fname, sizeof(fname), plat->pathname);
+	if (ret)
+		return ret;
+	priv->fd = os_open(fname, OS_O_RDONLY);
 	if (priv->fd != -1)
-		return os_get_filesize(plat->pathname, &priv->file_size);
+		return os_get_filesize(fname, &priv->file_size);
 
 	return 0;
 }
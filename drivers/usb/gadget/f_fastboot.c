@@ -482,6 +482,10 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 
 	req->actual = 0;
 	usb_ep_queue(ep, req, 0);
+
+	/* Write buffered data while the next transfer is received */
+	if (req->complete == rx_handler_dl_image)
+		fastboot_data_flush();
 }
 
 static void do_exit_on_complete(struct usb_ep *ep, struct usb_request *req)
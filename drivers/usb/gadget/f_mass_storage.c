@@ -246,6 +246,7 @@
 #include <common.h>
 #include <console.h>
 #include <g_dnl.h>
+#include <time.h>
 #include <dm/devres.h>
 #include <linux/bug.h>
 
@@ -260,6 +261,7 @@
 #include <linux/usb/gadget.h>
 #include <linux/usb/composite.h>
 #include <linux/bitmap.h>
+#include <linux/math64.h>
 #include <g_dnl.h>
 
 /*------------------------------------------------------------------------*/
@@ -290,6 +292,32 @@ struct completion {int x; };
 struct fsg_dev;
 struct fsg_common;
 
+/*
+ * Contents of the spare buffer used for read-ahead and write-behind.
+ *
+ * Within a command, USB transfers only overlap with storage accesses when
+ * the controller moves the queued requests by itself (DMA). A PIO-only
+ * controller copies each packet from usb_gadget_handle_interrupts(), so
+ * there the two still take turns. Bulk-only transport allows one command
+ * in flight, so between commands a single spare buffer is all that can be
+ * filled or drained while waiting for the next CBW.
+ */
+enum fsg_ahead_state {
+	AHEAD_NONE = 0,
+	AHEAD_READ,		/* data read ahead of a sequential READ */
+	AHEAD_WRITE,		/* data of a WRITE not yet written */
+};
+
+/* Per-session statistics, printed when ums exits */
+struct fsg_stats {
+	u64			read_bytes;
+	u64			read_us;
+	u64			write_bytes;
+	u64			write_us;
+	unsigned int		read_ahead_hits;
+	unsigned int		writes_behind;
+};
+
 /* Data shared by all the FSG instances. */
 struct fsg_common {
 	struct usb_gadget	*gadget;
@@ -303,6 +331,19 @@ struct fsg_common {
 	struct fsg_buffhd	*next_buffhd_to_drain;
 	struct fsg_buffhd	buffhds[FSG_NUM_BUFFERS];
 
+	void			*ahead_buf;
+	enum fsg_ahead_state	ahead_state;
+	unsigned int		ahead_lun;
+	u32			ahead_lba;
+	u32			ahead_count;	/* in sectors */
+
+	/* Where the last READ ended and whether it followed the one before */
+	unsigned int		ra_lun;
+	u32			ra_lba;
+	unsigned int		ra_wanted:1;
+
+	struct fsg_stats	stats;
+
 	int			cmnd_size;
 	u8			cmnd[MAX_COMMAND_SIZE];
 
@@ -688,6 +729,84 @@ static int sleep_thread(struct fsg_common *common)
 
 /*-------------------------------------------------------------------------*/
 
+/* Exchange the data buffer of @bh with the one at @buf */
+static void fsg_swap_buf(struct fsg_buffhd *bh, void **buf)
+{
+	void *tmp = bh->buf;
+
+	bh->buf = *buf;
+	bh->inreq->buf = bh->outreq->buf = bh->buf;
+	*buf = tmp;
+}
+
+/* Write the data held back from the last WRITE command */
+static void fsg_write_behind(struct fsg_common *common)
+{
+	unsigned int lun = common->ahead_lun;
+	int rc;
+
+	if (common->ahead_state != AHEAD_WRITE)
+		return;
+
+	common->ahead_state = AHEAD_NONE;
+	rc = ums[lun].write_sector(&ums[lun], common->ahead_lba,
+				   common->ahead_count, common->ahead_buf);
+	if (rc != common->ahead_count) {
+		printf("\rUMS: write of %u sectors at %u failed\n",
+		       common->ahead_count, common->ahead_lba);
+		common->luns[lun].write_error = 1;
+		common->luns[lun].sense_data_info = common->ahead_lba +
+						    max(rc, 0);
+	}
+}
+
+/* Read the data which a sequential READ is likely to ask for next */
+static void fsg_read_ahead(struct fsg_common *common)
+{
+	unsigned int lun = common->ra_lun;
+	u32 count;
+	int rc;
+
+	if (!common->ra_wanted || common->ahead_state != AHEAD_NONE)
+		return;
+
+	common->ra_wanted = 0;
+	if (common->ra_lba >= common->luns[lun].num_sectors)
+		return;
+
+	count = min_t(u64, FSG_BUFLEN / SECTOR_SIZE,
+		      common->luns[lun].num_sectors - common->ra_lba);
+	rc = ums[lun].read_sector(&ums[lun], common->ra_lba, count,
+				  common->ahead_buf);
+	if (rc <= 0)
+		return;
+
+	common->ahead_state = AHEAD_READ;
+	common->ahead_lun = lun;
+	common->ahead_lba = common->ra_lba;
+	common->ahead_count = rc;
+}
+
+static void fsg_print_stats(struct fsg_common *common)
+{
+	struct fsg_stats *stats = &common->stats;
+
+	printf("\rUMS: read %llu KiB at %llu KiB/s, wrote %llu KiB at %llu KiB/s\n",
+	       stats->read_bytes >> 10,
+	       stats->read_us ?
+	       div64_u64(stats->read_bytes * 1000000 >> 10, stats->read_us) : 0,
+	       stats->write_bytes >> 10,
+	       stats->write_us ?
+	       div64_u64(stats->write_bytes * 1000000 >> 10, stats->write_us) :
+	       0);
+	if (IS_ENABLED(CONFIG_USB_FUNCTION_MASS_STORAGE_READ_AHEAD) ||
+	    IS_ENABLED(CONFIG_USB_FUNCTION_MASS_STORAGE_WRITE_BEHIND))
+		printf("UMS: %u read-ahead hits, %u writes behind\n",
+		       stats->read_ahead_hits, stats->writes_behind);
+}
+
+/*-------------------------------------------------------------------------*/
+
 static int do_read(struct fsg_common *common)
 {
 	struct fsg_lun		*curlun = &common->luns[common->lun];
@@ -699,6 +818,7 @@ static int do_read(struct fsg_common *common)
 	unsigned int		amount;
 	unsigned int		partial_page;
 	ssize_t			nread;
+	ulong			start;
 
 	/* Get the starting Logical Block Address and check that it's
 	 * not too big */
@@ -726,6 +846,7 @@ static int do_read(struct fsg_common *common)
 	if (unlikely(amount_left == 0))
 		return -EIO;		/* No default reply */
 
+	start = timer_get_us();
 	for (;;) {
 
 		/* Figure out how much we need to read:
@@ -761,11 +882,21 @@ static int do_read(struct fsg_common *common)
 			break;
 		}
 
-		/* Perform the read */
-		rc = ums[common->lun].read_sector(&ums[common->lun],
-				      file_offset / SECTOR_SIZE,
-				      amount / SECTOR_SIZE,
-				      (char __user *)bh->buf);
+		/* Perform the read, unless it was done ahead of time */
+		if (common->ahead_state == AHEAD_READ &&
+		    common->ahead_lun == common->lun &&
+		    common->ahead_lba == file_offset / SECTOR_SIZE) {
+			amount = min(amount, common->ahead_count * SECTOR_SIZE);
+			fsg_swap_buf(bh, &common->ahead_buf);
+			common->ahead_state = AHEAD_NONE;
+			common->stats.read_ahead_hits++;
+			rc = amount / SECTOR_SIZE;
+		} else {
+			rc = ums[common->lun].read_sector(&ums[common->lun],
+					      file_offset / SECTOR_SIZE,
+					      amount / SECTOR_SIZE,
+					      (char __user *)bh->buf);
+		}
 		if (!rc)
 			return -EIO;
 
@@ -810,6 +941,18 @@ static int do_read(struct fsg_common *common)
 		common->next_buffhd_to_fill = bh->next;
 	}
 
+	common->stats.read_bytes += common->data_size_from_cmnd - amount_left;
+	common->stats.read_us += timer_get_us() - start;
+
+	/* Read ahead once the host is seen reading sequentially */
+	if (IS_ENABLED(CONFIG_USB_FUNCTION_MASS_STORAGE_READ_AHEAD) &&
+	    !amount_left) {
+		common->ra_wanted = common->ra_lun == common->lun &&
+				    common->ra_lba == lba;
+		common->ra_lun = common->lun;
+		common->ra_lba = file_offset / SECTOR_SIZE;
+	}
+
 	return -EIO;		/* No default reply */
 }
 
@@ -827,12 +970,16 @@ static int do_write(struct fsg_common *common)
 	unsigned int		partial_page;
 	ssize_t			nwritten;
 	int			rc;
+	bool			write_behind;
+	ulong			start;
 
 	if (curlun->ro) {
 		curlun->sense_data = SS_WRITE_PROTECTED;
 		return -EINVAL;
 	}
 
+	write_behind = IS_ENABLED(CONFIG_USB_FUNCTION_MASS_STORAGE_WRITE_BEHIND);
+
 	/* Get the starting Logical Block Address and check that it's
 	 * not too big */
 	if (common->cmnd[0] == SC_WRITE_6)
@@ -848,18 +995,26 @@ static int do_write(struct fsg_common *common)
 			curlun->sense_data = SS_INVALID_FIELD_IN_CDB;
 			return -EINVAL;
 		}
+		if (!curlun->nofua && (common->cmnd[1] & 0x08))
+			write_behind = false;
 	}
 	if (lba >= curlun->num_sectors) {
 		curlun->sense_data = SS_LOGICAL_BLOCK_ADDRESS_OUT_OF_RANGE;
 		return -EINVAL;
 	}
 
+	/* Anything read ahead may be about to change */
+	if (common->ahead_state == AHEAD_READ)
+		common->ahead_state = AHEAD_NONE;
+	common->ra_wanted = 0;
+
 	/* Carry out the file writes */
 	get_some_more = 1;
 	file_offset = usb_offset = ((loff_t) lba) << 9;
 	amount_left_to_req = common->data_size_from_cmnd;
 	amount_left_to_write = common->data_size_from_cmnd;
 
+	start = timer_get_us();
 	while (amount_left_to_write > 0) {
 
 		/* Queue a request for more data from the host */
@@ -935,11 +1090,27 @@ static int do_write(struct fsg_common *common)
 
 			amount = bh->outreq->actual;
 
-			/* Perform the write */
-			rc = ums[common->lun].write_sector(&ums[common->lun],
-					       file_offset / SECTOR_SIZE,
-					       amount / SECTOR_SIZE,
-					       (char __user *)bh->buf);
+			/*
+			 * Perform the write. The last buffer of the command
+			 * may be held back and written while the host sends
+			 * its next command.
+			 */
+			if (write_behind && amount == amount_left_to_write &&
+			    common->ahead_state == AHEAD_NONE) {
+				fsg_swap_buf(bh, &common->ahead_buf);
+				common->ahead_state = AHEAD_WRITE;
+				common->ahead_lun = common->lun;
+				common->ahead_lba = file_offset / SECTOR_SIZE;
+				common->ahead_count = amount / SECTOR_SIZE;
+				common->stats.writes_behind++;
+				rc = amount / SECTOR_SIZE;
+			} else {
+				rc = ums[common->lun].write_sector(
+					&ums[common->lun],
+					file_offset / SECTOR_SIZE,
+					amount / SECTOR_SIZE,
+					(char __user *)bh->buf);
+			}
 			if (!rc)
 				return -EIO;
 			nwritten = rc * SECTOR_SIZE;
@@ -985,6 +1156,10 @@ static int do_write(struct fsg_common *common)
 			return rc;
 	}
 
+	common->stats.write_bytes += common->data_size_from_cmnd -
+				     amount_left_to_write;
+	common->stats.write_us += timer_get_us() - start;
+
 	return -EIO;		/* No default reply */
 }
 
@@ -1739,6 +1914,15 @@ static int check_command(struct fsg_common *common, int cmnd_size,
 			curlun->sense_data = SS_NO_SENSE;
 			curlun->info_valid = 0;
 		}
+
+		/* Fail the next command if a held-back write failed */
+		if (curlun->write_error && common->cmnd[0] != SC_INQUIRY &&
+		    common->cmnd[0] != SC_REQUEST_SENSE) {
+			curlun->write_error = 0;
+			curlun->sense_data = SS_WRITE_ERROR;
+			curlun->info_valid = 1;
+			return -EINVAL;
+		}
 	} else {
 		curlun = NULL;
 		common->bad_lun_okay = 0;
@@ -2136,6 +2320,10 @@ static int get_next_command(struct fsg_common *common)
 	 * can reuse it for the next filling.  No need to advance
 	 * next_buffhd_to_fill. */
 
+	/* Use the time until the CBW arrives for storage accesses */
+	fsg_write_behind(common);
+	fsg_read_ahead(common);
+
 	/* Wait for the CBW to arrive */
 	while (bh->state != BUF_STATE_FULL) {
 		rc = sleep_thread(common);
@@ -2405,14 +2593,14 @@ int fsg_main_thread(void *common_)
 		if (!common->running) {
 			ret = sleep_thread(common);
 			if (ret)
-				return ret;
+				goto out;
 
 			continue;
 		}
 
 		ret = get_next_command(common);
 		if (ret)
-			return ret;
+			goto out;
 
 		if (!exception_in_progress(common))
 			common->state = FSG_STATE_DATA_PHASE;
@@ -2433,6 +2621,13 @@ int fsg_main_thread(void *common_)
 	common->thread_task = NULL;
 
 	return 0;
+
+out:
+	/* The session is over */
+	fsg_write_behind(common);
+	fsg_print_stats(common);
+
+	return ret;
 }
 
 static void fsg_common_release(struct kref *ref);
@@ -2516,6 +2711,16 @@ buffhds_first_it:
 	} while (--i);
 	bh->next = common->buffhds;
 
+	if (IS_ENABLED(CONFIG_USB_FUNCTION_MASS_STORAGE_READ_AHEAD) ||
+	    IS_ENABLED(CONFIG_USB_FUNCTION_MASS_STORAGE_WRITE_BEHIND)) {
+		common->ahead_buf = memalign(CONFIG_SYS_CACHELINE_SIZE,
+					     FSG_BUFLEN);
+		if (unlikely(!common->ahead_buf)) {
+			rc = -ENOMEM;
+			goto error_release;
+		}
+	}
+
 	snprintf(common->inquiry_string, sizeof common->inquiry_string,
 		 "%-8s%-16s%04x",
 		 "Linux   ",
@@ -2581,6 +2786,7 @@ static void fsg_common_release(struct kref *ref)
 			kfree(bh->buf);
 		} while (++bh, --i);
 	}
+	kfree(common->ahead_buf);
 
 	if (common->free_storage_on_release)
 		kfree(common);
@@ -286,6 +286,7 @@ struct fsg_lun {
 	unsigned int	registered:1;
 	unsigned int	info_valid:1;
 	unsigned int	nofua:1;
+	unsigned int	write_error:1;	/* a write-behind failed */
 
 	u32		sense_data;
 	u32		sense_data_info;
@@ -306,11 +307,17 @@ static struct fsg_lun *fsg_lun_from_dev(struct device *dev)
 #define EP0_BUFSIZE	256
 #define DELAYED_STATUS	(EP0_BUFSIZE + 999)	/* An impossibly large value */
 
-/* Number of buffers we will use.  2 is enough for double-buffering */
-#define FSG_NUM_BUFFERS	2
+/*
+ * Number of buffers we will use.  2 is enough for double-buffering; more
+ * let USB transfers run further ahead of the storage accesses.
+ */
+#define FSG_NUM_BUFFERS	CONFIG_USB_FUNCTION_MASS_STORAGE_BUFFERS
 
-/* Default size of buffer length. */
-#define FSG_BUFLEN	((u32)131072)
+/* Size of each buffer */
+#define FSG_BUFLEN	((u32)CONFIG_USB_FUNCTION_MASS_STORAGE_BUFLEN)
+#if CONFIG_USB_FUNCTION_MASS_STORAGE_BUFLEN % 4096
+#error "CONFIG_USB_FUNCTION_MASS_STORAGE_BUFLEN must be a multiple of 4096"
+#endif
 
 /* Maximal number of LUNs supported in mass storage function */
 #define FSG_MAX_LUNS	8
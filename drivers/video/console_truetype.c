@@ -211,7 +211,7 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 	u8 *bits, *data;
 	int advance;
 	void *start, *end, *line;
-	int row, ret;
+	int row;
 
 	/* First get some basic metrics about this character */
 	stbtt_GetCodepointHMetrics(font, ch, &advance, &lsb);
@@ -348,9 +348,8 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 
 		line += vid_priv->line_length;
 	}
-	ret = vidconsole_sync_copy(dev, start, line);
-	if (ret)
-		return ret;
+	video_damage(vid, VID_TO_PIXEL(x) + xoff, y + max(linenum, 0), width,
+		     height);
 	free(data);
 
 	return width_frac;
@@ -376,7 +375,7 @@ static int console_truetype_erase(struct udevice *dev, int xstart, int ystart,
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
 	void *start, *line;
 	int pixels = xend - xstart;
-	int row, i, ret;
+	int row, i;
 
 	start = vid_priv->fb + ystart * vid_priv->line_length;
 	start += xstart * VNBYTES(vid_priv->bpix);
@@ -415,9 +414,7 @@ static int console_truetype_erase(struct udevice *dev, int xstart, int ystart,
 		}
 		line += vid_priv->line_length;
 	}
-	ret = vidconsole_sync_copy(dev, start, line);
-	if (ret)
-		return ret;
+	video_damage(dev->parent, xstart, ystart, xend - xstart, yend - ystart);
 
 	return 0;
 }
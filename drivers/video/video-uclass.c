@@ -122,7 +122,6 @@ int video_reserve(ulong *addrp)
 int video_clear(struct udevice *dev)
 {
 	struct video_priv *priv = dev_get_uclass_priv(dev);
-	int ret;
 
 	switch (priv->bpix) {
 	case VIDEO_BPP16:
@@ -147,9 +146,7 @@ int video_clear(struct udevice *dev)
 		memset(priv->fb, priv->colour_bg, priv->fb_size);
 		break;
 	}
-	ret = video_sync_copy(dev, priv->fb, priv->fb + priv->fb_size);
-	if (ret)
-		return ret;
+	video_damage(dev, 0, 0, priv->xsize, priv->ysize);
 
 	return video_sync(dev, false);
 }
@@ -180,12 +177,90 @@ void video_set_default_colors(struct udevice *dev, bool invert)
 	priv->colour_bg = vid_console_color(priv, back);
 }
 
+/* Forget about the changes, once they have been synced */
+static void video_damage_reset(struct video_priv *priv)
+{
+	priv->damage.xstart = priv->xsize;
+	priv->damage.ystart = priv->ysize;
+	priv->damage.xend = 0;
+	priv->damage.yend = 0;
+}
+
+/**
+ * video_damage_range() - Get the frame buffer range to sync for a line
+ *
+ * @priv:	Video device private data
+ * @startp:	Returns the byte offset of the damage within each line
+ * @sizep:	Returns the number of bytes to sync in each line
+ * Return: number of lines to handle at once (1, or all damaged lines if whole
+ *	lines are damaged so a single range covers them), 0 if nothing changed
+ */
+static int video_damage_range(struct video_priv *priv, ulong *startp,
+			      ulong *sizep)
+{
+	int pbytes = VNBYTES(priv->bpix);
+	int lines = priv->damage.yend - priv->damage.ystart;
+
+	if (priv->damage.xend <= priv->damage.xstart || lines <= 0)
+		return 0;
+
+	/* Sub-byte pixels and full-width damage are synced by whole lines */
+	if (!pbytes || (!priv->damage.xstart &&
+			priv->damage.xend == priv->xsize)) {
+		*startp = 0;
+		*sizep = priv->line_length * lines;
+		return lines;
+	}
+	*startp = priv->damage.xstart * pbytes;
+	*sizep = (priv->damage.xend - priv->damage.xstart) * pbytes;
+
+	return 1;
+}
+
+/* Copy the changed part of the frame buffer to the hardware copy */
+static void video_damage_copy(struct video_priv *priv)
+{
+	ulong start, size, offset;
+	int y, step;
+
+	step = video_damage_range(priv, &start, &size);
+	if (!priv->copy_fb || !step)
+		return;
+	for (y = priv->damage.ystart; y < priv->damage.yend; y += step) {
+		offset = y * priv->line_length + start;
+		memcpy(priv->copy_fb + offset, priv->fb + offset, size);
+	}
+}
+
+/* Flush the data cache for the changed part of the frame buffer */
+static void __maybe_unused video_damage_flush(struct video_priv *priv)
+{
+	ulong fb = (ulong)(priv->copy_fb ? priv->copy_fb : priv->fb);
+	ulong start, size, addr;
+	int y, step;
+
+	step = video_damage_range(priv, &start, &size);
+	if (!step)
+		return;
+	for (y = priv->damage.ystart; y < priv->damage.yend; y += step) {
+		addr = fb + y * priv->line_length + start;
+		flush_dcache_range(ALIGN_DOWN(addr, CONFIG_SYS_CACHELINE_SIZE),
+				   ALIGN(addr + size, CONFIG_SYS_CACHELINE_SIZE));
+	}
+}
+
 /* Flush video activity to the caches */
 int video_sync(struct udevice *vid, bool force)
 {
 	struct video_ops *ops = video_get_ops(vid);
+	struct video_priv *priv = dev_get_uclass_priv(vid);
 	int ret;
 
+	if (priv->damage_all)
+		video_damage(vid, 0, 0, priv->xsize, priv->ysize);
+	if (IS_ENABLED(CONFIG_VIDEO_COPY))
+		video_damage_copy(priv);
+
 	if (ops && ops->video_sync) {
 		ret = ops->video_sync(vid);
 		if (ret)
@@ -198,15 +273,15 @@ int video_sync(struct udevice *vid, bool force)
 	 * out whether it exists? For now, ARM is safe.
 	 */
 #if defined(CONFIG_ARM) && !CONFIG_IS_ENABLED(SYS_DCACHE_OFF)
-	struct video_priv *priv = dev_get_uclass_priv(vid);
-
 	if (priv->flush_dcache) {
-		flush_dcache_range((ulong)priv->fb,
-				   ALIGN((ulong)priv->fb + priv->fb_size,
-					 CONFIG_SYS_CACHELINE_SIZE));
+		if (IS_ENABLED(CONFIG_VIDEO_DAMAGE))
+			video_damage_flush(priv);
+		else
+			flush_dcache_range((ulong)priv->fb,
+					   ALIGN((ulong)priv->fb + priv->fb_size,
+						 CONFIG_SYS_CACHELINE_SIZE));
 	}
 #elif defined(CONFIG_VIDEO_SANDBOX_SDL)
-	struct video_priv *priv = dev_get_uclass_priv(vid);
 	static ulong last_sync;
 
 	if (force || get_timer(last_sync) > 100) {
@@ -214,6 +289,8 @@ int video_sync(struct udevice *vid, bool force)
 		last_sync = get_timer(0);
 	}
 #endif
+	video_damage_reset(priv);
+
 	return 0;
 }
 
@@ -261,53 +338,78 @@ int video_get_ysize(struct udevice *dev)
 	return priv->ysize;
 }
 
-#ifdef CONFIG_VIDEO_COPY
-int video_sync_copy(struct udevice *dev, void *from, void *to)
+#ifdef CONFIG_VIDEO_DAMAGE
+void video_damage(struct udevice *dev, int x, int y, int width, int height)
 {
 	struct video_priv *priv = dev_get_uclass_priv(dev);
+	int xend = min(x + width, (int)priv->xsize);
+	int yend = min(y + height, (int)priv->ysize);
+
+	x = max(x, 0);
+	y = max(y, 0);
+	if (x >= xend || y >= yend)
+		return;
+
+	priv->damage.xstart = min(x, priv->damage.xstart);
+	priv->damage.ystart = min(y, priv->damage.ystart);
+	priv->damage.xend = max(xend, priv->damage.xend);
+	priv->damage.yend = max(yend, priv->damage.yend);
+}
 
-	if (priv->copy_fb) {
-		long offset, size;
-
-		/* Find the offset of the first byte to copy */
-		if ((ulong)to > (ulong)from) {
-			size = to - from;
-			offset = from - priv->fb;
-		} else {
-			size = from - to;
-			offset = to - priv->fb;
-		}
+int video_sync_copy(struct udevice *dev, void *from, void *to)
+{
+	struct video_priv *priv = dev_get_uclass_priv(dev);
+	int pbytes = VNBYTES(priv->bpix);
+	long offset, size;
+	int x, y, lines;
+
+	/* Find the offset of the first byte to copy */
+	if ((ulong)to > (ulong)from) {
+		size = to - from;
+		offset = from - priv->fb;
+	} else {
+		size = from - to;
+		offset = to - priv->fb;
+	}
 
-		/*
-		 * Allow a bit of leeway for valid requests somewhere near the
-		 * frame buffer
-		 */
-		if (offset < -priv->fb_size || offset > 2 * priv->fb_size) {
+	/*
+	 * Allow a bit of leeway for valid requests somewhere near the
+	 * frame buffer
+	 */
+	if (offset < -priv->fb_size || offset > 2 * priv->fb_size) {
 #ifdef DEBUG
-			char str[120];
+		char str[120];
 
-			snprintf(str, sizeof(str),
-				 "[** FAULT sync_copy fb=%p, from=%p, to=%p, offset=%lx]",
-				 priv->fb, from, to, offset);
-			console_puts_select_stderr(true, str);
+		snprintf(str, sizeof(str),
+			 "[** FAULT sync_copy fb=%p, from=%p, to=%p, offset=%lx]",
+			 priv->fb, from, to, offset);
+		console_puts_select_stderr(true, str);
 #endif
-			return -EFAULT;
-		}
+		return -EFAULT;
+	}
 
-		/*
-		 * Silently crop the memcpy. This allows callers to avoid doing
-		 * this themselves. It is common for the end pointer to go a
-		 * few lines after the end of the frame buffer, since most of
-		 * the update algorithms terminate a line after their last write
-		 */
-		if (offset + size > priv->fb_size) {
-			size = priv->fb_size - offset;
-		} else if (offset < 0) {
-			size += offset;
-			offset = 0;
-		}
+	/*
+	 * Silently crop the region. This allows callers to avoid doing
+	 * this themselves. It is common for the end pointer to go a
+	 * few lines after the end of the frame buffer, since most of
+	 * the update algorithms terminate a line after their last write
+	 */
+	if (offset + size > priv->fb_size) {
+		size = priv->fb_size - offset;
+	} else if (offset < 0) {
+		size += offset;
+		offset = 0;
+	}
+	if (size <= 0)
+		return 0;
 
-		memcpy(priv->copy_fb + offset, priv->fb + offset, size);
+	y = offset / priv->line_length;
+	lines = DIV_ROUND_UP(offset + size, priv->line_length) - y;
+	if (lines == 1 && pbytes) {
+		x = offset % priv->line_length / pbytes;
+		video_damage(dev, x, y, DIV_ROUND_UP(size, pbytes), 1);
+	} else {
+		video_damage(dev, 0, y, priv->xsize, lines);
 	}
 
 	return 0;
@@ -317,7 +419,8 @@ int video_sync_copy_all(struct udevice *dev)
 {
 	struct video_priv *priv = dev_get_uclass_priv(dev);
 
-	video_sync_copy(dev, priv->fb, priv->fb + priv->fb_size);
+	if (priv->copy_fb)
+		memcpy(priv->copy_fb, priv->fb, priv->fb_size);
 
 	return 0;
 }
@@ -361,6 +464,7 @@ static int video_post_probe(struct udevice *dev)
 
 	if (IS_ENABLED(CONFIG_VIDEO_COPY) && plat->copy_base)
 		priv->copy_fb = map_sysmem(plat->copy_base, plat->size);
+	video_damage_reset(priv);
 
 	/* Set up colors  */
 	video_set_default_colors(dev, false);
@@ -10,7 +10,6 @@
 #include <uuid.h>
 #include <linux/time.h>
 #include "btrfs.h"
-#include "crypto/hash.h"
 #include "disk-io.h"
 
 struct btrfs_fs_info *current_fs_info;
@@ -122,7 +121,6 @@ int btrfs_probe(struct blk_desc *fs_dev_desc,
 	struct btrfs_fs_info *fs_info;
 	int ret = -1;
 
-	btrfs_hash_init();
 	fs_info = open_ctree_fs_info(fs_dev_desc, fs_partition);
 	if (fs_info) {
 		current_fs_info = fs_info;
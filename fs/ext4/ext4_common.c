@@ -1087,6 +1087,101 @@ fail:
 	return -1;
 }
 
+/*
+ * Allocate up to @want blocks in a row, starting the search after the
+ * last block handed out. Returns the first block and sets @count to the
+ * number of blocks allocated, or returns 0 if the partition is full.
+ */
+uint32_t ext4fs_get_new_blk_run(uint32_t want, uint32_t *count)
+{
+	struct ext_filesystem *fs = get_fs();
+	struct ext2_block_group *bgd;
+	uint32_t blk_per_grp = le32_to_cpu(fs->sb->blocks_per_group);
+	uint32_t first_data = le32_to_cpu(fs->sb->first_data_block);
+	uint64_t total = le32_to_cpu(fs->sb->total_blocks);
+	uint32_t bg_idx, bit, end, start, n, i;
+	unsigned char *bmap;
+	char *journal_buffer;
+	uint16_t bg_flags;
+	uint64_t b_bitmap_blk;
+
+	if (le32_to_cpu(fs->sb->feature_incompat) &
+	    EXT4_FEATURE_INCOMPAT_64BIT)
+		total += (uint64_t)le32_to_cpu(fs->sb->total_blocks_high) << 32;
+
+	if (fs->first_pass_bbmap && fs->curr_blkno + 1 < total) {
+		bg_idx = (fs->curr_blkno + 1 - first_data) / blk_per_grp;
+		bit = (fs->curr_blkno + 1 - first_data) % blk_per_grp;
+	} else {
+		bg_idx = 0;
+		bit = 0;
+	}
+
+	/* Look through every group once, wrapping around to the start */
+	for (i = 0; i <= fs->no_blkgrp; i++, bg_idx++, bit = 0) {
+		if (bg_idx >= fs->no_blkgrp)
+			bg_idx = 0;
+		bgd = ext4fs_get_group_descriptor(fs, bg_idx);
+		if (!ext4fs_bg_get_free_blocks(bgd, fs))
+			continue;
+
+		end = min_t(uint64_t, blk_per_grp,
+			    total - first_data - (uint64_t)bg_idx * blk_per_grp);
+		bmap = fs->blk_bmaps[bg_idx];
+		bg_flags = ext4fs_bg_get_flags(bgd);
+		b_bitmap_blk = ext4fs_bg_get_block_id(bgd, fs);
+		if (bg_flags & EXT4_BG_BLOCK_UNINIT) {
+			memset(bmap, 0, fs->blksz);
+			put_ext4(b_bitmap_blk * fs->blksz, bmap, fs->blksz);
+			bg_flags &= ~EXT4_BG_BLOCK_UNINIT;
+			ext4fs_bg_set_flags(bgd, bg_flags);
+		}
+
+		/* Skip whole bytes of used blocks, then find a free one */
+		while (bit < end && (bit & 7) == 0 && bmap[bit / 8] == 0xff)
+			bit += 8;
+		while (bit < end && (bmap[bit / 8] & (1 << (bit % 8)))) {
+			bit++;
+			while (bit < end && (bit & 7) == 0 &&
+			       bmap[bit / 8] == 0xff)
+				bit += 8;
+		}
+		if (bit >= end)
+			continue;
+
+		/* Take as many of the following free blocks as wanted */
+		start = bit;
+		for (n = 0; n < want && bit < end &&
+		     !(bmap[bit / 8] & (1 << (bit % 8))); n++, bit++)
+			bmap[bit / 8] |= 1 << (bit % 8);
+
+		/* journal backup of the bitmap before it was changed */
+		journal_buffer = zalloc(fs->blksz);
+		if (!journal_buffer)
+			return 0;
+		if (ext4fs_devread(b_bitmap_blk * fs->sect_perblk, 0,
+				   fs->blksz, journal_buffer) == 0 ||
+		    ext4fs_log_journal(journal_buffer, b_bitmap_blk)) {
+			free(journal_buffer);
+			return 0;
+		}
+		free(journal_buffer);
+
+		for (i = 0; i < n; i++) {
+			ext4fs_bg_free_blocks_dec(bgd, fs);
+			ext4fs_sb_free_blocks_dec(fs->sb);
+		}
+
+		fs->curr_blkno = first_data + bg_idx * blk_per_grp + bit - 1;
+		fs->first_pass_bbmap = 1;
+		*count = n;
+
+		return first_data + bg_idx * blk_per_grp + start;
+	}
+
+	return 0;
+}
+
 int ext4fs_get_new_inode_no(void)
 {
 	short i;
@@ -1493,20 +1588,184 @@ fail:
 	free(ti_gp_buff_start_addr);
 }
 
-void ext4fs_allocate_blocks(struct ext2_inode *file_inode,
-				unsigned int total_remaining_blocks,
-				unsigned int *total_no_of_block)
+/* Give back a run of blocks taken by ext4fs_get_new_blk_run() */
+static void ext4fs_put_blk_run(uint32_t blk, uint32_t len)
+{
+	struct ext_filesystem *fs = get_fs();
+	uint32_t blk_per_grp = le32_to_cpu(fs->sb->blocks_per_group);
+	struct ext2_block_group *bgd;
+	uint64_t free_blocks;
+	uint32_t i;
+	int bg_idx;
+
+	/* a run never crosses a block group */
+	bg_idx = blk / blk_per_grp;
+	if (fs->blksz == 1024 && !(blk % blk_per_grp))
+		bg_idx--;
+	for (i = 0; i < len; i++)
+		ext4fs_reset_block_bmap(blk + i, fs->blk_bmaps[bg_idx], bg_idx);
+
+	bgd = ext4fs_get_group_descriptor(fs, bg_idx);
+	free_blocks = ext4fs_bg_get_free_blocks(bgd, fs) + len;
+	bgd->free_blocks = cpu_to_le16(free_blocks & 0xffff);
+	if (fs->gdsize == 64)
+		bgd->free_blocks_high = cpu_to_le16(free_blocks >> 16);
+
+	free_blocks = le32_to_cpu(fs->sb->free_blocks);
+	free_blocks += (uint64_t)le32_to_cpu(fs->sb->free_blocks_high) << 32;
+	free_blocks += len;
+	fs->sb->free_blocks = cpu_to_le32(free_blocks & 0xffffffff);
+	fs->sb->free_blocks_high = cpu_to_le32(free_blocks >> 32);
+}
+
+/*
+ * Allocate the blocks of a file as extents of consecutive blocks. Up to
+ * four extents fit in the inode; beyond that they go to leaf blocks, with
+ * the inode holding an index of up to four of them.
+ *
+ * Returns -E2BIG, with all blocks given back, if the free space is too
+ * fragmented for the file to fit in that many extents. Blocks are given back
+ * on other errors too, including the leaf blocks.
+ */
+static int ext4fs_allocate_extents(struct ext2_inode *file_inode,
+				   unsigned int total_remaining_blocks,
+				   unsigned int *total_no_of_block)
+{
+	struct ext_filesystem *fs = get_fs();
+	struct ext4_extent_header *eh =
+		(struct ext4_extent_header *)file_inode->b.blocks.dir_blocks;
+	struct ext4_extent_idx *idx = (struct ext4_extent_idx *)(eh + 1);
+	unsigned int per_leaf = (fs->blksz - sizeof(*eh)) /
+				sizeof(struct ext4_extent);
+	unsigned int max = EXT4_EXT_INODE_ENTRIES * per_leaf;
+	unsigned int nr = 0, nr_leaves = 0, fileblock = 0, leaves, i, n;
+	struct ext4_extent *ext, *cur = NULL;
+	struct ext4_extent_header *leaf;
+	uint32_t blk, len, leaf_blk;
+	uint64_t start;
+	int ret = -ENOSPC;
+
+	ext = calloc(max, sizeof(*ext));
+	leaf = zalloc(fs->blksz);
+	if (!ext || !leaf) {
+		ret = -ENOMEM;
+		goto fail;
+	}
+
+	while (total_remaining_blocks) {
+		blk = ext4fs_get_new_blk_run(min_t(unsigned int,
+						   total_remaining_blocks,
+						   EXT4_EXT_MAX_LEN), &len);
+		if (!blk) {
+			printf("no block left to assign\n");
+			goto fail;
+		}
+		debug("EXT %u: %u+%u\n", fileblock, blk, len);
+
+		/* Grow the last extent if the run carries straight on */
+		if (cur && le32_to_cpu(cur->ee_start_lo) +
+			   le16_to_cpu(cur->ee_len) == blk &&
+		    le16_to_cpu(cur->ee_len) + len <= EXT4_EXT_MAX_LEN) {
+			cur->ee_len = cpu_to_le16(le16_to_cpu(cur->ee_len) +
+						  len);
+		} else {
+			if (nr == max) {
+				debug("file too fragmented for extents\n");
+				ext4fs_put_blk_run(blk, len);
+				ret = -E2BIG;
+				goto fail;
+			}
+			cur = &ext[nr++];
+			cur->ee_block = cpu_to_le32(fileblock);
+			cur->ee_len = cpu_to_le16(len);
+			cur->ee_start_lo = cpu_to_le32(blk);
+		}
+		fileblock += len;
+		total_remaining_blocks -= len;
+	}
+
+	eh->eh_magic = cpu_to_le16(EXT4_EXT_MAGIC);
+	eh->eh_max = cpu_to_le16(EXT4_EXT_INODE_ENTRIES);
+	if (nr <= EXT4_EXT_INODE_ENTRIES) {
+		eh->eh_entries = cpu_to_le16(nr);
+		memcpy(eh + 1, ext, nr * sizeof(*ext));
+		goto done;
+	}
+
+	leaves = DIV_ROUND_UP(nr, per_leaf);
+	eh->eh_entries = cpu_to_le16(leaves);
+	eh->eh_depth = cpu_to_le16(1);
+	for (i = 0; i < leaves; i++) {
+		n = min(nr - i * per_leaf, per_leaf);
+		leaf_blk = ext4fs_get_new_blk_no();
+		if (leaf_blk == -1) {
+			printf("no block left to assign\n");
+			goto fail;
+		}
+		idx[i].ei_leaf_lo = cpu_to_le32(leaf_blk);
+		nr_leaves++;
+		(*total_no_of_block)++;
+
+		memset(leaf, 0, fs->blksz);
+		leaf->eh_magic = cpu_to_le16(EXT4_EXT_MAGIC);
+		leaf->eh_entries = cpu_to_le16(n);
+		leaf->eh_max = cpu_to_le16(per_leaf);
+		memcpy(leaf + 1, &ext[i * per_leaf], n * sizeof(*ext));
+		start = leaf_blk;
+		put_ext4(start * fs->blksz, leaf, fs->blksz);
+
+		idx[i].ei_block = ext[i * per_leaf].ee_block;
+	}
+
+done:
+	file_inode->flags = cpu_to_le32(le32_to_cpu(file_inode->flags) |
+					EXT4_EXTENTS_FL);
+	ret = 0;
+fail:
+	if (ret && ext) {
+		for (i = 0; i < nr_leaves; i++)
+			ext4fs_put_blk_run(le32_to_cpu(idx[i].ei_leaf_lo), 1);
+		*total_no_of_block -= nr_leaves;
+		memset(eh, 0, sizeof(file_inode->b.blocks.dir_blocks));
+		for (i = 0; i < nr; i++)
+			ext4fs_put_blk_run(le32_to_cpu(ext[i].ee_start_lo),
+					   le16_to_cpu(ext[i].ee_len));
+		/* let the next allocation pick up the blocks given back */
+		if (nr)
+			fs->curr_blkno = le32_to_cpu(ext[0].ee_start_lo) - 1;
+	}
+	free(leaf);
+	free(ext);
+
+	return ret;
+}
+
+int ext4fs_allocate_blocks(struct ext2_inode *file_inode,
+			   unsigned int total_remaining_blocks,
+			   unsigned int *total_no_of_block)
 {
 	short i;
 	long int direct_blockno;
 	unsigned int no_blks_reqd = 0;
+	int ret;
+
+	if (total_remaining_blocks &&
+	    le32_to_cpu(get_fs()->sb->feature_incompat) &
+	    EXT4_FEATURE_INCOMPAT_EXTENTS) {
+		ret = ext4fs_allocate_extents(file_inode,
+					      total_remaining_blocks,
+					      total_no_of_block);
+		/* too many extents: fall back to indirect blocks */
+		if (ret != -E2BIG)
+			return ret;
+	}
 
 	/* allocation of direct blocks */
 	for (i = 0; total_remaining_blocks && i < INDIRECT_BLOCKS; i++) {
 		direct_blockno = ext4fs_get_new_blk_no();
 		if (direct_blockno == -1) {
 			printf("no block left to assign\n");
-			return;
+			return -ENOSPC;
 		}
 		file_inode->b.blocks.dir_blocks[i] = cpu_to_le32(direct_blockno);
 		debug("DB %ld: %u\n", direct_blockno, total_remaining_blocks);
@@ -1521,6 +1780,8 @@ void ext4fs_allocate_blocks(struct ext2_inode *file_inode,
 	alloc_triple_indirect_block(file_inode, &total_remaining_blocks,
 				    &no_blks_reqd);
 	*total_no_of_block += no_blks_reqd;
+
+	return total_remaining_blocks ? -ENOSPC : 0;
 }
 
 #endif
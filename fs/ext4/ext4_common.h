@@ -63,6 +63,7 @@ uint16_t ext4fs_checksum_update(unsigned int i);
 int ext4fs_get_parent_inode_num(const char *dirname, char *dname, int flags);
 int ext4fs_update_parent_dentry(char *filename, int file_type);
 uint32_t ext4fs_get_new_blk_no(void);
+uint32_t ext4fs_get_new_blk_run(uint32_t want, uint32_t *count);
 int ext4fs_get_new_inode_no(void);
 void ext4fs_reset_block_bmap(long int blockno, unsigned char *buffer,
 					int index);
@@ -70,9 +71,9 @@ int ext4fs_set_block_bmap(long int blockno, unsigned char *buffer, int index);
 int ext4fs_set_inode_bmap(int inode_no, unsigned char *buffer, int index);
 void ext4fs_reset_inode_bmap(int inode_no, unsigned char *buffer, int index);
 int ext4fs_iget(int inode_no, struct ext2_inode *inode);
-void ext4fs_allocate_blocks(struct ext2_inode *file_inode,
-				unsigned int total_remaining_blocks,
-				unsigned int *total_no_of_block);
+int ext4fs_allocate_blocks(struct ext2_inode *file_inode,
+			   unsigned int total_remaining_blocks,
+			   unsigned int *total_no_of_block);
 void put_ext4(uint64_t off, const void *buf, uint32_t size);
 struct ext2_block_group *ext4fs_get_group_descriptor
 	(const struct ext_filesystem *fs, uint32_t bg_idx);
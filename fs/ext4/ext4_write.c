@@ -435,6 +435,63 @@ fail:
 	free(journal_buffer);
 }
 
+/* Release the index and leaf blocks of an extent tree below @eh */
+static int delete_extent_index_blocks(struct ext4_extent_header *eh)
+{
+	struct ext4_extent_idx *idx = (struct ext4_extent_idx *)(eh + 1);
+	struct ext_filesystem *fs = get_fs();
+	struct ext2_block_group *bgd;
+	uint32_t blk_per_grp = le32_to_cpu(ext4fs_root->sblock.blocks_per_group);
+	char *buf = NULL;
+	uint64_t blknr, b_bitmap_blk;
+	int bg_idx, i, ret = -1;
+
+	if (le16_to_cpu(eh->eh_magic) != EXT4_EXT_MAGIC)
+		return -1;
+	if (!eh->eh_depth)
+		return 0;
+
+	buf = zalloc(fs->blksz);
+	if (!buf)
+		return -ENOMEM;
+
+	for (i = 0; i < le16_to_cpu(eh->eh_entries); i++) {
+		blknr = le16_to_cpu(idx[i].ei_leaf_hi);
+		blknr = (blknr << 32) + le32_to_cpu(idx[i].ei_leaf_lo);
+
+		/* the level below first */
+		if (le16_to_cpu(eh->eh_depth) > 1) {
+			if (!ext4fs_devread(blknr * fs->sect_perblk, 0,
+					    fs->blksz, buf))
+				goto fail;
+			if (delete_extent_index_blocks((struct ext4_extent_header *)
+						       buf))
+				goto fail;
+		}
+
+		bg_idx = blknr / blk_per_grp;
+		if (fs->blksz == 1024 && !(blknr % blk_per_grp))
+			bg_idx--;
+		ext4fs_reset_block_bmap(blknr, fs->blk_bmaps[bg_idx], bg_idx);
+		bgd = ext4fs_get_group_descriptor(fs, bg_idx);
+		ext4fs_bg_free_blocks_inc(bgd, fs);
+		ext4fs_sb_free_blocks_inc(fs->sb);
+		/* journal backup */
+		b_bitmap_blk = ext4fs_bg_get_block_id(bgd, fs);
+		if (!ext4fs_devread(b_bitmap_blk * fs->sect_perblk, 0,
+				    fs->blksz, buf))
+			goto fail;
+		if (ext4fs_log_journal(buf, b_bitmap_blk))
+			goto fail;
+		debug("extent index block releasing %llu\n", blknr);
+	}
+	ret = 0;
+fail:
+	free(buf);
+
+	return ret;
+}
+
 static int ext4fs_delete_file(int inodeno)
 {
 	struct ext2_inode inode;
@@ -457,9 +514,11 @@ static int ext4fs_delete_file(int inodeno)
 	struct ext2_inode *inode_buffer = NULL;
 	struct ext2_block_group *bgd = NULL;
 	struct ext_filesystem *fs = get_fs();
+	struct ext_block_cache cache;
 	char *journal_buffer = zalloc(fs->blksz);
 	if (!journal_buffer)
 		return -ENOMEM;
+	ext_cache_init(&cache);
 	status = ext4fs_read_inode(ext4fs_root, inodeno, &inode);
 	if (status == 0)
 		goto fail;
@@ -479,11 +538,12 @@ static int ext4fs_delete_file(int inodeno)
 	}
 
 	if (le32_to_cpu(inode.flags) & EXT4_EXTENTS_FL) {
-		/* FIXME delete extent index blocks, i.e. eh_depth >= 1 */
 		struct ext4_extent_header *eh =
 			(struct ext4_extent_header *)
 				inode.b.blocks.dir_blocks;
 		debug("del: dep=%d entries=%d\n", eh->eh_depth, eh->eh_entries);
+		if (delete_extent_index_blocks(eh))
+			goto fail;
 	} else {
 		delete_single_indirect_block(&inode);
 		delete_double_indirect_block(&inode);
@@ -492,7 +552,7 @@ static int ext4fs_delete_file(int inodeno)
 
 	/* release data blocks */
 	for (i = 0; i < no_blocks; i++) {
-		blknr = read_allocated_block(&inode, i, NULL);
+		blknr = read_allocated_block(&inode, i, &cache);
 		if (blknr == 0)
 			continue;
 		if (blknr < 0)
@@ -584,11 +644,13 @@ static int ext4fs_delete_file(int inodeno)
 		goto fail;
 	}
 
+	ext_cache_fini(&cache);
 	free(start_block_address);
 	free(journal_buffer);
 
 	return 0;
 fail:
+	ext_cache_fini(&cache);
 	free(start_block_address);
 	free(journal_buffer);
 
@@ -778,6 +840,7 @@ static int ext4fs_write_file(struct ext2_inode *file_inode,
 	int delayed_extent = 0;
 	int delayed_next = 0;
 	const char *delayed_buf = NULL;
+	struct ext_block_cache cache;
 
 	/* Adjust len so it we can't read past the end of the file. */
 	if (len > filesize)
@@ -785,13 +848,16 @@ static int ext4fs_write_file(struct ext2_inode *file_inode,
 
 	blockcnt = ((len + pos) + fs->blksz - 1) / fs->blksz;
 
+	ext_cache_init(&cache);
 	for (i = pos / fs->blksz; i < blockcnt; i++) {
 		long int blknr;
 		int blockend = fs->blksz;
 		int skipfirst = 0;
-		blknr = read_allocated_block(file_inode, i, NULL);
-		if (blknr <= 0)
+		blknr = read_allocated_block(file_inode, i, &cache);
+		if (blknr <= 0) {
+			ext_cache_fini(&cache);
 			return -1;
+		}
 
 		blknr = blknr << log2_fs_blocksize;
 
@@ -832,6 +898,7 @@ static int ext4fs_write_file(struct ext2_inode *file_inode,
 		}
 		buf += fs->blksz - skipfirst;
 	}
+	ext_cache_fini(&cache);
 	if (previous_block_number != -1) {
 		/* spill */
 		put_ext4((uint64_t) ((uint64_t)delayed_start << log2blksz),
@@ -958,8 +1025,9 @@ int ext4fs_write(const char *fname, const char *buffer,
 	file_inode->nlinks = cpu_to_le16(1);
 
 	/* Allocate data blocks */
-	ext4fs_allocate_blocks(file_inode, blocks_remaining,
-			       &blks_reqd_for_file);
+	if (ext4fs_allocate_blocks(file_inode, blocks_remaining,
+				   &blks_reqd_for_file))
+		goto fail;
 	file_inode->blockcnt = cpu_to_le32((blks_reqd_for_file * fs->blksz) >>
 					   LOG2_SECTOR_SIZE);
 
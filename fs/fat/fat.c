@@ -623,6 +623,20 @@ static int get_fs_info(fsdata *mydata)
 		mydata->root_cluster = 0;
 	}
 
+	/* Clusters that both the FAT and the disk have room for */
+	mydata->clust_count = mydata->fatlength * mydata->sect_size /
+			      mydata->fatsize * 8;
+	while (CHECK_CLUST(mydata->clust_count - 1, mydata->fatsize) &&
+	       mydata->clust_count > 2)
+		mydata->clust_count--;
+	if ((s64)mydata->total_sect > mydata->data_begin)
+		mydata->clust_count = min(mydata->clust_count,
+					  (mydata->total_sect -
+					   mydata->data_begin) /
+					  mydata->clust_size);
+	if (mydata->fatsize == 32)
+		mydata->info_sector = bs.info_sector;
+
 	mydata->fatbufnum = -1;
 	mydata->fat_dirty = 0;
 	mydata->fatbuf = malloc_cache_aligned(FATBUFSIZE);
@@ -18,6 +18,7 @@
 #include <asm/cache.h>
 #include <linux/ctype.h>
 #include <linux/math64.h>
+#include <linux/sizes.h>
 #include "fat.c"
 
 static dir_entry *find_directory_entry(fat_itr *itr, char *filename);
@@ -430,6 +431,307 @@ fill_dir_slot(fat_itr *itr, const char *l_name, const char *shortname)
 	return 0;
 }
 
+/* FAT entries read into the free cluster map at a time */
+#define FAT_MAP_CHUNK	32768
+/* Largest bounce buffer for writing misaligned data */
+#define FAT_BOUNCE_SIZE	SZ_1M
+
+static inline bool fat_map_test(const u32 *map, u32 nr)
+{
+	return map[nr / 32] & BIT(nr % 32);
+}
+
+static inline void fat_map_set(u32 *map, u32 nr, bool set)
+{
+	if (set)
+		map[nr / 32] |= BIT(nr % 32);
+	else
+		map[nr / 32] &= ~BIT(nr % 32);
+}
+
+/*
+ * Read the FSInfo sector for its free cluster count and allocation hint
+ */
+static void fat_fsinfo_read(fsdata *mydata)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(__u8, block, mydata->sect_size);
+	struct fsinfo_sector *info = (struct fsinfo_sector *)block;
+	u32 free_count, nxt_free;
+
+	if (!mydata->info_sector || mydata->info_sector >= mydata->fat_sect ||
+	    mydata->sect_size < sizeof(*info))
+		return;
+	if (disk_read(mydata->info_sector, 1, block) != 1)
+		return;
+	if (FAT2CPU32(info->lead_sig) != FSINFO_LEAD_SIG ||
+	    FAT2CPU32(info->struc_sig) != FSINFO_STRUC_SIG ||
+	    FAT2CPU32(info->trail_sig) != FSINFO_TRAIL_SIG)
+		return;
+
+	free_count = FAT2CPU32(info->free_count);
+	if (free_count <= mydata->clust_count - 2)
+		mydata->free_count = free_count;
+	nxt_free = FAT2CPU32(info->nxt_free);
+	if (nxt_free >= 2 && nxt_free < mydata->clust_count)
+		mydata->next_free = nxt_free;
+	mydata->fsinfo_valid = 1;
+}
+
+/*
+ * Write the free cluster count and allocation hint back to FSInfo
+ */
+static int fat_fsinfo_write(fsdata *mydata)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(__u8, block, mydata->sect_size);
+	struct fsinfo_sector *info = (struct fsinfo_sector *)block;
+
+	if (!mydata->fsinfo_valid || !mydata->fsinfo_dirty)
+		return 0;
+	if (disk_read(mydata->info_sector, 1, block) != 1)
+		return -EIO;
+
+	info->free_count = cpu_to_le32(mydata->free_count);
+	info->nxt_free = cpu_to_le32(mydata->next_free);
+	if (disk_write(mydata->info_sector, 1, block) != 1)
+		return -EIO;
+	mydata->fsinfo_dirty = 0;
+
+	return 0;
+}
+
+/*
+ * Set up the free cluster map. The FAT is only read into it as allocation
+ * reaches each part of it, see fat_map_load().
+ */
+static void fat_map_init(fsdata *mydata)
+{
+	u32 chunks = DIV_ROUND_UP(mydata->clust_count, FAT_MAP_CHUNK);
+
+	if (mydata->free_map || mydata->clust_count <= 2)
+		return;
+
+	mydata->free_map = calloc(DIV_ROUND_UP(mydata->clust_count, 32),
+				  sizeof(u32));
+	mydata->map_loaded = calloc(DIV_ROUND_UP(chunks, 32), sizeof(u32));
+	if (!mydata->free_map || !mydata->map_loaded) {
+		debug("FAT: no memory for free cluster map\n");
+		free(mydata->free_map);
+		free(mydata->map_loaded);
+		mydata->free_map = NULL;
+		mydata->map_loaded = NULL;
+		return;
+	}
+
+	mydata->free_count = FSINFO_UNKNOWN;
+	mydata->next_free = 2;
+	mydata->max_run = mydata->clust_count;
+	if (mydata->fatsize == 32)
+		fat_fsinfo_read(mydata);
+}
+
+static void fat_map_release(fsdata *mydata)
+{
+	free(mydata->free_map);
+	free(mydata->map_loaded);
+	mydata->free_map = NULL;
+	mydata->map_loaded = NULL;
+}
+
+/*
+ * Read the part of the FAT holding cluster @chunk * FAT_MAP_CHUNK into the
+ * free cluster map, if that has not been done yet
+ */
+static int fat_map_load(fsdata *mydata, u32 chunk)
+{
+	u32 first = chunk * FAT_MAP_CHUNK;
+	u32 last = min(first + FAT_MAP_CHUNK, mydata->clust_count);
+	u32 startsect, nsects, clust, val;
+	__u8 *buf = NULL;
+
+	if (fat_map_test(mydata->map_loaded, chunk))
+		return 0;
+
+	/* Entries changed in the FAT buffer must be seen */
+	if (flush_dirty_fat_buffer(mydata) < 0)
+		return -EIO;
+
+	if (mydata->fatsize != 12) {
+		startsect = first * (mydata->fatsize / 8) / mydata->sect_size;
+		nsects = DIV_ROUND_UP((last - first) * (mydata->fatsize / 8),
+				      mydata->sect_size);
+		nsects = min(nsects, mydata->fatlength - startsect);
+		buf = malloc_cache_aligned(nsects * mydata->sect_size);
+		if (!buf)
+			return -ENOMEM;
+		if (disk_read(mydata->fat_sect + startsect, nsects, buf) !=
+		    nsects) {
+			free(buf);
+			return -EIO;
+		}
+	}
+
+	for (clust = max(first, 2U); clust < last; clust++) {
+		if (mydata->fatsize == 32)
+			val = FAT2CPU32(((__u32 *)buf)[clust - first]) &
+			      0x0fffffff;
+		else if (mydata->fatsize == 16)
+			val = FAT2CPU16(((__u16 *)buf)[clust - first]);
+		else
+			val = get_fatent(mydata, clust);
+		fat_map_set(mydata->free_map, clust, !val);
+	}
+	free(buf);
+	fat_map_set(mydata->map_loaded, chunk, true);
+
+	return 0;
+}
+
+/*
+ * Get the number of free clusters, reading the rest of the FAT if the
+ * count is not known yet. Returns FSINFO_UNKNOWN if that fails.
+ */
+static u32 fat_map_free_count(fsdata *mydata)
+{
+	u32 i;
+
+	if (mydata->free_count != FSINFO_UNKNOWN)
+		return mydata->free_count;
+
+	for (i = 0; i * FAT_MAP_CHUNK < mydata->clust_count; i++) {
+		if (fat_map_load(mydata, i))
+			return FSINFO_UNKNOWN;
+	}
+
+	mydata->free_count = 0;
+	for (i = 0; i < DIV_ROUND_UP(mydata->clust_count, 32); i++)
+		mydata->free_count += hweight32(mydata->free_map[i]);
+	mydata->fsinfo_dirty = 1;
+
+	return mydata->free_count;
+}
+
+/*
+ * Find the first cluster in [@clust, @end) that is free, or in use if @used
+ * is set. Returns @end if there is none, or 0 if the FAT cannot be read.
+ */
+static u32 fat_map_find(fsdata *mydata, u32 clust, u32 end, bool used)
+{
+	u32 word;
+
+	while (clust < end) {
+		if (fat_map_load(mydata, clust / FAT_MAP_CHUNK))
+			return 0;
+
+		word = mydata->free_map[clust / 32];
+		if (used)
+			word = ~word;
+		word >>= clust % 32;
+		if (word)
+			return min(clust + ffs(word) - 1, end);
+		clust = round_down(clust, 32) + 32;
+	}
+
+	return end;
+}
+
+/*
+ * Keep the free cluster map and count up to date as a FAT entry changes
+ */
+static void fat_map_update(fsdata *mydata, __u32 entry, __u32 old_value,
+			   __u32 entry_value)
+{
+	old_value &= 0x0fffffff;
+	entry_value &= 0x0fffffff;
+	if (entry >= mydata->clust_count || !old_value == !entry_value)
+		return;
+
+	fat_map_set(mydata->free_map, entry, !entry_value);
+	if (mydata->free_count != FSINFO_UNKNOWN)
+		mydata->free_count += entry_value ? -1 : 1;
+	if (!entry_value)
+		mydata->max_run = mydata->clust_count;
+	mydata->fsinfo_dirty = 1;
+}
+
+/**
+ * fat_alloc_run() - find free clusters to allocate
+ *
+ * Looks for @want consecutive free clusters, starting from the allocation
+ * hint and wrapping around. If there is no such run, the first free clusters
+ * after the hint are used. The clusters are not marked as used here, that
+ * happens as they are linked into the FAT.
+ *
+ * @mydata:	filesystem data
+ * @want:	number of clusters wanted
+ * @len:	returns the number of consecutive clusters found, at most @want
+ * Return:	first cluster found, or 0 if the filesystem is full
+ */
+static u32 fat_alloc_run(fsdata *mydata, u32 want, u32 *len)
+{
+	u32 count = mydata->clust_count;
+	u32 hint, start, end, clust, next, longest = 0;
+	int pass;
+
+	fat_map_init(mydata);
+	hint = clamp(mydata->next_free, 2U, count - 1);
+
+	if (!mydata->free_map) {
+		/* No map, so scan the FAT itself */
+		for (clust = hint; clust < count; clust++) {
+			if (!get_fatent(mydata, clust))
+				break;
+		}
+		if (clust >= count)
+			return 0;
+		for (next = clust + 1; next < min(clust + want, count); next++) {
+			if (get_fatent(mydata, next))
+				break;
+		}
+		goto found;
+	}
+
+	if (want > 1 && want <= mydata->max_run) {
+		for (pass = 0; pass < 2; pass++) {
+			start = pass ? 2 : hint;
+			end = pass ? hint : count;
+			clust = fat_map_find(mydata, start, end, false);
+			while (clust && clust < end) {
+				next = fat_map_find(mydata, clust, count, true);
+				if (!next)
+					return 0;
+				if (next - clust >= want) {
+					next = clust + want;
+					goto found;
+				}
+				longest = max(longest, next - clust);
+				clust = fat_map_find(mydata, next, end, false);
+			}
+			if (!clust)
+				return 0;
+		}
+		mydata->max_run = longest;
+	}
+
+	clust = fat_map_find(mydata, hint, count, false);
+	if (clust == count) {
+		clust = fat_map_find(mydata, 2, hint, false);
+		if (clust == hint)
+			return 0;
+	}
+	if (!clust)
+		return 0;
+	next = fat_map_find(mydata, clust, min(clust + want, count), true);
+	if (!next)
+		return 0;
+
+found:
+	*len = next - clust;
+	mydata->next_free = next;
+	mydata->fsinfo_dirty = 1;
+
+	return clust;
+}
+
 /*
  * Set the entry at index 'entry' in a FAT (12/16/32) table.
  */
@@ -479,6 +781,12 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 		mydata->fatbufnum = bufnum;
 	}
 
+	/* Track free space, the entry is in the FAT buffer by now */
+	fat_map_init(mydata);
+	if (mydata->free_map)
+		fat_map_update(mydata, entry, get_fatent(mydata, entry),
+			       entry_value);
+
 	/* Mark as dirty */
 	mydata->fat_dirty = 1;
 
@@ -536,29 +844,6 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 	return 0;
 }
 
-/*
- * Determine the next free cluster after 'entry' in a FAT (12/16/32) table
- * and link it to 'entry'. EOC marker is not set on returned entry.
- */
-static __u32 determine_fatent(fsdata *mydata, __u32 entry)
-{
-	__u32 next_fat, next_entry = entry + 1;
-
-	while (1) {
-		next_fat = get_fatent(mydata, next_entry);
-		if (next_fat == 0) {
-			/* found free entry, link to entry */
-			set_fatent_value(mydata, entry, next_entry);
-			break;
-		}
-		next_entry++;
-	}
-	debug("FAT%d: entry: %08x, entry_value: %04x\n",
-	       mydata->fatsize, entry, next_entry);
-
-	return next_entry;
-}
-
 /**
  * set_sectors() - write data to sectors
  *
@@ -567,7 +852,7 @@ static __u32 determine_fatent(fsdata *mydata, __u32 entry)
  * @mydata:	data to be written
  * @startsect:	sector to be written to
  * @buffer:	data to be written
- * @size:	bytes to be written (but not more than the size of a cluster)
+ * @size:	bytes to be written
  * Return:	0 on success, -1 otherwise
  */
 static int
@@ -579,9 +864,30 @@ set_sectors(fsdata *mydata, u32 startsect, u8 *buffer, u32 size)
 
 	if ((unsigned long)buffer & (ARCH_DMA_MINALIGN - 1)) {
 		ALLOC_CACHE_ALIGN_BUFFER(__u8, tmpbuf, mydata->sect_size);
+		u32 nsects = min(size, (u32)FAT_BOUNCE_SIZE) / mydata->sect_size;
+		u8 *bounce = NULL;
 
 		debug("FAT: Misaligned buffer address (%p)\n", buffer);
 
+		/* Copy through a bounce buffer to keep transfers large */
+		if (nsects > 1)
+			bounce = malloc_cache_aligned(nsects * mydata->sect_size);
+		while (bounce && size >= mydata->sect_size) {
+			nsects = min(nsects, size / mydata->sect_size);
+			memcpy(bounce, buffer, nsects * mydata->sect_size);
+			ret = disk_write(startsect, nsects, bounce);
+			if (ret != nsects) {
+				debug("Error writing data (got %d)\n", ret);
+				free(bounce);
+				return -1;
+			}
+
+			startsect += nsects;
+			buffer += nsects * mydata->sect_size;
+			size -= nsects * mydata->sect_size;
+		}
+		free(bounce);
+
 		while (size >= mydata->sect_size) {
 			memcpy(tmpbuf, buffer, mydata->sect_size);
 			ret = disk_write(startsect++, 1, tmpbuf);
@@ -631,7 +937,7 @@ set_sectors(fsdata *mydata, u32 startsect, u8 *buffer, u32 size)
  * @mydata:	data to be written
  * @clustnum:	cluster to be written to
  * @buffer:	data to be written
- * @size:	bytes to be written (but not more than the size of a cluster)
+ * @size:	bytes to be written, possibly spanning consecutive clusters
  * Return:	0 on success, -1 otherwise
  */
 static int
@@ -794,23 +1100,6 @@ get_set_cluster(fsdata *mydata, __u32 clustnum, loff_t pos, __u8 *buffer,
 	return 0;
 }
 
-/*
- * Find the first empty cluster
- */
-static int find_empty_cluster(fsdata *mydata)
-{
-	__u32 fat_val, entry = 3;
-
-	while (1) {
-		fat_val = get_fatent(mydata, entry);
-		if (fat_val == 0)
-			break;
-		entry++;
-	}
-
-	return entry;
-}
-
 /**
  * new_dir_table() - allocate a cluster for additional directory entries
  *
@@ -822,9 +1111,14 @@ static int new_dir_table(fat_itr *itr)
 	fsdata *mydata = itr->fsdata;
 	int dir_newclust = 0;
 	int dir_oldclust = itr->clust;
+	u32 count;
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
 
-	dir_newclust = find_empty_cluster(mydata);
+	dir_newclust = fat_alloc_run(mydata, 1, &count);
+	if (!dir_newclust) {
+		log_err("Error: no space left for directory\n");
+		return -ENOSPC;
+	}
 
 	/*
 	 * Flush before updating FAT to ensure valid directory structure
@@ -890,30 +1184,6 @@ static void set_start_cluster(const fsdata *mydata, dir_entry *dentptr,
 	dentptr->start = cpu_to_le16(start_cluster & 0xffff);
 }
 
-/*
- * Check whether adding a file makes the file system to
- * exceed the size of the block device
- * Return -1 when overflow occurs, otherwise return 0
- */
-static int check_overflow(fsdata *mydata, __u32 clustnum, loff_t size)
-{
-	__u32 startsect, sect_num, offset;
-
-	if (clustnum > 0)
-		startsect = clust_to_sect(mydata, clustnum);
-	else
-		startsect = mydata->rootdir_sect;
-
-	sect_num = div_u64_rem(size, mydata->sect_size, &offset);
-
-	if (offset != 0)
-		sect_num++;
-
-	if (startsect + sect_num > total_sector)
-		return -1;
-	return 0;
-}
-
 /*
  * Write at most 'maxsize' bytes from 'buffer' into
  * the file associated with 'dentptr'
@@ -927,6 +1197,7 @@ set_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos, __u8 *buffer,
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
 	__u32 curclust = START(dentptr);
 	__u32 endclust = 0, newclust = 0;
+	u32 want, count, eoc;
 	u64 cur_pos, filesize;
 	loff_t offset, actsize, wsize;
 
@@ -1064,84 +1335,64 @@ set_clusters:
 	/* allocate and write */
 	assert(!pos);
 
-	/* Assure that curclust is valid */
-	if (!curclust) {
-		curclust = find_empty_cluster(mydata);
-		set_start_cluster(mydata, dentptr, curclust);
-	} else {
-		newclust = get_fatent(mydata, curclust);
-
-		if (IS_LAST_CLUST(newclust, mydata->fatsize)) {
-			newclust = determine_fatent(mydata, curclust);
-			set_fatent_value(mydata, curclust, newclust);
-			curclust = newclust;
-		} else {
-			debug("error: something wrong\n");
-			return -1;
-		}
-	}
-
-	/* TODO: already partially written */
-	if (check_overflow(mydata, curclust, filesize)) {
-		printf("Error: no space left: %llu\n", filesize);
+	/* Assure that curclust is the last cluster of the file, if any */
+	if (curclust &&
+	    !IS_LAST_CLUST(get_fatent(mydata, curclust), mydata->fatsize)) {
+		debug("error: something wrong\n");
 		return -1;
 	}
 
-	actsize = bytesperclust;
-	endclust = curclust;
-	do {
-		/* search for consecutive clusters */
-		while (actsize < filesize) {
-			newclust = determine_fatent(mydata, endclust);
-
-			if ((newclust - 1) != endclust)
-				/* write to <curclust..endclust> */
-				goto getit;
-
-			if (CHECK_CLUST(newclust, mydata->fatsize)) {
-				debug("newclust: 0x%x\n", newclust);
-				debug("Invalid FAT entry\n");
-				return 0;
-			}
-			endclust = newclust;
-			actsize += bytesperclust;
+	/*
+	 * Refuse to start writing what cannot be completed. FSInfo may be
+	 * stale, so count the free clusters before trusting it for that.
+	 */
+	fat_map_init(mydata);
+	want = div_u64(filesize + bytesperclust - 1, bytesperclust);
+	if (mydata->free_map && want > fat_map_free_count(mydata)) {
+		mydata->free_count = FSINFO_UNKNOWN;
+		if (want > fat_map_free_count(mydata)) {
+			printf("Error: no space left: %llu\n", filesize);
+			return -1;
 		}
+	}
 
-		/* set remaining bytes */
-		actsize = filesize;
-		if (set_cluster(mydata, curclust, buffer, (u32)actsize) != 0) {
-			debug("error: writing cluster\n");
+	if (mydata->fatsize == 12)
+		eoc = 0xfff;
+	else if (mydata->fatsize == 16)
+		eoc = 0xffff;
+	else
+		eoc = 0xfffffff;
+
+	while (filesize) {
+		/* Allocate as many consecutive clusters as possible */
+		want = div_u64(filesize + bytesperclust - 1, bytesperclust);
+		newclust = fat_alloc_run(mydata, want, &count);
+		if (!newclust) {
+			printf("Error: no space left: %llu\n", filesize);
 			return -1;
 		}
-		*gotsize += actsize;
 
-		/* Mark end of file in FAT */
-		if (mydata->fatsize == 12)
-			newclust = 0xfff;
-		else if (mydata->fatsize == 16)
-			newclust = 0xffff;
-		else if (mydata->fatsize == 32)
-			newclust = 0xfffffff;
-		set_fatent_value(mydata, endclust, newclust);
-
-		return 0;
-getit:
-		if (set_cluster(mydata, curclust, buffer, (u32)actsize) != 0) {
+		/* Link them to the end of the file */
+		if (curclust)
+			set_fatent_value(mydata, curclust, newclust);
+		else
+			set_start_cluster(mydata, dentptr, newclust);
+		for (endclust = newclust; endclust < newclust + count - 1;
+		     endclust++)
+			set_fatent_value(mydata, endclust, endclust + 1);
+		set_fatent_value(mydata, endclust, eoc);
+		curclust = endclust;
+
+		/* and write them in one go */
+		actsize = min_t(u64, filesize, (u64)count * bytesperclust);
+		if (set_cluster(mydata, newclust, buffer, (u32)actsize) != 0) {
 			debug("error: writing cluster\n");
 			return -1;
 		}
 		*gotsize += actsize;
 		filesize -= actsize;
 		buffer += actsize;
-
-		if (CHECK_CLUST(newclust, mydata->fatsize)) {
-			debug("newclust: 0x%x\n", newclust);
-			debug("Invalid FAT entry\n");
-			return 0;
-		}
-		actsize = bytesperclust;
-		curclust = endclust = newclust;
-	} while (1);
+	}
 
 	return 0;
 }
@@ -1420,11 +1671,14 @@ int file_fat_write_at(const char *filename, loff_t pos, void *buffer,
 		ret = -EIO;
 		goto exit;
 	}
+	if (fat_fsinfo_write(mydata))
+		debug("Error: updating FSInfo\n");
 
 	/* Write directory table to device */
 	ret = flush_dir(itr);
 
 exit:
+	fat_map_release(mydata);
 	free(filename_copy);
 	free(mydata->fatbuf);
 	free(itr);
@@ -1620,8 +1874,11 @@ int fat_unlink(const char *filename)
 	}
 
 	ret = delete_dentry_long(itr);
+	if (!ret && fat_fsinfo_write(&fsdata))
+		debug("Error: updating FSInfo\n");
 
 exit:
+	fat_map_release(&fsdata);
 	free(fsdata.fatbuf);
 	free(itr);
 	free(filename_copy);
@@ -1760,11 +2017,14 @@ int fat_mkdir(const char *dirname)
 		ret = -EIO;
 		goto exit;
 	}
+	if (fat_fsinfo_write(mydata))
+		debug("Error: updating FSInfo\n");
 
 	/* Write directory table to device */
 	ret = flush_dir(itr);
 
 exit:
+	fat_map_release(mydata);
 	free(dirname_copy);
 	free(mydata->fatbuf);
 	free(itr);
@@ -28,6 +28,7 @@ struct AvbOpsData {
 	struct AvbOps ops;
 	int mmc_dev;
 	enum avb_boot_state boot_state;
+	size_t preload_used;
 #ifdef CONFIG_OPTEE_TA_AVB
 	struct udevice *tee;
 	u32 session;
@@ -49,6 +50,16 @@ enum mmc_io_type {
 AvbOps *avb_ops_alloc(int boot_device);
 void avb_ops_free(AvbOps *ops);
 
+/**
+ * avb_preload_reset() - Release the partitions loaded by the last verification
+ *
+ * Partitions are loaded into the area at CONFIG_AVB_PRELOAD_ADDR one after the
+ * other. Call this before verifying again to start from the beginning.
+ *
+ * @ops: AVB ops
+ */
+void avb_preload_reset(AvbOps *ops);
+
 char *avb_set_state(AvbOps *ops, enum avb_boot_state boot_state);
 char *avb_set_enforce_verity(const char *cmdline);
 char *avb_set_ignore_corruption(const char *cmdline);
@@ -210,6 +210,25 @@ static inline void blkcache_invalidate(int iftype, int dev) {}
 
 #endif
 
+#if CONFIG_IS_ENABLED(EFI_PARTITION_CACHE)
+/**
+ * gpt_cache_invalidate() - discard the cached GPT of a device if it changed
+ *
+ * The GPT is only discarded if the blocks overlap the protective MBR, the
+ * GPT headers or the partition entries.
+ *
+ * @block_dev:	block device descriptor
+ * @start:	first block written
+ * @blkcnt:	number of blocks written, or 0 to discard the GPT of all
+ *		hardware partitions of the device (media change)
+ */
+void gpt_cache_invalidate(struct blk_desc *block_dev, lbaint_t start,
+			  lbaint_t blkcnt);
+#else
+static inline void gpt_cache_invalidate(struct blk_desc *block_dev,
+					lbaint_t start, lbaint_t blkcnt) {}
+#endif
+
 #if CONFIG_IS_ENABLED(BLK)
 struct udevice;
 
@@ -483,6 +502,7 @@ static inline ulong blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 			       lbaint_t blkcnt, const void *buffer)
 {
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	gpt_cache_invalidate(block_dev, start, blkcnt);
 	return block_dev->block_write(block_dev, start, blkcnt, buffer);
 }
 
@@ -490,6 +510,7 @@ static inline ulong blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			       lbaint_t blkcnt)
 {
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+	gpt_cache_invalidate(block_dev, start, blkcnt);
 	return block_dev->block_erase(block_dev, start, blkcnt);
 }
 
@@ -63,6 +63,17 @@ struct bootdev_ops {
 	 */
 	int (*get_bootflow)(struct udevice *dev, struct bootflow_iter *iter,
 			    struct bootflow *bflow);
+
+	/**
+	 * start() - start getting the media ready (optional)
+	 *
+	 * This must not wait for the media. It is called for all bootdevs
+	 * before they are scanned, so that slow media get ready in parallel.
+	 *
+	 * @dev:	Bootflow device to start
+	 * Return: 0 if OK, -ve on error
+	 */
+	int (*start)(struct udevice *dev);
 };
 
 #define bootdev_get_ops(dev)  ((struct bootdev_ops *)(dev)->driver->ops)
@@ -80,6 +91,17 @@ struct bootdev_ops {
 int bootdev_get_bootflow(struct udevice *dev, struct bootflow_iter *iter,
 			 struct bootflow *bflow);
 
+/**
+ * bootdev_start() - start getting the media of a bootdev ready
+ *
+ * This probes the bootdev and asks it to get its media ready, without
+ * waiting for that
+ *
+ * @dev:	Bootflow device to start
+ * Return: 0 if OK (or the bootdev has no start() method), -ve on error
+ */
+int bootdev_start(struct udevice *dev);
+
 /**
  * bootdev_bind() - Bind a new named bootdev device
  *
@@ -19,6 +19,16 @@ enum bootstage_flags {
 	BOOTSTAGEF_ALLOC	= 1 << 1,	/* Allocate an id */
 };
 
+/* Types of nested span, see bootstage_span_start() */
+enum bootstage_span_t {
+	BOOTSTAGE_SPAN_GENERAL,		/* General activity */
+	BOOTSTAGE_SPAN_BIND,		/* Binding a device */
+	BOOTSTAGE_SPAN_OF_TO_PLAT,	/* Reading a device's platform data */
+	BOOTSTAGE_SPAN_PROBE,		/* Probing a device */
+
+	BOOTSTAGE_SPAN_TYPE_COUNT,
+};
+
 /* bootstate sub-IDs used for kernel and ramdisk ranges */
 enum {
 	BOOTSTAGE_SUB_FORMAT,
@@ -209,6 +219,7 @@ enum bootstage_id {
 	BOOTSTAGE_ID_ACCUM_FSP_M,
 	BOOTSTAGE_ID_ACCUM_FSP_S,
 	BOOTSTAGE_ID_ACCUM_MMAP_SPI,
+	BOOTSTAGE_ID_RELOCATE,
 
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
@@ -329,9 +340,47 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name);
  */
 uint32_t bootstage_accum(enum bootstage_id id);
 
+/**
+ * bootstage_span_start() - start a nested span of activity
+ *
+ * Spans record how long an activity took, like bootstage_start() and
+ * bootstage_accum(), but each call creates a new span. A span started while
+ * another is in progress is nested within it, so that spans form a tree which
+ * can be shown with bootstage_tree().
+ *
+ * Spans are only recorded after relocation. Up to
+ * CONFIG_BOOTSTAGE_SPAN_COUNT spans are recorded, after which further spans
+ * are dropped.
+ *
+ * @type:	Type of span
+ * @name:	Name of the span, which is copied (truncated if too long)
+ * Return: ID of the span to pass to bootstage_span_end(), or 0 if the span is
+ *	not recorded
+ */
+int bootstage_span_start(enum bootstage_span_t type, const char *name);
+
+/**
+ * bootstage_span_end() - end a nested span of activity
+ *
+ * This records the duration of the span and makes its parent the current
+ * span again.
+ *
+ * @id:		ID returned by bootstage_span_start() (0 to do nothing)
+ */
+void bootstage_span_end(int id);
+
 /* Print a report about boot time */
 void bootstage_report(void);
 
+/**
+ * bootstage_tree() - print the nested spans as a tree
+ *
+ * Each span is shown with its inclusive time (including nested spans) and
+ * exclusive time. The spans at each level are sorted by inclusive time, with
+ * the largest first.
+ */
+void bootstage_tree(void);
+
 /**
  * Add bootstage information to the device tree
  *
@@ -428,6 +477,16 @@ static inline uint32_t bootstage_accum(enum bootstage_id id)
 	return 0;
 }
 
+static inline int bootstage_span_start(enum bootstage_span_t type,
+				       const char *name)
+{
+	return 0;
+}
+
+static inline void bootstage_span_end(int id)
+{
+}
+
 static inline int bootstage_stash(void *base, int size)
 {
 	return 0;	/* Pretend to succeed */
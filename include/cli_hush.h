@@ -11,6 +11,7 @@
 #define FLAG_PARSE_SEMICOLON (1 << 1)	  /* symbol ';' is special for parser */
 #define FLAG_REPARSING       (1 << 2)	  /* >=2nd pass */
 #define FLAG_CONT_ON_NEWLINE (1 << 3)	  /* continue when we see \n */
+#define FLAG_CACHE_PARSE     (1 << 4)	  /* keep the parsed script for reuse */
 
 extern int u_boot_hush_start(void);
 extern int parse_string_outer(const char *, int);
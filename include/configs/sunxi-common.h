@@ -132,7 +132,15 @@
 #define BOOTM_SIZE        __stringify(0xa000000)
 #define KERNEL_ADDR_R     __stringify(SDRAM_OFFSET(0080000))
 #define KERNEL_COMP_ADDR_R __stringify(SDRAM_OFFSET(4000000))
+#ifdef CONFIG_RELOC_IN_PLACE
+/*
+ * U-Boot keeps running at CONFIG_SYS_TEXT_BASE (0x4a000000) and booti does
+ * not check where it decompresses to, so end the window there
+ */
+#define KERNEL_COMP_SIZE  __stringify(0x6000000)
+#else
 #define KERNEL_COMP_SIZE  __stringify(0xb000000)
+#endif
 #define FDT_ADDR_R        __stringify(SDRAM_OFFSET(FA00000))
 #define SCRIPT_ADDR_R     __stringify(SDRAM_OFFSET(FC00000))
 #define PXEFILE_ADDR_R    __stringify(SDRAM_OFFSET(FD00000))
@@ -49,6 +49,47 @@ int is_core_valid(unsigned int core);
  */
 int checkcpu(void);
 
+#if IS_ENABLED(CONFIG_CPU_PARALLEL)
+/**
+ * cpu_parallel_count() - Get the number of CPUs that cpu_run_parallel() uses
+ *
+ * Return: number of CPUs, including the current one
+ */
+int cpu_parallel_count(void);
+
+/**
+ * cpu_run_parallel() - Run a function on several CPUs at once
+ *
+ * Each call may run on a different CPU. The first call always runs on the
+ * current CPU. If there are not enough CPUs, some calls run one after another.
+ *
+ * Other CPUs are only set up far enough to access memory, so @func must not
+ * use the console, timers, malloc() or driver model, except in the first call.
+ *
+ * @func: Function to call
+ * @args: Argument to pass to each call
+ * @count: Number of calls to make
+ * Return: 0 once all the calls have returned, -ve on error
+ */
+int cpu_run_parallel(void (*func)(void *arg), void *const args[], int count);
+#else
+static inline int cpu_parallel_count(void)
+{
+	return 1;
+}
+
+static inline int cpu_run_parallel(void (*func)(void *arg),
+				   void *const args[], int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		func(args[i]);
+
+	return 0;
+}
+#endif
+
 void smp_set_core_boot_addr(unsigned long addr, int corenr);
 void smp_kick_all_cpus(void);
 
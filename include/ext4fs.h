@@ -38,6 +38,8 @@ struct disk_partition;
 #define EXT4_FEATURE_INCOMPAT_EXTENTS	0x0040
 #define EXT4_FEATURE_INCOMPAT_64BIT	0x0080
 #define EXT4_INDIRECT_BLOCKS		12
+#define EXT4_EXT_INODE_ENTRIES		4	/* Extents held in the inode */
+#define EXT4_EXT_MAX_LEN		32768	/* Blocks in an extent */
 
 #define EXT4_BG_INODE_UNINIT		0x0001
 #define EXT4_BG_BLOCK_UNINIT		0x0002
@@ -18,6 +18,14 @@ extern u32 fastboot_buf_size;
  */
 extern void (*fastboot_progress_callback)(const char *msg);
 
+/**
+ * fastboot_data_max_size() - Get the largest download accepted
+ *
+ * Return: size of the download buffer, or a larger limit if downloads are
+ * streamed to storage
+ */
+u32 fastboot_data_max_size(void);
+
 /**
  * fastboot_getvar() - Writes variable indicated by cmd_parameter to response.
  *
@@ -44,6 +44,9 @@ enum {
 #if CONFIG_IS_ENABLED(FASTBOOT_CMD_OEM_BOOTBUS)
 	FASTBOOT_COMMAND_OEM_BOOTBUS,
 #endif
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+	FASTBOOT_COMMAND_OEM_STREAM,
+#endif
 #if CONFIG_IS_ENABLED(FASTBOOT_UUU_SUPPORT)
 	FASTBOOT_COMMAND_ACMD,
 	FASTBOOT_COMMAND_UCMD,
@@ -164,6 +167,16 @@ u32 fastboot_data_remaining(void);
 void fastboot_data_download(const void *fastboot_data,
 			    unsigned int fastboot_data_len, char *response);
 
+/**
+ * fastboot_data_flush() - Write out buffered data of a streamed download
+ *
+ * When a download is streamed to storage (see the "oem stream" command),
+ * fastboot_data_download() only buffers the data. A transport should call
+ * this once it has started receiving the next packet, so that writing to
+ * storage overlaps with the transfer. This does nothing for normal downloads.
+ */
+void fastboot_data_flush(void);
+
 /**
  * fastboot_data_complete() - Mark current transfer complete
  *
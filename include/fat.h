@@ -137,6 +137,22 @@ struct nameext {
 	char ext[3];
 };
 
+/* FAT32 file system information sector */
+struct fsinfo_sector {
+	__u32	lead_sig;	/* FSINFO_LEAD_SIG */
+	__u8	reserved1[480];
+	__u32	struc_sig;	/* FSINFO_STRUC_SIG */
+	__u32	free_count;	/* Free clusters, FSINFO_UNKNOWN if not known */
+	__u32	nxt_free;	/* Where to start looking for free clusters */
+	__u8	reserved2[12];
+	__u32	trail_sig;	/* FSINFO_TRAIL_SIG */
+};
+
+#define FSINFO_LEAD_SIG		0x41615252
+#define FSINFO_STRUC_SIG	0x61417272
+#define FSINFO_TRAIL_SIG	0xaa550000
+#define FSINFO_UNKNOWN		0xffffffff
+
 typedef struct dir_entry {
 	struct nameext nameext;	/* Name and extension */
 	__u8	attr;		/* Attribute bits */
@@ -182,6 +198,16 @@ typedef struct {
 	__u32	root_cluster;	/* First cluster of root dir for FAT32 */
 	u32	total_sect;	/* Number of sectors */
 	int	fats;		/* Number of FATs */
+	__u16	info_sector;	/* FSInfo sector for FAT32, 0 if none */
+	u32	clust_count;	/* Number of FAT entries, including 0 and 1 */
+	/* Free space, set up by the first FAT update of a write */
+	u32	*free_map;	/* Free clusters */
+	u32	*map_loaded;	/* Parts of the FAT read into free_map */
+	u32	free_count;	/* Free clusters, FSINFO_UNKNOWN if not known */
+	u32	next_free;	/* Where to start looking for free clusters */
+	u32	max_run;	/* No free run is longer than this */
+	__u8	fsinfo_valid;	/* Set if the FSInfo sector can be updated */
+	__u8	fsinfo_dirty;	/* Set if free_count or next_free changed */
 } fsdata;
 
 struct fat_itr;
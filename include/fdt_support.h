@@ -411,6 +411,198 @@ int fdt_valid(struct fdt_header **blobp);
  */
 int fdt_get_cells_len(const void *blob, char *nr_cells_name);
 
+struct device_node;
+
+#if CONFIG_IS_ENABLED(OF_FDT_TXN)
+/**
+ * fdt_txn_begin() - start a transaction of fixups on a device tree
+ *
+ * While the transaction is open, the fixups in fdt_support.c work on a live
+ * copy of @blob, which fdt_txn_root() creates on first use. The flat tree is
+ * written once by fdt_txn_commit(). Only one transaction can be open at a
+ * time; any other one is aborted.
+ *
+ * Code which writes @blob with libfdt must call fdt_txn_sync() first. Code
+ * which reads @blob sees it as it was when the live tree was created.
+ *
+ * @blob: Flat tree to fix up
+ */
+void fdt_txn_begin(void *blob);
+
+/**
+ * fdt_txn_root() - get the live tree of the transaction on a device tree
+ *
+ * @blob: Flat tree
+ * Return: root of the live tree, or NULL if there is no transaction open on
+ *	@blob or the tree cannot be unflattened, in which case fixups must be
+ *	made to @blob directly
+ */
+struct device_node *fdt_txn_root(const void *blob);
+
+/**
+ * fdt_txn_sync() - write the live tree to the flat tree
+ *
+ * This keeps the transaction open, so the next fdt_txn_root() unflattens the
+ * tree again. It does nothing if there is no transaction open on @blob.
+ *
+ * @blob: Flat tree
+ * Return: 0 if OK, -FDT_ERR_NOSPACE if the tree does not fit in @blob or
+ *	there is not enough memory, in which case the fixups are lost
+ */
+int fdt_txn_sync(void *blob);
+
+/**
+ * fdt_txn_commit() - write the live tree to the flat tree and end the
+ *	transaction
+ *
+ * The tree keeps the totalsize of @blob, so callers which need to grow it
+ * must update the header before this is called.
+ *
+ * @blob: Flat tree
+ * Return: 0 if OK, -FDT_ERR_NOSPACE if the tree does not fit in @blob or
+ *	there is not enough memory
+ */
+int fdt_txn_commit(void *blob);
+
+/**
+ * fdt_txn_abort() - end the transaction, dropping any changes
+ *
+ * @blob: Flat tree
+ */
+void fdt_txn_abort(void *blob);
+#else
+static inline void fdt_txn_begin(void *blob)
+{
+}
+
+static inline struct device_node *fdt_txn_root(const void *blob)
+{
+	return NULL;
+}
+
+static inline int fdt_txn_sync(void *blob)
+{
+	return 0;
+}
+
+static inline int fdt_txn_commit(void *blob)
+{
+	return 0;
+}
+
+static inline void fdt_txn_abort(void *blob)
+{
+}
+#endif
+
+/**
+ * fdt_txn_find_node() - find a node in the live tree of a transaction
+ *
+ * This looks up @path in the same way as fdt_path_offset(), including
+ * aliases and node names given without a unit address.
+ *
+ * @root: Root of the live tree
+ * @path: Path of the node
+ * Return: node, or NULL if not found
+ */
+struct device_node *fdt_txn_find_node(struct device_node *root,
+				      const char *path);
+
+/**
+ * fdt_txn_add_subnode() - find or add a subnode in the live tree
+ *
+ * Like fdt_add_subnode(), a new node is added before the existing ones.
+ *
+ * @parent: Parent node
+ * @name: Name of the subnode
+ * Return: subnode, or NULL if out of memory
+ */
+struct device_node *fdt_txn_add_subnode(struct device_node *parent,
+					const char *name);
+
+/**
+ * fdt_txn_setprop() - set a property in the live tree
+ *
+ * The value is copied. Like fdt_setprop(), a new property is added before
+ * the existing ones.
+ *
+ * @np: Node
+ * @name: Name of the property
+ * @val: Value of the property
+ * @len: Length of @val in bytes
+ * Return: 0 if OK, -FDT_ERR_NOSPACE if out of memory
+ */
+int fdt_txn_setprop(struct device_node *np, const char *name, const void *val,
+		    int len);
+
+static inline int fdt_txn_setprop_u32(struct device_node *np,
+				      const char *name, u32 val)
+{
+	fdt32_t tmp = cpu_to_fdt32(val);
+
+	return fdt_txn_setprop(np, name, &tmp, sizeof(tmp));
+}
+
+static inline int fdt_txn_setprop_u64(struct device_node *np,
+				      const char *name, u64 val)
+{
+	fdt64_t tmp = cpu_to_fdt64(val);
+
+	return fdt_txn_setprop(np, name, &tmp, sizeof(tmp));
+}
+
+/**
+ * fdt_txn_address_cells() - get #address-cells of a node in the live tree
+ *
+ * @np: Node
+ * Return: number of cells, with the same default and errors as
+ *	fdt_address_cells()
+ */
+int fdt_txn_address_cells(const struct device_node *np);
+
+/**
+ * fdt_txn_size_cells() - get #size-cells of a node in the live tree
+ *
+ * @np: Node
+ * Return: number of cells, with the same default and errors as
+ *	fdt_size_cells()
+ */
+int fdt_txn_size_cells(const struct device_node *np);
+
+/**
+ * fdt_txn_add_mem_rsv() - add a memory-reservation entry in a transaction
+ *
+ * @blob: Flat tree with an open transaction
+ * @address: Start of the reserved region
+ * @size: Size of the reserved region
+ * Return: 0 if OK, -FDT_ERR_BADSTATE if there is no live tree for @blob,
+ *	-FDT_ERR_NOSPACE if out of memory
+ */
+int fdt_txn_add_mem_rsv(void *blob, u64 address, u64 size);
+
+/**
+ * fdt_txn_del_mem_rsv() - delete a memory-reservation entry in a transaction
+ *
+ * @blob: Flat tree with an open transaction
+ * @address: Start of the reserved region to delete
+ * Return: 0 if OK, -FDT_ERR_BADSTATE if there is no live tree for @blob,
+ *	-FDT_ERR_NOTFOUND if there is no entry for @address
+ */
+int fdt_txn_del_mem_rsv(void *blob, u64 address);
+
+/**
+ * fdt_txn_overlay_apply() - apply an overlay to the live tree
+ *
+ * This works like fdt_overlay_apply(), including the changes it makes to
+ * @fdto. On error the magic of both trees is erased and the transaction can
+ * no longer be used.
+ *
+ * @blob: Flat tree with an open transaction
+ * @fdto: Overlay to apply
+ * Return: 0 if OK, -FDT_ERR_... on error
+ */
+int fdt_txn_overlay_apply(void *blob, void *fdto);
+
 #endif /* ifdef CONFIG_OF_LIBFDT */
 
 #ifdef USE_HOSTCC
@@ -135,6 +135,18 @@ int hash_block(const char *algo_name, const void *data, unsigned int len,
  */
 int hash_lookup_algo(const char *algo_name, struct hash_algo **algop);
 
+/**
+ * hash_get_algo() - Get a hash algorithm by its position in the table
+ *
+ * This allows callers to step through all the available algorithms.
+ *
+ * @index: Index of the algorithm, starting at 0
+ * @algop: Pointer to the hash_algo struct if found
+ *
+ * Return: 0 if ok, -ENOENT if @index is beyond the last algorithm
+ */
+int hash_get_algo(int index, struct hash_algo **algop);
+
 /**
  * hash_progressive_lookup_algo() - Look up hash_algo for prog. hash support
  *
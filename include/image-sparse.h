@@ -24,6 +24,17 @@ struct sparse_storage {
 				 lbaint_t blk,
 				 lbaint_t blkcnt);
 
+	/*
+	 * Optional: discard blocks which the image does not care about, or
+	 * which it fills with zeroes if @erase_zero is set. Only whole erase
+	 * groups of @erase_grp blocks are passed to it.
+	 */
+	lbaint_t	(*erase)(struct sparse_storage *info,
+				 lbaint_t blk,
+				 lbaint_t blkcnt);
+	lbaint_t	erase_grp;
+	bool		erase_zero;
+
 	void		(*mssg)(const char *str, char *response);
 };
 
@@ -40,3 +51,87 @@ static inline int is_sparse_image(void *buf)
 
 int write_sparse_image(struct sparse_storage *info, const char *part_name,
 		       void *data, char *response);
+
+/**
+ * struct sparse_stream - state for writing an image while it is received
+ *
+ * The image may be an Android sparse image or a raw image; this is decided
+ * once the first bytes have arrived.
+ *
+ * @info: storage to write to
+ * @part_name: name of the partition, for messages
+ * @size: total size of the image in bytes
+ * @state: current parser state
+ * @sparse: true if the image is a sparse image
+ * @header: sparse image header
+ * @chunk: header of the current chunk
+ * @hdr: buffer for collecting a header split between calls
+ * @hdr_len: number of bytes in @hdr
+ * @skip: number of bytes to drop before parsing continues
+ * @data_left: bytes of data left in the current RAW chunk or raw image
+ * @chunk_index: number of chunk headers seen so far
+ * @blk: next block to write
+ * @total_blocks: number of sparse blocks processed
+ * @bytes_written: number of bytes written
+ * @blkbuf: buffer for a storage block split between calls
+ * @blkbuf_len: number of bytes in @blkbuf
+ */
+struct sparse_stream {
+	struct sparse_storage	*info;
+	const char		*part_name;
+	u64			size;
+	int			state;
+	bool			sparse;
+	sparse_header_t		header;
+	chunk_header_t		chunk;
+	u8			hdr[sizeof(sparse_header_t)];
+	unsigned int		hdr_len;
+	unsigned int		skip;
+	u64			data_left;
+	unsigned int		chunk_index;
+	lbaint_t		blk;
+	u32			total_blocks;
+	u64			bytes_written;
+	u8			*blkbuf;
+	unsigned int		blkbuf_len;
+};
+
+/**
+ * sparse_stream_init() - Prepare to write an image as it is received
+ *
+ * @ss: stream state to set up
+ * @info: storage to write to
+ * @part_name: name of the partition, for messages
+ * @size: total size of the image in bytes
+ * @response: pointer to fastboot response buffer
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+int sparse_stream_init(struct sparse_stream *ss, struct sparse_storage *info,
+		       const char *part_name, u64 size, char *response);
+
+/**
+ * sparse_stream_write() - Write the next part of an image
+ *
+ * The data may be split at any position, including within headers.
+ *
+ * @ss: stream state
+ * @data: next part of the image
+ * @len: length of @data in bytes
+ * @response: pointer to fastboot response buffer
+ * Return: 0 if OK, -ve on error, in which case info->mssg() has been called
+ */
+int sparse_stream_write(struct sparse_stream *ss, const void *data,
+			size_t len, char *response);
+
+/**
+ * sparse_stream_finish() - Complete writing an image
+ *
+ * This writes any remaining partial block and checks that the whole image
+ * has been received. It must be called once for each successful call to
+ * sparse_stream_init(), also after an error.
+ *
+ * @ss: stream state
+ * @response: pointer to fastboot response buffer
+ * Return: 0 if OK, -ve on error
+ */
+int sparse_stream_finish(struct sparse_stream *ss, char *response);
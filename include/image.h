@@ -837,6 +837,38 @@ static inline int image_check_target_arch(const image_header_t *hdr)
  */
 int image_decomp_type(const unsigned char *buf, ulong len);
 
+/**
+ * image_decomp_margin() - Get the margin needed to decompress in place
+ *
+ * An image can be decompressed in place by loading it at the end of the
+ * output buffer. The decompressed data is then written in front of the
+ * compressed data, which must end at least this many bytes after the end of
+ * the decompressed data, so that the decompressor never overwrites input
+ * which it has not read yet.
+ *
+ * @comp:	Compression algorithm that is used (IH_COMP_...)
+ * @image_len:	Number of bytes of compressed data
+ * @unc_len:	Maximum number of bytes of decompressed data
+ * Return: margin in bytes, or 0 if @comp cannot be decompressed in place
+ */
+ulong image_decomp_margin(int comp, ulong image_len, ulong unc_len);
+
+/**
+ * image_decomp_data() - decompress data without reporting progress
+ *
+ * This does the work of image_decomp(), without printing anything.
+ *
+ * @comp:	Compression algorithm that is used (IH_COMP_...)
+ * @load_buf:	Place to decompress to
+ * @image_buf:	Address to decompress from
+ * @lenp:	On entry, number of bytes in @image_buf to decompress. On
+ *		success, set to the number of bytes written to @load_buf
+ * @unc_len:	Available space for decompression
+ * Return: 0 if OK, -ENOSYS if @comp is not supported, other -ve on error
+ */
+int image_decomp_data(int comp, void *load_buf, void *image_buf,
+		      ulong *lenp, uint unc_len);
+
 /**
  * image_decomp() - decompress an image
  *
@@ -1105,9 +1137,26 @@ int fit_set_timestamp(void *fit, int noffset, time_t timestamp);
  */
 int fit_pre_load_data(const char *keydir, void *keydest, void *fit);
 
+/**
+ * fit_cipher_data() - encrypt the data of FIT image nodes
+ *
+ * @keydir:	Directory containing keys
+ * @keydest:	FDT blob to write cipher information to (NULL if none)
+ * @fit:	Pointer to the FIT format image header
+ * @comment:	Comment to add to cipher nodes
+ * @require_keys: Mark all keys as 'required'
+ * @engine_id:	Engine to use for signing
+ * @cmdname:	Command name used when reporting errors
+ * @jobs:	Number of threads to encrypt images with, 0 or 1 to do it
+ *		serially
+ *
+ * returns:
+ *	0, on success
+ *	< 0, on failure
+ */
 int fit_cipher_data(const char *keydir, void *keydest, void *fit,
 		    const char *comment, int require_keys,
-		    const char *engine_id, const char *cmdname);
+		    const char *engine_id, const char *cmdname, int jobs);
 
 #define NODE_MAX_NAME_LEN	80
 
@@ -1140,6 +1189,8 @@ struct image_summary {
  * @cmdname:	Command name used when reporting errors
  * @algo_name:	Algorithm name, or NULL if to be read from FIT
  * @summary:	Returns information about what data was written
+ * @jobs:	Number of threads to hash and sign images with, 0 or 1 to do
+ *		it serially
  *
  * Adds hash values for all component images in the FIT blob.
  * Hashes are calculated for all component images which have hash subnodes
@@ -1147,6 +1198,10 @@ struct image_summary {
  *
  * Also add signatures if signature nodes are present.
  *
+ * With @jobs > 1 the hashes and image signatures are calculated in parallel
+ * before they are written to the FIT in the usual order, so the result does
+ * not depend on the number of threads.
+ *
  * returns
  *     0, on success
  *     libfdt error code, on failure
@@ -1155,7 +1210,7 @@ int fit_add_verification_data(const char *keydir, const char *keyfile,
 			      void *keydest, void *fit, const char *comment,
 			      int require_keys, const char *engine_id,
 			      const char *cmdname, const char *algo_name,
-			      struct image_summary *summary);
+			      struct image_summary *summary, int jobs);
 
 /**
  * fit_image_verify_with_data() - Verify an image with given data
@@ -987,6 +987,79 @@ extern ulong mem_malloc_brk;
 
 void mem_malloc_init(ulong start, ulong size);
 
+/**
+ * struct malloc_info - summary of the state of the malloc() pool
+ *
+ * @pool_size:		size of the pool set up by mem_malloc_init()
+ * @arena:		bytes of the pool currently handed to the allocator
+ * @max_arena:		high-water mark of @arena
+ * @free:		free bytes, including the top chunk
+ * @top_size:		size of the top chunk
+ * @largest_free:	largest free chunk, including the top chunk
+ * @free_chunks:	number of free chunks in the bins
+ * @cached:		bytes held by the size-class cache
+ * @cached_chunks:	number of chunks held by the size-class cache
+ */
+struct malloc_info {
+	ulong pool_size;
+	ulong arena;
+	ulong max_arena;
+	ulong free;
+	ulong top_size;
+	ulong largest_free;
+	ulong free_chunks;
+	ulong cached;
+	ulong cached_chunks;
+};
+
+/**
+ * struct malloc_class_info - statistics for one size class of the cache
+ *
+ * @size:	chunk size served by this class, including malloc overhead
+ * @requests:	number of malloc() calls which mapped to this class
+ * @hits:	number of those which were served from the cache
+ * @cached:	number of free chunks currently held for this class
+ */
+struct malloc_class_info {
+	ulong size;
+	ulong requests;
+	ulong hits;
+	ulong cached;
+};
+
+/**
+ * malloc_get_info() - obtain a summary of the malloc() pool
+ *
+ * @info:	returns the pool information
+ */
+void malloc_get_info(struct malloc_info *info);
+
+/**
+ * malloc_cache_class() - obtain statistics for a size class of the cache
+ *
+ * @idx:	index of the class, starting at 0
+ * @info:	returns the class statistics
+ * Return: 0 if OK, -ENOENT if @idx is out of range or the cache is not enabled
+ */
+int malloc_cache_class(int idx, struct malloc_class_info *info);
+
+/**
+ * malloc_cache_flush() - return all cached chunks to the allocator
+ *
+ * Return: number of chunks released
+ */
+int malloc_cache_flush(void);
+
+/**
+ * malloc_cache_enable() - enable or disable the size-class cache
+ *
+ * Disabling the cache flushes it first.
+ *
+ * @enable:	true to enable the cache, false to disable it
+ * Return: true if the cache was enabled before the call
+ */
+bool malloc_cache_enable(bool enable);
+
 #ifdef __cplusplus
 };  /* end of extern "C" */
 #endif
@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Memory test engine, for testing a range of memory on each CPU
+ */
+
+#ifndef __MEMTEST_H
+#define __MEMTEST_H
+
+#include <linux/bitops.h>
+#include <linux/types.h>
+
+/* Number of errors recorded in each job, after which they are just counted */
+#define MEMTEST_MAX_ERRS	8
+
+/* Each job's range must be aligned to, and a multiple of, this many bytes */
+#define MEMTEST_ALIGN		64
+
+/**
+ * enum memtest_flags - tests to run
+ *
+ * @MEMTEST_PATTERN: Fill with the pattern, then with its inverse
+ * @MEMTEST_WALK: Walking ones and walking zeroes, across bits and addresses
+ * @MEMTEST_ADDR: Each word holds its own address, then the inverse
+ * @MEMTEST_BITFLIP: Each bit is set and cleared with the opposite value in
+ *	the neighbouring words
+ */
+enum memtest_flags {
+	MEMTEST_PATTERN		= BIT(0),
+	MEMTEST_WALK		= BIT(1),
+	MEMTEST_ADDR		= BIT(2),
+	MEMTEST_BITFLIP		= BIT(3),
+
+	MEMTEST_ALL		= MEMTEST_PATTERN | MEMTEST_WALK |
+				  MEMTEST_ADDR | MEMTEST_BITFLIP,
+};
+
+/**
+ * struct memtest_err - a word which did not read back correctly
+ *
+ * @addr: Address of the word
+ * @expect: Value written
+ * @actual: Value read back
+ */
+struct memtest_err {
+	u64 *addr;
+	u64 expect;
+	u64 actual;
+};
+
+/**
+ * struct memtest_job - a range of memory to test
+ *
+ * @buf: Start of the range, aligned to MEMTEST_ALIGN
+ * @size: Size of the range in bytes, a multiple of MEMTEST_ALIGN
+ * @tests: Tests to run (enum memtest_flags)
+ * @pattern: Pattern for MEMTEST_PATTERN
+ * @primary: true if this job runs on the boot CPU, so that it can kick the
+ *	watchdog and check for Ctrl-C between tests
+ * @stop: Flag shared by all the jobs, or NULL. The primary job sets it when
+ *	Ctrl-C is pressed, and each job stops at its next test once it is set
+ * @bytes: Returns the number of bytes written and read
+ * @errors: Returns the number of words which did not read back correctly
+ * @err: Returns the first MEMTEST_MAX_ERRS of these
+ */
+struct memtest_job {
+	u64 *buf;
+	ulong size;
+	uint tests;
+	u64 pattern;
+	bool primary;
+	bool *stop;
+	u64 bytes;
+	ulong errors;
+	struct memtest_err err[MEMTEST_MAX_ERRS];
+};
+
+/**
+ * memtest_run() - Test a range of memory
+ *
+ * Apart from the primary job, this only accesses the memory under test and the
+ * job itself, so it can be passed to cpu_run_parallel() to test several ranges
+ * at once.
+ *
+ * @arg: Job to run (struct memtest_job *)
+ */
+void memtest_run(void *arg);
+
+#endif
@@ -82,6 +82,7 @@ struct bd_info;
 
 
 #define SD_DATA_4BIT	0x00040000
+#define SD_DATA_STAT_AFTER_ERASE	0x00800000
 
 #define IS_SD(x)	((x)->version & SD_VERSION_SD)
 #define IS_MMC(x)	((x)->version & MMC_VERSION_MMC)
@@ -231,6 +232,7 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 #define EXT_CSD_ERASE_GROUP_DEF		175	/* R/W */
 #define EXT_CSD_BOOT_BUS_WIDTH		177
 #define EXT_CSD_PART_CONF		179	/* R/W */
+#define EXT_CSD_ERASED_MEM_CONT		181	/* RO */
 #define EXT_CSD_BUS_WIDTH		183	/* R/W */
 #define EXT_CSD_STROBE_SUPPORT		184	/* R/W */
 #define EXT_CSD_HS_TIMING		185	/* R/W */
@@ -710,6 +712,8 @@ struct mmc {
 	struct blk_desc block_dev;
 #endif
 	char op_cond_pending;	/* 1 if we are waiting on an op_cond command */
+	char sd_op_cond_pending;	/* 1 if an SD card is still powering up */
+	char sd_op_cond_uhs;	/* ... and was offered 1.8V signalling */
 	char init_in_progress;	/* 1 if we have done mmc_start_init() */
 	char preinit;		/* start init as early as possible */
 	int ddr_mode;
@@ -909,9 +913,9 @@ int mmc_get_op_cond(struct mmc *mmc, bool quiet);
 
 /**
  * Start device initialization and return immediately; it does not block on
- * polling OCR (operation condition register) status.  Then you should call
- * mmc_init, which would block on polling OCR status and complete the device
- * initializatin.
+ * polling OCR (operation condition register) status, also not while an SD
+ * card powers up.  Then you should call mmc_init, which would block on
+ * polling OCR status and complete the device initializatin.
  *
  * @param mmc	Pointer to a MMC device struct
  * Return: 0 on success, <0 on error.
@@ -10,6 +10,7 @@
 #define _OF_LIVE_H
 
 struct device_node;
+struct fdt_reserve_entry;
 
 /**
  * of_live_build() - build a live (hierarchical) tree from a flat DT
@@ -36,4 +37,27 @@ int of_live_build(const void *fdt_blob, struct device_node **rootp);
  */
 int unflatten_device_tree(const void *blob, struct device_node **mynodes);
 
+/**
+ * of_live_flatten() - write a live tree back out as a flat DT
+ *
+ * This is the reverse of unflatten_device_tree(). Nodes and properties are
+ * written in the order they appear in the live tree. The "name" properties
+ * which unflatten_device_tree() makes up are dropped. Property names keep
+ * their offsets in the strings block of @fdt where possible, so @fdt must be
+ * the blob that @root was unflattened from and must not overlap @buf. The
+ * memory-reservation block stays at the offset it has in @fdt.
+ *
+ * @root: Root of the live tree to write
+ * @fdt: Flat tree which @root was unflattened from
+ * @rsv: Memory-reservation entries to write
+ * @rsv_count: Number of entries in @rsv
+ * @buf: Buffer to write the flat tree to
+ * @size: Size of @buf, which is also used as the totalsize of the new tree
+ * Return: 0 if OK, -ENOSPC if the tree does not fit in @size bytes, other
+ *	-ve on error
+ */
+int of_live_flatten(const struct device_node *root, const void *fdt,
+		    const struct fdt_reserve_entry *rsv, int rsv_count,
+		    void *buf, int size);
+
 #endif
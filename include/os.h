@@ -413,6 +413,24 @@ int os_write_file(const char *name, const void *buf, int size);
  */
 int os_read_file(const char *name, void **bufp, int *sizep);
 
+/**
+ * os_persistent_file() - Find the path to a test file
+ *
+ * Test images such as the backing files of emulated MMC and SPI flash devices
+ * are kept in the persistent-data directory when running under test/py, so
+ * that they stay out of the source tree. That directory is passed in the
+ * U_BOOT_PERSISTENT_DATA_DIR environment variable. When it is not set, the
+ * filename is used as is, i.e. relative to the current directory.
+ *
+ * The file need not exist, so this can be used for files to be created.
+ *
+ * @buf:	Returns the full path to the file
+ * @maxsize:	Size of @buf in bytes
+ * @fname:	Leaf filename of the file
+ * Return:	0 if OK, -ENOSPC if the path does not fit in @buf
+ */
+int os_persistent_file(char *buf, int maxsize, const char *fname);
+
 /**
  * os_map_file() - Map a file from the host filesystem into memory
  *
@@ -496,4 +514,24 @@ long os_get_time_offset(void);
  */
 void os_set_time_offset(long offset);
 
+
+/**
+ * os_get_cpu_count() - get the number of CPUs on the host
+ *
+ * Return:	number of CPUs which are online, at least 1
+ */
+int os_get_cpu_count(void);
+
+/**
+ * os_run_threads() - call a function in several host threads at once
+ *
+ * The first call is made in the calling thread.
+ *
+ * @func:	Function to call
+ * @args:	Argument to pass to each call
+ * @count:	Number of calls to make
+ * Return:	0 once all the calls have returned, -ENOMEM if out of memory
+ */
+int os_run_threads(void (*func)(void *arg), void *const args[], int count);
+
 #endif
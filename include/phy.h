@@ -167,6 +167,11 @@ struct phy_device {
 	u32 phy_id;
 	bool is_c45;
 	u32 flags;
+
+	/* get_timer() value when autonegotiation was last started, or 0 */
+	ulong aneg_start;
+	/* Time autonegotiation took in ms, or 0 if not yet seen complete */
+	ulong aneg_time;
 };
 
 struct fixed_link {
@@ -198,6 +203,17 @@ int phy_init(void);
  */
 int phy_reset(struct phy_device *phydev);
 
+/**
+ * phy_poll_link() - Check on autonegotiation without waiting for it
+ * Reads the PHY status once and, if autonegotiation has completed since it
+ * was started, records how long it took in @phydev->aneg_time
+ *
+ * @phydev:	PHY to check
+ * @return: 0 if autonegotiation is complete or not in use, -EINPROGRESS if it
+ *	is still running, other -ve on error
+ */
+int phy_poll_link(struct phy_device *phydev);
+
 /**
  * phy_find_by_mask() - Searches for a PHY on the specified MDIO bus
  * The function checks the PHY addresses flagged in phy_mask and returns a
@@ -2,6 +2,7 @@
 #define __SERIAL_H__
 
 #include <post.h>
+#include <linux/errno.h>
 
 struct serial_device {
 	/* enough bytes to match alignment of following func pointer */
@@ -205,7 +206,8 @@ struct dm_serial_ops {
 	 * If the whole string cannot be written at once, then this function
 	 * should return the number of characters written. Returning a negative
 	 * error code implies that no characters were written. If this function
-	 * returns 0, then it will be called again with the same arguments.
+	 * returns 0 or -EAGAIN, then it will be called again with the same
+	 * arguments.
 	 *
 	 * @dev: Device pointer
 	 * @s: The string to write
@@ -284,6 +286,21 @@ struct dm_serial_ops {
 	int (*getinfo)(struct udevice *dev, struct serial_device_info *info);
 };
 
+/**
+ * struct serial_tx_stats - statistics about the TX buffer of a device
+ *
+ * @queued:	Number of characters put into the TX buffer
+ * @idle:	Number of characters sent while the CPU would otherwise spin,
+ *		rather than when they were written
+ * @wait_us:	Time spent waiting for the UART when the TX buffer was full
+ *		or flushed, in microseconds
+ */
+struct serial_tx_stats {
+	ulong queued;
+	ulong idle;
+	ulong wait_us;
+};
+
 /**
  * struct serial_dev_priv - information about a device used by the uclass
  *
@@ -292,6 +309,12 @@ struct dm_serial_ops {
  * @buf:	Pointer to the RX buffer
  * @rd_ptr:	Read pointer in the RX buffer
  * @wr_ptr:	Write pointer in the RX buffer
+ *
+ * @tx_buf:	Pointer to the TX buffer, NULL if output is not buffered
+ * @tx_head:	Number of characters ever put into the TX buffer
+ * @tx_tail:	Number of characters ever sent from the TX buffer
+ * @tx_busy:	true while the TX buffer is being drained
+ * @tx_stats:	TX buffer statistics
  */
 struct serial_dev_priv {
 	struct stdio_dev *sdev;
@@ -299,6 +322,12 @@ struct serial_dev_priv {
 	char *buf;
 	int rd_ptr;
 	int wr_ptr;
+
+	char *tx_buf;
+	uint tx_head;
+	uint tx_tail;
+	bool tx_busy;
+	struct serial_tx_stats tx_stats;
 };
 
 /* Access the serial operations for a device */
@@ -365,4 +394,46 @@ void serial_puts(const char *str);
 int serial_getc(void);
 int serial_tstc(void);
 
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+/**
+ * serial_tx_poll() - Send buffered output that the console UART accepts now
+ *
+ * This never waits for the UART. Call it from loops which spin waiting for
+ * something else, so that buffered output goes out meanwhile.
+ */
+void serial_tx_poll(void);
+
+/**
+ * serial_flush() - Wait until buffered output to the console UART has gone
+ */
+void serial_flush(void);
+
+/**
+ * serial_get_tx_stats() - Get statistics about the TX buffer of a device
+ *
+ * @dev: Serial device
+ * @stats: Returns the statistics
+ * @reclaimedp: Returns the estimated time the callers did not have to wait
+ *	for the UART, in microseconds
+ * Return: 0 if OK, -ENOENT if the device does not buffer its output
+ */
+int serial_get_tx_stats(struct udevice *dev, struct serial_tx_stats *stats,
+			ulong *reclaimedp);
+#else
+static inline void serial_tx_poll(void)
+{
+}
+
+static inline void serial_flush(void)
+{
+}
+
+static inline int serial_get_tx_stats(struct udevice *dev,
+				      struct serial_tx_stats *stats,
+				      ulong *reclaimedp)
+{
+	return -ENOENT;
+}
+#endif
+
 #endif
@@ -17,6 +17,7 @@ void putc(const char c);
 void puts(const char *s);
 int __printf(1, 2) printf(const char *fmt, ...);
 int vprintf(const char *fmt, va_list args);
+void flush(void);
 #else
 static inline void putc(const char c)
 {
@@ -35,6 +36,10 @@ static inline int vprintf(const char *fmt, va_list args)
 {
 	return 0;
 }
+
+static inline void flush(void)
+{
+}
 #endif
 
 /*
@@ -53,6 +58,7 @@ static inline int vprintf(const char *fmt, va_list args)
 int __printf(2, 3) fprintf(int file, const char *fmt, ...);
 void fputs(int file, const char *s);
 void fputc(int file, const char c);
+void fflush(int file);
 int ftstc(int file);
 int fgetc(int file);
 
@@ -37,6 +37,8 @@ struct stdio_dev {
 	void (*putc)(struct stdio_dev *dev, const char c);
 	/* To put a string (accelerator) */
 	void (*puts)(struct stdio_dev *dev, const char *s);
+	/* To wait until buffered output has gone out */
+	void (*flush)(struct stdio_dev *dev);
 
 /* INPUT functions */
 
@@ -65,16 +65,29 @@ enum ftrace_flags {
 	FUNCF_ENTRY		= 1UL << 30,
 	FUNCF_TEXTBASE		= 2UL << 30,
 
-	FUNCF_TIMESTAMP_MASK	= 0x3fffffff,
+	FUNCF_CPU_SHIFT		= 16,
+	FUNCF_CPU_MASK		= 0xffUL << FUNCF_CPU_SHIFT,
+	FUNCF_DEPTH_MASK	= 0xffff,
 };
 
 #define TRACE_CALL_TYPE(call)	((call)->flags & 0xc0000000UL)
+#define TRACE_CALL_CPU(call)	\
+	(((call)->flags & FUNCF_CPU_MASK) >> FUNCF_CPU_SHIFT)
+
+/*
+ * Call depth of the function, relative to the depth at which tracing started.
+ * This is the same for the entry and exit records of a call and is negative
+ * for functions which were already running when tracing started.
+ */
+#define TRACE_CALL_DEPTH(call)	((int16_t)((call)->flags & FUNCF_DEPTH_MASK))
 
 /* Information about a single function entry/exit */
 struct trace_call {
 	uint32_t func;		/* Function offset */
 	uint32_t caller;	/* Caller function offset */
-	uint32_t flags;		/* Flags and timestamp */
+	uint32_t flags;		/* Flags, CPU number and call depth */
+	uint32_t reserved;
+	uint64_t timestamp;	/* Time of the entry/exit in microseconds */
 };
 
 int trace_list_calls(void *buff, size_t buff_size, size_t *needed);
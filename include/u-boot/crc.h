@@ -123,4 +123,19 @@ void crc32c_init(uint32_t *crc32c_table, uint32_t pol);
 uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
 		    uint32_t *crc32c_table);
 
+/**
+ * crc32c() - Calculate the CRC32C (Castagnoli) of a buffer
+ *
+ * This uses the ARMv8 CRC32 instructions when CONFIG_ARM64_CRC32 is enabled,
+ * otherwise a table which is set up on the first call. No inversion is done
+ * on the way in or out, so callers wanting the standard CRC32C pass ~0 and
+ * invert the result.
+ *
+ * @crc: Previous crc
+ * @data: Data bytes to checksum
+ * @length: Number of bytes to process
+ * Return: checksum value
+ */
+uint32_t crc32c(uint32_t crc, const void *data, size_t length);
+
 #endif /* _UBOOT_CRC_H */
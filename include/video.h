@@ -91,6 +91,12 @@ enum video_format {
  *		the LCD is updated
  * @fg_col_idx:	Foreground color code (bit 3 = bold, bit 0-2 = color)
  * @bg_col_idx:	Background color code (bit 3 = bold, bit 0-2 = color)
+ * @damage:	Bounding box, in pixels, of the frame buffer area changed
+ *		since the last video_sync(); empty if @damage.xend is 0. Only
+ *		used with CONFIG_VIDEO_DAMAGE
+ * @damage_all:	true if the frame buffer may be written without reporting
+ *		damage (e.g. by an EFI application through the GOP frame
+ *		buffer), so that every video_sync() syncs all of it
  */
 struct video_priv {
 	/* Things set up by the driver: */
@@ -115,6 +121,13 @@ struct video_priv {
 	bool flush_dcache;
 	u8 fg_col_idx;
 	u8 bg_col_idx;
+	struct {
+		int xstart;
+		int ystart;
+		int xend;
+		int yend;
+	} damage;
+	bool damage_all;
 };
 
 /**
@@ -231,16 +244,33 @@ void video_set_flush_dcache(struct udevice *dev, bool flush);
  */
 void video_set_default_colors(struct udevice *dev, bool invert);
 
-#ifdef CONFIG_VIDEO_COPY
+#ifdef CONFIG_VIDEO_DAMAGE
 /**
- * vidconsole_sync_copy() - Sync back to the copy framebuffer
+ * video_damage() - Mark a region of the frame buffer as changed
  *
- * This ensures that the copy framebuffer has the same data as the framebuffer
- * for a particular region. It should be called after the framebuffer is updated
+ * The region is added to the bounding box of changes since the last
+ * video_sync(), which then only copies (with CONFIG_VIDEO_COPY) and flushes
+ * that part of the frame buffer. It is cropped to the display.
+ *
+ * @dev: Video device being updated
+ * @x: X position of the region in pixels from the left
+ * @y: Y position of the region in pixels from the top
+ * @width: Width of the region in pixels
+ * @height: Height of the region in pixels
+ */
+void video_damage(struct udevice *dev, int x, int y, int width, int height);
+
+/**
+ * video_sync_copy() - Mark a range of the framebuffer as changed
+ *
+ * This ensures that the next video_sync() brings the copy framebuffer (and the
+ * data cache) up to date for a particular region. It should be called after
+ * the framebuffer is updated. A range covering more than one line marks whole
+ * lines, so callers which know the exact area should use video_damage().
  *
  * @from and @to can be in either order. The region between them is synced.
  *
- * @dev: Vidconsole device being updated
+ * @dev: Video device being updated
  * @from: Start/end address within the framebuffer (->fb)
  * @to: Other address within the frame buffer
  * Return: 0 if OK, -EFAULT if the start address is before the start of the
@@ -256,6 +286,11 @@ int video_sync_copy(struct udevice *dev, void *from, void *to);
  */
 int video_sync_copy_all(struct udevice *dev);
 #else
+static inline void video_damage(struct udevice *dev, int x, int y, int width,
+				int height)
+{
+}
+
 static inline int video_sync_copy(struct udevice *dev, void *from, void *to)
 {
 	return 0;
@@ -256,12 +256,13 @@ void vidconsole_position_cursor(struct udevice *dev, unsigned col,
  */
 u32 vid_console_color(struct video_priv *priv, unsigned int idx);
 
-#ifdef CONFIG_VIDEO_COPY
+#ifdef CONFIG_VIDEO_DAMAGE
 /**
- * vidconsole_sync_copy() - Sync back to the copy framebuffer
+ * vidconsole_sync_copy() - Mark a range of the framebuffer as changed
  *
- * This ensures that the copy framebuffer has the same data as the framebuffer
- * for a particular region. It should be called after the framebuffer is updated
+ * This ensures that the next video_sync() brings the copy framebuffer up to
+ * date for a particular region. It should be called after the framebuffer is
+ * updated
  *
  * @from and @to can be in either order. The region between them is synced.
  *
@@ -276,8 +277,8 @@ int vidconsole_sync_copy(struct udevice *dev, void *from, void *to);
 /**
  * vidconsole_memmove() - Perform a memmove() within the frame buffer
  *
- * This handles a memmove(), e.g. for scrolling. It also updates the copy
- * framebuffer.
+ * This handles a memmove(), e.g. for scrolling. It also marks the destination
+ * as changed, see vidconsole_sync_copy().
  *
  * @dev: Vidconsole device being updated
  * @dst: Destination address within the framebuffer (->fb)
@@ -0,0 +1,128 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * CRC-32 and CRC-32C using the ARMv8 CRC32 instructions
+ *
+ * This is shared by lib/crc32.c and lib/crc32c.c. Everything is inlined so
+ * that crc32() can still be used by EFI runtime services.
+ */
+
+#ifndef __CRC32_ARM64_H
+#define __CRC32_ARM64_H
+
+#include <linux/types.h>
+#include <asm/byteorder.h>
+
+/*
+ * Long buffers are split into three streams of this many bytes. The CRCs of
+ * the streams do not depend on each other, so their instructions overlap in
+ * the pipeline. The results are then combined by shifting each one over the
+ * length of the stream after it and adding that stream's CRC.
+ */
+#define CRC32_ARM64_STRIDE	1024
+
+/* x^(8 * CRC32_ARM64_STRIDE - 33) mod P, bit-reflected, for each polynomial */
+#define CRC32_ARM64_SHIFT_K	0xbbf2f6d6
+#define CRC32C_ARM64_SHIFT_K	0x170076fa
+
+static __always_inline u32 crc32_arm64_byte(u32 crc, u8 val, bool castagnoli)
+{
+	return castagnoli ? __builtin_aarch64_crc32cb(crc, val) :
+			    __builtin_aarch64_crc32b(crc, val);
+}
+
+static __always_inline u32 crc32_arm64_word(u32 crc, u64 val, bool castagnoli)
+{
+	val = le64_to_cpu(val);
+
+	return castagnoli ? __builtin_aarch64_crc32cx(crc, val) :
+			    __builtin_aarch64_crc32x(crc, val);
+}
+
+/* Carry-less multiply of two 32-bit values */
+static __always_inline u64 crc32_arm64_clmul(u32 a, u32 b)
+{
+#ifdef CONFIG_ARMV8_CE_CRC32
+	u64 res;
+
+	/* U-Boot is built without FP/SIMD registers, so name them here */
+	asm(".arch_extension crypto\n"
+	    "fmov	d0, %1\n"
+	    "fmov	d1, %2\n"
+	    "pmull	v0.1q, v0.1d, v1.1d\n"
+	    "fmov	%0, d0\n"
+	    : "=r" (res) : "r" ((u64)a), "r" ((u64)b) : "v0", "v1");
+
+	return res;
+#else
+	u64 res = 0;
+	int i;
+
+	for (i = 0; i < 32; i++)
+		res ^= ((u64)a << i) & -(u64)((b >> i) & 1);
+
+	return res;
+#endif
+}
+
+/* Advance @crc over CRC32_ARM64_STRIDE zero bytes */
+static __always_inline u32 crc32_arm64_shift(u32 crc, bool castagnoli)
+{
+	u32 k = castagnoli ? CRC32C_ARM64_SHIFT_K : CRC32_ARM64_SHIFT_K;
+
+	/* the product has an extra factor x, the CRC instruction adds x^32 */
+	return crc32_arm64_word(0, cpu_to_le64(crc32_arm64_clmul(crc, k)),
+				castagnoli);
+}
+
+/**
+ * crc32_arm64() - Calculate a CRC-32 or CRC-32C with the CRC32 instructions
+ *
+ * No inversion is done on the way in or out.
+ *
+ * @crc: Previous CRC value
+ * @p: Data to checksum
+ * @len: Number of bytes at @p
+ * @castagnoli: true for CRC-32C, false for CRC-32
+ * Return: updated CRC value
+ */
+static __always_inline u32 crc32_arm64(u32 crc, const u8 *p, size_t len,
+				       bool castagnoli)
+{
+	const u64 *q;
+	u32 crc1, crc2;
+	size_t i;
+
+	while (len && ((ulong)p & 7)) {
+		crc = crc32_arm64_byte(crc, *p++, castagnoli);
+		len--;
+	}
+
+	while (len >= 3 * CRC32_ARM64_STRIDE) {
+		q = (const u64 *)p;
+		crc1 = 0;
+		crc2 = 0;
+		for (i = 0; i < CRC32_ARM64_STRIDE / 8; i++) {
+			crc = crc32_arm64_word(crc, q[i], castagnoli);
+			crc1 = crc32_arm64_word(crc1,
+						q[i + CRC32_ARM64_STRIDE / 8],
+						castagnoli);
+			crc2 = crc32_arm64_word(crc2,
+						q[i + 2 * CRC32_ARM64_STRIDE / 8],
+						castagnoli);
+		}
+		crc = crc32_arm64_shift(crc, castagnoli) ^ crc1;
+		crc = crc32_arm64_shift(crc, castagnoli) ^ crc2;
+		p += 3 * CRC32_ARM64_STRIDE;
+		len -= 3 * CRC32_ARM64_STRIDE;
+	}
+
+	for (; len >= 8; len -= 8, p += 8)
+		crc = crc32_arm64_word(crc, *(const u64 *)p, castagnoli);
+
+	while (len--)
+		crc = crc32_arm64_byte(crc, *p++, castagnoli);
+
+	return crc;
+}
+
+#endif /* __CRC32_ARM64_H */
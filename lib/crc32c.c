@@ -12,6 +12,14 @@
 
 #include <common.h>
 #include <compiler.h>
+#include <u-boot/crc.h>
+
+#ifdef CONFIG_ARM64_CRC32
+#include "crc32_arm64.h"
+#endif
+
+/* Bit-reflected CRC32C polynomial */
+#define CRC32C_POLY	0x82f63b78
 
 uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
 		    uint32_t *crc32c_table)
@@ -36,3 +44,23 @@ void crc32c_init(uint32_t *crc32c_table, uint32_t pol)
 		crc32c_table[i] = v;
 	}
 }
+
+uint32_t crc32c(uint32_t crc, const void *data, size_t length)
+{
+#ifdef CONFIG_ARM64_CRC32
+	return crc32_arm64(crc, data, length, true);
+#else
+	static uint32_t table[256];
+	static bool inited;
+	const u8 *p = data;
+
+	if (!inited) {
+		crc32c_init(table, CRC32C_POLY);
+		inited = true;
+	}
+	while (length--)
+		crc = table[(u8)(crc ^ *p++)] ^ (crc >> 8);
+
+	return crc;
+#endif
+}
@@ -18,6 +18,7 @@
 #include <time.h>
 #include <u-boot/crc.h>
 #include <usb.h>
+#include <video.h>
 #include <watchdog.h>
 #include <asm/global_data.h>
 #include <asm/setjmp.h>
@@ -2170,6 +2171,12 @@ static efi_status_t EFIAPI efi_exit_boot_services(efi_handle_t image_handle,
 			list_del(&evt->link);
 	}
 
+	/* The OS takes over the console; let buffered output finish first */
+	flush();
+	/* Make what the application drew on the frame buffer visible */
+	if (IS_ENABLED(CONFIG_DM_VIDEO))
+		video_sync_all();
+
 	if (!efi_st_keep_devices) {
 		bootm_disable_interrupts();
 		if (IS_ENABLED(CONFIG_USB_DEVICE))
@@ -35,6 +35,7 @@ struct efi_gop_obj {
 	/* Fields we only have access to during init */
 	u32 bpix;
 	void *fb;
+	struct udevice *vdev;
 };
 
 static efi_status_t EFIAPI gop_query_mode(struct efi_gop *this, u32 mode_number,
@@ -458,6 +459,12 @@ efi_status_t EFIAPI gop_blt(struct efi_gop *this, struct efi_gop_pixel *buffer,
 	if (ret != EFI_SUCCESS)
 		return EFI_EXIT(ret);
 
+	if (operation != EFI_BLT_VIDEO_TO_BLT_BUFFER) {
+		struct efi_gop_obj *gopobj;
+
+		gopobj = container_of(this, struct efi_gop_obj, ops);
+		video_damage(gopobj->vdev, dx, dy, width, height);
+	}
 	video_sync_all();
 
 	return EFI_EXIT(EFI_SUCCESS);
@@ -495,6 +502,8 @@ efi_status_t efi_gop_register(void)
 	fb_base = (uintptr_t)priv->fb;
 	fb_size = priv->fb_size;
 	fb = priv->fb;
+	/* Applications may draw straight to the frame buffer */
+	priv->damage_all = true;
 #else
 	int line_len;
 
@@ -577,6 +586,7 @@ efi_status_t efi_gop_register(void)
 	gopobj->info.pixels_per_scanline = col;
 	gopobj->bpix = bpix;
 	gopobj->fb = fb;
+	gopobj->vdev = vdev;
 
 	return EFI_SUCCESS;
 }
@@ -13,7 +13,8 @@
 #include <watchdog.h>
 #include <asm/cache.h>
 #include <asm/global_data.h>
-#include <linux/list_sort.h>
+#include <asm/sections.h>
+#include <linux/rbtree_augmented.h>
 #include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -23,17 +24,32 @@ DECLARE_GLOBAL_DATA_PTR;
 
 efi_uintn_t efi_memory_map_key;
 
+/**
+ * struct efi_mem_list - memory map entry
+ *
+ * @node:		node in the memory map tree, keyed by physical start
+ * @desc:		memory descriptor
+ * @max_free_pages:	largest number of pages of a single
+ *			EFI_CONVENTIONAL_MEMORY entry in the subtree rooted
+ *			at this node
+ *
+ * The memory map is kept in a red-black tree sorted by address. Entries never
+ * overlap and adjacent entries with identical type and attributes are always
+ * merged, so that the tree is the canonical representation of the map.
+ * Tracking the largest free block per subtree allows to find free memory
+ * without walking the whole map.
+ */
 struct efi_mem_list {
-	struct list_head link;
+	struct rb_node node;
 	struct efi_mem_desc desc;
+	u64 max_free_pages;
 };
 
-#define EFI_CARVE_NO_OVERLAP		-1
-#define EFI_CARVE_LOOP_AGAIN		-2
-#define EFI_CARVE_OVERLAPS_NONRAM	-3
+/* This tree contains all memory map items */
+static struct rb_root efi_mem = RB_ROOT;
 
-/* This list contains all memory map items */
-LIST_HEAD(efi_mem);
+/* Number of entries in the memory map */
+static efi_uintn_t efi_mem_entries;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 void *efi_bounce_buffer;
@@ -78,156 +94,291 @@ static u64 checksum(struct efi_pool_allocation *alloc)
 	return ret;
 }
 
-/*
- * Sorts the memory list from highest address to lowest address
+static uint64_t desc_get_end(struct efi_mem_desc *desc)
+{
+	return desc->physical_start + (desc->num_pages << EFI_PAGE_SHIFT);
+}
+
+/**
+ * efi_mem_compute_max_free() - compute largest free block of a subtree
  *
- * When allocating memory we should always start from the highest
- * address chunk, so sort the memory list such that the first list
- * iterator gets the highest address and goes lower from there.
+ * @item:	root of the subtree
+ * Return:	number of pages of the largest EFI_CONVENTIONAL_MEMORY entry
  */
-static int efi_mem_cmp(void *priv, struct list_head *a, struct list_head *b)
+static u64 efi_mem_compute_max_free(struct efi_mem_list *item)
 {
-	struct efi_mem_list *mema = list_entry(a, struct efi_mem_list, link);
-	struct efi_mem_list *memb = list_entry(b, struct efi_mem_list, link);
+	struct efi_mem_list *child;
+	u64 pages = 0;
+
+	if (item->desc.type == EFI_CONVENTIONAL_MEMORY)
+		pages = item->desc.num_pages;
+	if (item->node.rb_left) {
+		child = rb_entry(item->node.rb_left, struct efi_mem_list, node);
+		pages = max(pages, child->max_free_pages);
+	}
+	if (item->node.rb_right) {
+		child = rb_entry(item->node.rb_right, struct efi_mem_list,
+				 node);
+		pages = max(pages, child->max_free_pages);
+	}
 
-	if (mema->desc.physical_start == memb->desc.physical_start)
-		return 0;
-	else if (mema->desc.physical_start < memb->desc.physical_start)
-		return 1;
-	else
-		return -1;
+	return pages;
 }
 
-static uint64_t desc_get_end(struct efi_mem_desc *desc)
+RB_DECLARE_CALLBACKS(static, efi_mem_augment, struct efi_mem_list, node, u64,
+		     max_free_pages, efi_mem_compute_max_free)
+
+static struct efi_mem_list *efi_mem_next(struct efi_mem_list *item)
 {
-	return desc->physical_start + (desc->num_pages << EFI_PAGE_SHIFT);
+	return rb_entry_safe(rb_next(&item->node), struct efi_mem_list, node);
 }
 
-static void efi_mem_sort(void)
+static struct efi_mem_list *efi_mem_prev(struct efi_mem_list *item)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *prevmem = NULL;
-	bool merge_again = true;
-
-	list_sort(NULL, &efi_mem, efi_mem_cmp);
-
-	/* Now merge entries that can be merged */
-	while (merge_again) {
-		merge_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			struct efi_mem_desc *prev = &prevmem->desc;
-			struct efi_mem_desc *cur;
-			uint64_t pages;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			if (!prevmem) {
-				prevmem = lmem;
-				continue;
-			}
-
-			cur = &lmem->desc;
-
-			if ((desc_get_end(cur) == prev->physical_start) &&
-			    (prev->type == cur->type) &&
-			    (prev->attribute == cur->attribute)) {
-				/* There is an existing map before, reuse it */
-				pages = cur->num_pages;
-				prev->num_pages += pages;
-				prev->physical_start -= pages << EFI_PAGE_SHIFT;
-				prev->virtual_start -= pages << EFI_PAGE_SHIFT;
-				list_del(&lmem->link);
-				free(lmem);
-
-				merge_again = true;
-				break;
-			}
+	return rb_entry_safe(rb_prev(&item->node), struct efi_mem_list, node);
+}
 
-			prevmem = lmem;
-		}
+/**
+ * efi_mem_find() - find the memory map entry containing an address
+ *
+ * @addr:	address to look up
+ * Return:	memory map entry or NULL if the address is not mapped
+ */
+static struct efi_mem_list *efi_mem_find(u64 addr)
+{
+	struct rb_node *rb = efi_mem.rb_node;
+
+	while (rb) {
+		struct efi_mem_list *item = rb_entry(rb, struct efi_mem_list,
+						     node);
+
+		if (addr < item->desc.physical_start)
+			rb = rb->rb_left;
+		else if (addr >= desc_get_end(&item->desc))
+			rb = rb->rb_right;
+		else
+			return item;
 	}
+
+	return NULL;
 }
 
-/** efi_mem_carve_out - unmap memory region
- *
- * @map:		memory map
- * @carve_desc:		memory region to unmap
- * @overlap_only_ram:	the carved out region may only overlap RAM
- * Return Value:	the number of overlapping pages which have been
- *			removed from the map,
- *			EFI_CARVE_NO_OVERLAP, if the regions don't overlap,
- *			EFI_CARVE_OVERLAPS_NONRAM, if the carve and map overlap,
- *			and the map contains anything but free ram
- *			(only when overlap_only_ram is true),
- *			EFI_CARVE_LOOP_AGAIN, if the mapping list should be
- *			traversed again, as it has been altered.
- *
- * Unmaps all memory occupied by the carve_desc region from the list entry
- * pointed to by map.
- *
- * In case of EFI_CARVE_OVERLAPS_NONRAM it is the callers responsibility
- * to re-add the already carved out pages to the mapping.
+/**
+ * efi_mem_first_overlap() - find the lowest entry ending above an address
+ *
+ * As entries do not overlap, their end addresses are sorted in the same order
+ * as their start addresses.
+ *
+ * @addr:	address
+ * Return:	memory map entry or NULL if no entry ends above @addr
  */
-static s64 efi_mem_carve_out(struct efi_mem_list *map,
-			     struct efi_mem_desc *carve_desc,
-			     bool overlap_only_ram)
+static struct efi_mem_list *efi_mem_first_overlap(u64 addr)
 {
-	struct efi_mem_list *newmap;
-	struct efi_mem_desc *map_desc = &map->desc;
-	uint64_t map_start = map_desc->physical_start;
-	uint64_t map_end = map_start + (map_desc->num_pages << EFI_PAGE_SHIFT);
-	uint64_t carve_start = carve_desc->physical_start;
-	uint64_t carve_end = carve_start +
-			     (carve_desc->num_pages << EFI_PAGE_SHIFT);
-
-	/* check whether we're overlapping */
-	if ((carve_end <= map_start) || (carve_start >= map_end))
-		return EFI_CARVE_NO_OVERLAP;
-
-	/* We're overlapping with non-RAM, warn the caller if desired */
-	if (overlap_only_ram && (map_desc->type != EFI_CONVENTIONAL_MEMORY))
-		return EFI_CARVE_OVERLAPS_NONRAM;
-
-	/* Sanitize carve_start and carve_end to lie within our bounds */
-	carve_start = max(carve_start, map_start);
-	carve_end = min(carve_end, map_end);
-
-	/* Carving at the beginning of our map? Just move it! */
-	if (carve_start == map_start) {
-		if (map_end == carve_end) {
-			/* Full overlap, just remove map */
-			list_del(&map->link);
-			free(map);
+	struct rb_node *rb = efi_mem.rb_node;
+	struct efi_mem_list *found = NULL;
+
+	while (rb) {
+		struct efi_mem_list *item = rb_entry(rb, struct efi_mem_list,
+						     node);
+
+		if (desc_get_end(&item->desc) > addr) {
+			found = item;
+			rb = rb->rb_left;
 		} else {
-			map->desc.physical_start = carve_end;
-			map->desc.virtual_start = carve_end;
-			map->desc.num_pages = (map_end - carve_end)
-					      >> EFI_PAGE_SHIFT;
+			rb = rb->rb_right;
 		}
+	}
+
+	return found;
+}
+
+/**
+ * efi_mem_insert() - insert a new entry into the memory map
+ *
+ * The caller must ensure that the entry does not overlap any existing entry.
+ *
+ * @desc:	memory descriptor to copy into the new entry
+ * Return:	new memory map entry or NULL if out of memory
+ */
+static struct efi_mem_list *efi_mem_insert(struct efi_mem_desc *desc)
+{
+	struct rb_node **link = &efi_mem.rb_node, *parent = NULL;
+	struct efi_mem_list *item;
+
+	item = calloc(1, sizeof(*item));
+	if (!item)
+		return NULL;
+	item->desc = *desc;
+
+	while (*link) {
+		struct efi_mem_list *cur;
 
-		return (carve_end - carve_start) >> EFI_PAGE_SHIFT;
+		parent = *link;
+		cur = rb_entry(parent, struct efi_mem_list, node);
+		if (desc->physical_start < cur->desc.physical_start)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
 	}
 
+	rb_link_node(&item->node, parent, link);
+	efi_mem_augment.propagate(&item->node, NULL);
+	rb_insert_augmented(&item->node, &efi_mem, &efi_mem_augment);
+	++efi_mem_entries;
+
+	return item;
+}
+
+/**
+ * efi_mem_remove() - remove an entry from the memory map and free it
+ *
+ * @item:	memory map entry
+ */
+static void efi_mem_remove(struct efi_mem_list *item)
+{
+	rb_erase_augmented(&item->node, &efi_mem, &efi_mem_augment);
+	free(item);
+	--efi_mem_entries;
+}
+
+/**
+ * efi_mem_resize() - change the address range of an entry
+ *
+ * The new range must keep the entry between its neighbours in the tree.
+ *
+ * @item:	memory map entry
+ * @start:	new start address
+ * @end:	new end address
+ */
+static void efi_mem_resize(struct efi_mem_list *item, u64 start, u64 end)
+{
+	item->desc.physical_start = start;
+	item->desc.virtual_start = start;
+	item->desc.num_pages = (end - start) >> EFI_PAGE_SHIFT;
+	efi_mem_augment.propagate(&item->node, NULL);
+}
+
+/**
+ * efi_mem_can_merge() - check if two adjacent entries can be merged
+ *
+ * @lower:	entry at the lower address
+ * @upper:	entry at the higher address
+ * Return:	true if @upper directly follows @lower with the same type and
+ *		attributes
+ */
+static bool efi_mem_can_merge(struct efi_mem_list *lower,
+			      struct efi_mem_list *upper)
+{
+	return desc_get_end(&lower->desc) == upper->desc.physical_start &&
+	       lower->desc.type == upper->desc.type &&
+	       lower->desc.attribute == upper->desc.attribute;
+}
+
+/**
+ * efi_mem_merge() - merge an entry with its neighbours
+ *
+ * @item:	memory map entry
+ */
+static void efi_mem_merge(struct efi_mem_list *item)
+{
+	struct efi_mem_list *prev = efi_mem_prev(item);
+	struct efi_mem_list *next = efi_mem_next(item);
+
+	u64 pages;
+
 	/*
-	 * Overlapping maps, just split the list map at carve_start,
-	 * it will get moved or removed in the next iteration.
-	 *
-	 * [ map_desc |__carve_start__| newmap ]
+	 * Entries are removed before the surviving entry grows so that the
+	 * subtree maxima are consistent whenever they are propagated.
 	 */
+	if (prev && efi_mem_can_merge(prev, item)) {
+		/* There is an existing map before, reuse it */
+		pages = item->desc.num_pages;
+		efi_mem_remove(item);
+		prev->desc.num_pages += pages;
+		efi_mem_augment.propagate(&prev->node, NULL);
+		item = prev;
+	}
 
-	/* Create a new map from [ carve_start ... map_end ] */
-	newmap = calloc(1, sizeof(*newmap));
-	newmap->desc = map->desc;
-	newmap->desc.physical_start = carve_start;
-	newmap->desc.virtual_start = carve_start;
-	newmap->desc.num_pages = (map_end - carve_start) >> EFI_PAGE_SHIFT;
-	/* Insert before current entry (descending address order) */
-	list_add_tail(&newmap->link, &map->link);
+	if (next && efi_mem_can_merge(item, next)) {
+		pages = next->desc.num_pages;
+		efi_mem_remove(next);
+		item->desc.num_pages += pages;
+		efi_mem_augment.propagate(&item->node, NULL);
+	}
+}
 
-	/* Shrink the map to [ map_start ... carve_start ] */
-	map_desc->num_pages = (carve_start - map_start) >> EFI_PAGE_SHIFT;
+/**
+ * efi_mem_check_ram() - check that a region is fully covered by free RAM
+ *
+ * @start:	start address of the region
+ * @end:	end address of the region
+ * Return:	true if the region only overlaps EFI_CONVENTIONAL_MEMORY
+ *		entries without any holes
+ */
+static bool efi_mem_check_ram(u64 start, u64 end)
+{
+	struct efi_mem_list *item;
+	u64 covered = start;
+
+	for (item = efi_mem_first_overlap(start);
+	     item && item->desc.physical_start < end;
+	     item = efi_mem_next(item)) {
+		if (item->desc.type != EFI_CONVENTIONAL_MEMORY ||
+		    item->desc.physical_start > covered)
+			return false;
+		covered = desc_get_end(&item->desc);
+	}
+
+	return covered >= end;
+}
+
+/**
+ * efi_mem_carve_out() - unmap memory region
+ *
+ * Removes all memory occupied by the region [start, end) from the memory map,
+ * shrinking or splitting entries that partially overlap it.
+ *
+ * @start:	start address of the region
+ * @end:	end address of the region
+ * Return:	0 on success, -ENOMEM if an entry could not be split
+ */
+static int efi_mem_carve_out(u64 start, u64 end)
+{
+	struct efi_mem_list *item, *next;
+
+	for (item = efi_mem_first_overlap(start);
+	     item && item->desc.physical_start < end; item = next) {
+		u64 item_start = item->desc.physical_start;
+		u64 item_end = desc_get_end(&item->desc);
+
+		next = efi_mem_next(item);
+		if (item_start < start) {
+			if (item_end > end) {
+				struct efi_mem_desc tail = item->desc;
+
+				/*
+				 * The region lies inside the entry, split it
+				 *
+				 * [ item | carved region | tail ]
+				 */
+				tail.physical_start = end;
+				tail.virtual_start = end;
+				tail.num_pages = (item_end - end) >>
+						 EFI_PAGE_SHIFT;
+				if (!efi_mem_insert(&tail))
+					return -ENOMEM;
+			}
+			efi_mem_resize(item, item_start, start);
+		} else if (item_end > end) {
+			/* Carving at the beginning of the entry, move it */
+			efi_mem_resize(item, end, item_end);
+		} else {
+			/* Full overlap, just remove the entry */
+			efi_mem_remove(item);
+		}
+	}
 
-	return EFI_CARVE_LOOP_AGAIN;
+	return 0;
 }
 
 /**
@@ -243,11 +394,10 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 					  int memory_type,
 					  bool overlap_only_ram)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *newlist;
-	bool carve_again;
-	uint64_t carved_pages = 0;
+	struct efi_mem_list *item;
+	struct efi_mem_desc desc = {};
 	struct efi_event *evt;
+	u64 end;
 
 	EFI_PRINT("%s: 0x%llx 0x%llx %d %s\n", __func__,
 		  start, pages, memory_type, overlap_only_ram ? "yes" : "no");
@@ -258,80 +408,45 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 	if (!pages)
 		return EFI_SUCCESS;
 
-	++efi_memory_map_key;
-	newlist = calloc(1, sizeof(*newlist));
-	newlist->desc.type = memory_type;
-	newlist->desc.physical_start = start;
-	newlist->desc.virtual_start = start;
-	newlist->desc.num_pages = pages;
+	end = start + (pages << EFI_PAGE_SHIFT);
+
+	/*
+	 * The payload wanted to have RAM overlaps, but we would overlap with
+	 * a non-RAM or an unallocated region. Error out before the map is
+	 * modified.
+	 */
+	if (overlap_only_ram && !efi_mem_check_ram(start, end))
+		return EFI_NO_MAPPING;
+
+	desc.type = memory_type;
+	desc.physical_start = start;
+	desc.virtual_start = start;
+	desc.num_pages = pages;
 
 	switch (memory_type) {
 	case EFI_RUNTIME_SERVICES_CODE:
 	case EFI_RUNTIME_SERVICES_DATA:
-		newlist->desc.attribute = EFI_MEMORY_WB | EFI_MEMORY_RUNTIME;
+		desc.attribute = EFI_MEMORY_WB | EFI_MEMORY_RUNTIME;
 		break;
 	case EFI_MMAP_IO:
-		newlist->desc.attribute = EFI_MEMORY_RUNTIME;
+		desc.attribute = EFI_MEMORY_RUNTIME;
 		break;
 	default:
-		newlist->desc.attribute = EFI_MEMORY_WB;
+		desc.attribute = EFI_MEMORY_WB;
 		break;
 	}
 
-	/* Add our new map */
-	do {
-		carve_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			s64 r;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			r = efi_mem_carve_out(lmem, &newlist->desc,
-					      overlap_only_ram);
-			switch (r) {
-			case EFI_CARVE_OVERLAPS_NONRAM:
-				/*
-				 * The user requested to only have RAM overlaps,
-				 * but we hit a non-RAM region. Error out.
-				 */
-				return EFI_NO_MAPPING;
-			case EFI_CARVE_NO_OVERLAP:
-				/* Just ignore this list entry */
-				break;
-			case EFI_CARVE_LOOP_AGAIN:
-				/*
-				 * We split an entry, but need to loop through
-				 * the list again to actually carve it.
-				 */
-				carve_again = true;
-				break;
-			default:
-				/* We carved a number of pages */
-				carved_pages += r;
-				carve_again = true;
-				break;
-			}
-
-			if (carve_again) {
-				/* The list changed, we need to start over */
-				break;
-			}
-		}
-	} while (carve_again);
-
-	if (overlap_only_ram && (carved_pages != pages)) {
-		/*
-		 * The payload wanted to have RAM overlaps, but we overlapped
-		 * with an unallocated region. Error out.
-		 */
-		return EFI_NO_MAPPING;
-	}
+	++efi_memory_map_key;
 
-	/* Add our new map */
-        list_add_tail(&newlist->link, &efi_mem);
+	/* Remove the region from the map and add our new entry */
+	if (efi_mem_carve_out(start, end))
+		return EFI_OUT_OF_RESOURCES;
+	item = efi_mem_insert(&desc);
+	if (!item)
+		return EFI_OUT_OF_RESOURCES;
 
-	/* And make sure memory is listed in descending order */
-	efi_mem_sort();
+	/* And make sure adjacent entries of the same kind are merged */
+	efi_mem_merge(item);
 
 	/* Notify that the memory map was changed */
 	list_for_each_entry(evt, &efi_events, link) {
@@ -384,65 +499,72 @@ efi_status_t efi_add_memory_map(u64 start, u64 size, int memory_type)
  * Return:		status code
  */
 static efi_status_t efi_check_allocated(u64 addr, bool must_be_allocated)
+{
+	struct efi_mem_list *item = efi_mem_find(addr);
+
+	if (item && (must_be_allocated ^
+		     (item->desc.type == EFI_CONVENTIONAL_MEMORY)))
+		return EFI_SUCCESS;
+
+	return EFI_NOT_FOUND;
+}
+
+/**
+ * efi_find_free_in() - find free memory in a subtree of the memory map
+ *
+ * Subtrees without a large enough EFI_CONVENTIONAL_MEMORY entry are skipped
+ * and higher addresses are searched first.
+ *
+ * @rb:		root of the subtree
+ * @len:	number of bytes needed
+ * @max_addr:	page aligned upper limit of the allocation
+ * Return:	highest suitable address or 0 if none was found
+ */
+static uint64_t efi_find_free_in(struct rb_node *rb, uint64_t len,
+				 uint64_t max_addr)
 {
 	struct efi_mem_list *item;
+	struct efi_mem_desc *desc;
+	uint64_t desc_end, curmax, ret;
 
-	list_for_each_entry(item, &efi_mem, link) {
-		u64 start = item->desc.physical_start;
-		u64 end = start + (item->desc.num_pages << EFI_PAGE_SHIFT);
+	if (!rb)
+		return 0;
 
-		if (addr >= start && addr < end) {
-			if (must_be_allocated ^
-			    (item->desc.type == EFI_CONVENTIONAL_MEMORY))
-				return EFI_SUCCESS;
-			else
-				return EFI_NOT_FOUND;
-		}
+	item = rb_entry(rb, struct efi_mem_list, node);
+	desc = &item->desc;
+	if (item->max_free_pages < (len >> EFI_PAGE_SHIFT))
+		return 0;
+
+	/* Entries to the right start above this one */
+	if (desc->physical_start < max_addr) {
+		ret = efi_find_free_in(rb->rb_right, len, max_addr);
+		if (ret)
+			return ret;
 	}
 
-	return EFI_NOT_FOUND;
+	/* We only take memory from free RAM */
+	if (desc->type == EFI_CONVENTIONAL_MEMORY) {
+		desc_end = desc_get_end(desc);
+		curmax = min(max_addr, desc_end);
+		ret = curmax - len;
+
+		/* Return the highest address in this map within bounds */
+		if (curmax >= len && ret >= desc->physical_start)
+			return ret;
+	}
+
+	return efi_find_free_in(rb->rb_left, len, max_addr);
 }
 
 static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
 {
-	struct list_head *lhandle;
-
 	/*
 	 * Prealign input max address, so we simplify our matching
 	 * logic below and can just reuse it as return pointer.
 	 */
 	max_addr &= ~EFI_PAGE_MASK;
 
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem = list_entry(lhandle,
-			struct efi_mem_list, link);
-		struct efi_mem_desc *desc = &lmem->desc;
-		uint64_t desc_len = desc->num_pages << EFI_PAGE_SHIFT;
-		uint64_t desc_end = desc->physical_start + desc_len;
-		uint64_t curmax = min(max_addr, desc_end);
-		uint64_t ret = curmax - len;
-
-		/* We only take memory from free RAM */
-		if (desc->type != EFI_CONVENTIONAL_MEMORY)
-			continue;
-
-		/* Out of bounds for max_addr */
-		if ((ret + len) > max_addr)
-			continue;
-
-		/* Out of bounds for upper map limit */
-		if ((ret + len) > desc_end)
-			continue;
-
-		/* Out of bounds for lower map limit */
-		if (ret < desc->physical_start)
-			continue;
-
-		/* Return the highest address in this map within bounds */
-		return ret;
-	}
-
-	return 0;
+	return efi_find_free_in(efi_mem.rb_node, len, max_addr);
 }
 
 /*
@@ -689,8 +811,7 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 				uint32_t *descriptor_version)
 {
 	efi_uintn_t map_size = 0;
-	int map_entries = 0;
-	struct list_head *lhandle;
+	struct rb_node *rb;
 	efi_uintn_t provided_map_size;
 
 	if (!memory_map_size)
@@ -698,10 +819,7 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 
 	provided_map_size = *memory_map_size;
 
-	list_for_each(lhandle, &efi_mem)
-		map_entries++;
-
-	map_size = map_entries * sizeof(struct efi_mem_desc);
+	map_size = efi_mem_entries * sizeof(struct efi_mem_desc);
 
 	*memory_map_size = map_size;
 
@@ -717,15 +835,12 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 	if (!memory_map)
 		return EFI_INVALID_PARAMETER;
 
-	/* Copy list into array */
-	/* Return the list in ascending order */
-	memory_map = &memory_map[map_entries - 1];
-	list_for_each(lhandle, &efi_mem) {
+	/* Copy tree into array, in ascending order */
+	for (rb = rb_first(&efi_mem); rb; rb = rb_next(rb)) {
 		struct efi_mem_list *lmem;
 
-		lmem = list_entry(lhandle, struct efi_mem_list, link);
-		*memory_map = lmem->desc;
-		memory_map--;
+		lmem = rb_entry(rb, struct efi_mem_list, node);
+		*memory_map++ = lmem->desc;
 	}
 
 	if (map_key)
@@ -824,6 +939,20 @@ static void add_u_boot_and_runtime(void)
 	efi_add_memory_map_pg(uboot_start, uboot_pages, EFI_LOADER_DATA,
 			      false);
 
+#ifdef CONFIG_RELOC_IN_PLACE
+	/*
+	 * When U-Boot runs where it was loaded, its code, data and BSS are not
+	 * in the area above, so keep them away from EFI allocations too
+	 */
+	if (gd->relocaddr == (ulong)__image_copy_start) {
+		uboot_start = (uintptr_t)__image_copy_start & ~EFI_PAGE_MASK;
+		uboot_pages = ((uintptr_t)__image_copy_start + gd->mon_len -
+			       uboot_start + EFI_PAGE_MASK) >> EFI_PAGE_SHIFT;
+		efi_add_memory_map_pg(uboot_start, uboot_pages,
+				      EFI_BOOT_SERVICES_CODE, false);
+	}
+#endif
+
 #if defined(__aarch64__)
 	/*
 	 * Runtime Services must be 64KiB aligned according to the
@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * efi_selftest_memory_churn
+ *
+ * This unit test stresses the memory map with many interleaved page
+ * allocations and frees and reports the time spent.
+ *
+ * After the churn the memory map must be sorted, free of overlaps, have all
+ * adjacent entries of the same kind merged, and be of the same size as
+ * before the test.
+ */
+
+#include <efi_selftest.h>
+#include <time.h>
+
+#define EFI_ST_CHURN_COUNT 1024
+#define EFI_ST_CHURN_ROUNDS 4
+
+static struct efi_boot_services *boottime;
+static u64 addr[EFI_ST_CHURN_COUNT];
+
+/**
+ * setup() - setup unit test
+ *
+ * @handle:	handle of the loaded image
+ * @systable:	system table
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int setup(const efi_handle_t handle,
+		 const struct efi_system_table *systable)
+{
+	boottime = systable->boottime;
+
+	return EFI_ST_SUCCESS;
+}
+
+/**
+ * num_pages() - number of pages used for an allocation
+ *
+ * @i:		index of the allocation
+ * Return:	number of pages
+ */
+static efi_uintn_t num_pages(int i)
+{
+	return 1 + (i % 3);
+}
+
+/**
+ * memory_type() - memory type used for an allocation
+ *
+ * Alternating memory types keep neighbouring allocations from being merged.
+ *
+ * @i:		index of the allocation
+ * Return:	memory type
+ */
+static enum efi_memory_type memory_type(int i)
+{
+	return (i & 1) ? EFI_LOADER_DATA : EFI_BOOT_SERVICES_DATA;
+}
+
+/**
+ * check_memory_map() - check consistency of the memory map
+ *
+ * @entries:	on return number of memory map entries
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int check_memory_map(efi_uintn_t *entries)
+{
+	efi_uintn_t map_size = 0;
+	efi_uintn_t map_key;
+	efi_uintn_t desc_size;
+	u32 desc_version;
+	struct efi_mem_desc *memory_map, *prev = NULL;
+	efi_uintn_t i;
+	efi_status_t ret;
+	int r = EFI_ST_SUCCESS;
+
+	ret = boottime->get_memory_map(&map_size, NULL, &map_key, &desc_size,
+				       &desc_version);
+	if (ret != EFI_BUFFER_TOO_SMALL) {
+		efi_st_error("GetMemoryMap did not return EFI_BUFFER_TOO_SMALL\n");
+		return EFI_ST_FAILURE;
+	}
+	/* Allocate extra space for newly allocated memory */
+	map_size += sizeof(struct efi_mem_desc);
+	ret = boottime->allocate_pool(EFI_BOOT_SERVICES_DATA, map_size,
+				      (void **)&memory_map);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("AllocatePool did not return EFI_SUCCESS\n");
+		return EFI_ST_FAILURE;
+	}
+	ret = boottime->get_memory_map(&map_size, memory_map, &map_key,
+				       &desc_size, &desc_version);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("GetMemoryMap did not return EFI_SUCCESS\n");
+		r = EFI_ST_FAILURE;
+		goto out;
+	}
+
+	*entries = map_size / desc_size;
+	for (i = 0; i < *entries; ++i) {
+		struct efi_mem_desc *entry = (void *)memory_map + i * desc_size;
+
+		if (!entry->num_pages) {
+			efi_st_error("Empty memory map entry\n");
+			r = EFI_ST_FAILURE;
+			break;
+		}
+		if (prev) {
+			u64 prev_end = prev->physical_start +
+				       (prev->num_pages << EFI_PAGE_SHIFT);
+
+			if (prev_end > entry->physical_start) {
+				efi_st_error("Memory map not sorted or overlapping\n");
+				r = EFI_ST_FAILURE;
+				break;
+			}
+			if (prev_end == entry->physical_start &&
+			    prev->type == entry->type &&
+			    prev->attribute == entry->attribute) {
+				efi_st_error("Memory map entries not merged\n");
+				r = EFI_ST_FAILURE;
+				break;
+			}
+		}
+		prev = entry;
+	}
+out:
+	ret = boottime->free_pool(memory_map);
+	if (ret != EFI_SUCCESS) {
+		efi_st_error("FreePool did not return EFI_SUCCESS\n");
+		return EFI_ST_FAILURE;
+	}
+
+	return r;
+}
+
+/**
+ * allocate() - allocate pages for a range of allocations
+ *
+ * @first:	first allocation
+ * @step:	increment between allocations
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int allocate(int first, int step)
+{
+	efi_status_t ret;
+	int i;
+
+	for (i = first; i < EFI_ST_CHURN_COUNT; i += step) {
+		ret = boottime->allocate_pages(EFI_ALLOCATE_ANY_PAGES,
+					       memory_type(i), num_pages(i),
+					       &addr[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("AllocatePages did not return EFI_SUCCESS\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+/**
+ * release() - free pages for a range of allocations
+ *
+ * @first:	first allocation
+ * @step:	increment between allocations
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int release(int first, int step)
+{
+	efi_status_t ret;
+	int i;
+
+	for (i = first; i < EFI_ST_CHURN_COUNT; i += step) {
+		ret = boottime->free_pages(addr[i], num_pages(i));
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("FreePages did not return EFI_SUCCESS\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+
+	return EFI_ST_SUCCESS;
+}
+
+/**
+ * execute() - execute unit test
+ *
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int execute(void)
+{
+	efi_uintn_t entries_before, entries_during, entries_after;
+	unsigned long start, duration;
+	unsigned int ops = 0;
+	int round;
+
+	if (check_memory_map(&entries_before) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+
+	start = timer_get_us();
+	for (round = 0; round < EFI_ST_CHURN_ROUNDS; ++round) {
+		/* Fill the map, punch holes into it and fill them again */
+		if (allocate(0, 1) != EFI_ST_SUCCESS ||
+		    release(round & 1, 2) != EFI_ST_SUCCESS ||
+		    allocate(round & 1, 2) != EFI_ST_SUCCESS)
+			return EFI_ST_FAILURE;
+		if (!round &&
+		    check_memory_map(&entries_during) != EFI_ST_SUCCESS)
+			return EFI_ST_FAILURE;
+		if (release(0, 1) != EFI_ST_SUCCESS)
+			return EFI_ST_FAILURE;
+		ops += 3 * EFI_ST_CHURN_COUNT;
+	}
+	duration = timer_get_us() - start;
+
+	if (check_memory_map(&entries_after) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+	if (entries_after != entries_before) {
+		efi_st_error("Memory map has %u entries, expected %u\n",
+			     (unsigned int)entries_after,
+			     (unsigned int)entries_before);
+		return EFI_ST_FAILURE;
+	}
+
+	efi_st_printf("%u allocate/free operations with up to %u map entries in %u us\n",
+		      ops, (unsigned int)entries_during,
+		      (unsigned int)duration);
+
+	return EFI_ST_SUCCESS;
+}
+
+EFI_UNIT_TEST(memchurn) = {
+	.name = "memory map churn",
+	.phase = EFI_EXECUTE_BEFORE_BOOTTIME_EXIT,
+	.setup = setup,
+	.execute = execute,
+};
@@ -58,7 +58,9 @@ static lbaint_t write_sparse_chunk_raw(struct sparse_storage *info,
 	lbaint_t n = blkcnt, write_blks, blks = 0, aligned_buf_blks = 100;
 	uint32_t *aligned_buf = NULL;
 
-	if (CONFIG_IS_ENABLED(SYS_DCACHE_OFF)) {
+	/* Write straight from the image if the data is suitable for DMA */
+	if (CONFIG_IS_ENABLED(SYS_DCACHE_OFF) ||
+	    IS_ALIGNED((ulong)data, ARCH_DMA_MINALIGN)) {
 		write_blks = info->write(info, blk, n, data);
 		if (write_blks < n)
 			goto write_fail;
@@ -106,26 +108,153 @@ write_fail:
 	return -1;
 }
 
+static int check_sparse_header(struct sparse_storage *info,
+			       sparse_header_t *sparse_header, char *response)
+{
+	unsigned int offset;
+
+	/*
+	 * Verify that the sparse block size is a multiple of our
+	 * storage backend block size
+	 */
+	div_u64_rem(sparse_header->blk_sz, info->blksz, &offset);
+	if (offset) {
+		printf("%s: Sparse image block size issue [%u]\n",
+		       __func__, sparse_header->blk_sz);
+		info->mssg("sparse image block size issue", response);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Discard the erase groups which lie entirely within @blkcnt blocks at @blk
+ * and inside the partition. Returns the number of blocks discarded and sets
+ * @head to the number of blocks in front of them; nothing is discarded if
+ * the storage cannot erase or the erase fails.
+ */
+static lbaint_t sparse_discard(struct sparse_storage *info, lbaint_t blk,
+			       lbaint_t blkcnt, lbaint_t *head)
+{
+	lbaint_t grp = info->erase_grp;
+	lbaint_t first, last, blks;
+
+	*head = 0;
+	if (!info->erase || !grp)
+		return 0;
+
+	last = min(blk + blkcnt, info->start + info->size);
+	first = DIV_ROUND_UP_ULL(blk, grp) * grp;
+	last = lldiv(last, grp) * grp;
+	if (last <= first)
+		return 0;
+
+	blks = info->erase(info, first, last - first);
+	if (blks != last - first) {
+		debug("%s: Erase failed, block #" LBAFU " [" LBAFU "]\n",
+		      __func__, first, last - first);
+		return 0;
+	}
+	*head = first - blk;
+
+	return blks;
+}
+
+static lbaint_t write_sparse_fill(struct sparse_storage *info,
+				  lbaint_t blk, lbaint_t blkcnt,
+				  uint32_t fill_val, char *response)
+{
+	lbaint_t blks, start = blk;
+	uint32_t *fill_buf;
+	size_t fill_buf_size, len, n;
+	int fill_buf_num_blks;
+	int i;
+	int j;
+
+	if (!blkcnt)
+		return 0;
+
+	fill_buf_num_blks = CONFIG_IMAGE_SPARSE_FILLBUF_SIZE / info->blksz;
+	if (fill_buf_num_blks > blkcnt)
+		fill_buf_num_blks = blkcnt;
+	fill_buf_size = info->blksz * fill_buf_num_blks;
+	fill_buf = (uint32_t *)
+		   memalign(ARCH_DMA_MINALIGN,
+			    ROUNDUP(fill_buf_size, ARCH_DMA_MINALIGN));
+	if (!fill_buf) {
+		info->mssg("Malloc failed for: CHUNK_TYPE_FILL", response);
+		return -ENOMEM;
+	}
+
+	/* Fill one block, then keep doubling it until the buffer is full */
+	for (i = 0; i < info->blksz / sizeof(fill_val); i++)
+		fill_buf[i] = fill_val;
+	for (len = info->blksz; len < fill_buf_size; len += n) {
+		n = min(len, fill_buf_size - len);
+		memcpy((void *)fill_buf + len, fill_buf, n);
+	}
+
+	for (i = 0; i < blkcnt;) {
+		j = blkcnt - i;
+		if (j > fill_buf_num_blks)
+			j = fill_buf_num_blks;
+		blks = info->write(info, blk, j, fill_buf);
+		/* blks might be > j (eg. NAND bad-blocks) */
+		if (blks < j) {
+			printf("%s: %s " LBAFU " [%d]\n", __func__,
+			       "Write failed, block #", blk, j);
+			info->mssg("flash write failure", response);
+			free(fill_buf);
+			return -1;
+		}
+		blk += blks;
+		i += j;
+	}
+
+	free(fill_buf);
+	return blk - start;
+}
+
+static lbaint_t write_sparse_chunk_fill(struct sparse_storage *info,
+					lbaint_t blk, lbaint_t blkcnt,
+					uint32_t fill_val, char *response)
+{
+	lbaint_t head, erased = 0, blks, tail;
+
+	/* Erase rather than write zeroes where the storage allows it */
+	if (!fill_val && info->erase_zero)
+		erased = sparse_discard(info, blk, blkcnt, &head);
+	if (!erased)
+		return write_sparse_fill(info, blk, blkcnt, fill_val, response);
+
+	blks = write_sparse_fill(info, blk, head, fill_val, response);
+	if (IS_ERR_VALUE(blks))
+		return -1;
+	blks += erased;
+
+	tail = write_sparse_fill(info, blk + blks, blkcnt - head - erased,
+				 fill_val, response);
+	if (IS_ERR_VALUE(tail))
+		return -1;
+
+	return blks + tail;
+}
+
 int write_sparse_image(struct sparse_storage *info,
 		       const char *part_name, void *data, char *response)
 {
 	lbaint_t blk;
 	lbaint_t blkcnt;
 	lbaint_t blks;
+	lbaint_t head;
 	uint64_t bytes_written = 0;
 	unsigned int chunk;
-	unsigned int offset;
 	uint64_t chunk_data_sz;
-	uint32_t *fill_buf = NULL;
 	uint32_t fill_val;
 	sparse_header_t *sparse_header;
 	chunk_header_t *chunk_header;
 	uint32_t total_blocks = 0;
-	int fill_buf_num_blks;
-	int i;
-	int j;
-
-	fill_buf_num_blks = CONFIG_IMAGE_SPARSE_FILLBUF_SIZE / info->blksz;
 
 	/* Read and skip over sparse image header */
 	sparse_header = (sparse_header_t *)data;
@@ -152,17 +281,8 @@ int write_sparse_image(struct sparse_storage *info,
 	debug("total_blks: %d\n", sparse_header->total_blks);
 	debug("total_chunks: %d\n", sparse_header->total_chunks);
 
-	/*
-	 * Verify that the sparse block size is a multiple of our
-	 * storage backend block size
-	 */
-	div_u64_rem(sparse_header->blk_sz, info->blksz, &offset);
-	if (offset) {
-		printf("%s: Sparse image block size issue [%u]\n",
-		       __func__, sparse_header->blk_sz);
-		info->mssg("sparse image block size issue", response);
+	if (check_sparse_header(info, sparse_header, response))
 		return -1;
-	}
 
 	puts("Flashing Sparse Image\n");
 
@@ -211,7 +331,7 @@ int write_sparse_image(struct sparse_storage *info,
 
 			blks = write_sparse_chunk_raw(info, blk, blkcnt,
 						      data, response);
-			if (blks < 0)
+			if (IS_ERR_VALUE(blks))
 				return -1;
 
 			blk += blks;
@@ -227,26 +347,9 @@ int write_sparse_image(struct sparse_storage *info,
 				return -1;
 			}
 
-			fill_buf = (uint32_t *)
-				   memalign(ARCH_DMA_MINALIGN,
-					    ROUNDUP(
-						info->blksz * fill_buf_num_blks,
-						ARCH_DMA_MINALIGN));
-			if (!fill_buf) {
-				info->mssg("Malloc failed for: CHUNK_TYPE_FILL",
-					   response);
-				return -1;
-			}
-
 			fill_val = *(uint32_t *)data;
 			data = (char *)data + sizeof(uint32_t);
 
-			for (i = 0;
-			     i < (info->blksz * fill_buf_num_blks /
-				  sizeof(fill_val));
-			     i++)
-				fill_buf[i] = fill_val;
-
 			if (blk + blkcnt > info->start + info->size) {
 				printf(
 				    "%s: Request would exceed partition size!\n",
@@ -256,32 +359,19 @@ int write_sparse_image(struct sparse_storage *info,
 				return -1;
 			}
 
-			for (i = 0; i < blkcnt;) {
-				j = blkcnt - i;
-				if (j > fill_buf_num_blks)
-					j = fill_buf_num_blks;
-				blks = info->write(info, blk, j, fill_buf);
-				/* blks might be > j (eg. NAND bad-blocks) */
-				if (blks < j) {
-					printf("%s: %s " LBAFU " [%d]\n",
-					       __func__,
-					       "Write failed, block #",
-					       blk, j);
-					info->mssg("flash write failure",
-						   response);
-					free(fill_buf);
-					return -1;
-				}
-				blk += blks;
-				i += j;
-			}
+			blks = write_sparse_chunk_fill(info, blk, blkcnt,
+						       fill_val, response);
+			if (IS_ERR_VALUE(blks))
+				return -1;
+
+			blk += blks;
 			bytes_written += ((u64)blkcnt) * info->blksz;
 			total_blocks += DIV_ROUND_UP_ULL(chunk_data_sz,
 							 sparse_header->blk_sz);
-			free(fill_buf);
 			break;
 
 		case CHUNK_TYPE_DONT_CARE:
+			sparse_discard(info, blk, blkcnt, &head);
 			blk += info->reserve(info, blk, blkcnt);
 			total_blocks += chunk_header->chunk_sz;
 			break;
@@ -316,3 +406,367 @@ int write_sparse_image(struct sparse_storage *info,
 
 	return 0;
 }
+
+enum {
+	SPARSE_STREAM_DETECT,		/* collecting the sparse header */
+	SPARSE_STREAM_CHUNK_HDR,	/* collecting a chunk header */
+	SPARSE_STREAM_FILL,		/* collecting the value of a FILL chunk */
+	SPARSE_STREAM_DATA,		/* writing RAW chunk or raw image data */
+	SPARSE_STREAM_DONE,
+	SPARSE_STREAM_ERROR,
+};
+
+/*
+ * Collect header bytes into ss->hdr until @want bytes are present. Returns
+ * the number of bytes consumed from @data.
+ */
+static size_t sparse_stream_collect(struct sparse_stream *ss, const void *data,
+				    size_t len, unsigned int want)
+{
+	size_t n = min_t(size_t, len, want - ss->hdr_len);
+
+	memcpy(ss->hdr + ss->hdr_len, data, n);
+	ss->hdr_len += n;
+
+	return n;
+}
+
+static int sparse_stream_data(struct sparse_stream *ss, const void *data,
+			      size_t len, char *response)
+{
+	struct sparse_storage *info = ss->info;
+	lbaint_t blkcnt, blks;
+	size_t n;
+
+	/* Complete a block which was split between two buffers */
+	if (ss->blkbuf_len) {
+		n = min_t(size_t, len, info->blksz - ss->blkbuf_len);
+		memcpy(ss->blkbuf + ss->blkbuf_len, data, n);
+		ss->blkbuf_len += n;
+		data += n;
+		len -= n;
+		if (ss->blkbuf_len < info->blksz)
+			return 0;
+
+		blks = write_sparse_chunk_raw(info, ss->blk, 1, ss->blkbuf,
+					      response);
+		if (IS_ERR_VALUE(blks))
+			return -1;
+		ss->blk += blks;
+		ss->blkbuf_len = 0;
+	}
+
+	blkcnt = len / info->blksz;
+	if (blkcnt) {
+		blks = write_sparse_chunk_raw(info, ss->blk, blkcnt,
+					      (void *)data, response);
+		if (IS_ERR_VALUE(blks))
+			return -1;
+		ss->blk += blks;
+		data += blkcnt * info->blksz;
+		len -= blkcnt * info->blksz;
+	}
+
+	memcpy(ss->blkbuf, data, len);
+	ss->blkbuf_len = len;
+
+	return 0;
+}
+
+static int sparse_stream_start(struct sparse_stream *ss, char *response)
+{
+	struct sparse_storage *info = ss->info;
+	sparse_header_t *sparse_header = &ss->header;
+	lbaint_t blkcnt;
+
+	if (ss->hdr_len == sizeof(*sparse_header) && is_sparse_image(ss->hdr)) {
+		memcpy(sparse_header, ss->hdr, sizeof(*sparse_header));
+		if (sparse_header->file_hdr_sz < sizeof(*sparse_header) ||
+		    sparse_header->chunk_hdr_sz < sizeof(chunk_header_t)) {
+			info->mssg("Bogus sparse image header", response);
+			return -1;
+		}
+		if (check_sparse_header(info, sparse_header, response))
+			return -1;
+
+		puts("Flashing Sparse Image\n");
+		ss->sparse = true;
+		ss->skip = sparse_header->file_hdr_sz - sizeof(*sparse_header);
+		ss->hdr_len = 0;
+		ss->state = SPARSE_STREAM_CHUNK_HDR;
+
+		return 0;
+	}
+
+	blkcnt = DIV_ROUND_UP_ULL(ss->size, info->blksz);
+	if (blkcnt > info->size) {
+		printf("%s: too large for partition: '%s'\n", __func__,
+		       ss->part_name);
+		info->mssg("too large for partition", response);
+		return -1;
+	}
+
+	puts("Flashing Raw Image\n");
+	ss->data_left = ss->size;
+	ss->state = SPARSE_STREAM_DATA;
+
+	/* The bytes collected so far are image data */
+	ss->data_left -= ss->hdr_len;
+	if (!ss->data_left)
+		ss->state = SPARSE_STREAM_DONE;
+
+	return sparse_stream_data(ss, ss->hdr, ss->hdr_len, response);
+}
+
+static int sparse_stream_chunk(struct sparse_stream *ss, char *response)
+{
+	struct sparse_storage *info = ss->info;
+	sparse_header_t *sparse_header = &ss->header;
+	chunk_header_t *chunk_header = &ss->chunk;
+	uint64_t chunk_data_sz;
+	lbaint_t blkcnt, head;
+
+	memcpy(chunk_header, ss->hdr, sizeof(*chunk_header));
+	ss->hdr_len = 0;
+	ss->skip = sparse_header->chunk_hdr_sz - sizeof(*chunk_header);
+	ss->chunk_index++;
+
+	if (chunk_header->chunk_type != CHUNK_TYPE_RAW) {
+		debug("=== Chunk Header ===\n");
+		debug("chunk_type: 0x%x\n", chunk_header->chunk_type);
+		debug("chunk_data_sz: 0x%x\n", chunk_header->chunk_sz);
+		debug("total_size: 0x%x\n", chunk_header->total_sz);
+	}
+
+	if (chunk_header->total_sz < sparse_header->chunk_hdr_sz) {
+		info->mssg("Bogus chunk size", response);
+		return -1;
+	}
+
+	chunk_data_sz = ((u64)sparse_header->blk_sz) * chunk_header->chunk_sz;
+	blkcnt = DIV_ROUND_UP_ULL(chunk_data_sz, info->blksz);
+	if (chunk_header->chunk_type != CHUNK_TYPE_CRC32 &&
+	    ss->blk + blkcnt > info->start + info->size) {
+		printf("%s: Request would exceed partition size!\n", __func__);
+		info->mssg("Request would exceed partition size!", response);
+		return -1;
+	}
+
+	switch (chunk_header->chunk_type) {
+	case CHUNK_TYPE_RAW:
+		if (chunk_header->total_sz !=
+		    (sparse_header->chunk_hdr_sz + chunk_data_sz)) {
+			info->mssg("Bogus chunk size for chunk type Raw",
+				   response);
+			return -1;
+		}
+		ss->data_left = chunk_data_sz;
+		ss->bytes_written += ((u64)blkcnt) * info->blksz;
+		ss->total_blocks += chunk_header->chunk_sz;
+		ss->state = chunk_data_sz ? SPARSE_STREAM_DATA :
+			    SPARSE_STREAM_CHUNK_HDR;
+		break;
+
+	case CHUNK_TYPE_FILL:
+		if (chunk_header->total_sz !=
+		    (sparse_header->chunk_hdr_sz + sizeof(uint32_t))) {
+			info->mssg("Bogus chunk size for chunk type FILL",
+				   response);
+			return -1;
+		}
+		ss->state = SPARSE_STREAM_FILL;
+		break;
+
+	case CHUNK_TYPE_DONT_CARE:
+		sparse_discard(info, ss->blk, blkcnt, &head);
+		ss->blk += info->reserve(info, ss->blk, blkcnt);
+		ss->total_blocks += chunk_header->chunk_sz;
+		ss->skip += chunk_header->total_sz - sparse_header->chunk_hdr_sz;
+		break;
+
+	case CHUNK_TYPE_CRC32:
+		ss->total_blocks += chunk_header->chunk_sz;
+		ss->skip += chunk_header->total_sz - sparse_header->chunk_hdr_sz;
+		break;
+
+	default:
+		printf("%s: Unknown chunk type: %x\n", __func__,
+		       chunk_header->chunk_type);
+		info->mssg("Unknown chunk type", response);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int sparse_stream_fill(struct sparse_stream *ss, char *response)
+{
+	struct sparse_storage *info = ss->info;
+	uint64_t chunk_data_sz;
+	lbaint_t blkcnt, blks;
+	uint32_t fill_val;
+
+	memcpy(&fill_val, ss->hdr, sizeof(fill_val));
+	ss->hdr_len = 0;
+
+	chunk_data_sz = ((u64)ss->header.blk_sz) * ss->chunk.chunk_sz;
+	blkcnt = DIV_ROUND_UP_ULL(chunk_data_sz, info->blksz);
+	blks = write_sparse_chunk_fill(info, ss->blk, blkcnt, fill_val,
+				       response);
+	if (IS_ERR_VALUE(blks))
+		return -1;
+
+	ss->blk += blks;
+	ss->bytes_written += ((u64)blkcnt) * info->blksz;
+	ss->total_blocks += DIV_ROUND_UP_ULL(chunk_data_sz, ss->header.blk_sz);
+	ss->state = SPARSE_STREAM_CHUNK_HDR;
+
+	return 0;
+}
+
+int sparse_stream_init(struct sparse_stream *ss, struct sparse_storage *info,
+		       const char *part_name, u64 size, char *response)
+{
+	memset(ss, '\0', sizeof(*ss));
+	if (!info->mssg)
+		info->mssg = default_log;
+
+	ss->info = info;
+	ss->part_name = part_name;
+	ss->size = size;
+	ss->blk = info->start;
+	ss->blkbuf = memalign(ARCH_DMA_MINALIGN,
+			      ROUNDUP(info->blksz, ARCH_DMA_MINALIGN));
+	if (!ss->blkbuf) {
+		info->mssg("Malloc failed for sparse stream", response);
+		ss->state = SPARSE_STREAM_ERROR;
+		return -ENOMEM;
+	}
+	ss->state = SPARSE_STREAM_DETECT;
+
+	return 0;
+}
+
+int sparse_stream_write(struct sparse_stream *ss, const void *data,
+			size_t len, char *response)
+{
+	size_t n;
+	int ret = 0;
+
+	while (len && !ret) {
+		if (ss->skip) {
+			n = min_t(size_t, len, ss->skip);
+			ss->skip -= n;
+			data += n;
+			len -= n;
+			continue;
+		}
+
+		switch (ss->state) {
+		case SPARSE_STREAM_DETECT:
+			n = sparse_stream_collect(ss, data, len,
+						  min_t(u64, ss->size,
+							sizeof(sparse_header_t)));
+			data += n;
+			len -= n;
+			if (ss->hdr_len == min_t(u64, ss->size,
+						 sizeof(sparse_header_t)))
+				ret = sparse_stream_start(ss, response);
+			break;
+		case SPARSE_STREAM_CHUNK_HDR:
+			if (ss->chunk_index == ss->header.total_chunks) {
+				/* Ignore anything after the last chunk */
+				ss->state = SPARSE_STREAM_DONE;
+				break;
+			}
+			n = sparse_stream_collect(ss, data, len,
+						  sizeof(chunk_header_t));
+			data += n;
+			len -= n;
+			if (ss->hdr_len == sizeof(chunk_header_t))
+				ret = sparse_stream_chunk(ss, response);
+			break;
+		case SPARSE_STREAM_FILL:
+			n = sparse_stream_collect(ss, data, len,
+						  sizeof(uint32_t));
+			data += n;
+			len -= n;
+			if (ss->hdr_len == sizeof(uint32_t))
+				ret = sparse_stream_fill(ss, response);
+			break;
+		case SPARSE_STREAM_DATA:
+			n = min_t(u64, len, ss->data_left);
+			ret = sparse_stream_data(ss, data, n, response);
+			ss->data_left -= n;
+			data += n;
+			len -= n;
+			if (!ss->data_left)
+				ss->state = ss->sparse ?
+					SPARSE_STREAM_CHUNK_HDR :
+					SPARSE_STREAM_DONE;
+			break;
+		case SPARSE_STREAM_DONE:
+			len = 0;
+			break;
+		default:
+			return -1;
+		}
+	}
+	if (ret)
+		ss->state = SPARSE_STREAM_ERROR;
+
+	return ret;
+}
+
+int sparse_stream_finish(struct sparse_stream *ss, char *response)
+{
+	struct sparse_storage *info = ss->info;
+	lbaint_t blks;
+	int ret = -1;
+
+	if (ss->state == SPARSE_STREAM_ERROR)
+		goto out;
+
+	if (!ss->sparse) {
+		if (ss->state != SPARSE_STREAM_DONE) {
+			info->mssg("incomplete image", response);
+			goto out;
+		}
+
+		/* Pad the final partial block */
+		if (ss->blkbuf_len) {
+			memset(ss->blkbuf + ss->blkbuf_len, '\0',
+			       info->blksz - ss->blkbuf_len);
+			blks = write_sparse_chunk_raw(info, ss->blk, 1,
+						      ss->blkbuf, response);
+			if (IS_ERR_VALUE(blks))
+				goto out;
+			ss->blk += blks;
+		}
+		ss->bytes_written = ROUNDUP(ss->size, info->blksz);
+	} else {
+		if (ss->chunk_index != ss->header.total_chunks ||
+		    (ss->state != SPARSE_STREAM_CHUNK_HDR &&
+		     ss->state != SPARSE_STREAM_DONE)) {
+			info->mssg("incomplete sparse image", response);
+			goto out;
+		}
+
+		debug("Wrote %d blocks, expected to write %d blocks\n",
+		      ss->total_blocks, ss->header.total_blks);
+		if (ss->total_blocks != ss->header.total_blks) {
+			info->mssg("sparse image write failure", response);
+			goto out;
+		}
+	}
+
+	printf("........ wrote %llu bytes to '%s'\n", ss->bytes_written,
+	       ss->part_name);
+	ret = 0;
+out:
+	free(ss->blkbuf);
+	ss->blkbuf = NULL;
+	ss->state = ret ? SPARSE_STREAM_ERROR : SPARSE_STREAM_DONE;
+
+	return ret;
+}
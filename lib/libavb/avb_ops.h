@@ -135,6 +135,22 @@ struct AvbOps {
                                          uint8_t** out_pointer,
                                          size_t* out_num_bytes_preloaded);
 
+  /* Gets a buffer of |num_bytes| to read partition |partition| into, and
+   * saves it to |out_pointer|. Unlike with |get_preloaded_partition| the
+   * partition is not loaded yet: |read_from_partition| reads it into the
+   * buffer piece by piece, so that it can be hashed as it arrives.
+   *
+   * When this function pointer is not set (has value NULL), or when
+   * |out_pointer| is set to NULL as a result, a temporary buffer is used.
+   *
+   * The buffer must outlive the lifespan of the |AvbSlotVerifyData|
+   * structure that |avb_slot_verify| outputs, like preloaded partition data.
+   */
+  AvbIOResult (*get_preload_buffer)(AvbOps* ops,
+                                    const char* partition,
+                                    size_t num_bytes,
+                                    uint8_t** out_pointer);
+
   /* Writes |num_bytes| from |bffer| at offset |offset| to partition
    * with name |partition| (NUL-terminated UTF-8 string). If |offset|
    * is negative, its absolute value should be interpreted as the
@@ -57,12 +57,52 @@ static inline bool result_should_continue(AvbSlotVerifyResult result) {
   return false;
 }
 
+/* Amount of a partition read at a time by load_full_partition(). Each piece
+ * is hashed right after it has been read, while it is still in the cache.
+ */
+#define LOAD_CHUNK_SIZE (1024 * 1024)
+
+/* Digest which load_full_partition() updates as the partition is read. */
+typedef struct {
+  /* Exactly one of these is set. */
+  AvbSHA256Ctx* sha256_ctx;
+  AvbSHA512Ctx* sha512_ctx;
+  /* Number of bytes at the start of the partition to hash. */
+  uint64_t size;
+} LoadHash;
+
+/* Adds |len| bytes of |data|, which is at |offset| in the partition, to
+ * |hash|. Anything past |hash->size| is left out.
+ */
+static void load_hash_update(LoadHash* hash,
+                             const uint8_t* data,
+                             uint64_t offset,
+                             size_t len) {
+  if (offset >= hash->size) {
+    return;
+  }
+  if (len > hash->size - offset) {
+    len = hash->size - offset;
+  }
+  if (hash->sha256_ctx != NULL) {
+    avb_sha256_update(hash->sha256_ctx, data, len);
+  } else {
+    avb_sha512_update(hash->sha512_ctx, data, len);
+  }
+}
+
+/* Loads |image_size| bytes of |part_name| into memory. If |hash| is not NULL
+ * the data is added to it as it is read.
+ */
 static AvbSlotVerifyResult load_full_partition(AvbOps* ops,
                                                const char* part_name,
                                                uint64_t image_size,
+                                               LoadHash* hash,
                                                uint8_t** out_image_buf,
                                                bool* out_image_preloaded) {
   size_t part_num_read;
+  size_t offset;
+  size_t chunk;
   AvbIOResult io_ret;
 
   /* Make sure that we do not overwrite existing data. */
@@ -93,21 +133,44 @@ static AvbSlotVerifyResult load_full_partition(AvbOps* ops,
         return AVB_SLOT_VERIFY_RESULT_ERROR_IO;
       }
       *out_image_preloaded = true;
+      if (hash != NULL) {
+        load_hash_update(hash, *out_image_buf, 0, image_size);
+      }
+      return AVB_SLOT_VERIFY_RESULT_OK;
     }
   }
 
-  /* Allocate and copy the partition. */
-  if (!*out_image_preloaded) {
+  /* Read into a buffer which outlives |AvbSlotVerifyData| if there is one. */
+  if (ops->get_preload_buffer != NULL) {
+    io_ret = ops->get_preload_buffer(
+        ops, part_name, image_size, out_image_buf);
+    if (io_ret == AVB_IO_RESULT_ERROR_OOM) {
+      return AVB_SLOT_VERIFY_RESULT_ERROR_OOM;
+    } else if (io_ret != AVB_IO_RESULT_OK) {
+      avb_errorv(part_name, ": Error loading data from partition.\n", NULL);
+      return AVB_SLOT_VERIFY_RESULT_ERROR_IO;
+    }
+    *out_image_preloaded = *out_image_buf != NULL;
+  }
+
+  /* Otherwise allocate one. */
+  if (*out_image_buf == NULL) {
     *out_image_buf = avb_malloc(image_size);
     if (*out_image_buf == NULL) {
       return AVB_SLOT_VERIFY_RESULT_ERROR_OOM;
     }
+  }
 
+  for (offset = 0; offset < image_size; offset += chunk) {
+    chunk = image_size - offset;
+    if (chunk > LOAD_CHUNK_SIZE) {
+      chunk = LOAD_CHUNK_SIZE;
+    }
     io_ret = ops->read_from_partition(ops,
                                       part_name,
-                                      0 /* offset */,
-                                      image_size,
-                                      *out_image_buf,
+                                      offset,
+                                      chunk,
+                                      *out_image_buf + offset,
                                       &part_num_read);
     if (io_ret == AVB_IO_RESULT_ERROR_OOM) {
       return AVB_SLOT_VERIFY_RESULT_ERROR_OOM;
@@ -115,10 +178,13 @@ static AvbSlotVerifyResult load_full_partition(AvbOps* ops,
       avb_errorv(part_name, ": Error loading data from partition.\n", NULL);
       return AVB_SLOT_VERIFY_RESULT_ERROR_IO;
     }
-    if (part_num_read != image_size) {
+    if (part_num_read != chunk) {
       avb_errorv(part_name, ": Read incorrect number of bytes.\n", NULL);
       return AVB_SLOT_VERIFY_RESULT_ERROR_IO;
     }
+    if (hash != NULL) {
+      load_hash_update(hash, *out_image_buf + offset, offset, chunk);
+    }
   }
 
   return AVB_SLOT_VERIFY_RESULT_OK;
@@ -363,40 +429,45 @@ static AvbSlotVerifyResult load_and_verify_hash_partition(
     avb_debugv(part_name, ": Loading entire partition.\n", NULL);
   }
 
-  ret = load_full_partition(
-      ops, part_name, image_size, &image_buf, &image_preloaded);
-  if (ret != AVB_SLOT_VERIFY_RESULT_OK) {
-    goto out;
-  }
   // Although only one of the type might be used, we have to defined the
   // structure here so that they would live outside the 'if/else' scope to be
   // used later.
   AvbSHA256Ctx sha256_ctx;
   AvbSHA512Ctx sha512_ctx;
-  size_t image_size_to_hash = hash_desc.image_size;
+  LoadHash hash = {NULL, NULL, hash_desc.image_size};
   // If we allow verification error and the whole partition is smaller than
   // image size in hash descriptor, we just hash the whole partition.
-  if (image_size_to_hash > image_size) {
-    image_size_to_hash = image_size;
+  if (hash.size > image_size) {
+    hash.size = image_size;
   }
+  // The salt goes first; the data is hashed while it is being loaded.
   if (avb_strcmp((const char*)hash_desc.hash_algorithm, "sha256") == 0) {
     avb_sha256_init(&sha256_ctx);
     avb_sha256_update(&sha256_ctx, desc_salt, hash_desc.salt_len);
-    avb_sha256_update(&sha256_ctx, image_buf, image_size_to_hash);
-    digest = avb_sha256_final(&sha256_ctx);
-    digest_len = AVB_SHA256_DIGEST_SIZE;
+    hash.sha256_ctx = &sha256_ctx;
   } else if (avb_strcmp((const char*)hash_desc.hash_algorithm, "sha512") == 0) {
     avb_sha512_init(&sha512_ctx);
     avb_sha512_update(&sha512_ctx, desc_salt, hash_desc.salt_len);
-    avb_sha512_update(&sha512_ctx, image_buf, image_size_to_hash);
-    digest = avb_sha512_final(&sha512_ctx);
-    digest_len = AVB_SHA512_DIGEST_SIZE;
+    hash.sha512_ctx = &sha512_ctx;
   } else {
     avb_errorv(part_name, ": Unsupported hash algorithm.\n", NULL);
     ret = AVB_SLOT_VERIFY_RESULT_ERROR_INVALID_METADATA;
     goto out;
   }
 
+  ret = load_full_partition(
+      ops, part_name, image_size, &hash, &image_buf, &image_preloaded);
+  if (ret != AVB_SLOT_VERIFY_RESULT_OK) {
+    goto out;
+  }
+  if (hash.sha256_ctx != NULL) {
+    digest = avb_sha256_final(&sha256_ctx);
+    digest_len = AVB_SHA256_DIGEST_SIZE;
+  } else {
+    digest = avb_sha512_final(&sha512_ctx);
+    digest_len = AVB_SHA512_DIGEST_SIZE;
+  }
+
   if (hash_desc.digest_len == 0) {
     /* Expect a match to a persistent digest. */
     avb_debugv(part_name, ": No digest, using persistent digest.\n", NULL);
@@ -500,7 +571,7 @@ static AvbSlotVerifyResult load_requested_partitions(
     avb_debugv(part_name, ": Loading entire partition.\n", NULL);
 
     ret = load_full_partition(
-        ops, part_name, image_size, &image_buf, &image_preloaded);
+        ops, part_name, image_size, NULL, &image_buf, &image_preloaded);
     if (ret != AVB_SLOT_VERIFY_RESULT_OK) {
       goto out;
     }
@@ -146,7 +146,9 @@ void arch_lmb_reserve_generic(struct lmb *lmb, ulong sp, ulong end, ulong align)
 
 		lmb_reserve(lmb, sp, bank_end - sp + 1);
 
-		if (gd->flags & GD_FLG_SKIP_RELOC)
+		if ((gd->flags & GD_FLG_SKIP_RELOC) ||
+		    (IS_ENABLED(CONFIG_RELOC_IN_PLACE) &&
+		     gd->relocaddr == (uintptr_t)_start))
 			lmb_reserve(lmb, (phys_addr_t)(uintptr_t)_start, gd->mon_len);
 
 		break;
@@ -0,0 +1,210 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Memory test engine
+ *
+ * Each test fills the range and then reads it back. Tests which repeat a pair
+ * of words use 64-byte NEON loads and stores on arm64, so that they run close
+ * to the memory bandwidth. Nothing here may use the console, timers or
+ * malloc(), since it runs on CPUs which U-Boot has not set up for that. The
+ * one exception is the job on the boot CPU, which kicks the watchdog and
+ * checks for Ctrl-C between tests.
+ */
+
+#include <common.h>
+#include <console.h>
+#include <memtest.h>
+#include <watchdog.h>
+#include <linux/compiler.h>
+
+#define MEMTEST_WORDS	(MEMTEST_ALIGN / sizeof(u64))
+
+#ifdef CONFIG_ARM64
+/* Fill from @p to @end with @lo and @hi in alternate words */
+static void memtest_fill_pair(u64 *p, u64 *end, u64 lo, u64 hi)
+{
+	/* U-Boot is built without FP/SIMD registers, so name them here */
+	asm volatile(".arch_extension simd\n"
+		     "	mov	v0.d[0], %[lo]\n"
+		     "	mov	v0.d[1], %[hi]\n"
+		     "	mov	v1.16b, v0.16b\n"
+		     "	mov	v2.16b, v0.16b\n"
+		     "	mov	v3.16b, v0.16b\n"
+		     "1:	st1	{v0.2d-v3.2d}, [%[p]], #64\n"
+		     "	cmp	%[p], %[end]\n"
+		     "	b.lo	1b\n"
+		     : [p] "+r" (p)
+		     : [end] "r" (end), [lo] "r" (lo), [hi] "r" (hi)
+		     : "v0", "v1", "v2", "v3", "cc", "memory");
+}
+
+/* Return the first block from @p which does not hold @lo and @hi, or @end */
+static u64 *memtest_check_pair(u64 *p, u64 *end, u64 lo, u64 hi)
+{
+	u32 diff;
+
+	asm volatile(".arch_extension simd\n"
+		     "	mov	v4.d[0], %[lo]\n"
+		     "	mov	v4.d[1], %[hi]\n"
+		     "1:	ld1	{v0.2d-v3.2d}, [%[p]]\n"
+		     "	eor	v0.16b, v0.16b, v4.16b\n"
+		     "	eor	v1.16b, v1.16b, v4.16b\n"
+		     "	eor	v2.16b, v2.16b, v4.16b\n"
+		     "	eor	v3.16b, v3.16b, v4.16b\n"
+		     "	orr	v0.16b, v0.16b, v1.16b\n"
+		     "	orr	v2.16b, v2.16b, v3.16b\n"
+		     "	orr	v0.16b, v0.16b, v2.16b\n"
+		     "	umaxv	s0, v0.4s\n"
+		     "	fmov	%w[diff], s0\n"
+		     "	cbnz	%w[diff], 2f\n"
+		     "	add	%[p], %[p], #64\n"
+		     "	cmp	%[p], %[end]\n"
+		     "	b.lo	1b\n"
+		     "2:\n"
+		     : [p] "+r" (p), [diff] "=&r" (diff)
+		     : [end] "r" (end), [lo] "r" (lo), [hi] "r" (hi)
+		     : "v0", "v1", "v2", "v3", "v4", "cc", "memory");
+
+	return p;
+}
+#else
+static void memtest_fill_pair(u64 *p, u64 *end, u64 lo, u64 hi)
+{
+	for (; p < end; p += 2) {
+		p[0] = lo;
+		p[1] = hi;
+	}
+}
+
+static u64 *memtest_check_pair(u64 *p, u64 *end, u64 lo, u64 hi)
+{
+	u64 diff;
+	int i;
+
+	for (; p < end; p += MEMTEST_WORDS) {
+		diff = 0;
+		for (i = 0; i < MEMTEST_WORDS; i += 2)
+			diff |= (p[i] ^ lo) | (p[i + 1] ^ hi);
+		if (diff)
+			break;
+	}
+
+	return p;
+}
+#endif
+
+static void memtest_error(struct memtest_job *job, u64 *addr, u64 expect,
+			  u64 actual)
+{
+	struct memtest_err *err;
+
+	if (job->errors < MEMTEST_MAX_ERRS) {
+		err = &job->err[job->errors];
+		err->addr = addr;
+		err->expect = expect;
+		err->actual = actual;
+	}
+	job->errors++;
+}
+
+/* Fill the range with @lo and @hi in alternate words, then check it */
+static void memtest_pair(struct memtest_job *job, u64 lo, u64 hi)
+{
+	u64 *p = job->buf, *end = job->buf + job->size / sizeof(u64);
+	u64 expect, val;
+	int i;
+
+	memtest_fill_pair(p, end, lo, hi);
+	barrier();
+	for (;;) {
+		p = memtest_check_pair(p, end, lo, hi);
+		if (p == end)
+			break;
+
+		/* find out which words in the block are wrong */
+		for (i = 0; i < MEMTEST_WORDS; i++) {
+			expect = i & 1 ? hi : lo;
+			val = READ_ONCE(p[i]);
+			if (val != expect)
+				memtest_error(job, &p[i], expect, val);
+		}
+		p += MEMTEST_WORDS;
+	}
+	job->bytes += job->size * 2;
+}
+
+static inline u64 memtest_word_val(u64 *p, ulong i, bool addr, u64 invert)
+{
+	return (addr ? (ulong)p : 1ULL << (i & 63)) ^ invert;
+}
+
+/* Fill each word with a value depending on its position, then check it */
+static void memtest_words(struct memtest_job *job, bool addr, u64 invert)
+{
+	ulong i, count = job->size / sizeof(u64);
+	u64 *buf = job->buf;
+	u64 expect, val;
+
+	for (i = 0; i < count; i++)
+		buf[i] = memtest_word_val(&buf[i], i, addr, invert);
+	barrier();
+	for (i = 0; i < count; i++) {
+		expect = memtest_word_val(&buf[i], i, addr, invert);
+		val = buf[i];
+		if (val != expect)
+			memtest_error(job, &buf[i], expect, val);
+	}
+	job->bytes += job->size * 2;
+}
+
+/* Check whether to stop, also kicking the watchdog if on the boot CPU */
+static bool memtest_stop(struct memtest_job *job)
+{
+	if (job->primary) {
+		WATCHDOG_RESET();
+		if (job->stop && ctrlc())
+			WRITE_ONCE(*job->stop, true);
+	}
+
+	return job->stop && READ_ONCE(*job->stop);
+}
+
+void memtest_run(void *arg)
+{
+	struct memtest_job *job = arg;
+	u64 val;
+	int i;
+
+	if (job->tests & MEMTEST_PATTERN) {
+		memtest_pair(job, job->pattern, job->pattern);
+		if (memtest_stop(job))
+			return;
+		memtest_pair(job, ~job->pattern, ~job->pattern);
+	}
+	if (job->tests & MEMTEST_WALK) {
+		if (memtest_stop(job))
+			return;
+		memtest_words(job, false, 0);
+		if (memtest_stop(job))
+			return;
+		memtest_words(job, false, ~0ULL);
+	}
+	if (job->tests & MEMTEST_ADDR) {
+		if (memtest_stop(job))
+			return;
+		memtest_words(job, true, 0);
+		if (memtest_stop(job))
+			return;
+		memtest_words(job, true, ~0ULL);
+	}
+	if (job->tests & MEMTEST_BITFLIP) {
+		/* one bit in each byte at a time, flipping between words */
+		for (i = 0; i < 8; i++) {
+			if (memtest_stop(job))
+				return;
+			val = 0x0101010101010101ULL << i;
+			memtest_pair(job, val, ~val);
+			memtest_pair(job, ~val, val);
+		}
+	}
+	memtest_stop(job);
+}
@@ -283,6 +283,8 @@ int unflatten_device_tree(const void *blob, struct device_node **mynodes)
 
 	/* Allocate memory for the expanded device tree */
 	mem = malloc(size + 4);
+	if (!mem)
+		return -ENOMEM;
 	memset(mem, '\0', size);
 
 	*(__be32 *)(mem + size) = cpu_to_be32(0xdeadbeef);
@@ -322,3 +324,214 @@ int of_live_build(const void *fdt_blob, struct device_node **rootp)
 
 	return ret;
 }
+
+/**
+ * struct flatten_priv - state while writing a live tree out as a flat one
+ *
+ * @old_strings: Strings block of the tree which was unflattened
+ * @old_size: Size of @old_strings in bytes
+ * @strings: Strings block being written, which starts with a copy of
+ *	@old_strings
+ * @strings_size: Number of bytes written to @strings
+ * @strings_max: Number of bytes available at @strings
+ * @offsets: Offsets in @strings of names which are not in @old_strings
+ * @count: Number of entries in @offsets
+ * @max: Number of entries allocated for @offsets
+ */
+struct flatten_priv {
+	const char *old_strings;
+	int old_size;
+	char *strings;
+	int strings_size;
+	int strings_max;
+	int *offsets;
+	int count;
+	int max;
+};
+
+/* Check for a "name" property which unflatten_dt_node() made up */
+static bool flatten_dt_made_up(const struct property *pp)
+{
+	return pp->value == (void *)(pp + 1) && !strcmp(pp->name, "name");
+}
+
+/* Get the size of the structure block needed for a node and its children */
+static int flatten_dt_size(const struct device_node *np)
+{
+	const struct device_node *child;
+	const struct property *pp;
+	int size;
+
+	size = 2 * sizeof(fdt32_t) +
+		ALIGN(strlen(strrchr(np->full_name, '/') + 1) + 1, FDT_TAGSIZE);
+	for (pp = np->properties; pp; pp = pp->next) {
+		if (!flatten_dt_made_up(pp))
+			size += sizeof(struct fdt_property) +
+				ALIGN(pp->length, FDT_TAGSIZE);
+	}
+	for (child = np->child; child; child = child->sibling)
+		size += flatten_dt_size(child);
+
+	return size;
+}
+
+/**
+ * flatten_dt_string() - Get the offset of a property name in the strings block
+ *
+ * Names which point into the strings block of the original tree keep their
+ * offset. Others are looked up and added if needed, the same way that libfdt
+ * does it.
+ *
+ * @priv: Flatten state
+ * @name: Property name
+ * Return: offset of @name in the strings block, -ENOSPC if there is no space
+ *	left or -ENOMEM if out of memory
+ */
+static int flatten_dt_string(struct flatten_priv *priv, const char *name)
+{
+	const char *p, *last;
+	int len, offset, i;
+	int *offsets;
+
+	if (name >= priv->old_strings &&
+	    name < priv->old_strings + priv->old_size)
+		return name - priv->old_strings;
+
+	for (i = 0; i < priv->count; i++) {
+		if (!strcmp(priv->strings + priv->offsets[i], name))
+			return priv->offsets[i];
+	}
+
+	len = strlen(name) + 1;
+	offset = -1;
+	last = priv->old_strings + priv->old_size - len;
+	for (p = priv->old_strings; p <= last; p++) {
+		if (!memcmp(p, name, len)) {
+			offset = p - priv->old_strings;
+			break;
+		}
+	}
+	if (offset < 0) {
+		if (priv->strings_size + len > priv->strings_max)
+			return -ENOSPC;
+		offset = priv->strings_size;
+		memcpy(priv->strings + offset, name, len);
+		priv->strings_size += len;
+	}
+
+	if (priv->count == priv->max) {
+		priv->max = priv->max ? priv->max * 2 : 16;
+		offsets = realloc(priv->offsets, priv->max * sizeof(int));
+		if (!offsets)
+			return -ENOMEM;
+		priv->offsets = offsets;
+	}
+	priv->offsets[priv->count++] = offset;
+
+	return offset;
+}
+
+/**
+ * flatten_dt_node() - Write a device_node and its children to a flat tree
+ *
+ * @priv: Flatten state
+ * @np: Node to write
+ * @pos: Position in the structure block to write to, which must have room
+ *	for the node, as worked out by flatten_dt_size()
+ * Return: position after the node, or an ERR_PTR() on error
+ */
+static void *flatten_dt_node(struct flatten_priv *priv,
+			     const struct device_node *np, void *pos)
+{
+	const struct device_node *child;
+	const struct property *pp;
+	struct fdt_property *prop;
+	const char *name;
+	int len, offset;
+
+	name = strrchr(np->full_name, '/') + 1;
+	len = strlen(name) + 1;
+	*(fdt32_t *)pos = cpu_to_fdt32(FDT_BEGIN_NODE);
+	pos += sizeof(fdt32_t);
+	memset(pos + ALIGN(len, FDT_TAGSIZE) - sizeof(fdt32_t), '\0',
+	       sizeof(fdt32_t));
+	memcpy(pos, name, len);
+	pos += ALIGN(len, FDT_TAGSIZE);
+
+	for (pp = np->properties; pp; pp = pp->next) {
+		if (flatten_dt_made_up(pp))
+			continue;
+		offset = flatten_dt_string(priv, pp->name);
+		if (offset < 0)
+			return ERR_PTR(offset);
+		prop = pos;
+		prop->tag = cpu_to_fdt32(FDT_PROP);
+		prop->len = cpu_to_fdt32(pp->length);
+		prop->nameoff = cpu_to_fdt32(offset);
+		pos += sizeof(*prop);
+		len = ALIGN(pp->length, FDT_TAGSIZE);
+		if (len) {
+			memset(pos + len - sizeof(fdt32_t), '\0',
+			       sizeof(fdt32_t));
+			memcpy(pos, pp->value, pp->length);
+		}
+		pos += len;
+	}
+
+	for (child = np->child; child; child = child->sibling) {
+		pos = flatten_dt_node(priv, child, pos);
+		if (IS_ERR(pos))
+			return pos;
+	}
+	*(fdt32_t *)pos = cpu_to_fdt32(FDT_END_NODE);
+
+	return pos + sizeof(fdt32_t);
+}
+
+int of_live_flatten(const struct device_node *root, const void *fdt,
+		    const struct fdt_reserve_entry *rsv, int rsv_count,
+		    void *buf, int size)
+{
+	struct flatten_priv priv = {};
+	int off_rsv, off_struct, struct_size;
+	void *pos;
+
+	off_rsv = fdt_off_mem_rsvmap(fdt);
+	off_struct = off_rsv + (rsv_count + 1) * sizeof(*rsv);
+	struct_size = flatten_dt_size(root) + sizeof(fdt32_t);
+	if (off_struct + struct_size + fdt_size_dt_strings(fdt) > size) {
+		debug("flatten: tree does not fit in %x bytes\n", size);
+		return -ENOSPC;
+	}
+
+	memset(buf, '\0', off_struct);
+	memcpy(buf + off_rsv, rsv, rsv_count * sizeof(*rsv));
+
+	priv.old_strings = fdt + fdt_off_dt_strings(fdt);
+	priv.old_size = fdt_size_dt_strings(fdt);
+	priv.strings = buf + off_struct + struct_size;
+	priv.strings_max = size - off_struct - struct_size;
+	memcpy(priv.strings, priv.old_strings, priv.old_size);
+	priv.strings_size = priv.old_size;
+
+	pos = flatten_dt_node(&priv, root, buf + off_struct);
+	free(priv.offsets);
+	if (IS_ERR(pos)) {
+		debug("flatten: error %ld writing FDT\n", PTR_ERR(pos));
+		return PTR_ERR(pos);
+	}
+	*(fdt32_t *)pos = cpu_to_fdt32(FDT_END);
+
+	fdt_set_magic(buf, FDT_MAGIC);
+	fdt_set_totalsize(buf, size);
+	fdt_set_off_dt_struct(buf, off_struct);
+	fdt_set_off_dt_strings(buf, off_struct + struct_size);
+	fdt_set_off_mem_rsvmap(buf, off_rsv);
+	fdt_set_version(buf, 17);
+	fdt_set_last_comp_version(buf, 16);
+	fdt_set_boot_cpuid_phys(buf, fdt_boot_cpuid_phys(fdt));
+	fdt_set_size_dt_strings(buf, priv.strings_size);
+	fdt_set_size_dt_struct(buf, struct_size);
+
+	return 0;
+}
@@ -6,6 +6,7 @@
 
 #include <common.h>
 #include <fdtdec.h>
+#include <fdt_support.h>
 #include <image.h>
 #include <log.h>
 #include <malloc.h>
@@ -136,6 +137,10 @@ int optee_copy_fdt_nodes(void *new_blob)
 		return 0;
 	}
 
+	ret = fdt_txn_sync(new_blob);
+	if (ret < 0)
+		return ret;
+
 	ret = optee_copy_firmware_node(node, new_blob);
 	if (ret < 0) {
 		printf("Failed to add OP-TEE firmware node\n");
@@ -10,6 +10,7 @@
 #include <dm.h>
 #include <errno.h>
 #include <init.h>
+#include <serial.h>
 #include <spl.h>
 #include <time.h>
 #include <timer.h>
@@ -193,12 +194,22 @@ void __weak __udelay(unsigned long usec)
 
 /* ------------------------------------------------------------------------- */
 
+/*
+ * Shorter delays are left alone, since they are often timing-critical (e.g.
+ * bit-banged buses) and too short to send even one character at 115200 baud
+ */
+#define UDELAY_TX_POLL_MIN_US	100
+
 void udelay(unsigned long usec)
 {
+	bool tx_poll = usec >= UDELAY_TX_POLL_MIN_US;
 	ulong kv;
 
 	do {
 		WATCHDOG_RESET();
+		/* Let buffered console output go out while we wait anyway */
+		if (tx_poll)
+			serial_tx_poll();
 		kv = usec > CONFIG_WD_PERIOD ? CONFIG_WD_PERIOD : usec;
 		__udelay(kv);
 		usec -= kv;
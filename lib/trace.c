@@ -10,12 +10,21 @@
 #include <asm/global_data.h>
 #include <asm/io.h>
 #include <asm/sections.h>
+#ifdef CONFIG_ARM64
+#include <asm/system.h>
+#endif
 
 DECLARE_GLOBAL_DATA_PTR;
 
 static char trace_enabled __section(".data");
 static char trace_inited __section(".data");
 
+/*
+ * Set while a trace record is being written, so that any traced functions
+ * called to read the timer are not themselves traced, which would recurse
+ */
+static char trace_locked __section(".data");
+
 /* The header block at the start of the trace memory area */
 struct trace_hdr {
 	int func_count;		/* Total number of function call sites */
@@ -101,6 +110,20 @@ static void __attribute__((no_instrument_function)) trace_swap_gd(void)
 
 #endif
 
+/**
+ * trace_cpu() - get the number of the CPU we are running on
+ *
+ * Return:	CPU number, as recorded in the trace
+ */
+static inline uint __attribute__((no_instrument_function)) trace_cpu(void)
+{
+#ifdef CONFIG_ARM64
+	return read_mpidr() & 0xff;
+#else
+	return 0;
+#endif
+}
+
 static void __attribute__((no_instrument_function)) add_ftrace(void *func_ptr,
 				void *caller, ulong flags)
 {
@@ -113,7 +136,10 @@ static void __attribute__((no_instrument_function)) add_ftrace(void *func_ptr,
 
 		rec->func = func_ptr_to_num(func_ptr);
 		rec->caller = func_ptr_to_num(caller);
-		rec->flags = flags | (timer_get_us() & FUNCF_TIMESTAMP_MASK);
+		rec->flags = flags | trace_cpu() << FUNCF_CPU_SHIFT |
+			(hdr->depth & FUNCF_DEPTH_MASK);
+		rec->reserved = 0;
+		rec->timestamp = timer_get_us();
 	}
 	hdr->ftrace_count++;
 }
@@ -126,6 +152,8 @@ static void __attribute__((no_instrument_function)) add_textbase(void)
 		rec->func = CONFIG_SYS_TEXT_BASE;
 		rec->caller = 0;
 		rec->flags = FUNCF_TEXTBASE;
+		rec->reserved = 0;
+		rec->timestamp = 0;
 	}
 	hdr->ftrace_count++;
 }
@@ -142,9 +170,10 @@ static void __attribute__((no_instrument_function)) add_textbase(void)
 void __attribute__((no_instrument_function)) __cyg_profile_func_enter(
 		void *func_ptr, void *caller)
 {
-	if (trace_enabled) {
+	if (trace_enabled && !trace_locked) {
 		int func;
 
+		trace_locked = 1;
 		trace_swap_gd();
 		add_ftrace(func_ptr, caller, FUNCF_ENTRY);
 		func = func_ptr_to_num(func_ptr);
@@ -155,9 +184,10 @@ void __attribute__((no_instrument_function)) __cyg_profile_func_enter(
 			hdr->untracked_count++;
 		}
 		hdr->depth++;
-		if (hdr->depth > hdr->depth_limit)
+		if (hdr->depth > hdr->max_depth)
 			hdr->max_depth = hdr->depth;
 		trace_swap_gd();
+		trace_locked = 0;
 	}
 }
 
@@ -170,11 +200,14 @@ void __attribute__((no_instrument_function)) __cyg_profile_func_enter(
 void __attribute__((no_instrument_function)) __cyg_profile_func_exit(
 		void *func_ptr, void *caller)
 {
-	if (trace_enabled) {
+	if (trace_enabled && !trace_locked) {
+		trace_locked = 1;
 		trace_swap_gd();
-		add_ftrace(func_ptr, caller, FUNCF_EXIT);
+		/* Record the exit at the same depth as the entry */
 		hdr->depth--;
+		add_ftrace(func_ptr, caller, FUNCF_EXIT);
 		trace_swap_gd();
+		trace_locked = 0;
 	}
 }
 
@@ -273,6 +306,8 @@ int trace_list_calls(void *buff, size_t buff_size, size_t *needed)
 			out->func = call->func * FUNC_SITE_SIZE;
 			out->caller = call->caller * FUNC_SITE_SIZE;
 			out->flags = call->flags;
+			out->reserved = 0;
+			out->timestamp = call->timestamp;
 			upto++;
 		}
 		ptr += sizeof(struct trace_call);
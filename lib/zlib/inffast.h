@@ -9,3 +9,13 @@
  */
 
 void inflate_fast OF((z_streamp strm, unsigned start));
+
+/* Minimum input and output space for inflate() to call inflate_fast() */
+#ifdef CONFIG_ZLIB_INFLATE_CHUNK
+#define INFLATE_CHUNK_SIZE 16
+#define INFLATE_FAST_MIN_INPUT 8
+#define INFLATE_FAST_MIN_OUTPUT (258 + INFLATE_CHUNK_SIZE)
+#else
+#define INFLATE_FAST_MIN_INPUT 6
+#define INFLATE_FAST_MIN_OUTPUT 258
+#endif
@@ -0,0 +1,303 @@
+/* inffast_chunk.c -- fast decoding with wide reads and chunked copies
+ * Copyright (C) 1995-2004 Mark Adler
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/* U-Boot: we already included these
+#include "zutil.h"
+#include "inftrees.h"
+#include "inflate.h"
+#include "inffast.h"
+*/
+
+/*
+   This is inffast.c reworked along the lines of the "chunk" decoder in
+   Chromium's zlib:
+
+    - The bit buffer is 64 bits wide and is refilled with a single unaligned
+      64-bit load. Bits above the valid ones in hold are always either zero
+      or the same input bits again, so the refill can simply OR the new bits
+      in and count only the 48 bits which are sure to fit.
+
+    - Matches are copied in 16-byte chunks, which may write up to
+      INFLATE_CHUNK_SIZE - 1 bytes past the end of the match. Those bytes
+      lie inside the output space which inflate() has not yet filled, and
+      are overwritten by the bytes which follow.
+
+   The output is identical to that of inffast.c.
+ */
+
+/* Copy @len bytes to @out from @dist bytes before it, returning the new end */
+static inline unsigned char *chunk_copy(unsigned char *out, unsigned dist,
+                                        unsigned len)
+{
+    unsigned char *end = out + len;
+    unsigned char *from;
+    unsigned period;
+
+    if (dist == 1) {
+        memset(out, out[-1], len);
+        return end;
+    }
+
+    /*
+     * With overlapping matches the output repeats every dist bytes, so any
+     * multiple of dist is just as good as a distance. Copy enough bytes one
+     * at a time for a multiple of at least a chunk to be available.
+     */
+    period = dist;
+    while (period < INFLATE_CHUNK_SIZE)
+        period += dist;
+    if (period != dist) {
+        len = period - dist < len ? period - dist : len;
+        from = out - dist;
+        while (len--)
+            *out++ = *from++;
+        if (out == end)
+            return end;
+    }
+
+    from = out - period;
+    do {
+        __builtin_memcpy(out, from, INFLATE_CHUNK_SIZE);
+        out += INFLATE_CHUNK_SIZE;
+        from += INFLATE_CHUNK_SIZE;
+    } while (out < end);
+
+    return end;
+}
+
+/*
+   Decode literal, length, and distance codes and write out the resulting
+   literal and match bytes until either not enough input or output is
+   available, an end-of-block is encountered, or a data error is encountered.
+
+   Entry assumptions:
+
+        state->mode == LEN
+        strm->avail_in >= INFLATE_FAST_MIN_INPUT
+        strm->avail_out >= INFLATE_FAST_MIN_OUTPUT
+        start >= strm->avail_out
+        state->bits < 8
+
+   On return, state->mode is one of:
+
+        LEN -- ran out of enough output space or enough available input
+        TYPE -- reached end of block code, inflate() to interpret next block
+        BAD -- error in block data
+
+   Notes:
+
+    - A length/distance pair uses at most 48 input bits. Each refill leaves
+      at least 48 bits in hold, so there is at most one refill per pair. That
+      reads 8 bytes, so if strm->avail_in >= 8 then there is enough input to
+      avoid checking for available input while decoding.
+
+    - A pair outputs at most 258 bytes, and the chunked copy may write up to
+      INFLATE_CHUNK_SIZE - 1 bytes beyond that.
+ */
+void inflate_fast(z_streamp strm, unsigned start)
+/* start: inflate()'s starting value for strm->avail_out */
+{
+    struct inflate_state FAR *state;
+    unsigned char FAR *in;      /* local strm->next_in */
+    unsigned char FAR *last;    /* while in < last, enough input available */
+    unsigned char FAR *out;     /* local strm->next_out */
+    unsigned char FAR *beg;     /* inflate()'s initial strm->next_out */
+    unsigned char FAR *end;     /* while out < end, enough space available */
+#ifdef INFLATE_STRICT
+    unsigned dmax;              /* maximum distance from zlib header */
+#endif
+    unsigned wsize;             /* window size or zero if not using window */
+    unsigned whave;             /* valid bytes in the window */
+    unsigned write;             /* window write index */
+    unsigned char FAR *window;  /* allocated sliding window, if wsize != 0 */
+    uint64_t hold;              /* local strm->hold */
+    unsigned bits;              /* local strm->bits */
+    code const FAR *lcode;      /* local strm->lencode */
+    code const FAR *dcode;      /* local strm->distcode */
+    unsigned lmask;             /* mask for first level of length codes */
+    unsigned dmask;             /* mask for first level of distance codes */
+    code this;                  /* retrieved table entry */
+    unsigned op;                /* code bits, operation, extra bits, or */
+                                /*  window position, window bytes to copy */
+    unsigned len;               /* match length, unused bytes */
+    unsigned dist;              /* match distance */
+    unsigned char FAR *from;    /* where to copy match from */
+
+    /* copy state to local variables */
+    state = (struct inflate_state FAR *)strm->state;
+    in = strm->next_in;
+    last = in + (strm->avail_in - (INFLATE_FAST_MIN_INPUT - 1));
+    if (in > last && strm->avail_in > INFLATE_FAST_MIN_INPUT - 1) {
+        /*
+         * overflow detected, limit strm->avail_in to the
+         * max. possible size and recalculate last
+         */
+        strm->avail_in = 0xffffffff - (uintptr_t)in;
+        last = in + (strm->avail_in - (INFLATE_FAST_MIN_INPUT - 1));
+    }
+    out = strm->next_out;
+    beg = out - (start - strm->avail_out);
+    end = out + (strm->avail_out - (INFLATE_FAST_MIN_OUTPUT - 1));
+#ifdef INFLATE_STRICT
+    dmax = state->dmax;
+#endif
+    wsize = state->wsize;
+    whave = state->whave;
+    write = state->write;
+    window = state->window;
+    hold = state->hold;
+    bits = state->bits;
+    lcode = state->lencode;
+    dcode = state->distcode;
+    lmask = (1U << state->lenbits) - 1;
+    dmask = (1U << state->distbits) - 1;
+
+#define REFILL() \
+    do { \
+        hold |= get_unaligned_le64(in) << bits; \
+        in += 6; \
+        bits += 48; \
+    } while (0)
+
+    /* decode literals and length/distances until end-of-block or not enough
+       input data or output space */
+    do {
+        if (bits < 15)
+            REFILL();
+        this = lcode[hold & lmask];
+      dolen:
+        op = (unsigned)(this.bits);
+        hold >>= op;
+        bits -= op;
+        op = (unsigned)(this.op);
+        if (op == 0) {                          /* literal */
+            Tracevv((stderr, this.val >= 0x20 && this.val < 0x7f ?
+                    "inflate:         literal '%c'\n" :
+                    "inflate:         literal 0x%02x\n", this.val));
+            *out++ = (unsigned char)(this.val);
+        }
+        else if (op & 16) {                     /* length base */
+            len = (unsigned)(this.val);
+            op &= 15;                           /* number of extra bits */
+            if (op) {
+                if (bits < op)
+                    REFILL();
+                len += (unsigned)hold & ((1U << op) - 1);
+                hold >>= op;
+                bits -= op;
+            }
+            Tracevv((stderr, "inflate:         length %u\n", len));
+            if (bits < 15)
+                REFILL();
+            this = dcode[hold & dmask];
+          dodist:
+            op = (unsigned)(this.bits);
+            hold >>= op;
+            bits -= op;
+            op = (unsigned)(this.op);
+            if (op & 16) {                      /* distance base */
+                dist = (unsigned)(this.val);
+                op &= 15;                       /* number of extra bits */
+                if (bits < op)
+                    REFILL();
+                dist += (unsigned)hold & ((1U << op) - 1);
+#ifdef INFLATE_STRICT
+                if (dist > dmax) {
+                    strm->msg = (char *)"invalid distance too far back";
+                    state->mode = BAD;
+                    break;
+                }
+#endif
+                hold >>= op;
+                bits -= op;
+                Tracevv((stderr, "inflate:         distance %u\n", dist));
+                op = (unsigned)(out - beg);     /* max distance in output */
+                if (dist > op) {                /* see if copy from window */
+                    op = dist - op;             /* distance back in window */
+                    if (op > whave) {
+                        strm->msg = (char *)"invalid distance too far back";
+                        state->mode = BAD;
+                        break;
+                    }
+                    if (write == 0) {           /* very common case */
+                        from = window + wsize - op;
+                    }
+                    else if (write < op) {      /* wrap around window */
+                        from = window + wsize + write - op;
+                        op -= write;
+                        if (op < len) {         /* some from end of window */
+                            len -= op;
+                            memcpy(out, from, op);
+                            out += op;
+                            from = window;      /* then start of window */
+                            op = write;
+                        }
+                    }
+                    else {                      /* contiguous in window */
+                        from = window + write - op;
+                    }
+                    /* the window is a separate buffer, so copy it exactly */
+                    if (op < len) {             /* some from window */
+                        len -= op;
+                        memcpy(out, from, op);
+                        out += op;
+                        out = chunk_copy(out, dist, len); /* rest from output */
+                    }
+                    else {
+                        memcpy(out, from, len);
+                        out += len;
+                    }
+                }
+                else {
+                    out = chunk_copy(out, dist, len); /* direct from output */
+                }
+            }
+            else if ((op & 64) == 0) {          /* 2nd level distance code */
+                this = dcode[this.val + (hold & ((1U << op) - 1))];
+                goto dodist;
+            }
+            else {
+                strm->msg = (char *)"invalid distance code";
+                state->mode = BAD;
+                break;
+            }
+        }
+        else if ((op & 64) == 0) {              /* 2nd level length code */
+            this = lcode[this.val + (hold & ((1U << op) - 1))];
+            goto dolen;
+        }
+        else if (op & 32) {                     /* end-of-block */
+            Tracevv((stderr, "inflate:         end of block\n"));
+            state->mode = TYPE;
+            break;
+        }
+        else {
+            strm->msg = (char *)"invalid literal/length code";
+            state->mode = BAD;
+            break;
+        }
+    } while (in < last && out < end);
+
+#undef REFILL
+
+    /* return unused bytes, dropping the bits read ahead beyond them */
+    len = bits >> 3;
+    in -= len;
+    bits -= len << 3;
+    hold &= ((uint64_t)1 << bits) - 1;
+
+    /* update state and return */
+    strm->next_in = in;
+    strm->next_out = out;
+    strm->avail_in = (unsigned)(in < last ?
+                                (INFLATE_FAST_MIN_INPUT - 1) + (last - in) :
+                                (INFLATE_FAST_MIN_INPUT - 1) - (in - last));
+    strm->avail_out = (unsigned)(out < end ?
+                                 (INFLATE_FAST_MIN_OUTPUT - 1) + (end - out) :
+                                 (INFLATE_FAST_MIN_OUTPUT - 1) - (out - end));
+    state->hold = hold;
+    state->bits = bits;
+    return;
+}
@@ -83,8 +83,18 @@ static int eth_bootdev_bind(struct udevice *dev)
 	return 0;
 }
 
+static int eth_bootdev_start(struct udevice *dev)
+{
+	/*
+	 * bootdev_start() probes the Ethernet device, which is where drivers
+	 * start bringing the link up, so there is nothing more to do
+	 */
+	return 0;
+}
+
 struct bootdev_ops eth_bootdev_ops = {
 	.get_bootflow	= eth_get_bootflow,
+	.start		= eth_bootdev_start,
 };
 
 static const struct udevice_id eth_bootdev_ids[] = {
@@ -97,6 +97,7 @@
 #include <net/pcap.h>
 #endif
 #include <net/udp.h>
+#include <serial.h>
 #if defined(CONFIG_LED_STATUS)
 #include <miiphy.h>
 #include <status_led.h>
@@ -560,6 +561,7 @@ restart:
 	 */
 	for (;;) {
 		WATCHDOG_RESET();
+		serial_tx_poll();
 		if (arp_timeout_check() > 0)
 			time_start = get_timer(0);
 
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for bench command
+ */
+
+#include <common.h>
+#include <command.h>
+#include <console.h>
+#include <dm.h>
+#include <env.h>
+#include <dm/root.h>
+#include <dm/test.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define BENCH_LINE(name, bytes, ops) \
+	"  {\"name\": \"" name "\", \"bytes\": " bytes ", \"ops\": " ops ", \"us\": "
+
+/* Test the JSON output of 'bench' */
+static int dm_test_cmd_bench_json(struct unit_test_state *uts)
+{
+	ut_assertok(console_record_reset_enable());
+	ut_assertok(run_command("bench -j -s 1000 -n 2 memcpy crc32 env", 0));
+	ut_assert_nextline("[");
+	ut_assert_nextlinen(BENCH_LINE("memcpy", "8192", "2"));
+	ut_assert_nextlinen(BENCH_LINE("crc32", "8192", "2"));
+	if (IS_ENABLED(CONFIG_CRC32C))
+		ut_assert_nextlinen(BENCH_LINE("crc32c", "8192", "2"));
+	ut_assert_nextlinen(BENCH_LINE("env_get", "0", "2048"));
+	ut_assert_nextline("]");
+	ut_assert_console_end();
+
+	/* the temporary variable is gone again */
+	ut_assertnull(env_get("bench_var"));
+
+	return 0;
+}
+DM_TEST(dm_test_cmd_bench_json, UT_TESTF_CONSOLE_REC);
+
+/* Test the text output of 'bench', with decompression checking its data */
+static int dm_test_cmd_bench_text(struct unit_test_state *uts)
+{
+	ut_assertok(console_record_reset_enable());
+	ut_assertok(run_command("bench -s 1000 -n 1 memset decomp", 0));
+	ut_assert_nextlinen("memset  ");
+	ut_assert_nextlinen("decomp:none  ");
+	if (IS_ENABLED(CONFIG_GZIP_COMPRESSED))
+		ut_assert_nextlinen("decomp:gzip  ");
+	ut_assert_console_end();
+
+	ut_asserteq(1, run_command("bench nosuch", 0));
+	ut_assert_nextline("Unknown case 'nosuch'");
+
+	return 0;
+}
+DM_TEST(dm_test_cmd_bench_text, UT_TESTF_CONSOLE_REC);
+
+/* Test that binding a second tree leaves the existing one alone */
+static int dm_test_cmd_bench_dm(struct unit_test_state *uts)
+{
+	struct udevice *root = dm_root();
+	struct udevice *dev;
+	int before, after;
+
+	before = uclass_id_count(UCLASS_TEST_FDT);
+	ut_assert(before > 0);
+
+	ut_assertok(console_record_reset_enable());
+	ut_assertok(run_command("bench -n 2 dm", 0));
+	ut_assert_nextlinen("dm_bind  ");
+	ut_assert_console_end();
+
+	ut_asserteq_ptr(root, dm_root());
+	after = uclass_id_count(UCLASS_TEST_FDT);
+	ut_asserteq(before, after);
+	ut_assertok(uclass_first_device_err(UCLASS_TEST_FDT, &dev));
+
+	return 0;
+}
+DM_TEST(dm_test_cmd_bench_dm, UT_TESTF_SCAN_FDT | UT_TESTF_CONSOLE_REC);
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the mtest command
+ */
+
+#include <common.h>
+#include <command.h>
+#include <console.h>
+#include <cpu_func.h>
+#include <test/ut.h>
+
+/* Declare a new mem test */
+#define MEM_TEST(_name, _flags)	UNIT_TEST(_name, _flags, mem_test)
+
+/* Test 'mtest -p', which runs on host threads in sandbox */
+static int mem_test_mtest_parallel(struct unit_test_state *uts)
+{
+	ut_assertok(console_record_reset_enable());
+	ut_assertok(run_command("mtest -p 100000 140000 55aa 2", 0));
+	ut_assert_nextline("Testing 00100000 ... 00140000:");
+	ut_assert_nextlinen("Iteration:      1: %d CPU(s), ",
+			    cpu_parallel_count());
+	ut_assert_nextlinen("Iteration:      2: %d CPU(s), ",
+			    cpu_parallel_count());
+	ut_assert_nextline("Tested 2 iteration(s) with 0 errors.");
+	ut_assert_console_end();
+
+	/* unaligned ends are trimmed, but a range must remain */
+	ut_asserteq(1, run_command("mtest -p 100008 100040 0 1", 0));
+	ut_assert_nextline("Testing 00100008 ... 00100040:");
+	ut_assert_nextline("Refusing to do empty test");
+
+	return 0;
+}
+MEM_TEST(mem_test_mtest_parallel, UT_TESTF_CONSOLE_REC);
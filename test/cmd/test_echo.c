@@ -7,6 +7,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <env.h>
 #include <asm/global_data.h>
 #include <display_options.h>
 #include <test/lib.h>
@@ -59,3 +60,61 @@ static int lib_test_hush_echo(struct unit_test_state *uts)
 }
 
 LIB_TEST(lib_test_hush_echo, 0);
+
+static struct test_data run_data[] = {
+	/* The loop variable must be back in place for the next run */
+	{"setenv jQs 'for jQx in 1 2 3; do echo -n \"${jQx}\"; done; echo'",
+	 "123"},
+	{"setenv jQs 'for jQx in 1 2 3; do if test ${jQx} = 2; "
+	 "then echo -n b; else echo -n a; fi; done; echo'",
+	 "aba"},
+	/* Assignments change the parsed command only while it runs */
+	{"setenv jQs 'foo=bar echo baz ${jQv}'",
+	 "baz X"},
+	/* Abbreviated command names */
+	{"setenv jQs 'ech ${jQv}'",
+	 "X"},
+};
+
+/* Run each script a few times, as it may be kept parsed in between */
+static int lib_test_hush_run(struct unit_test_state *uts)
+{
+	int i, j;
+
+	ut_assertok(env_set("jQv", "X"));
+	for (i = 0; i < ARRAY_SIZE(run_data); ++i) {
+		ut_assertok(run_command(run_data[i].cmd, 0));
+		for (j = 0; j < 3; j++) {
+			ut_silence_console(uts);
+			console_record_reset_enable();
+			ut_assertok(run_command("run jQs", 0));
+			ut_unsilence_console(uts);
+			console_record_readline(uts->actual_str,
+						sizeof(uts->actual_str));
+			ut_asserteq_str(run_data[i].expected,
+					uts->actual_str);
+			ut_assertok(ut_check_console_end(uts));
+		}
+	}
+
+	/* A changed script must be parsed again */
+	ut_assertok(env_set("jQs", "echo ${jQv}${jQv}"));
+	ut_silence_console(uts);
+	console_record_reset_enable();
+	ut_assertok(run_command("run jQs", 0));
+	ut_unsilence_console(uts);
+	ut_assert_nextline("XX");
+	ut_assertok(ut_check_console_end(uts));
+
+	/* An ambiguous abbreviation is not run */
+	ut_silence_console(uts);
+	ut_asserteq(1, run_command("e", 0));
+	ut_unsilence_console(uts);
+
+	env_set("jQs", NULL);
+	env_set("jQv", NULL);
+
+	return 0;
+}
+
+LIB_TEST(lib_test_hush_run, 0);
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for bootstage spans
+ */
+
+#include <common.h>
+#include <bootstage.h>
+#include <console.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/*
+ * line_indent() - get the indent of a span in a line of 'bootstage tree'
+ *
+ * @str: Line of output
+ * @label: Type and name of the span, as shown in the tree
+ * Return: indent of @label beyond that of a top-level span, or -1 if the line
+ *	does not show that span
+ */
+static int line_indent(const char *str, const char *label)
+{
+	const char *p = str + strlen(str) - strlen(label);
+	int indent;
+
+	if (p <= str || strcmp(p, label) || p[-1] != ' ')
+		return -1;
+
+	/* Skip back over the spaces after the two columns of times */
+	for (indent = 0; p > str && p[-1] == ' '; p--)
+		indent++;
+
+	return indent - 2;
+}
+
+/* Read the recorded console output up to @label and return its indent */
+static int span_indent(struct unit_test_state *uts, const char *label)
+{
+	int indent;
+
+	while (console_record_readline(uts->actual_str,
+				       sizeof(uts->actual_str)) > 0) {
+		indent = line_indent(uts->actual_str, label);
+		if (indent >= 0)
+			return indent;
+	}
+
+	return -1;
+}
+
+/* Test that spans nest and that the tree shows them under their parent */
+static int test_bootstage_span_nested(struct unit_test_state *uts)
+{
+	int outer, inner, sibling, after;
+	char *str = uts->actual_str;
+
+	outer = bootstage_span_start(BOOTSTAGE_SPAN_GENERAL, "ut_outer");
+	if (!outer)
+		return -EAGAIN;
+	inner = bootstage_span_start(BOOTSTAGE_SPAN_PROBE, "ut_inner");
+	ut_assert(inner > outer);
+	bootstage_span_end(inner);
+
+	/* Ending a span makes its parent current again */
+	sibling = bootstage_span_start(BOOTSTAGE_SPAN_BIND, "ut_sibling");
+	ut_assert(sibling > inner);
+	bootstage_span_end(sibling);
+	bootstage_span_end(outer);
+
+	after = bootstage_span_start(BOOTSTAGE_SPAN_GENERAL, "ut_after");
+	ut_assert(after > sibling);
+	bootstage_span_end(after);
+
+	/* The children follow their parent, in either order */
+	console_record_reset_enable();
+	bootstage_tree();
+	ut_asserteq(0, span_indent(uts, "ut_outer"));
+	ut_assert(console_record_readline(str, sizeof(uts->actual_str)) > 0);
+	if (line_indent(str, "probe ut_inner") == 2) {
+		ut_assert(console_record_readline(str,
+						  sizeof(uts->actual_str)) > 0);
+		ut_asserteq(2, line_indent(str, "bind ut_sibling"));
+	} else {
+		ut_asserteq(2, line_indent(str, "bind ut_sibling"));
+		ut_assert(console_record_readline(str,
+						  sizeof(uts->actual_str)) > 0);
+		ut_asserteq(2, line_indent(str, "probe ut_inner"));
+	}
+
+	/* The last span is back at the top level */
+	console_record_reset_enable();
+	bootstage_tree();
+	ut_asserteq(0, span_indent(uts, "ut_after"));
+
+	return 0;
+}
+COMMON_TEST(test_bootstage_span_nested, UT_TESTF_CONSOLE_REC);
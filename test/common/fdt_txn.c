@@ -0,0 +1,317 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for device-tree fixup transactions
+ *
+ * Each test makes the same fixups to one copy of a tree directly and to
+ * another copy inside a transaction, then checks that both trees come out the
+ * same, including the order of nodes and properties.
+ */
+
+#include <common.h>
+#include <env.h>
+#include <fdt_support.h>
+#include <malloc.h>
+#include <asm/global_data.h>
+#include <linux/libfdt.h>
+#include <linux/sizes.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define TXN_FDT_SIZE	SZ_16K
+
+/* Build a base tree to fix up */
+static int make_base(struct unit_test_state *uts, void *fdt)
+{
+	ut_assertok(fdt_create(fdt, TXN_FDT_SIZE));
+	ut_assertok(fdt_add_reservemap_entry(fdt, 0x1000, 0x100));
+	ut_assertok(fdt_finish_reservemap(fdt));
+	ut_assertok(fdt_begin_node(fdt, ""));
+	ut_assertok(fdt_property_u32(fdt, "#address-cells", 1));
+	ut_assertok(fdt_property_u32(fdt, "#size-cells", 1));
+	ut_assertok(fdt_property_string(fdt, "model", "txn test"));
+
+	ut_assertok(fdt_begin_node(fdt, "aliases"));
+	ut_assertok(fdt_property_string(fdt, "ethernet0", "/eth@2000"));
+	ut_assertok(fdt_property_string(fdt, "serial0", "/serial@1000"));
+	ut_assertok(fdt_end_node(fdt));
+
+	ut_assertok(fdt_begin_node(fdt, "memory@40000000"));
+	ut_assertok(fdt_property_string(fdt, "device_type", "memory"));
+	ut_assertok(fdt_property_u32(fdt, "reg", 0x40000000));
+	ut_assertok(fdt_end_node(fdt));
+
+	ut_assertok(fdt_begin_node(fdt, "serial@1000"));
+	ut_assertok(fdt_property_string(fdt, "compatible", "ns16550a"));
+	ut_assertok(fdt_end_node(fdt));
+
+	ut_assertok(fdt_begin_node(fdt, "eth@2000"));
+	ut_assertok(fdt_property(fdt, "compatible", "vnd,mac\0test,eth", 17));
+	ut_assertok(fdt_property(fdt, "mac-address", "\0\0\0\0\0", 6));
+	ut_assertok(fdt_end_node(fdt));
+
+	/* A real "name" property must survive the live tree */
+	ut_assertok(fdt_begin_node(fdt, "named"));
+	ut_assertok(fdt_property_string(fdt, "name", "real"));
+	ut_assertok(fdt_end_node(fdt));
+
+	ut_assertok(fdt_begin_node(fdt, "target"));
+	ut_assertok(fdt_property_u32(fdt, "phandle", 1));
+	ut_assertok(fdt_end_node(fdt));
+
+	ut_assertok(fdt_begin_node(fdt, "__symbols__"));
+	ut_assertok(fdt_property_string(fdt, "tgt", "/target"));
+	ut_assertok(fdt_end_node(fdt));
+
+	ut_assertok(fdt_end_node(fdt));
+	ut_assertok(fdt_finish(fdt));
+	ut_assertok(fdt_open_into(fdt, fdt, TXN_FDT_SIZE));
+
+	return 0;
+}
+
+/* Build an overlay using a label, a local phandle and a target path */
+static int make_overlay(struct unit_test_state *uts, void *fdto)
+{
+	ut_assertok(fdt_create(fdto, TXN_FDT_SIZE));
+	ut_assertok(fdt_finish_reservemap(fdto));
+	ut_assertok(fdt_begin_node(fdto, ""));
+
+	ut_assertok(fdt_begin_node(fdto, "fragment@0"));
+	ut_assertok(fdt_property_u32(fdto, "target", 0xffffffff));
+	ut_assertok(fdt_begin_node(fdto, "__overlay__"));
+	ut_assertok(fdt_property_string(fdto, "new-prop", "added"));
+	ut_assertok(fdt_begin_node(fdto, "child"));
+	ut_assertok(fdt_property_u32(fdto, "phandle", 1));
+	ut_assertok(fdt_property_u32(fdto, "ref", 1));
+	ut_assertok(fdt_end_node(fdto));
+	ut_assertok(fdt_end_node(fdto));
+	ut_assertok(fdt_end_node(fdto));
+
+	ut_assertok(fdt_begin_node(fdto, "fragment@1"));
+	ut_assertok(fdt_property_string(fdto, "target-path", "/"));
+	ut_assertok(fdt_begin_node(fdto, "__overlay__"));
+	ut_assertok(fdt_begin_node(fdto, "eth@3000"));
+	ut_assertok(fdt_property_string(fdto, "compatible", "test,eth"));
+	ut_assertok(fdt_end_node(fdto));
+	ut_assertok(fdt_end_node(fdto));
+	ut_assertok(fdt_end_node(fdto));
+
+	ut_assertok(fdt_begin_node(fdto, "__symbols__"));
+	ut_assertok(fdt_property_string(fdto, "child",
+					"/fragment@0/__overlay__/child"));
+	ut_assertok(fdt_end_node(fdto));
+
+	ut_assertok(fdt_begin_node(fdto, "__fixups__"));
+	ut_assertok(fdt_property_string(fdto, "tgt", "/fragment@0:target:0"));
+	ut_assertok(fdt_end_node(fdto));
+
+	ut_assertok(fdt_begin_node(fdto, "__local_fixups__"));
+	ut_assertok(fdt_begin_node(fdto, "fragment@0"));
+	ut_assertok(fdt_begin_node(fdto, "__overlay__"));
+	ut_assertok(fdt_begin_node(fdto, "child"));
+	ut_assertok(fdt_property_u32(fdto, "ref", 0));
+	ut_assertok(fdt_end_node(fdto));
+	ut_assertok(fdt_end_node(fdto));
+	ut_assertok(fdt_end_node(fdto));
+	ut_assertok(fdt_end_node(fdto));
+
+	ut_assertok(fdt_end_node(fdto));
+	ut_assertok(fdt_finish(fdto));
+
+	return 0;
+}
+
+/* Check that two nodes have the same properties and subnodes, in order */
+static int check_same_node(struct unit_test_state *uts, const void *a,
+			   int anode, const void *b, int bnode)
+{
+	const char *aname, *bname;
+	const void *aval, *bval;
+	int alen, blen;
+	int aoff, boff;
+
+	ut_asserteq_str(fdt_get_name(a, anode, NULL),
+			fdt_get_name(b, bnode, NULL));
+
+	boff = fdt_first_property_offset(b, bnode);
+	fdt_for_each_property_offset(aoff, a, anode) {
+		ut_assert(boff >= 0);
+		aval = fdt_getprop_by_offset(a, aoff, &aname, &alen);
+		bval = fdt_getprop_by_offset(b, boff, &bname, &blen);
+		ut_asserteq_str(aname, bname);
+		ut_asserteq(alen, blen);
+		ut_asserteq_mem(aval, bval, alen);
+		boff = fdt_next_property_offset(b, boff);
+	}
+	ut_asserteq(-FDT_ERR_NOTFOUND, boff);
+
+	boff = fdt_first_subnode(b, bnode);
+	fdt_for_each_subnode(aoff, a, anode) {
+		ut_assert(boff >= 0);
+		ut_assertok(check_same_node(uts, a, aoff, b, boff));
+		boff = fdt_next_subnode(b, boff);
+	}
+	ut_asserteq(-FDT_ERR_NOTFOUND, boff);
+
+	return 0;
+}
+
+/* Check that two trees are the same, including the reserve map */
+static int check_same_tree(struct unit_test_state *uts, const void *a,
+			   const void *b)
+{
+	u64 aaddr, asize, baddr, bsize;
+	int i;
+
+	ut_assertok(fdt_check_header(a));
+	ut_assertok(fdt_check_header(b));
+	ut_asserteq(fdt_num_mem_rsv(a), fdt_num_mem_rsv(b));
+	for (i = 0; i < fdt_num_mem_rsv(a); i++) {
+		ut_assertok(fdt_get_mem_rsv(a, i, &aaddr, &asize));
+		ut_assertok(fdt_get_mem_rsv(b, i, &baddr, &bsize));
+		ut_asserteq_64(aaddr, baddr);
+		ut_asserteq_64(asize, bsize);
+	}
+
+	return check_same_node(uts, a, 0, b, 0);
+}
+
+/* Make the boot-time fixups, overlays first as bootm does */
+static int do_fixups(struct unit_test_state *uts, void *fdt, void *fdto)
+{
+	u64 start[] = { 0x40000000, 0x80000000 };
+	u64 size[] = { 0x10000000, 0x8000000 };
+
+	if (IS_ENABLED(CONFIG_OF_LIBFDT_OVERLAY))
+		ut_assertok(fdt_overlay_apply_verbose(fdt, fdto));
+	ut_assertok(fdt_root(fdt));
+	ut_assertok(fdt_chosen(fdt));
+	ut_assertok(fdt_fixup_memory_banks(fdt, start, size, 2));
+	fdt_fixup_ethernet(fdt);
+	do_fixup_by_compat_u32(fdt, "test,eth", "max-speed", 100, 1);
+	do_fixup_by_compat_u32(fdt, "vnd,mac", "mac-address", 0, 0);
+	do_fixup_by_prop(fdt, "device_type", "memory", 7, "numa-node-id",
+			 "\0\0\0\0", 4, 1);
+	ut_assertok(ft_board_setup(fdt, gd->bd));
+	ut_assertok(fdt_initrd(fdt, 0x2000000, 0x2100000));
+	ut_assertok(fdt_initrd(fdt, 0x3000000, 0x3200000));
+
+	return 0;
+}
+
+static int test_fdt_txn_fixups(struct unit_test_state *uts)
+{
+	void *flat, *live, *fdto;
+	char *bootargs;
+	const char *str;
+	const fdt32_t *ref;
+	u32 phandle;
+	int node, ret;
+
+	flat = malloc(TXN_FDT_SIZE);
+	live = malloc(TXN_FDT_SIZE);
+	fdto = malloc(TXN_FDT_SIZE);
+	ut_assertnonnull(flat);
+	ut_assertnonnull(live);
+	ut_assertnonnull(fdto);
+
+	str = env_get("bootargs");
+	bootargs = str ? strdup(str) : NULL;
+	ut_assertok(env_set("bootargs", "console=ttyS0 root=/dev/txn"));
+
+	ut_assertok(make_base(uts, flat));
+	memcpy(live, flat, TXN_FDT_SIZE);
+
+	ut_assertok(make_overlay(uts, fdto));
+	ut_assertok(do_fixups(uts, flat, fdto));
+
+	ut_assertok(make_overlay(uts, fdto));
+	fdt_txn_begin(live);
+	ut_assertnonnull(fdt_txn_root(live));
+	ut_assertnull(fdt_txn_root(flat));
+	ut_assertok(do_fixups(uts, live, fdto));
+	ut_assertok(fdt_txn_commit(live));
+	ut_assertnull(fdt_txn_root(live));
+
+	ret = check_same_tree(uts, flat, live);
+	env_set("bootargs", bootargs);
+	free(bootargs);
+	ut_assertok(ret);
+
+	str = fdt_getprop(live, fdt_path_offset(live, "/chosen"), "bootargs",
+			  NULL);
+	ut_asserteq_str("console=ttyS0 root=/dev/txn", str);
+	ut_asserteq_str("real", fdt_getprop(live,
+					    fdt_path_offset(live, "/named"),
+					    "name", NULL));
+	if (IS_ENABLED(CONFIG_OF_LIBFDT_OVERLAY)) {
+		node = fdt_path_offset(live, "/target/child");
+		ut_assert(node >= 0);
+		phandle = fdt_get_phandle(live, node);
+		ut_asserteq(2, phandle);
+		ref = fdt_getprop(live, node, "ref", NULL);
+		ut_assertnonnull(ref);
+		ut_asserteq(phandle, fdt32_to_cpu(*ref));
+		node = fdt_path_offset(live, "/__symbols__");
+		ut_asserteq_str("/target/child",
+				fdt_getprop(live, node, "child", NULL));
+		ut_assert(fdt_path_offset(live, "/eth@3000") >= 0);
+	}
+
+	free(fdto);
+	free(live);
+	free(flat);
+
+	return 0;
+}
+COMMON_TEST(test_fdt_txn_fixups, 0);
+
+/* Writing the flat tree in the middle of a transaction */
+static int test_fdt_txn_sync(struct unit_test_state *uts)
+{
+	u64 start[] = { 0x40000000 };
+	u64 size[] = { 0x20000000 };
+	void *flat, *live;
+	void *fdts[2];
+	int i;
+
+	flat = malloc(TXN_FDT_SIZE);
+	live = malloc(TXN_FDT_SIZE);
+	ut_assertnonnull(flat);
+	ut_assertnonnull(live);
+	ut_assertok(make_base(uts, flat));
+	memcpy(live, flat, TXN_FDT_SIZE);
+	fdts[0] = flat;
+	fdts[1] = live;
+
+	fdt_txn_begin(live);
+	for (i = 0; i < ARRAY_SIZE(fdts); i++) {
+		void *fdt = fdts[i];
+
+		ut_assertok(fdt_chosen(fdt));
+		ut_assertok(fdt_txn_sync(fdt));
+		ut_assertok(fdt_setprop_string(fdt, 0, "flat-prop", "flat"));
+		ut_assertok(fdt_fixup_memory_banks(fdt, start, size, 1));
+		ut_assertok(fdt_txn_sync(fdt));
+		ut_assertok(fdt_add_mem_rsv(fdt, 0x5000, 0x1000));
+		do_fixup_by_path_string(fdt, "/chosen", "after-sync", "live");
+	}
+	ut_assertok(fdt_txn_commit(live));
+
+	ut_assertok(check_same_tree(uts, flat, live));
+
+	/* An aborted transaction leaves the tree alone */
+	fdt_txn_begin(live);
+	do_fixup_by_path_string(live, "/chosen", "dropped", "yes");
+	fdt_txn_abort(live);
+	ut_assertok(check_same_tree(uts, flat, live));
+
+	free(live);
+	free(flat);
+
+	return 0;
+}
+COMMON_TEST(test_fdt_txn_sync, 0);
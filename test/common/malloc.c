@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests and micro-benchmark for the malloc() size-class cache
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <time.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define BENCH_COUNT	256
+#define BENCH_ROUNDS	200
+
+static void *bench_ptr[BENCH_COUNT];
+
+/* Sizes of typical driver-model allocations: udevice, priv, plat, names */
+static const size_t bench_size[] = { 200, 48, 96, 24, 160, 64, 32, 120 };
+
+/* Find the cache class serving a request of @size bytes */
+static int find_class(size_t size, struct malloc_class_info *info)
+{
+	int idx;
+
+	for (idx = 0; !malloc_cache_class(idx, info); idx++) {
+		if (info->size >= size + sizeof(size_t))
+			return idx;
+	}
+
+	return -ENOENT;
+}
+
+/* Check that a freed small chunk is handed back for the next request */
+static int test_malloc_cache_reuse(struct unit_test_state *uts)
+{
+	struct malloc_class_info before, after;
+	struct malloc_info info;
+	bool enabled;
+	u8 *ptr, *ptr2;
+	int idx, i;
+
+	idx = find_class(40, &before);
+	if (idx < 0)
+		return -EAGAIN;
+	enabled = malloc_cache_enable(true);
+
+	ptr = malloc(40);
+	ut_assertnonnull(ptr);
+	memset(ptr, 0xaa, 40);
+	free(ptr);
+	ut_assertok(malloc_cache_class(idx, &before));
+	ut_assert(before.cached > 0);
+
+	/* calloc() must still clear memory obtained from the cache */
+	ptr2 = calloc(1, 40);
+	ut_asserteq_ptr(ptr, ptr2);
+	for (i = 0; i < 40; i++)
+		ut_asserteq(0, ptr2[i]);
+
+	ut_assertok(malloc_cache_class(idx, &after));
+	ut_asserteq(before.requests + 1, after.requests);
+	ut_asserteq(before.hits + 1, after.hits);
+	ut_asserteq(before.cached - 1, after.cached);
+	free(ptr2);
+
+	/* Flushing empties the cache */
+	ut_assert(malloc_cache_flush() > 0);
+	malloc_get_info(&info);
+	ut_asserteq(0, info.cached);
+	ut_asserteq(0, info.cached_chunks);
+	malloc_cache_enable(enabled);
+
+	return 0;
+}
+COMMON_TEST(test_malloc_cache_reuse, 0);
+
+static int bench_run(struct unit_test_state *uts, bool cache, ulong *usp)
+{
+	bool enabled;
+	ulong start;
+	int round, i;
+
+	enabled = malloc_cache_enable(cache);
+	start = timer_get_us();
+	for (round = 0; round < BENCH_ROUNDS; round++) {
+		for (i = 0; i < BENCH_COUNT; i++) {
+			bench_ptr[i] = calloc(1, bench_size[i %
+						ARRAY_SIZE(bench_size)]);
+			ut_assertnonnull(bench_ptr[i]);
+		}
+		/* release in an interleaved order, as device removal does */
+		for (i = 0; i < BENCH_COUNT; i += 2)
+			free(bench_ptr[i]);
+		for (i = 1; i < BENCH_COUNT; i += 2)
+			free(bench_ptr[i]);
+	}
+	*usp = timer_get_us() - start;
+	malloc_cache_enable(enabled);
+
+	return 0;
+}
+
+/* Compare the cost of small allocations with and without the cache */
+static int test_malloc_bench(struct unit_test_state *uts)
+{
+	struct malloc_class_info cls;
+	struct malloc_info info;
+	ulong plain, cached;
+	ulong ops = 2 * BENCH_COUNT * BENCH_ROUNDS;
+
+	if (malloc_cache_class(0, &cls))
+		return -EAGAIN;
+
+	ut_assertok(bench_run(uts, false, &plain));
+	ut_assertok(bench_run(uts, true, &cached));
+	malloc_get_info(&info);
+	ut_assert(info.arena - info.free >= info.cached);
+
+	printf("malloc/free: %lu ops, %lu us without cache, %lu us with cache\n",
+	       ops, plain, cached);
+
+	return 0;
+}
+COMMON_TEST(test_malloc_bench, 0);
@@ -11,7 +11,9 @@
 #include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <time.h>
 #include <asm/io.h>
+#include <asm/unaligned.h>
 
 #include <u-boot/lz4.h>
 #include <u-boot/zlib.h>
@@ -22,6 +24,8 @@
 #include <lzma/LzmaTools.h>
 
 #include <linux/lzo.h>
+#include <linux/sizes.h>
+#include <linux/zstd.h>
 #include <test/compression.h>
 #include <test/suites.h>
 #include <test/ut.h>
@@ -414,6 +418,71 @@ static int compression_test_gzip(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_gzip, 0);
 
+#define GZIP_LARGE_SIZE		SZ_1M
+
+/* Fill @buf with literals and matches at distances both short and long */
+static void fill_compressible(u8 *buf, ulong size)
+{
+	u32 seed = 0x2545f491;
+	ulong pos = 0, dist, len;
+
+	while (pos < size) {
+		seed = seed * 1103515245 + 12345;
+		if (pos < 64 || (seed >> 28) < 8) {
+			buf[pos++] = 'a' + (seed >> 16) % 26;
+			continue;
+		}
+		if (seed & 0x100)
+			dist = 1 + (seed >> 9) % 24;
+		else
+			dist = 1 + (seed >> 9) % min(pos, 32768UL);
+		dist = min(dist, pos);
+		len = min_t(ulong, 3 + (seed >> 20) % 256, size - pos);
+		for (; len; len--, pos++)
+			buf[pos] = buf[pos - dist];
+	}
+}
+
+/*
+ * Decompress a larger buffer, so that the inflate fast path does most of the
+ * work, check that the result is exact and report the speed
+ */
+static int compression_test_gzip_large(struct unit_test_state *uts)
+{
+	unsigned long csize = GZIP_LARGE_SIZE, usize;
+	u8 *orig, *comp, *uncomp;
+	ulong start, us;
+
+	orig = malloc(GZIP_LARGE_SIZE);
+	comp = malloc(GZIP_LARGE_SIZE);
+	uncomp = malloc(GZIP_LARGE_SIZE + 1);
+	ut_assertnonnull(orig);
+	ut_assertnonnull(comp);
+	ut_assertnonnull(uncomp);
+
+	fill_compressible(orig, GZIP_LARGE_SIZE);
+	ut_assertok(gzip(comp, &csize, orig, GZIP_LARGE_SIZE));
+
+	/* use an exact-size buffer, to catch any writes beyond the end */
+	uncomp[GZIP_LARGE_SIZE] = 'A';
+	usize = csize;
+	start = timer_get_us();
+	ut_assertok(gunzip(uncomp, GZIP_LARGE_SIZE, comp, &usize));
+	us = max(timer_get_us() - start, 1UL);
+	ut_asserteq(GZIP_LARGE_SIZE, usize);
+	ut_asserteq_mem(orig, uncomp, GZIP_LARGE_SIZE);
+	ut_asserteq('A', uncomp[GZIP_LARGE_SIZE]);
+	printf("\tgunzip %lu -> %lu bytes in %lu us, %lu MB/s\n", csize, usize,
+	       us, usize / us);
+
+	free(uncomp);
+	free(comp);
+	free(orig);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_gzip_large, 0);
+
 static int compression_test_bzip2(struct unit_test_state *uts)
 {
 	return run_test(uts, "bzip2", compress_using_bzip2,
@@ -440,6 +509,187 @@ static int compression_test_lz4(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_lz4, 0);
 
+/*
+ * Decompress @image after loading it at the end of an output buffer which
+ * only has the margin for @comp beyond the @unc_len bytes of @plain
+ */
+static int decomp_inplace(struct unit_test_state *uts, int comp,
+			  const void *image, ulong image_len,
+			  const void *plain, ulong unc_len)
+{
+	ulong image_start, size, load_end;
+	u8 *buf;
+
+	size = unc_len + image_decomp_margin(comp, image_len, unc_len);
+	ut_assert(size > unc_len);
+	image_start = size - image_len;
+	ut_assert(image_start < unc_len);
+
+	buf = malloc(size + 1);
+	ut_assertnonnull(buf);
+	buf[size] = 'A';
+	memcpy(buf + image_start, image, image_len);
+	ut_assertok(image_decomp(comp, 0, image_start, IH_TYPE_KERNEL, buf,
+				 buf + image_start, image_len, unc_len,
+				 &load_end));
+	ut_asserteq(unc_len, load_end);
+	ut_asserteq_mem(plain, buf, unc_len);
+	ut_asserteq('A', buf[size]);
+	free(buf);
+
+	return 0;
+}
+
+/* Fill @buf with bytes which do not compress */
+static void fill_incompressible(u8 *buf, ulong size)
+{
+	u32 seed = 0x6b8b4567;
+
+	for (; size; size--) {
+		seed = seed * 1103515245 + 12345;
+		*buf++ = seed >> 16;
+	}
+}
+
+/* Decompress LZ4 data which has been loaded at the end of the output buffer */
+static int compression_test_lz4_inplace(struct unit_test_state *uts)
+{
+	ut_asserteq(0, image_decomp_margin(IH_COMP_GZIP, lz4_compressed_size,
+					   strlen(plain)));
+
+	return decomp_inplace(uts, IH_COMP_LZ4, lz4_compressed,
+			      lz4_compressed_size, plain, strlen(plain));
+}
+COMPRESSION_TEST(compression_test_lz4_inplace, 0);
+
+/*
+ * Blocks of the LZ4 frame for the in-place test: the size of the data and
+ * whether it is stored uncompressed. The others are made of literals only,
+ * so that they grow by the most an LZ4 block can.
+ */
+static const struct {
+	u32 size;
+	bool stored;
+} lz4_inplace_blocks[] = {
+	{ 65000 }, { 65536, true }, { 65000 }, { 65000 }, { 10000 },
+};
+
+/* Decompress LZ4 data which is bigger than its output, in several blocks */
+static int compression_test_lz4_inplace_large(struct unit_test_state *uts)
+{
+	ulong unc_len = 0, len, i;
+	u8 *plain_buf, *image, *in, *ptr;
+
+	for (i = 0; i < ARRAY_SIZE(lz4_inplace_blocks); i++)
+		unc_len += lz4_inplace_blocks[i].size;
+	plain_buf = malloc(unc_len);
+	image = malloc(unc_len + SZ_4K);
+	ut_assertnonnull(plain_buf);
+	ut_assertnonnull(image);
+	fill_incompressible(plain_buf, unc_len);
+
+	/*
+	 * Frame header: version 1, independent blocks, 64KiB blocks, no
+	 * checksums. ulz4fn() does not check the header checksum.
+	 */
+	ptr = image;
+	put_unaligned_le32(0x184d2204, ptr);
+	ptr += 4;
+	*ptr++ = 0x60;
+	*ptr++ = 0x40;
+	*ptr++ = 0;
+
+	for (in = plain_buf, i = 0; i < ARRAY_SIZE(lz4_inplace_blocks); i++) {
+		u32 size = lz4_inplace_blocks[i].size;
+		u8 *hdr = ptr;
+
+		ptr += 4;
+		if (lz4_inplace_blocks[i].stored) {
+			put_unaligned_le32(size | 0x80000000, hdr);
+		} else {
+			/* One sequence of literals, with no match */
+			*ptr++ = 0xf0;
+			for (len = size - 15; len >= 255; len -= 255)
+				*ptr++ = 255;
+			*ptr++ = len;
+		}
+		memcpy(ptr, in, size);
+		ptr += size;
+		in += size;
+		if (!lz4_inplace_blocks[i].stored)
+			put_unaligned_le32(ptr - hdr - 4, hdr);
+	}
+	put_unaligned_le32(0, ptr);
+	ptr += 4;
+	ut_assert(ptr - image > unc_len);
+
+	ut_assertok(decomp_inplace(uts, IH_COMP_LZ4, image, ptr - image,
+				   plain_buf, unc_len));
+	free(image);
+	free(plain_buf);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_lz4_inplace_large, 0);
+
+/* Blocks of the zstd frame for the in-place test, raw unless @rle is set */
+static const struct {
+	u32 size;
+	bool rle;
+} zstd_inplace_blocks[] = {
+	{ SZ_128K }, { 256, true }, { SZ_128K }, { 1000 },
+};
+
+/* Decompress mostly incompressible zstd data loaded at the end of its output */
+static int compression_test_zstd_inplace(struct unit_test_state *uts)
+{
+	ulong unc_len = 0, i;
+	u8 *plain_buf, *image, *in, *ptr;
+
+	for (i = 0; i < ARRAY_SIZE(zstd_inplace_blocks); i++)
+		unc_len += zstd_inplace_blocks[i].size;
+	plain_buf = malloc(unc_len);
+	image = malloc(unc_len + SZ_4K);
+	ut_assertnonnull(plain_buf);
+	ut_assertnonnull(image);
+	fill_incompressible(plain_buf, unc_len);
+
+	/* Frame header: 128KiB window, 4-byte content size, no checksum */
+	ptr = image;
+	put_unaligned_le32(ZSTD_MAGICNUMBER, ptr);
+	ptr += 4;
+	*ptr++ = 0x80;
+	*ptr++ = (17 - 10) << 3;
+	put_unaligned_le32(unc_len, ptr);
+	ptr += 4;
+
+	for (in = plain_buf, i = 0; i < ARRAY_SIZE(zstd_inplace_blocks); i++) {
+		u32 size = zstd_inplace_blocks[i].size;
+		u32 hdr = size << 3 | (i == ARRAY_SIZE(zstd_inplace_blocks) - 1);
+
+		/* 3-byte block header, then the data or the byte to repeat */
+		if (zstd_inplace_blocks[i].rle) {
+			memset(in, 0x5a, size);
+			put_unaligned_le32(hdr | 1 << 1, ptr);
+			ptr[3] = 0x5a;
+			ptr += 4;
+		} else {
+			put_unaligned_le32(hdr, ptr);
+			memcpy(ptr + 3, in, size);
+			ptr += 3 + size;
+		}
+		in += size;
+	}
+
+	ut_assertok(decomp_inplace(uts, IH_COMP_ZSTD, image, ptr - image,
+				   plain_buf, unc_len));
+	free(image);
+	free(plain_buf);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_zstd_inplace, 0);
+
 static int compress_using_none(struct unit_test_state *uts,
 			       void *in, unsigned long in_size,
 			       void *out, unsigned long out_max,
@@ -9,6 +9,9 @@
 #include <log.h>
 #include <miiphy.h>
 #include <misc.h>
+#include <phy.h>
+#include <time.h>
+#include <asm/test.h>
 #include <dm/test.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -56,3 +59,46 @@ static int dm_test_mdio(struct unit_test_state *uts)
 }
 
 DM_TEST(dm_test_mdio, UT_TESTF_SCAN_FDT);
+
+/* Test that autonegotiation time spent before phy_startup() is counted */
+static int dm_test_mdio_aneg_async(struct unit_test_state *uts)
+{
+	struct phy_device phydev = {};
+	struct udevice *dev;
+	ulong start;
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_MDIO, "mdio-test", &dev));
+	phydev.bus = miiphy_get_dev_by_name(dev->name);
+	ut_assertnonnull(phydev.bus);
+	phydev.dev = dev;
+	phydev.addr = SANDBOX_PHY_ADDR;
+	phydev.autoneg = AUTONEG_ENABLE;
+
+	/* Nothing to report until autonegotiation has been started */
+	ut_assertok(dm_mdio_write(dev, SANDBOX_PHY_ADDR, MDIO_DEVAD_NONE,
+				  MII_BMSR, 0));
+	ut_assertok(phy_poll_link(&phydev));
+	ut_assertok(genphy_restart_aneg(&phydev));
+	ut_assert(phydev.aneg_start);
+	ut_asserteq(-EINPROGRESS, phy_poll_link(&phydev));
+
+	/* Most of the timeout has passed, so only the rest is waited for */
+	timer_test_add_offset(PHY_ANEG_TIMEOUT - 200);
+	start = timer_get_us();
+	ut_asserteq(-ETIMEDOUT, genphy_update_link(&phydev));
+	ut_assert(timer_get_us() - start < PHY_ANEG_TIMEOUT * 1000 / 2);
+	ut_asserteq(0, phydev.link);
+	ut_asserteq(0, phydev.aneg_time);
+
+	/* The link comes up later and the time it took is kept */
+	ut_assertok(dm_mdio_write(dev, SANDBOX_PHY_ADDR, MDIO_DEVAD_NONE,
+				  MII_BMSR, BMSR_ANEGCOMPLETE | BMSR_LSTATUS));
+	ut_assertok(phy_poll_link(&phydev));
+	ut_assert(phydev.aneg_time >= PHY_ANEG_TIMEOUT);
+	ut_assertok(genphy_update_link(&phydev));
+	ut_asserteq(1, phydev.link);
+
+	return 0;
+}
+
+DM_TEST(dm_test_mdio_aneg_async, UT_TESTF_SCAN_FDT);
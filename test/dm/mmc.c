@@ -52,3 +52,30 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Test that starting init does not wait for an SD card to power up */
+static int dm_test_mmc_start_init(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	struct mmc *mmc;
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	mmc = mmc_get_mmc_dev(dev);
+	ut_assertnonnull(mmc);
+
+	mmc->has_init = 0;
+	ut_assertok(mmc_start_init(mmc));
+	ut_asserteq(1, mmc->init_in_progress);
+	ut_asserteq(1, mmc->sd_op_cond_pending);
+	ut_asserteq(0, mmc->has_init);
+
+	ut_assertok(mmc_init(mmc));
+	ut_asserteq(0, mmc->init_in_progress);
+	ut_asserteq(0, mmc->sd_op_cond_pending);
+	ut_asserteq(1, mmc->has_init);
+	ut_assert(IS_SD(mmc));
+	ut_assert(mmc->high_capacity);
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_start_init, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
@@ -3,6 +3,7 @@
 #include <common.h>
 #include <dm.h>
 #include <log.h>
+#include <malloc.h>
 #include <of_live.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
@@ -586,6 +587,35 @@ static int dm_test_ofnode_livetree_writing(struct unit_test_state *uts)
 DM_TEST(dm_test_ofnode_livetree_writing,
 	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT | UT_TESTF_LIVE_OR_FLAT);
 
+static int dm_test_of_write_prop_empty(struct unit_test_state *uts)
+{
+	struct device_node np = { .name = "empty", .full_name = "/empty" };
+	struct property *pp;
+	int len;
+
+	if (!IS_ENABLED(CONFIG_OF_LIVE))
+		return -EAGAIN;
+
+	/* A node built at runtime may have no properties at all */
+	ut_assertok(of_write_prop(&np, "status", 5, "okay"));
+	ut_asserteq_str("okay", of_get_property(&np, "status", &len));
+	ut_asserteq(5, len);
+
+	/* Further properties go after it */
+	ut_assertok(of_write_prop(&np, "reg", 4, "\x00\x00\x00\x42"));
+	ut_asserteq_str("status", np.properties->name);
+	ut_asserteq_str("reg", np.properties->next->name);
+
+	while ((pp = np.properties)) {
+		np.properties = pp->next;
+		free(pp->name);
+		free(pp);
+	}
+
+	return 0;
+}
+DM_TEST(dm_test_of_write_prop_empty, 0);
+
 static int dm_test_ofnode_u32(struct unit_test_state *uts)
 {
 	ofnode node;
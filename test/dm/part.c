@@ -97,3 +97,62 @@ out:
 	return ret;
 }
 DM_TEST(dm_test_part, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Test that a changed GPT is seen, while other writes keep it cached */
+static int dm_test_part_cache(struct unit_test_state *uts)
+{
+	struct blk_desc *mmc_dev_desc;
+	struct disk_partition info;
+	struct disk_partition parts[2] = {
+		{
+			.start = 48,
+			.size = 1,
+			.name = "test1",
+		},
+		{
+			.start = 49,
+			.size = 1,
+			.name = "test2",
+		},
+	};
+	char str_disk_guid[UUID_STR_LEN + 1];
+	u8 buf[512];
+
+	ut_asserteq(1, blk_get_device_by_str("mmc", "1", &mmc_dev_desc));
+	if (CONFIG_IS_ENABLED(RANDOM_UUID)) {
+		gen_rand_uuid_str(parts[0].uuid, UUID_STR_FORMAT_STD);
+		gen_rand_uuid_str(parts[1].uuid, UUID_STR_FORMAT_STD);
+		gen_rand_uuid_str(str_disk_guid, UUID_STR_FORMAT_STD);
+	}
+	ut_assertok(gpt_restore(mmc_dev_desc, str_disk_guid, parts,
+				ARRAY_SIZE(parts)));
+	ut_assertok(part_get_info(mmc_dev_desc, 2, &info));
+	ut_asserteq_str("test2", (char *)info.name);
+
+	/* Writing a partition leaves the table alone */
+	memset(buf, 0xa5, sizeof(buf));
+	ut_asserteq(1, blk_dwrite(mmc_dev_desc, 49, 1, buf));
+	ut_assertok(part_get_info(mmc_dev_desc, 2, &info));
+	ut_asserteq(49, info.start);
+
+	/* A new table must be read again */
+	strcpy((char *)parts[1].name, "other");
+	parts[1].start = 50;
+	ut_assertok(gpt_restore(mmc_dev_desc, str_disk_guid, parts,
+				ARRAY_SIZE(parts)));
+	ut_assertok(part_get_info(mmc_dev_desc, 2, &info));
+	ut_asserteq_str("other", (char *)info.name);
+	ut_asserteq(50, info.start);
+	ut_asserteq(2, part_get_info_by_name(mmc_dev_desc, "other", &info));
+
+	/* So must a table that is wiped out */
+	memset(buf, '\0', sizeof(buf));
+	ut_asserteq(1, blk_dwrite(mmc_dev_desc, 1, 1, buf));
+	ut_asserteq(1, blk_dwrite(mmc_dev_desc, mmc_dev_desc->lba - 1, 1, buf));
+	ut_silence_console(uts);
+	ut_assert(part_get_info(mmc_dev_desc, 2, &info));
+	ut_unsilence_console(uts);
+
+	return 0;
+}
+DM_TEST(dm_test_part_cache, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
@@ -7,11 +7,15 @@
 #include <log.h>
 #include <serial.h>
 #include <dm.h>
+#include <asm/global_data.h>
 #include <asm/serial.h>
 #include <dm/test.h>
+#include <linux/delay.h>
 #include <test/test.h>
 #include <test/ut.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 static const char test_message[] =
 	"This is a test message\n"
 	"consisting of multiple lines\n";
@@ -89,3 +93,67 @@ static int dm_test_serial(struct unit_test_state *uts)
 }
 
 DM_TEST(dm_test_serial, UT_TESTF_SCAN_FDT);
+
+/* Test that output waits in the TX buffer while the UART is busy */
+static int dm_test_serial_tx_buffer(struct unit_test_state *uts)
+{
+	struct serial_tx_stats before, after;
+	size_t start, busy_written, short_written, poll_written, delay_written;
+	struct udevice *dev;
+	ulong reclaimed;
+
+	if (!CONFIG_IS_ENABLED(SERIAL_TX_BUFFER))
+		return -EAGAIN;
+
+	/* serial_puts() etc. write to the console UART */
+	dev = gd->cur_serial_dev;
+	ut_assertnonnull(dev);
+	ut_assertok(serial_get_tx_stats(dev, &before, &reclaimed));
+
+	sandbox_serial_endisable(false);
+	start = sandbox_serial_written();
+
+	/* Output is queued while the UART is busy, without waiting for it */
+	sandbox_serial_set_busy(true);
+	serial_puts(test_message);
+	busy_written = sandbox_serial_written();
+
+	/* Short delays do not touch the UART */
+	sandbox_serial_set_busy(false);
+	udelay(1);
+	short_written = sandbox_serial_written();
+
+	/* Polling sends it once the UART takes it */
+	serial_tx_poll();
+	poll_written = sandbox_serial_written();
+
+	/* So do longer delays */
+	sandbox_serial_set_busy(true);
+	serial_putc('\n');
+	sandbox_serial_set_busy(false);
+	udelay(100);
+	delay_written = sandbox_serial_written();
+
+	/* Flushing sends it too */
+	sandbox_serial_set_busy(true);
+	serial_putc('\n');
+	sandbox_serial_set_busy(false);
+	serial_flush();
+	sandbox_serial_endisable(true);
+
+	ut_asserteq(start, busy_written);
+	ut_asserteq(start, short_written);
+	/* Each newline gets a carriage return in front */
+	ut_asserteq(sizeof(test_message) - 1 + 2, poll_written - start);
+	ut_asserteq(poll_written + 2, delay_written);
+	ut_asserteq(delay_written + 2, sandbox_serial_written());
+
+	ut_assertok(serial_get_tx_stats(dev, &after, &reclaimed));
+	ut_asserteq(sizeof(test_message) - 1 + 6, after.queued - before.queued);
+	ut_asserteq(sizeof(test_message) - 1 + 4, after.idle - before.idle);
+	ut_assert(reclaimed > 0);
+
+	return 0;
+}
+
+DM_TEST(dm_test_serial_tx_buffer, UT_TESTF_SCAN_FDT);
@@ -27,11 +27,13 @@ static int dm_test_spi_flash(struct unit_test_state *uts)
 	u8 *src, *dst;
 	uint map_size;
 	ulong map_base;
+	char fname[256];
 	uint offset;
 	int i;
 
 	src = map_sysmem(0x20000, full_size);
-	ut_assertok(os_write_file("spi.bin", src, full_size));
+	ut_assertok(os_persistent_file(fname, sizeof(fname), "spi.bin"));
+	ut_assertok(os_write_file(fname, src, full_size));
 	ut_assertok(uclass_first_device_err(UCLASS_SPI_FLASH, &dev));
 
 	dst = map_sysmem(0x20000 + full_size, full_size);
@@ -78,6 +80,9 @@ DM_TEST(dm_test_spi_flash, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
 /* Functional test that sandbox SPI flash works correctly */
 static int dm_test_spi_flash_func(struct unit_test_state *uts)
 {
+	char fname[256];
+	char cmd[320];
+
 	/*
 	 * Create an empty test file and run the SPI flash tests. This is a
 	 * long way from being a unit test, but it does test SPI device and
@@ -89,10 +94,12 @@ static int dm_test_spi_flash_func(struct unit_test_state *uts)
 	 * it would make bugs easier to find. It's not clear whether the
 	 * benefit is worth the extra complexity.
 	 */
-	ut_asserteq(0, run_command_list(
-		"host save hostfs - 0 spi.bin 200000;"
-		"sf probe;"
-		"sf test 0 10000", -1,  0));
+	ut_assertok(os_persistent_file(fname, sizeof(fname), "spi.bin"));
+	snprintf(cmd, sizeof(cmd),
+		 "host save hostfs - 0 %s 200000;"
+		 "sf probe;"
+		 "sf test 0 10000", fname);
+	ut_asserteq(0, run_command_list(cmd, -1,  0));
 	/*
 	 * Since we are about to destroy all devices, we must tell sandbox
 	 * to forget the emulation device
@@ -54,8 +54,8 @@ DM_TEST(dm_test_video_base, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
  * size of the compressed data. This provides a pretty good level of
  * certainty and the resulting tests need only check a single value.
  *
- * If the copy framebuffer is enabled, this compares it to the main framebuffer
- * too.
+ * If the copy framebuffer is enabled, this syncs the device and compares the
+ * copy to the main framebuffer too.
  *
  * @uts:	Test state
  * @dev:	Video device
@@ -81,8 +81,12 @@ static int compress_frame_buffer(struct unit_test_state *uts,
 	if (ret)
 		return ret;
 
-	/* Check here that the copy frame buffer is working correctly */
+	/*
+	 * Check here that the copy frame buffer is working correctly. It is
+	 * only updated when syncing.
+	 */
 	if (IS_ENABLED(CONFIG_VIDEO_COPY)) {
+		video_sync(dev, false);
 		ut_assertf(!memcmp(uc_priv->fb, uc_priv->copy_fb,
 				   uc_priv->fb_size),
 				   "Copy framebuffer does not match fb");
@@ -191,6 +195,70 @@ static int dm_test_video_chars(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_video_chars, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
 
+/* Test that only the damaged part of the frame buffer is synced */
+static int dm_test_video_damage(struct unit_test_state *uts)
+{
+	struct vidconsole_priv *vc_priv;
+	struct video_priv *priv;
+	struct udevice *dev, *con;
+	u16 *pix;
+
+	if (!IS_ENABLED(CONFIG_VIDEO_DAMAGE))
+		return -EAGAIN;
+
+	ut_assertok(select_vidconsole(uts, "vidconsole0"));
+	ut_assertok(video_get_nologo(uts, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	priv = dev_get_uclass_priv(dev);
+	vc_priv = dev_get_uclass_priv(con);
+
+	/* Nothing is pending after probing */
+	ut_asserteq(0, priv->damage.xend);
+	ut_asserteq(0, priv->damage.yend);
+
+	/* A character only damages its own cell */
+	vidconsole_putc_xy(con, VID_TO_POS(16), 32, 'a');
+	ut_asserteq(16, priv->damage.xstart);
+	ut_asserteq(32, priv->damage.ystart);
+	ut_asserteq(16 + vc_priv->x_charsize, priv->damage.xend);
+	ut_asserteq(32 + vc_priv->y_charsize, priv->damage.yend);
+
+	/* Further damage grows the bounding box, cropped to the display */
+	video_damage(dev, priv->xsize - 4, 8, 100, 2);
+	ut_asserteq(16, priv->damage.xstart);
+	ut_asserteq(8, priv->damage.ystart);
+	ut_asserteq(priv->xsize, priv->damage.xend);
+	ut_asserteq(32 + vc_priv->y_charsize, priv->damage.yend);
+
+	ut_assertok(video_sync(dev, false));
+	ut_asserteq(0, priv->damage.xend);
+	ut_asserteq(0, priv->damage.yend);
+
+	if (IS_ENABLED(CONFIG_VIDEO_COPY)) {
+		/* A change which is not reported is not copied */
+		pix = priv->fb;
+		*pix = ~*pix;
+		ut_assertok(video_sync(dev, false));
+		ut_assert(*pix != *(u16 *)priv->copy_fb);
+
+		video_damage(dev, 0, 0, 1, 1);
+		ut_assertok(video_sync(dev, false));
+		ut_asserteq(*pix, *(u16 *)priv->copy_fb);
+
+		/* With damage_all set, every sync copies the whole display */
+		priv->damage_all = true;
+		pix = priv->fb + priv->line_length * (priv->ysize - 1);
+		*pix = ~*pix;
+		ut_assertok(video_sync(dev, false));
+		priv->damage_all = false;
+		ut_asserteq(*pix, *(u16 *)(priv->copy_fb +
+				priv->line_length * (priv->ysize - 1)));
+	}
+
+	return 0;
+}
+DM_TEST(dm_test_video_damage, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
 #ifdef CONFIG_VIDEO_ANSI
 #define ANSI_ESC "\x1b"
 /* Test handling of ANSI escape sequences */
@@ -0,0 +1,253 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for loading and hashing partitions with Android Verified Boot
+ *
+ * The partitions live in memory and an unsigned vbmeta image describes the
+ * boot partition, so that the test does not depend on a signed disk image.
+ */
+
+#include <common.h>
+#include <avb_verify.h>
+#include <console.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <linux/kernel.h>
+#include <linux/sizes.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/sha256.h>
+
+/* More than one chunk, and not a multiple of the block size */
+#define BOOT_IMAGE_SIZE		(SZ_1M + SZ_512K + 123)
+/* The partition is larger than the image it holds */
+#define BOOT_PART_SIZE		(SZ_1M + SZ_512K + SZ_4K)
+#define VBMETA_SIZE		SZ_4K
+
+static const u8 test_salt[] = { 0x5a, 0x17, 0x00, 0xc3 };
+
+static u8 *test_boot;
+static u8 *test_vbmeta;
+static uint test_boot_reads;
+
+static u8 *test_find_partition(const char *partition, size_t *sizep)
+{
+	if (!strcmp(partition, "boot")) {
+		*sizep = BOOT_PART_SIZE;
+		return test_boot;
+	}
+	if (!strcmp(partition, "vbmeta")) {
+		*sizep = VBMETA_SIZE;
+		return test_vbmeta;
+	}
+
+	return NULL;
+}
+
+static AvbIOResult test_read_from_partition(AvbOps *ops, const char *partition,
+					    int64_t offset, size_t num_bytes,
+					    void *buffer, size_t *out_num_read)
+{
+	size_t size;
+	u8 *data;
+
+	data = test_find_partition(partition, &size);
+	if (!data)
+		return AVB_IO_RESULT_ERROR_NO_SUCH_PARTITION;
+	if (offset < 0)
+		offset += size;
+	if (offset < 0 || offset > size)
+		return AVB_IO_RESULT_ERROR_RANGE_OUTSIDE_PARTITION;
+
+	num_bytes = min(num_bytes, size - (size_t)offset);
+	memcpy(buffer, data + offset, num_bytes);
+	*out_num_read = num_bytes;
+	if (data == test_boot)
+		test_boot_reads++;
+
+	return AVB_IO_RESULT_OK;
+}
+
+static AvbIOResult test_get_size_of_partition(AvbOps *ops,
+					      const char *partition,
+					      u64 *out_size)
+{
+	size_t size;
+
+	if (!test_find_partition(partition, &size))
+		return AVB_IO_RESULT_ERROR_NO_SUCH_PARTITION;
+	*out_size = size;
+
+	return AVB_IO_RESULT_OK;
+}
+
+static AvbIOResult test_validate_vbmeta_public_key(AvbOps *ops,
+						   const u8 *public_key_data,
+						   size_t public_key_length,
+						   const u8 *metadata,
+						   size_t metadata_length,
+						   bool *out_key_is_trusted)
+{
+	*out_key_is_trusted = true;
+
+	return AVB_IO_RESULT_OK;
+}
+
+static AvbIOResult test_read_rollback_index(AvbOps *ops, size_t location,
+					    u64 *out_rollback_index)
+{
+	*out_rollback_index = 0;
+
+	return AVB_IO_RESULT_OK;
+}
+
+static AvbIOResult test_read_is_device_unlocked(AvbOps *ops,
+						bool *out_is_unlocked)
+{
+	*out_is_unlocked = true;
+
+	return AVB_IO_RESULT_OK;
+}
+
+static AvbIOResult test_get_unique_guid_for_partition(AvbOps *ops,
+						      const char *partition,
+						      char *guid_buf,
+						      size_t guid_buf_size)
+{
+	strlcpy(guid_buf, "1234", guid_buf_size);
+
+	return AVB_IO_RESULT_OK;
+}
+
+/* Build an unsigned vbmeta image with a hash descriptor for the boot image */
+static void test_build_vbmeta(void)
+{
+	AvbVBMetaImageHeader *hdr = (AvbVBMetaImageHeader *)test_vbmeta;
+	AvbHashDescriptor *desc = (AvbHashDescriptor *)(hdr + 1);
+	u8 *name = (u8 *)(desc + 1);
+	sha256_context ctx;
+	size_t desc_size;
+
+	memset(test_vbmeta, '\0', VBMETA_SIZE);
+	desc_size = ALIGN(sizeof(*desc) + strlen("boot") + sizeof(test_salt) +
+			  AVB_SHA256_DIGEST_SIZE, 8);
+
+	memcpy(hdr->magic, AVB_MAGIC, AVB_MAGIC_LEN);
+	hdr->required_libavb_version_major = cpu_to_be32(AVB_VERSION_MAJOR);
+	hdr->auxiliary_data_block_size = cpu_to_be64(ALIGN(desc_size, 64));
+	hdr->algorithm_type = cpu_to_be32(AVB_ALGORITHM_TYPE_NONE);
+	hdr->descriptors_size = cpu_to_be64(desc_size);
+
+	desc->parent_descriptor.tag = cpu_to_be64(AVB_DESCRIPTOR_TAG_HASH);
+	desc->parent_descriptor.num_bytes_following =
+		cpu_to_be64(desc_size - sizeof(AvbDescriptor));
+	desc->image_size = cpu_to_be64(BOOT_IMAGE_SIZE);
+	strcpy((char *)desc->hash_algorithm, "sha256");
+	desc->partition_name_len = cpu_to_be32(strlen("boot"));
+	desc->salt_len = cpu_to_be32(sizeof(test_salt));
+	desc->digest_len = cpu_to_be32(AVB_SHA256_DIGEST_SIZE);
+
+	memcpy(name, "boot", strlen("boot"));
+	memcpy(name + strlen("boot"), test_salt, sizeof(test_salt));
+	sha256_starts(&ctx);
+	sha256_update(&ctx, test_salt, sizeof(test_salt));
+	sha256_update(&ctx, test_boot, BOOT_IMAGE_SIZE);
+	sha256_finish(&ctx, name + strlen("boot") + sizeof(test_salt));
+}
+
+/* Check whether a line containing @str was printed */
+static bool test_console_has(struct unit_test_state *uts, const char *str)
+{
+	bool found = false;
+
+	while (console_record_avail()) {
+		console_record_readline(uts->actual_str,
+					sizeof(uts->actual_str));
+		if (strstr(uts->actual_str, str))
+			found = true;
+	}
+
+	return found;
+}
+
+/*
+ * Verify the boot partition, checking that it is read in pieces into the
+ * preload area and that its hash is checked
+ */
+static int test_verify(struct unit_test_state *uts, AvbOps *ops, bool good)
+{
+	const char * const partitions[] = { "boot", NULL };
+	AvbSlotVerifyData *out_data;
+	AvbPartitionData *part;
+	AvbSlotVerifyResult res;
+
+	avb_preload_reset(ops);
+	test_boot_reads = 0;
+	console_record_reset_enable();
+	res = avb_slot_verify(ops, partitions, "",
+			      AVB_SLOT_VERIFY_FLAGS_ALLOW_VERIFICATION_ERROR,
+			      AVB_HASHTREE_ERROR_MODE_RESTART_AND_INVALIDATE,
+			      &out_data);
+
+	/* The vbmeta image is not signed, so this is never a clean pass */
+	ut_asserteq(AVB_SLOT_VERIFY_RESULT_ERROR_VERIFICATION, res);
+	ut_asserteq(!good,
+		    test_console_has(uts, "boot: Hash of data does not match"));
+	ut_assert(test_boot_reads > 1);
+
+	ut_assertnonnull(out_data);
+	ut_asserteq(1, out_data->num_loaded_partitions);
+	part = &out_data->loaded_partitions[0];
+	ut_asserteq_str("boot", part->partition_name);
+	ut_assert(part->preloaded);
+	ut_asserteq(CONFIG_AVB_PRELOAD_ADDR, map_to_sysmem(part->data));
+	ut_asserteq(BOOT_PART_SIZE, part->data_size);
+	ut_asserteq_mem(test_boot, part->data, BOOT_PART_SIZE);
+	avb_slot_verify_data_free(out_data);
+
+	return 0;
+}
+
+static int lib_test_avb_load_hash(struct unit_test_state *uts)
+{
+	AvbOps *ops;
+	int i;
+
+	if (CONFIG_AVB_PRELOAD_SIZE < BOOT_PART_SIZE)
+		return -EAGAIN;
+
+	test_boot = malloc(BOOT_PART_SIZE);
+	test_vbmeta = malloc(VBMETA_SIZE);
+	ut_assertnonnull(test_boot);
+	ut_assertnonnull(test_vbmeta);
+	for (i = 0; i < BOOT_PART_SIZE; i++)
+		test_boot[i] = i * 7 + (i >> 10);
+	test_build_vbmeta();
+
+	ops = avb_ops_alloc(0);
+	ut_assertnonnull(ops);
+	ops->read_from_partition = test_read_from_partition;
+	ops->get_size_of_partition = test_get_size_of_partition;
+	ops->validate_vbmeta_public_key = test_validate_vbmeta_public_key;
+	ops->read_rollback_index = test_read_rollback_index;
+	ops->read_is_device_unlocked = test_read_is_device_unlocked;
+	ops->get_unique_guid_for_partition = test_get_unique_guid_for_partition;
+
+	ut_assertok(test_verify(uts, ops, true));
+
+	/* A change after the first chunk must still be noticed */
+	test_boot[SZ_1M + 5] ^= 0x80;
+	ut_assertok(test_verify(uts, ops, false));
+
+	/* Data past the image size in the descriptor is not hashed */
+	test_boot[SZ_1M + 5] ^= 0x80;
+	test_boot[BOOT_IMAGE_SIZE] ^= 0x80;
+	ut_assertok(test_verify(uts, ops, true));
+
+	avb_ops_free(ops);
+	free(test_vbmeta);
+	free(test_boot);
+
+	return 0;
+}
+LIB_TEST(lib_test_avb_load_hash, UT_TESTF_CONSOLE_REC);
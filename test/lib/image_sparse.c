@@ -0,0 +1,343 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Test writing Android sparse images to a sandbox host block device
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <image-sparse.h>
+#include <malloc.h>
+#include <os.h>
+#include <sandboxblockdev.h>
+#include <sparse_format.h>
+#include <time.h>
+#include <asm/cache.h>
+#include <linux/sizes.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define SPARSE_TEST_FILE	"sparse_test.img"
+#define SPARSE_TEST_DISK_SIZE	SZ_16M
+#define SPARSE_TEST_BLK_SZ	4096
+/* Partition start and erase group in 512-byte sectors, deliberately odd */
+#define SPARSE_TEST_START	72
+#define SPARSE_TEST_ERASE_GRP	16
+#define SPARSE_TEST_OLD		0xa5
+
+/* Chunks of the test image: type, size in sparse blocks, fill value */
+static const struct {
+	u16 type;
+	u32 blocks;
+	u32 fill;
+} sparse_test_chunks[] = {
+	{ CHUNK_TYPE_RAW, 512 },
+	{ CHUNK_TYPE_FILL, 256, 0 },
+	{ CHUNK_TYPE_FILL, 256, 0xdeadbeef },
+	{ CHUNK_TYPE_DONT_CARE, 256 },
+	{ CHUNK_TYPE_RAW, 512 },
+};
+
+static lbaint_t sparse_test_write(struct sparse_storage *info, lbaint_t blk,
+				  lbaint_t blkcnt, const void *buffer)
+{
+	return blk_dwrite(info->priv, blk, blkcnt, buffer);
+}
+
+static lbaint_t sparse_test_reserve(struct sparse_storage *info,
+				    lbaint_t blk, lbaint_t blkcnt)
+{
+	return blkcnt;
+}
+
+static lbaint_t sparse_test_erase(struct sparse_storage *info, lbaint_t blk,
+				  lbaint_t blkcnt)
+{
+	return blk_derase(info->priv, blk, blkcnt);
+}
+
+static u8 sparse_test_byte(uint i)
+{
+	return i * 7 + (i >> 12);
+}
+
+/* Build the test image at @buf, returning its size */
+static size_t sparse_test_image(void *buf, u32 *total_blks)
+{
+	sparse_header_t *hdr = buf;
+	chunk_header_t *chunk;
+	void *ptr = buf + sizeof(*hdr);
+	uint i, j, raw = 0;
+
+	*total_blks = 0;
+	for (i = 0; i < ARRAY_SIZE(sparse_test_chunks); i++) {
+		u32 size = sparse_test_chunks[i].blocks * SPARSE_TEST_BLK_SZ;
+
+		chunk = ptr;
+		chunk->chunk_type = sparse_test_chunks[i].type;
+		chunk->reserved1 = 0;
+		chunk->chunk_sz = sparse_test_chunks[i].blocks;
+		chunk->total_sz = sizeof(*chunk);
+		ptr += sizeof(*chunk);
+
+		switch (chunk->chunk_type) {
+		case CHUNK_TYPE_RAW:
+			for (j = 0; j < size; j++)
+				((u8 *)ptr)[j] = sparse_test_byte(raw++);
+			chunk->total_sz += size;
+			break;
+		case CHUNK_TYPE_FILL:
+			memcpy(ptr, &sparse_test_chunks[i].fill, sizeof(u32));
+			chunk->total_sz += sizeof(u32);
+			break;
+		}
+		ptr += chunk->total_sz - sizeof(*chunk);
+		*total_blks += chunk->chunk_sz;
+	}
+
+	hdr->magic = SPARSE_HEADER_MAGIC;
+	hdr->major_version = 1;
+	hdr->minor_version = 0;
+	hdr->file_hdr_sz = sizeof(*hdr);
+	hdr->chunk_hdr_sz = sizeof(*chunk);
+	hdr->blk_sz = SPARSE_TEST_BLK_SZ;
+	hdr->total_blks = *total_blks;
+	hdr->total_chunks = ARRAY_SIZE(sparse_test_chunks);
+	hdr->image_checksum = 0;
+
+	return ptr - buf;
+}
+
+/* Check that the partition holds the test image, @discard if it was used */
+static int sparse_test_check(struct unit_test_state *uts,
+			     struct blk_desc *desc, u8 *buf, bool discard)
+{
+	lbaint_t blk = SPARSE_TEST_START;
+	lbaint_t first, last, sector;
+	uint i, j, raw = 0;
+
+	for (i = 0; i < ARRAY_SIZE(sparse_test_chunks); i++) {
+		u32 size = sparse_test_chunks[i].blocks * SPARSE_TEST_BLK_SZ;
+		lbaint_t count = size / desc->blksz;
+		u32 fill = sparse_test_chunks[i].fill;
+
+		/* Only whole erase groups are discarded */
+		first = roundup(blk, SPARSE_TEST_ERASE_GRP);
+		last = rounddown(blk + count, SPARSE_TEST_ERASE_GRP);
+
+		ut_asserteq(count, blk_dread(desc, blk, count, buf));
+		for (j = 0; j < size; j++) {
+			u8 expect;
+
+			switch (sparse_test_chunks[i].type) {
+			case CHUNK_TYPE_RAW:
+				expect = sparse_test_byte(raw++);
+				break;
+			case CHUNK_TYPE_FILL:
+				expect = ((u8 *)&fill)[j % sizeof(fill)];
+				break;
+			default:
+				sector = blk + j / desc->blksz;
+				if (discard && sector >= first && sector < last)
+					expect = 0;
+				else
+					expect = SPARSE_TEST_OLD;
+			}
+			ut_assertf(buf[j] == expect,
+				   "chunk %u byte %u: expected %x, got %x\n",
+				   i, j, expect, buf[j]);
+		}
+		blk += count;
+	}
+
+	/* Nothing after the image may be touched */
+	ut_asserteq(1, blk_dread(desc, blk, 1, buf));
+	for (j = 0; j < desc->blksz; j++)
+		ut_asserteq(SPARSE_TEST_OLD, buf[j]);
+
+	return 0;
+}
+
+/* Put old data everywhere so that untouched blocks can be spotted */
+static int sparse_test_reset(struct unit_test_state *uts,
+			     struct blk_desc *desc, u8 *buf,
+			     struct sparse_storage *info)
+{
+	lbaint_t blk;
+
+	memset(buf, SPARSE_TEST_OLD, SZ_1M);
+	for (blk = 0; blk < desc->lba; blk += SZ_1M / desc->blksz)
+		ut_asserteq(SZ_1M / desc->blksz,
+			    blk_dwrite(desc, blk, SZ_1M / desc->blksz, buf));
+
+	memset(info, '\0', sizeof(*info));
+	info->blksz = desc->blksz;
+	info->start = SPARSE_TEST_START;
+	info->size = desc->lba - SPARSE_TEST_START;
+	info->priv = desc;
+	info->write = sparse_test_write;
+	info->reserve = sparse_test_reserve;
+
+	return 0;
+}
+
+static int sparse_test_flash(struct unit_test_state *uts,
+			     struct blk_desc *desc, void *image, u8 *buf,
+			     bool discard, const char *desc_str)
+{
+	struct sparse_storage info;
+	ulong start, duration;
+	u32 total_blks;
+
+	ut_assertok(sparse_test_reset(uts, desc, buf, &info));
+	sparse_test_image(image, &total_blks);
+	if (discard) {
+		info.erase = sparse_test_erase;
+		info.erase_grp = SPARSE_TEST_ERASE_GRP;
+		info.erase_zero = true;
+	}
+
+	start = timer_get_us();
+	ut_assertok(write_sparse_image(&info, "test", image, NULL));
+	duration = timer_get_us() - start;
+
+	printf("%s: %u KiB in %lu us, %lu MB/s\n", desc_str,
+	       total_blks * SPARSE_TEST_BLK_SZ / 1024, duration,
+	       duration ? (ulong)total_blks * SPARSE_TEST_BLK_SZ / duration :
+	       0);
+
+	return sparse_test_check(uts, desc, buf, discard);
+}
+
+static lbaint_t sparse_test_write_fail(struct sparse_storage *info,
+				       lbaint_t blk, lbaint_t blkcnt,
+				       const void *buffer)
+{
+	return -EIO;
+}
+
+/*
+ * Pieces to feed to the stream writer: the first two split the sparse
+ * header and the first chunk header, the rest are odd sizes which keep
+ * landing in the middle of headers, FILL values and storage blocks.
+ */
+static const uint sparse_test_pieces[] = { 3, 30, 1, 4093, 12, 511, 8191 };
+
+/* Write the test image through sparse_stream_write() in @pieces */
+static int sparse_test_stream(struct unit_test_state *uts,
+			      struct sparse_storage *info, const u8 *image,
+			      size_t size)
+{
+	struct sparse_stream ss;
+	size_t pos, len;
+	uint i;
+	int ret = 0;
+
+	ut_assertok(sparse_stream_init(&ss, info, "test", size, NULL));
+	for (pos = 0, i = 0; pos < size && !ret; pos += len, i++) {
+		len = min_t(size_t, size - pos,
+			    sparse_test_pieces[i % ARRAY_SIZE(sparse_test_pieces)]);
+		ret = sparse_stream_write(&ss, image + pos, len, NULL);
+	}
+
+	return sparse_stream_finish(&ss, NULL) ?: ret;
+}
+
+/* Test sparse_stream_write() with the image split at awkward places */
+static int sparse_test_stream_write(struct unit_test_state *uts,
+				    struct blk_desc *desc, u8 *image, u8 *buf)
+{
+	struct sparse_storage info;
+	u32 total_blks;
+	size_t size;
+
+	ut_assertok(sparse_test_reset(uts, desc, buf, &info));
+	size = sparse_test_image(image, &total_blks);
+	ut_assertok(sparse_test_stream(uts, &info, image, size));
+	ut_assertok(sparse_test_check(uts, desc, buf, false));
+
+	/* A failing write must be reported, not counted as blocks written */
+	info.write = sparse_test_write_fail;
+	ut_assert(sparse_test_stream(uts, &info, image, size));
+
+	return 0;
+}
+
+static int sparse_test_setup(struct unit_test_state *uts,
+			     struct blk_desc **descp, u8 **imagep, u8 **bufp)
+{
+	char fname[256];
+	int fd, i;
+
+	ut_assertok(os_persistent_file(fname, sizeof(fname), SPARSE_TEST_FILE));
+	fd = os_open(fname, OS_O_RDWR | OS_O_CREAT | OS_O_TRUNC);
+	ut_assert(fd >= 0);
+	*bufp = calloc(1, SZ_2M);
+	ut_assertnonnull(*bufp);
+	for (i = 0; i < SPARSE_TEST_DISK_SIZE / SZ_1M; i++)
+		ut_asserteq(SZ_1M, os_write(fd, *bufp, SZ_1M));
+	os_close(fd);
+
+	ut_assertok(host_dev_bind(0, fname, false));
+	*descp = blk_get_devnum_by_type(IF_TYPE_HOST, 0);
+	ut_assertnonnull(*descp);
+
+	*imagep = memalign(ARCH_DMA_MINALIGN, SZ_8M);
+	ut_assertnonnull(*imagep);
+
+	return 0;
+}
+
+static void sparse_test_teardown(u8 *image, u8 *buf)
+{
+	char fname[256];
+
+	free(image);
+	free(buf);
+	host_dev_bind(0, NULL, false);
+	if (!os_persistent_file(fname, sizeof(fname), SPARSE_TEST_FILE))
+		os_unlink(fname);
+}
+
+/* Test write_sparse_image() with and without zero-copy and discard */
+static int lib_test_sparse_write(struct unit_test_state *uts)
+{
+	struct blk_desc *desc;
+	u8 *image, *buf;
+	int ret;
+
+	ut_assertok(sparse_test_setup(uts, &desc, &image, &buf));
+
+	/*
+	 * The first RAW chunk follows the two headers, so shift the image to
+	 * align its data for DMA; the second RAW chunk stays unaligned.
+	 */
+	ret = sparse_test_flash(uts, desc,
+				image + ARCH_DMA_MINALIGN -
+				(sizeof(sparse_header_t) +
+				 sizeof(chunk_header_t)) % ARCH_DMA_MINALIGN,
+				buf, true, "aligned, discard");
+	if (!ret)
+		ret = sparse_test_flash(uts, desc, image + 1, buf, false,
+					"unaligned");
+
+	sparse_test_teardown(image, buf);
+
+	return ret;
+}
+LIB_TEST(lib_test_sparse_write, 0);
+
+/* Test writing a sparse image as it arrives, in odd-sized pieces */
+static int lib_test_sparse_stream(struct unit_test_state *uts)
+{
+	struct blk_desc *desc;
+	u8 *image, *buf;
+	int ret;
+
+	ut_assertok(sparse_test_setup(uts, &desc, &image, &buf));
+	ret = sparse_test_stream_write(uts, desc, image + 1, buf);
+	sparse_test_teardown(image, buf);
+
+	return ret;
+}
+LIB_TEST(lib_test_sparse_stream, 0);
@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for CRC-32 and CRC-32C
+ *
+ * The results are checked against known answers and against a simple
+ * bit-at-a-time implementation, across the lengths and alignments where the
+ * optimised code changes strategy.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <time.h>
+#include <linux/sizes.h>
+#include <u-boot/crc.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define CRC32_POLY	0xedb88320
+#define CRC32C_POLY	0x82f63b78
+
+static const char check_str[] = "123456789";
+
+/* Lengths either side of the word size and of three 1KiB streams */
+static const uint check_len[] = {
+	0, 1, 7, 8, 9, 63, 3071, 3072, 3073, 3079, 6144, 6151, 9300,
+};
+
+static u32 crc_bitwise(u32 crc, const u8 *p, uint len, u32 poly)
+{
+	int i;
+
+	while (len--) {
+		crc ^= *p++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ ((crc & 1) ? poly : 0);
+	}
+
+	return crc;
+}
+
+static void fill_buf(u8 *buf, uint size)
+{
+	u32 seed = 0x12345678;
+	uint i;
+
+	for (i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		buf[i] = seed >> 16;
+	}
+}
+
+static int lib_test_crc32_kat(struct unit_test_state *uts)
+{
+	const u8 *str = (const u8 *)check_str;
+
+	ut_asserteq(0xcbf43926, crc32(0, str, strlen(check_str)));
+	ut_asserteq(0, crc32(0, str, 0));
+	if (IS_ENABLED(CONFIG_CRC32C))
+		ut_asserteq(0xe3069283, ~crc32c(~0, str, strlen(check_str)));
+
+	return 0;
+}
+LIB_TEST(lib_test_crc32_kat, 0);
+
+static int lib_test_crc32_lengths(struct unit_test_state *uts)
+{
+	const uint size = 9300 + 8;
+	uint i, ofs, len;
+	u8 *buf;
+
+	buf = malloc(size);
+	ut_assertnonnull(buf);
+	fill_buf(buf, size);
+
+	for (i = 0; i < ARRAY_SIZE(check_len); i++) {
+		len = check_len[i];
+		for (ofs = 0; ofs < 8; ofs++) {
+			ut_asserteq(crc_bitwise(0x5a5a5a5a, buf + ofs, len,
+						CRC32_POLY),
+				    crc32_no_comp(0x5a5a5a5a, buf + ofs, len));
+			if (!IS_ENABLED(CONFIG_CRC32C))
+				continue;
+			ut_asserteq(crc_bitwise(0x5a5a5a5a, buf + ofs, len,
+						CRC32C_POLY),
+				    crc32c(0x5a5a5a5a, buf + ofs, len));
+		}
+	}
+
+	/* Splitting the buffer anywhere gives the same result */
+	for (i = 0; i < size; i += 997)
+		ut_asserteq(crc32(0, buf, size),
+			    crc32(crc32(0, buf, i), buf + i, size - i));
+
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_crc32_lengths, 0);
+
+static int lib_test_crc32_speed(struct unit_test_state *uts)
+{
+	const uint size = SZ_4M;
+	ulong start, us;
+	u8 *buf;
+	u32 crc;
+
+	buf = malloc(size);
+	ut_assertnonnull(buf);
+	fill_buf(buf, size);
+
+	start = timer_get_us();
+	crc = crc32(0, buf, size);
+	us = max(timer_get_us() - start, 1UL);
+	printf("crc32:  %u bytes in %lu us, %lu MB/s (%08x)\n", size, us,
+	       size / us, crc);
+
+	if (IS_ENABLED(CONFIG_CRC32C)) {
+		start = timer_get_us();
+		crc = crc32c(~0, buf, size);
+		us = max(timer_get_us() - start, 1UL);
+		printf("crc32c: %u bytes in %lu us, %lu MB/s (%08x)\n", size,
+		       us, size / us, crc);
+	}
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_crc32_speed, 0);
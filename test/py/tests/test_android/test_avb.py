@@ -135,3 +135,36 @@ def test_avb_persistent_values(u_boot_console):
 
     response = u_boot_console.run_command('avb read_pvalue test 12')
     assert response == 'Read 12 bytes, value = value_value'
+
+
+@pytest.mark.buildconfigspec('cmd_avb')
+@pytest.mark.buildconfigspec('cmd_mmc')
+@pytest.mark.notbuildconfigspec('sandbox')
+def test_avb_verify_preload(u_boot_console):
+    """Check that 'avb verify' leaves the verified boot partition in the
+    preload area, with the same contents as on the MMC
+
+    Sandbox has no vbmeta partition to verify; 'ut lib avb_load_hash' covers
+    the preload area there.
+    """
+
+    preload = u_boot_console.config.buildconfig.get('config_avb_preload_size',
+                                                    '0x0')
+    if not int(preload, 16):
+        pytest.skip('AVB preload area not configured')
+
+    success_str = 'Verification passed successfully'
+
+    response = u_boot_console.run_command('avb init %s' %str(mmc_dev))
+    assert response == ''
+    response = u_boot_console.run_command('avb verify')
+    assert success_str in response
+
+    response = u_boot_console.run_command('printenv avb_boot_addr')
+    assert 'avb_boot_addr=' in response
+    response = u_boot_console.run_command(
+        'avb read_part boot 0 ${avb_boot_size} 0x%x' % temp_addr)
+    assert 'Read' in response
+    response = u_boot_console.run_command(
+        'cmp.b ${avb_boot_addr} 0x%x ${avb_boot_size}' % temp_addr)
+    assert 'were the same' in response
@@ -31,10 +31,12 @@ def efi_capsule_data(request, u_boot_config):
     data_dir = mnt_point + CAPSULE_DATA_DIR
     install_dir = mnt_point + CAPSULE_INSTALL_DIR
     image_path = u_boot_config.persistent_data_dir + '/test_efi_capsule.img'
+    spi_path = u_boot_config.persistent_data_dir + '/spi.bin'
 
     try:
         # Create a target device
-        check_call('dd if=/dev/zero of=./spi.bin bs=1MiB count=16', shell=True)
+        check_call('dd if=/dev/zero of=%s bs=1MiB count=16' % spi_path,
+                   shell=True)
 
         check_call('rm -rf %s' % mnt_point, shell=True)
         check_call('mkdir -p %s' % data_dir, shell=True)
@@ -146,4 +148,4 @@ def efi_capsule_data(request, u_boot_config):
     finally:
         call('rm -rf %s' % mnt_point, shell=True)
         call('rm -f %s' % image_path, shell=True)
-        call('rm -f ./spi.bin', shell=True)
+        call('rm -f %s' % spi_path, shell=True)
@@ -0,0 +1,128 @@
+# SPDX-License-Identifier:	GPL-2.0+
+
+"""
+Check that mkimage produces the same FIT whatever the number of jobs
+
+mkimage -j computes the hashes and signatures of the images in threads but
+must write them in the same order as a serial run. This builds a FIT with
+several hashed and signed images with one and with four jobs and checks that
+the two files are byte-identical.
+
+Encrypted images are left out: unless an iv-name-hint is given, each run picks
+a random IV for them, so not even two serial runs give the same FIT.
+This test doesn't run the sandbox. It only checks the host tool 'mkimage'
+"""
+
+import os
+import random
+
+import pytest
+import u_boot_utils as util
+
+# Number of images in the FIT
+NUM_IMAGES = 6
+
+IMAGE_NODE = '''
+		kernel-%(idx)d {
+			data = /incbin/("%(fname)s");
+			type = "kernel_noload";
+			arch = "sandbox";
+			os = "linux";
+			compression = "none";
+			load = <0x4>;
+			entry = <0x8>;
+			hash-1 {
+				algo = "sha256";
+			};
+			hash-2 {
+				algo = "crc32";
+			};
+			signature {
+				algo = "sha256,rsa2048";
+				key-name-hint = "dev";
+			};
+		};
+'''
+
+FIT_ITS = '''/dts-v1/;
+
+/ {
+	description = "FIT with several signed images";
+	#address-cells = <1>;
+
+	images {
+%(images)s
+	};
+	configurations {
+		default = "conf-1";
+		conf-1 {
+			kernel = "kernel-1";
+			signature {
+				algo = "sha256,rsa2048";
+				key-name-hint = "dev";
+				sign-images = "kernel";
+			};
+		};
+	};
+};
+'''
+
+@pytest.mark.buildconfigspec('fit_signature')
+@pytest.mark.requiredtool('dtc')
+@pytest.mark.requiredtool('openssl')
+def test_mkimage_jobs(u_boot_console):
+    """Test that mkimage -j 4 writes the same FIT as mkimage -j 1"""
+
+    def make_fit(jobs):
+        """Build the FIT with the given number of jobs
+
+        Args:
+            jobs (int): Number of jobs to pass to mkimage
+
+        Returns:
+            bytes: Contents of the FIT
+        """
+        fit = os.path.join(tempdir, 'jobs-%d.fit' % jobs)
+        util.run_and_log(cons, [mkimage, '-D', dtc_args, '-k', tempdir,
+                                '-j', str(jobs), '-f', its, fit])
+        with open(fit, 'rb') as inf:
+            return inf.read()
+
+    cons = u_boot_console
+    mkimage = cons.config.build_dir + '/tools/mkimage'
+    tempdir = os.path.join(cons.config.result_dir, 'fit-jobs')
+    os.makedirs(tempdir, exist_ok=True)
+    dtc_args = '-I dts -O dtb -i %s' % tempdir
+
+    util.run_and_log(cons, 'openssl genpkey -algorithm RSA -out %s/dev.key '
+                     '-pkeyopt rsa_keygen_bits:2048 '
+                     '-pkeyopt rsa_keygen_pubexp:65537' % tempdir)
+    util.run_and_log(cons, 'openssl req -batch -new -x509 -key %s/dev.key '
+                     '-out %s/dev.crt' % (tempdir, tempdir))
+
+    # Images of different sizes, so that the jobs finish out of order
+    rand = random.Random(0)
+    images = ''
+    for idx in range(1, NUM_IMAGES + 1):
+        fname = 'kernel-%d.bin' % idx
+        with open(os.path.join(tempdir, fname), 'wb') as outf:
+            outf.write(bytes(rand.getrandbits(8)
+                             for _ in range(idx * 37 * 1024)))
+        images += IMAGE_NODE % {'idx': idx, 'fname': fname}
+    its = os.path.join(tempdir, 'jobs.its')
+    with open(its, 'w') as outf:
+        outf.write(FIT_ITS % {'images': images})
+
+    # Keep the timestamps the same in both runs
+    old_epoch = os.environ.get('SOURCE_DATE_EPOCH')
+    os.environ['SOURCE_DATE_EPOCH'] = '1600000000'
+    try:
+        serial = make_fit(1)
+        parallel = make_fit(4)
+    finally:
+        if old_epoch is None:
+            del os.environ['SOURCE_DATE_EPOCH']
+        else:
+            os.environ['SOURCE_DATE_EPOCH'] = old_epoch
+
+    assert serial == parallel
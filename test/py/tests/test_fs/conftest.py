@@ -15,6 +15,7 @@ supported_fs_ext = ['fat16', 'fat32']
 supported_fs_mkdir = ['fat16', 'fat32']
 supported_fs_unlink = ['fat16', 'fat32']
 supported_fs_symlink = ['ext4']
+supported_fs_alloc = ['fat16', 'fat32']
 
 #
 # Filesystem test specific setup
@@ -51,6 +52,7 @@ def pytest_configure(config):
     global supported_fs_mkdir
     global supported_fs_unlink
     global supported_fs_symlink
+    global supported_fs_alloc
 
     def intersect(listA, listB):
         return  [x for x in listA if x in listB]
@@ -63,6 +65,7 @@ def pytest_configure(config):
         supported_fs_mkdir =  intersect(supported_fs, supported_fs_mkdir)
         supported_fs_unlink =  intersect(supported_fs, supported_fs_unlink)
         supported_fs_symlink =  intersect(supported_fs, supported_fs_symlink)
+        supported_fs_alloc =  intersect(supported_fs, supported_fs_alloc)
 
 def pytest_generate_tests(metafunc):
     """Parametrize fixtures, fs_obj_xxx
@@ -91,6 +94,9 @@ def pytest_generate_tests(metafunc):
     if 'fs_obj_symlink' in metafunc.fixturenames:
         metafunc.parametrize('fs_obj_symlink', supported_fs_symlink,
             indirect=True, scope='module')
+    if 'fs_obj_alloc' in metafunc.fixturenames:
+        metafunc.parametrize('fs_obj_alloc', supported_fs_alloc,
+            indirect=True, scope='module')
 
 #
 # Helper functions
@@ -670,3 +676,52 @@ def fs_obj_symlink(request, u_boot_config):
     finally:
         call('rmdir %s' % mount_dir, shell=True)
         call('rm -f %s' % fs_img, shell=True)
+
+#
+# Fixture for FAT allocation test
+#
+@pytest.fixture()
+def fs_obj_alloc(request, u_boot_config):
+    """Set up a file system to be used in FAT allocation test.
+
+    Args:
+        request: Pytest request object.
+        u_boot_config: U-boot configuration.
+
+    Return:
+        A fixture for FAT allocation test, i.e. a quadruplet of file system
+        type, volume file name, data file name and its MD5 hash.
+    """
+    fs_type = request.param
+    fs_img = ''
+
+    fs_ubtype = fstype_to_ubname(fs_type)
+    check_ubconfig(u_boot_config, fs_ubtype)
+
+    data_file = u_boot_config.persistent_data_dir + '/alloc.data'
+
+    try:
+        # 64MiB volume, large enough for mkfs to make a FAT32 one
+        fs_img = mk_fs(u_boot_config, fs_type, 0x4000000, '64MB')
+    except CalledProcessError as err:
+        pytest.skip('Creating failed for filesystem: ' + fs_type + '. {}'.format(err))
+        return
+
+    # mk_fs() has added /sbin to the PATH
+    if not tool_is_in_path('fsck.fat'):
+        call('rm -f %s' % fs_img, shell=True)
+        pytest.skip('fsck.fat not found')
+        return
+
+    try:
+        check_call('dd if=/dev/urandom of=%s bs=1M count=1'
+                   % data_file, shell=True)
+        out = check_output('md5sum %s' % data_file, shell=True).decode()
+        md5val = out.split()[0]
+    except CalledProcessError:
+        pytest.skip('Setup failed for filesystem: ' + fs_type)
+        return
+    else:
+        yield [fs_ubtype, fs_img, data_file, md5val]
+    finally:
+        call('rm -f %s %s' % (data_file, fs_img), shell=True)
@@ -290,3 +290,30 @@ class TestFsBasic(object):
                 'setenv filesize'])
             assert(md5val[0] in ''.join(output))
             assert_fs_integrity(fs_type, fs_img)
+
+    def test_fs14(self, u_boot_console, fs_obj_basic):
+        """
+        Test Case 14 - write a large file in one go
+        """
+        fs_type,fs_img,md5val = fs_obj_basic
+        with u_boot_console.log.section('Test Case 14 - write (large)'):
+            # Test Case 14a - Check if command successfully returned
+            output = u_boot_console.run_command_list([
+                'host bind 0 %s' % fs_img,
+                'mw.l %x deadbeef 800000' % ADDR,
+                '%swrite host 0:0 %x /%s.w14 2000000'
+                    % (fs_type, ADDR, SMALL_FILE)])
+            assert('33554432 bytes written' in ''.join(output))
+            # Log the write rate so that runs can be compared
+            rate = re.search(r'\(([0-9.]+ [KMG]?i?B/s)\)', ''.join(output))
+            if rate:
+                u_boot_console.log.info('write rate: %s' % rate.group(1))
+
+            # Test Case 14b - Check file content
+            output = u_boot_console.run_command_list([
+                '%sload host 0:0 %x /%s.w14' % (fs_type, ADDR + 0x2000000,
+                                                SMALL_FILE),
+                'cmp.b %x %x 2000000' % (ADDR, ADDR + 0x2000000)])
+            assert('Total of 33554432 byte(s) were the same' in
+                   ''.join(output))
+            assert_fs_integrity(fs_type, fs_img)
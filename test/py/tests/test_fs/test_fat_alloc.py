@@ -0,0 +1,182 @@
+# SPDX-License-Identifier:      GPL-2.0+
+#
+# U-Boot File System: FAT cluster allocation Test
+
+"""
+This test fills a FAT volume, deletes every other file and writes files
+which have to be split over the holes left behind. It checks the data read
+back, runs fsck.fat and, on FAT32, checks that the FSInfo free cluster count
+matches the FAT and that the next-free hint is in range.
+"""
+
+import struct
+import pytest
+from subprocess import check_call
+from fstest_defs import *
+
+# Size of the files used to fill the volume
+FILL_SIZE = 0x40000
+
+# Size of the file which is split over the holes
+FRAG_SIZE = 0x100000
+
+# Address the data file is loaded to, the files are read back after it
+DATA_ADDR = ADDR
+READ_ADDR = ADDR + 0x200000
+
+FSINFO_LEAD_SIG = 0x41615252
+FSINFO_STRUCT_SIG = 0x61417272
+FSINFO_TRAIL_SIG = 0xaa550000
+FSINFO_UNKNOWN = 0xffffffff
+
+def fat_geometry(fs_img):
+    """Read the layout of a FAT volume from its boot sector
+
+    Args:
+        fs_img: Volume file name.
+
+    Return:
+        A dict with the sector size, cluster size, number of clusters, offset
+        and size of the first FAT and, on FAT32, the FSInfo sector number.
+    """
+    with open(fs_img, 'rb') as fd:
+        bs = fd.read(512)
+    sect_size, clust_sects, rsvd, nr_fats, root_ents, total16, fat_size16 = \
+        struct.unpack_from('<HBHBHHxH', bs, 11)
+    total32, fat_size32, _, _, _, fsinfo = \
+        struct.unpack_from('<IIHHIH', bs, 32)
+    total = total16 or total32
+    fat_size = fat_size16 or fat_size32
+    root_sects = (root_ents * 32 + sect_size - 1) // sect_size
+    data_start = rsvd + nr_fats * fat_size + root_sects
+    return {
+        'sect_size': sect_size,
+        'clust_size': clust_sects * sect_size,
+        'clust_count': (total - data_start) // clust_sects,
+        'fat_offset': rsvd * sect_size,
+        'fat_size': fat_size * sect_size,
+        'fat32': fat_size16 == 0,
+        'fsinfo': fsinfo,
+    }
+
+def assert_fat_fsinfo(fs_img):
+    """Check the FSInfo sector of a FAT32 volume against its FAT
+
+    Args:
+        fs_img: Volume file name.
+
+    Return:
+        Nothing.
+    """
+    geo = fat_geometry(fs_img)
+    if not geo['fat32']:
+        return
+
+    with open(fs_img, 'rb') as fd:
+        fd.seek(geo['fat_offset'])
+        fat = fd.read(geo['fat_size'])
+        fd.seek(geo['fsinfo'] * geo['sect_size'])
+        info = fd.read(512)
+
+    # Clusters are numbered from 2
+    last = geo['clust_count'] + 1
+    entries = struct.unpack_from('<%dI' % (last + 1), fat)
+    free = sum(1 for ent in entries[2:] if not ent & 0x0fffffff)
+
+    lead_sig, = struct.unpack_from('<I', info, 0)
+    struct_sig, free_count, next_free = struct.unpack_from('<III', info, 484)
+    trail_sig, = struct.unpack_from('<I', info, 508)
+    assert lead_sig == FSINFO_LEAD_SIG
+    assert struct_sig == FSINFO_STRUCT_SIG
+    assert trail_sig == FSINFO_TRAIL_SIG
+    assert free_count == free
+    assert next_free == FSINFO_UNKNOWN or 2 <= next_free <= last
+
+def assert_fat_integrity(fs_img):
+    check_call('fsck.fat -n %s' % fs_img, shell=True)
+    assert_fat_fsinfo(fs_img)
+
+def fill_count(fs_img):
+    """Number of fill files which leave less than one of them free"""
+    geo = fat_geometry(fs_img)
+    clusts = FILL_SIZE // geo['clust_size']
+    # The room left for one more file also covers the /fill directory
+    return geo['clust_count'] // clusts - 1
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.slow
+class TestFatAlloc(object):
+    def test_fat_alloc1(self, u_boot_console, fs_obj_alloc):
+        """
+        Test Case 1 - fill the volume
+        """
+        fs_type,fs_img,data_file,md5val = fs_obj_alloc
+        with u_boot_console.log.section('Test Case 1 - fill'):
+            u_boot_console.run_command_list([
+                'host bind 0 %s' % fs_img,
+                'host load hostfs - %x %s' % (DATA_ADDR, data_file),
+                '%smkdir host 0:0 /fill' % fs_type])
+            for i in range(fill_count(fs_img)):
+                output = u_boot_console.run_command(
+                    '%swrite host 0:0 %x /fill/%03d %x'
+                    % (fs_type, DATA_ADDR + (i % 4) * FILL_SIZE, i,
+                       FILL_SIZE))
+                assert('%d bytes written' % FILL_SIZE in output)
+            assert_fat_integrity(fs_img)
+
+    def test_fat_alloc2(self, u_boot_console, fs_obj_alloc):
+        """
+        Test Case 2 - delete every other file and write a fragmented file
+        """
+        fs_type,fs_img,data_file,md5val = fs_obj_alloc
+        with u_boot_console.log.section('Test Case 2 - fragmented write'):
+            u_boot_console.run_command('host bind 0 %s' % fs_img)
+            for i in range(1, fill_count(fs_img), 2):
+                output = u_boot_console.run_command(
+                    '%srm host 0:0 /fill/%03d' % (fs_type, i))
+                assert('' == output)
+            output = u_boot_console.run_command(
+                '%swrite host 0:0 %x /frag %x'
+                % (fs_type, DATA_ADDR, FRAG_SIZE))
+            assert('%d bytes written' % FRAG_SIZE in output)
+
+            output = u_boot_console.run_command_list([
+                '%sload host 0:0 %x /frag' % (fs_type, READ_ADDR),
+                'md5sum %x $filesize' % READ_ADDR])
+            assert(md5val in ''.join(output))
+            assert_fat_integrity(fs_img)
+
+    def test_fat_alloc3(self, u_boot_console, fs_obj_alloc):
+        """
+        Test Case 3 - rewrite fragmented files
+        """
+        fs_type,fs_img,data_file,md5val = fs_obj_alloc
+        with u_boot_console.log.section('Test Case 3 - fragmented rewrite'):
+            u_boot_console.run_command('host bind 0 %s' % fs_img)
+
+            # Shrink the file and free another hole, then write a file
+            # which still does not fit in any single hole
+            output = u_boot_console.run_command(
+                '%swrite host 0:0 %x /frag %x'
+                % (fs_type, DATA_ADDR, FILL_SIZE))
+            assert('%d bytes written' % FILL_SIZE in output)
+            output = u_boot_console.run_command(
+                '%srm host 0:0 /fill/000' % fs_type)
+            assert('' == output)
+            output = u_boot_console.run_command(
+                '%swrite host 0:0 %x /frag2 %x'
+                % (fs_type, DATA_ADDR, FRAG_SIZE))
+            assert('%d bytes written' % FRAG_SIZE in output)
+
+            # Grow the first file again over whatever is left
+            output = u_boot_console.run_command(
+                '%swrite host 0:0 %x /frag %x'
+                % (fs_type, DATA_ADDR, FRAG_SIZE))
+            assert('%d bytes written' % FRAG_SIZE in output)
+
+            for name in ['frag', 'frag2']:
+                output = u_boot_console.run_command_list([
+                    '%sload host 0:0 %x /%s' % (fs_type, READ_ADDR, name),
+                    'md5sum %x $filesize' % READ_ADDR])
+                assert(md5val in ''.join(output))
+            assert_fat_integrity(fs_img)
@@ -0,0 +1,219 @@
+# SPDX-License-Identifier: GPL-2.0+
+
+"""
+Test the function-trace output and the proftool commands which read it
+
+test_trace_proftool() runs proftool on a small hand-written trace, so that the
+Chrome trace-event JSON, the folded stacks and the per-function times can be
+checked exactly. test_trace_calls() takes a real trace from a sandbox built
+with FTRACE=1 and checks that the three outputs agree with each other.
+"""
+
+import json
+import os
+import re
+import struct
+
+import pytest
+import u_boot_utils as util
+
+# Record types, from include/trace.h
+TRACE_CHUNK_CALLS = 1
+FUNCF_EXIT = 0 << 30
+FUNCF_ENTRY = 1 << 30
+FUNCF_TEXTBASE = 2 << 30
+FUNCF_CPU_SHIFT = 16
+
+# Functions in the hand-written trace, with their offset from the text base
+FUNCS = {
+    'main': 0x0,
+    'foo': 0x100,
+    'bar': 0x200,
+}
+
+TEXT_BASE = 0x1000
+
+# (type, function, CPU, depth, timestamp in microseconds)
+CALLS = [
+    (FUNCF_ENTRY, 'main', 0, 0, 100),
+    (FUNCF_ENTRY, 'foo', 0, 1, 110),
+    (FUNCF_ENTRY, 'bar', 0, 2, 120),
+    (FUNCF_EXIT, 'bar', 0, 2, 150),
+    (FUNCF_EXIT, 'foo', 0, 1, 160),
+    (FUNCF_ENTRY, 'bar', 0, 1, 170),
+    (FUNCF_EXIT, 'bar', 0, 1, 180),
+    (FUNCF_EXIT, 'main', 0, 0, 200),
+    (FUNCF_ENTRY, 'foo', 1, 0, 300),
+    (FUNCF_EXIT, 'foo', 1, 0, 340),
+]
+
+def write_trace(map_fname, trace_fname):
+    """Write a System.map and a trace file for the calls in CALLS
+
+    The records use the host's layout of struct trace_output_hdr and
+    struct trace_call, as proftool reads them directly.
+
+    Args:
+        map_fname (str): Filename to write the map to
+        trace_fname (str): Filename to write the trace to
+    """
+    with open(map_fname, 'w') as fd:
+        for name, offset in FUNCS.items():
+            print('%016x T %s' % (TEXT_BASE + offset, name), file=fd)
+        print('%016x T _end_of_text' % (TEXT_BASE + 0x300), file=fd)
+
+    recs = [struct.pack('@IIIIQ', TEXT_BASE, 0, FUNCF_TEXTBASE, 0, 0)]
+    for ftype, name, cpu, depth, stamp in CALLS:
+        flags = ftype | cpu << FUNCF_CPU_SHIFT | depth
+        recs.append(struct.pack('@IIIIQ', FUNCS[name], 0, flags, 0, stamp))
+    with open(trace_fname, 'wb') as fd:
+        fd.write(struct.pack('@iN', TRACE_CHUNK_CALLS, len(recs)))
+        fd.write(b''.join(recs))
+
+def run_proftool(cons, map_fname, trace_fname, cmd):
+    """Run a proftool command and return its output
+
+    Args:
+        cons (ConsoleBase): U-Boot console
+        map_fname (str): Map file to pass to proftool
+        trace_fname (str): Trace file to pass to proftool
+        cmd (str): proftool command, e.g. 'dump-chrome'
+
+    Returns:
+        str: Output of the command
+    """
+    proftool = os.path.join(cons.config.build_dir, 'tools', 'proftool')
+    return util.run_and_log(cons, [proftool, '-v', '0', '-m', map_fname,
+                                   '-p', trace_fname, cmd])
+
+def parse_chrome(out):
+    """Check the Chrome trace-event JSON and return its function calls
+
+    Args:
+        out (str): Output of 'proftool dump-chrome'
+
+    Returns:
+        list of tuple: (name, tid, ts, dur) for each function call
+    """
+    data = json.loads(out)
+    # Timestamps are in microseconds; anything else would mis-scale them
+    assert data.get('displayTimeUnit', 'ms') == 'ms'
+    calls = []
+    for event in data['traceEvents']:
+        if event['ph'] == 'X':
+            assert event['cat'] == 'func'
+            calls.append((event['name'], event['tid'], event['ts'],
+                          event['dur']))
+        else:
+            assert event['ph'] == 'M'
+    return calls
+
+def parse_flamegraph(out):
+    """Return the folded stacks and their weights
+
+    Args:
+        out (str): Output of 'proftool dump-flamegraph'
+
+    Returns:
+        dict: Time in microseconds for each stack, e.g. {'main;foo': 20}
+    """
+    stacks = {}
+    for line in out.splitlines():
+        stack, weight = line.rsplit(' ', 1)
+        assert stack not in stacks
+        stacks[stack] = int(weight)
+    return stacks
+
+def parse_func_times(out):
+    """Return the calls and times of each function
+
+    Args:
+        out (str): Output of 'proftool dump-func-times'
+
+    Returns:
+        dict: (calls, inclusive us, exclusive us) for each function name
+    """
+    lines = out.splitlines()
+    assert lines[0].split() == ['Calls', 'Inclusive', 'us', 'Exclusive', 'us',
+                                'Function']
+    funcs = {}
+    for line in lines[1:]:
+        calls, incl, excl, name = line.split()
+        funcs[name] = (int(calls), int(incl), int(excl))
+    return funcs
+
+@pytest.mark.boardspec('sandbox')
+def test_trace_proftool(u_boot_console):
+    """Check each proftool output for a known trace"""
+    cons = u_boot_console
+    map_fname = os.path.join(cons.config.result_dir, 'trace_test.map')
+    trace_fname = os.path.join(cons.config.result_dir, 'trace_test.bin')
+    write_trace(map_fname, trace_fname)
+
+    out = run_proftool(cons, map_fname, trace_fname, 'dump-chrome')
+    assert sorted(parse_chrome(out)) == sorted([
+        ('main', 0, 100, 100),
+        ('foo', 0, 110, 50),
+        ('bar', 0, 120, 30),
+        ('bar', 0, 170, 10),
+        ('foo', 1, 300, 40),
+    ])
+    assert re.search(r'"tid":1,"args":\{"name":"CPU 1"\}', out)
+
+    out = run_proftool(cons, map_fname, trace_fname, 'dump-flamegraph')
+    assert parse_flamegraph(out) == {
+        'main': 40,
+        'main;foo': 20,
+        'main;foo;bar': 30,
+        'main;bar': 10,
+        'foo': 40,
+    }
+
+    out = run_proftool(cons, map_fname, trace_fname, 'dump-func-times')
+    funcs = parse_func_times(out)
+    assert funcs == {
+        'foo': (2, 90, 60),
+        'main': (1, 100, 40),
+        'bar': (2, 40, 40),
+    }
+    # Most exclusive time first, then by name
+    assert list(funcs) == ['foo', 'bar', 'main']
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_trace')
+def test_trace_calls(u_boot_console):
+    """Check that proftool can read a trace recorded by U-Boot"""
+    cons = u_boot_console
+    map_fname = os.path.join(cons.config.build_dir, 'System.map')
+    trace_fname = os.path.join(cons.config.result_dir, 'trace_calls.bin')
+    addr = 0x2000000
+    size = 0x2000000
+
+    cons.run_command('trace pause')
+    out = cons.run_command('trace calls %x %x' % (addr, size))
+    assert 'Call list dumped to %08x' % addr in out
+    assert 'truncated' not in out
+    out = cons.run_command('host save hostfs - %x %s ${profoffset}' %
+                           (addr, trace_fname))
+    assert 'bytes written' in out
+    cons.run_command('trace resume')
+
+    calls = parse_chrome(run_proftool(cons, map_fname, trace_fname,
+                                      'dump-chrome'))
+    stacks = parse_flamegraph(run_proftool(cons, map_fname, trace_fname,
+                                           'dump-flamegraph'))
+    funcs = parse_func_times(run_proftool(cons, map_fname, trace_fname,
+                                          'dump-func-times'))
+
+    # The 'trace pause' command was itself traced until it paused tracing
+    assert 'do_trace' in funcs
+    for name, _, _, dur in calls:
+        assert name in funcs
+        assert dur >= 0
+
+    # The three outputs describe the same calls and the same time
+    assert len(calls) == sum(count for count, _, _ in funcs.values())
+    assert sum(stacks.values()) == sum(excl for _, _, excl in funcs.values())
+    for name, (count, incl, excl) in funcs.items():
+        assert count == len([call for call in calls if call[0] == name])
+        assert excl <= incl
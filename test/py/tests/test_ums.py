@@ -12,6 +12,7 @@ import pytest
 import re
 import time
 import u_boot_utils
+import zlib
 
 """
 Note: This test relies on:
@@ -234,3 +235,65 @@ def test_ums(u_boot_console, env__usb_dev_port, env__block_devs):
 
     written_hash = test_f.content_hash
     assert(written_hash == read_back_hash)
+
+@pytest.mark.buildconfigspec('cmd_usb_mass_storage')
+@pytest.mark.buildconfigspec('cmd_crc32')
+def test_ums_sequential_read(u_boot_console, env__usb_dev_port,
+                             env__block_devs):
+    """Read the start of the exported device sequentially from the host and
+    check that the data matches what U-Boot reads directly. This streams
+    through the whole transfer buffer ring and, if enabled, read-ahead. The
+    statistics printed when "ums" is aborted must account for the data.
+
+    Args:
+        u_boot_console: A U-Boot console connection.
+        env__usb_dev_port: The single USB device-mode port specification on
+            which to run the test. See the file-level comment above for
+            details of the format.
+        env__block_devs: The list of block devices that the target U-Boot
+            device has attached. See the file-level comment above for details
+            of the format.
+
+    Returns:
+        Nothing.
+    """
+
+    tgt_usb_ctlr = env__usb_dev_port['tgt_usb_ctlr']
+    host_ums_dev_node = env__usb_dev_port['host_ums_dev_node']
+    tgt_dev_type = env__block_devs[0]['type']
+    tgt_dev_id = env__block_devs[0]['id']
+    size = 8 * 1024 * 1024
+
+    cmd = 'ums %s %s %s' % (tgt_usb_ctlr, tgt_dev_type, tgt_dev_id)
+    u_boot_console.run_command(cmd, wait_for_prompt=False)
+    u_boot_console.wait_for(re.compile('UMS: LUN.*[\r\n]'))
+    crc = 0
+    try:
+        fh = u_boot_utils.wait_until_open_succeeds(host_ums_dev_node)
+        u_boot_console.log.action('Reading %d bytes from UMS device' % size)
+        for i in range(0, size, 64 * 1024):
+            crc = zlib.crc32(fh.read(64 * 1024), crc)
+        fh.close()
+    finally:
+        u_boot_console.log.action(
+            'Stopping long-running U-Boot ums shell command')
+        output = u_boot_console.run_command(chr(3), wait_for_echo=False,
+                                            send_nl=False)
+        u_boot_utils.wait_until_file_open_fails(host_ums_dev_node, True)
+
+    m = re.search(r'UMS: read (\d+) KiB', output)
+    assert m
+    assert int(m.group(1)) >= size // 1024
+    if u_boot_console.config.buildconfig.get(
+            'config_usb_function_mass_storage_read_ahead', 'n') == 'y':
+        m = re.search(r'UMS: (\d+) read-ahead hits', output)
+        assert m
+        assert int(m.group(1)) > 0
+
+    addr = u_boot_utils.find_ram_base(u_boot_console)
+    u_boot_console.run_command('%s dev %s' % (tgt_dev_type, tgt_dev_id))
+    output = u_boot_console.run_command('%s read %x 0 %x' %
+                                        (tgt_dev_type, addr, size // 512))
+    assert 'error' not in output.lower()
+    output = u_boot_console.run_command('crc32 %x %x' % (addr, size))
+    assert output.endswith('%08x' % crc)
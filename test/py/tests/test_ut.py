@@ -20,7 +20,7 @@ def mkdir_cond(dirname):
 def setup_bootflow_image(u_boot_console):
     """Create a 20MB disk image with a single FAT partition"""
     cons = u_boot_console
-    fname = os.path.join(cons.config.source_dir, 'mmc1.img')
+    fname = os.path.join(cons.config.persistent_data_dir, 'mmc1.img')
     mnt = os.path.join(cons.config.persistent_data_dir, 'mnt')
     mkdir_cond(mnt)
 
@@ -101,14 +101,14 @@ label Fedora-Workstation-armhfp-31-1.9 (5.3.7-301.fc31.armv7hl)
 def test_ut_dm_init(u_boot_console):
     """Initialize data for ut dm tests."""
 
-    fn = u_boot_console.config.source_dir + '/testflash.bin'
+    fn = u_boot_console.config.persistent_data_dir + '/testflash.bin'
     if not os.path.exists(fn):
         data = b'this is a test'
         data += b'\x00' * ((4 * 1024 * 1024) - len(data))
         with open(fn, 'wb') as fh:
             fh.write(data)
 
-    fn = u_boot_console.config.source_dir + '/spi.bin'
+    fn = u_boot_console.config.persistent_data_dir + '/spi.bin'
     if not os.path.exists(fn):
         data = b'\x00' * (2 * 1024 * 1024)
         with open(fn, 'wb') as fh:
@@ -67,7 +67,8 @@ static int fit_add_file_data(struct image_tool_params *params, size_t size_inc,
 				      params->comment,
 				      params->require_keys,
 				      params->engine_id,
-				      params->cmdname);
+				      params->cmdname,
+				      params->jobs);
 	}
 
 	if (!ret) {
@@ -78,7 +79,8 @@ static int fit_add_file_data(struct image_tool_params *params, size_t size_inc,
 						params->engine_id,
 						params->cmdname,
 						params->algo_name,
-						&params->summary);
+						&params->summary,
+						params->jobs);
 	}
 
 	if (dest_blob) {
@@ -14,11 +14,246 @@
 #include <image.h>
 #include <version.h>
 
+#include <pthread.h>
+
 #include <openssl/pem.h>
 #include <openssl/evp.h>
 
 #define IMAGE_PRE_LOAD_PATH                             "/image/pre-load/sig"
 
+/**
+ * enum fit_work_type - type of work item processed in parallel
+ *
+ * @FIT_WORK_HASH:	calculate the value of a hash node
+ * @FIT_WORK_SIG:	sign the data of an image node
+ * @FIT_WORK_CIPHER:	encrypt the data of an image node
+ */
+enum fit_work_type {
+	FIT_WORK_HASH,
+	FIT_WORK_SIG,
+	FIT_WORK_CIPHER,
+};
+
+/**
+ * struct fit_work - the expensive part of processing a hash, signature or
+ * cipher node
+ *
+ * The FIT is only read while work items are processed, so independent items
+ * can be processed by several threads. The results are then written to the
+ * FIT in a serial pass which visits the nodes in the same order as the work
+ * items were created, so the output is identical to serial processing. Only
+ * ciphered images without an iv-name-hint differ, as each run, serial or
+ * not, picks a new random IV for them.
+ *
+ * @type:	type of work
+ * @data:	image data to process
+ * @size:	size of @data in bytes
+ * @ret:	result of processing, 0 on success
+ * @algo:	hash algorithm name (FIT_WORK_HASH)
+ * @value:	calculated hash value (FIT_WORK_HASH)
+ * @value_len:	length of @value in bytes (FIT_WORK_HASH)
+ * @sign_info:	signing information (FIT_WORK_SIG)
+ * @sig:	signature, allocated by the crypto algorithm (FIT_WORK_SIG)
+ * @sig_len:	length of @sig in bytes (FIT_WORK_SIG)
+ * @cipher_info: cipher information including key and iv (FIT_WORK_CIPHER)
+ * @ciphered:	encrypted data, allocated by the cipher (FIT_WORK_CIPHER)
+ * @ciphered_len: length of @ciphered in bytes (FIT_WORK_CIPHER)
+ */
+struct fit_work {
+	enum fit_work_type type;
+	const void *data;
+	size_t size;
+	int ret;
+	const char *algo;
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+	struct image_sign_info sign_info;
+	uint8_t *sig;
+	uint sig_len;
+	struct image_cipher_info cipher_info;
+	unsigned char *ciphered;
+	int ciphered_len;
+};
+
+/**
+ * struct fit_work_list - list of work items
+ *
+ * @items:	work items, in the order of the serial pass
+ * @count:	number of items
+ * @alloced:	number of items allocated
+ * @next:	next item to be picked up by a thread
+ * @used:	next item to be consumed by the serial pass
+ * @lock:	protects @next
+ */
+struct fit_work_list {
+	struct fit_work *items;
+	int count;
+	int alloced;
+	int next;
+	int used;
+	pthread_mutex_t lock;
+};
+
+static void fit_work_init(struct fit_work_list *work)
+{
+	memset(work, '\0', sizeof(*work));
+	pthread_mutex_init(&work->lock, NULL);
+}
+
+static void fit_work_free(struct fit_work_list *work)
+{
+	int i;
+
+	for (i = 0; i < work->count; i++) {
+		struct fit_work *item = &work->items[i];
+
+		free(item->sig);
+		free(item->ciphered);
+		free((void *)item->cipher_info.key);
+		free((void *)item->cipher_info.iv);
+	}
+	free(work->items);
+	pthread_mutex_destroy(&work->lock);
+}
+
+/**
+ * fit_work_add() - add a new work item
+ *
+ * @work:	work list
+ * @type:	type of work
+ * @data:	image data to process
+ * @size:	size of @data in bytes
+ * Return: new item, or NULL if out of memory
+ */
+static struct fit_work *fit_work_add(struct fit_work_list *work,
+				     enum fit_work_type type,
+				     const void *data, size_t size)
+{
+	struct fit_work *item;
+
+	if (work->count == work->alloced) {
+		int alloced = work->alloced ? work->alloced * 2 : 16;
+
+		item = realloc(work->items, alloced * sizeof(*item));
+		if (!item)
+			return NULL;
+		work->items = item;
+		work->alloced = alloced;
+	}
+	item = &work->items[work->count++];
+	memset(item, '\0', sizeof(*item));
+	item->type = type;
+	item->data = data;
+	item->size = size;
+
+	return item;
+}
+
+/**
+ * fit_work_next() - get the result of the next work item in the serial pass
+ *
+ * @work:	work list, or NULL if the work is not done in parallel
+ * @type:	expected type of work
+ * Return: work item, or NULL if @work is NULL
+ */
+static struct fit_work *fit_work_next(struct fit_work_list *work,
+				      enum fit_work_type type)
+{
+	struct fit_work *item;
+
+	if (!work)
+		return NULL;
+	if (work->used >= work->count ||
+	    work->items[work->used].type != type) {
+		fprintf(stderr, "Internal error: FIT work items out of order\n");
+		exit(EXIT_FAILURE);
+	}
+	item = &work->items[work->used++];
+
+	return item;
+}
+
+static void fit_work_process(struct fit_work *item)
+{
+	struct image_sign_info *info;
+
+	/* Items which could not be set up are reported in the serial pass */
+	if (item->ret)
+		return;
+
+	switch (item->type) {
+	case FIT_WORK_HASH:
+		item->ret = calculate_hash(item->data, item->size, item->algo,
+					   item->value, &item->value_len);
+		break;
+	case FIT_WORK_SIG: {
+		struct image_region region;
+
+		info = &item->sign_info;
+		region.data = item->data;
+		region.size = item->size;
+		item->ret = info->crypto->sign(info, &region, 1, &item->sig,
+					       &item->sig_len);
+		break;
+	}
+	case FIT_WORK_CIPHER:
+		item->ret = item->cipher_info.cipher->encrypt(&item->cipher_info,
+				item->data, item->size, &item->ciphered,
+				&item->ciphered_len);
+		break;
+	}
+}
+
+static void *fit_work_thread(void *arg)
+{
+	struct fit_work_list *work = arg;
+	int i;
+
+	for (;;) {
+		pthread_mutex_lock(&work->lock);
+		i = work->next++;
+		pthread_mutex_unlock(&work->lock);
+		if (i >= work->count)
+			break;
+		fit_work_process(&work->items[i]);
+	}
+
+	return NULL;
+}
+
+/**
+ * fit_work_run() - process all work items
+ *
+ * @work:	work list
+ * @jobs:	maximum number of threads to use
+ */
+static void fit_work_run(struct fit_work_list *work, int jobs)
+{
+	pthread_t *threads;
+	long ncpus;
+	int nthreads, i;
+
+	/* More threads than CPUs only adds overhead */
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (ncpus > 0 && jobs > ncpus)
+		jobs = ncpus;
+	nthreads = (jobs < work->count ? jobs : work->count) - 1;
+	threads = nthreads > 0 ? calloc(nthreads, sizeof(*threads)) : NULL;
+	if (!threads)
+		nthreads = 0;
+
+	/* If a thread cannot be created, the remaining ones do more work */
+	for (i = 0; i < nthreads; i++) {
+		if (pthread_create(&threads[i], NULL, fit_work_thread, work))
+			break;
+	}
+	nthreads = i;
+	fit_work_thread(work);
+	for (i = 0; i < nthreads; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+}
+
 /**
  * fit_set_hash_value - set hash value in requested has node
  * @fit: pointer to the FIT format image header
@@ -60,12 +295,16 @@ static int fit_set_hash_value(void *fit, int noffset, uint8_t *value,
  * @noffset:	subnode offset
  * @data:	data to process
  * @size:	size of data in bytes
+ * @work:	precalculated hash values, or NULL to calculate them here
  * Return: 0 if ok, -1 on error
  */
 static int fit_image_process_hash(void *fit, const char *image_name,
-		int noffset, const void *data, size_t size)
+		int noffset, const void *data, size_t size,
+		struct fit_work_list *work)
 {
-	uint8_t value[FIT_MAX_HASH_LEN];
+	struct fit_work *item = fit_work_next(work, FIT_WORK_HASH);
+	uint8_t buf[FIT_MAX_HASH_LEN];
+	uint8_t *value = buf;
 	const char *node_name;
 	int value_len;
 	const char *algo;
@@ -79,7 +318,14 @@ static int fit_image_process_hash(void *fit, const char *image_name,
 		return -ENOENT;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+	if (item) {
+		ret = item->ret;
+		value = item->value;
+		value_len = item->value_len;
+	} else {
+		ret = calculate_hash(data, size, algo, value, &value_len);
+	}
+	if (ret) {
 		printf("Unsupported hash algorithm (%s) for '%s' hash node in '%s' image node\n",
 		       algo, node_name, image_name);
 		return -EPROTONOSUPPORT;
@@ -217,6 +463,7 @@ static int fit_image_setup_sig(struct image_sign_info *info,
  * @comment:	Comment to add to signature nodes
  * @require_keys: Mark all keys as 'required'
  * @engine_id:	Engine to use for signing
+ * @work:	precalculated signatures, or NULL to sign here
  * Return: keydest node if @keydest is non-NULL, else 0 if none; -ve error code
  *	on failure
  */
@@ -224,8 +471,10 @@ static int fit_image_process_sig(const char *keydir, const char *keyfile,
 		void *keydest, void *fit, const char *image_name,
 		int noffset, const void *data, size_t size,
 		const char *comment, int require_keys, const char *engine_id,
-		const char *cmdname, const char *algo_name)
+		const char *cmdname, const char *algo_name,
+		struct fit_work_list *work)
 {
+	struct fit_work *item = NULL;
 	struct image_sign_info info;
 	struct image_region region;
 	const char *node_name;
@@ -238,10 +487,21 @@ static int fit_image_process_sig(const char *keydir, const char *keyfile,
 				engine_id, algo_name))
 		return -1;
 
+	/* Signing with an engine is not done in parallel */
+	if (!engine_id)
+		item = fit_work_next(work, FIT_WORK_SIG);
+
 	node_name = fit_get_name(fit, noffset, NULL);
-	region.data = data;
-	region.size = size;
-	ret = info.crypto->sign(&info, &region, 1, &value, &value_len);
+	if (item) {
+		ret = item->ret;
+		value = item->sig;
+		value_len = item->sig_len;
+		item->sig = NULL;
+	} else {
+		region.data = data;
+		region.size = size;
+		ret = info.crypto->sign(&info, &region, 1, &value, &value_len);
+	}
 	if (ret) {
 		printf("Failed to sign '%s' signature node in '%s' image node: %d\n",
 		       node_name, image_name, ret);
@@ -482,8 +742,9 @@ static int
 fit_image_process_cipher(const char *keydir, void *keydest, void *fit,
 			 const char *image_name, int image_noffset,
 			 int node_noffset, const void *data, size_t size,
-			 const char *cmdname)
+			 const char *cmdname, struct fit_work_list *work)
 {
+	struct fit_work *item = fit_work_next(work, FIT_WORK_CIPHER);
 	struct image_cipher_info info;
 	unsigned char *data_ciphered = NULL;
 	int data_ciphered_len;
@@ -491,15 +752,37 @@ fit_image_process_cipher(const char *keydir, void *keydest, void *fit,
 
 	memset(&info, 0, sizeof(info));
 
-	ret = fit_image_setup_cipher(&info, keydir, fit, image_name,
-				     image_noffset, node_noffset);
-	if (ret)
-		goto out;
+	if (item) {
+		/* Take over the key, iv and encrypted data */
+		info = item->cipher_info;
+		memset(&item->cipher_info, '\0', sizeof(item->cipher_info));
+		data_ciphered = item->ciphered;
+		data_ciphered_len = item->ciphered_len;
+		item->ciphered = NULL;
+		ret = item->ret;
+		if (ret)
+			goto out;
 
-	ret = info.cipher->encrypt(&info, data, size,
-				    &data_ciphered, &data_ciphered_len);
-	if (ret)
-		goto out;
+		/* The FIT has changed since the work item was set up */
+		info.fit = fit;
+		info.node_noffset = node_noffset;
+		info.keyname = fdt_getprop(fit, node_noffset, FIT_KEY_HINT,
+					   NULL);
+		info.ivname = fdt_getprop(fit, node_noffset, "iv-name-hint",
+					  NULL);
+		fit_image_cipher_get_algo(fit, node_noffset,
+					  (char **)&info.name);
+	} else {
+		ret = fit_image_setup_cipher(&info, keydir, fit, image_name,
+					     image_noffset, node_noffset);
+		if (ret)
+			goto out;
+
+		ret = info.cipher->encrypt(&info, data, size,
+					    &data_ciphered, &data_ciphered_len);
+		if (ret)
+			goto out;
+	}
 
 	/*
 	 * Write the public key into the supplied FDT file; this might fail
@@ -527,25 +810,34 @@ fit_image_process_cipher(const char *keydir, void *keydest, void *fit,
 	return ret;
 }
 
-int fit_image_cipher_data(const char *keydir, void *keydest,
-			  void *fit, int image_noffset, const char *comment,
-			  int require_keys, const char *engine_id,
-			  const char *cmdname)
+/**
+ * fit_image_get_cipher_node() - find the cipher node of an image to encrypt
+ *
+ * @keydir:	Directory containing keys, or NULL
+ * @fit:	Pointer to the FIT format image header
+ * @image_noffset: Component image node
+ * @image_namep: Returns the image name
+ * @datap:	Returns the image data
+ * @sizep:	Returns the size of the image data
+ * Return: offset of the cipher node, -FDT_ERR_NOTFOUND if the image is not
+ *	to be encrypted, -1 on error
+ */
+static int fit_image_get_cipher_node(const char *keydir, void *fit,
+				     int image_noffset,
+				     const char **image_namep,
+				     const void **datap, size_t *sizep)
 {
-	const char *image_name;
-	const void *data;
-	size_t size;
 	int cipher_node_offset, len;
 
 	/* Get image name */
-	image_name = fit_get_name(fit, image_noffset, NULL);
-	if (!image_name) {
+	*image_namep = fit_get_name(fit, image_noffset, NULL);
+	if (!*image_namep) {
 		printf("Can't get image name\n");
 		return -1;
 	}
 
 	/* Get image data and data length */
-	if (fit_image_get_data(fit, image_noffset, &data, &size)) {
+	if (fit_image_get_data(fit, image_noffset, datap, sizep)) {
 		printf("Can't get image data/size\n");
 		return -1;
 	}
@@ -558,7 +850,7 @@ int fit_image_cipher_data(const char *keydir, void *keydest,
 	 * run multiple times on a FIT image.
 	 */
 	if (fdt_getprop(fit, image_noffset, "data-size-unciphered", &len))
-		return 0;
+		return -FDT_ERR_NOTFOUND;
 	if (len != -FDT_ERR_NOTFOUND) {
 		printf("Failure testing for data-size-unciphered\n");
 		return -1;
@@ -568,15 +860,90 @@ int fit_image_cipher_data(const char *keydir, void *keydest,
 	cipher_node_offset = fdt_subnode_offset(fit, image_noffset,
 						FIT_CIPHER_NODENAME);
 	if (cipher_node_offset == -FDT_ERR_NOTFOUND)
-		return 0;
+		return -FDT_ERR_NOTFOUND;
 	if (cipher_node_offset < 0) {
 		printf("Failure getting cipher node\n");
 		return -1;
 	}
 	if (!IMAGE_ENABLE_ENCRYPT || !keydir)
+		return -FDT_ERR_NOTFOUND;
+
+	return cipher_node_offset;
+}
+
+static int fit_image_cipher_data_work(const char *keydir, void *keydest,
+				      void *fit, int image_noffset,
+				      const char *cmdname,
+				      struct fit_work_list *work)
+{
+	const char *image_name;
+	const void *data;
+	size_t size;
+	int cipher_node_offset;
+
+	cipher_node_offset = fit_image_get_cipher_node(keydir, fit,
+						       image_noffset,
+						       &image_name, &data,
+						       &size);
+	if (cipher_node_offset == -FDT_ERR_NOTFOUND)
 		return 0;
+	if (cipher_node_offset < 0)
+		return -1;
+
 	return fit_image_process_cipher(keydir, keydest, fit, image_name,
-		image_noffset, cipher_node_offset, data, size, cmdname);
+		image_noffset, cipher_node_offset, data, size, cmdname, work);
+}
+
+int fit_image_cipher_data(const char *keydir, void *keydest,
+			  void *fit, int image_noffset, const char *comment,
+			  int require_keys, const char *engine_id,
+			  const char *cmdname)
+{
+	return fit_image_cipher_data_work(keydir, keydest, fit, image_noffset,
+					  cmdname, NULL);
+}
+
+/**
+ * fit_cipher_prepare() - set up encryption of all images for parallel work
+ *
+ * Keys and IVs are read (or generated) here, in the order of the images, so
+ * that only the encryption itself runs in parallel.
+ *
+ * @keydir:	Directory containing keys
+ * @fit:	Pointer to the FIT format image header
+ * @images_noffset: Offset of the images node
+ * @work:	Work list to add the items to
+ * Return: 0 on success, -ve on error
+ */
+static int fit_cipher_prepare(const char *keydir, void *fit,
+			      int images_noffset, struct fit_work_list *work)
+{
+	struct fit_work *item;
+	const char *image_name;
+	const void *data;
+	size_t size;
+	int noffset, node;
+	int ret;
+
+	for (noffset = fdt_first_subnode(fit, images_noffset);
+	     noffset >= 0;
+	     noffset = fdt_next_subnode(fit, noffset)) {
+		node = fit_image_get_cipher_node(keydir, fit, noffset,
+						 &image_name, &data, &size);
+		if (node == -FDT_ERR_NOTFOUND)
+			continue;
+		if (node < 0)
+			return -1;
+		item = fit_work_add(work, FIT_WORK_CIPHER, data, size);
+		if (!item)
+			return -ENOMEM;
+		ret = fit_image_setup_cipher(&item->cipher_info, keydir, fit,
+					     image_name, noffset, node);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
 }
 
 /**
@@ -614,10 +981,11 @@ int fit_image_cipher_data(const char *keydir, void *keydest,
  * @engine_id:	Engine to use for signing
  * @return: 0 on success, <0 on failure
  */
-int fit_image_add_verification_data(const char *keydir, const char *keyfile,
-		void *keydest, void *fit, int image_noffset,
-		const char *comment, int require_keys, const char *engine_id,
-		const char *cmdname, const char* algo_name)
+static int fit_image_add_verification_data_work(const char *keydir,
+		const char *keyfile, void *keydest, void *fit,
+		int image_noffset, const char *comment, int require_keys,
+		const char *engine_id, const char *cmdname,
+		const char *algo_name, struct fit_work_list *work)
 {
 	const char *image_name;
 	const void *data;
@@ -648,14 +1016,14 @@ int fit_image_add_verification_data(const char *keydir, const char *keyfile,
 		if (!strncmp(node_name, FIT_HASH_NODENAME,
 			     strlen(FIT_HASH_NODENAME))) {
 			ret = fit_image_process_hash(fit, image_name, noffset,
-						data, size);
+						data, size, work);
 		} else if (IMAGE_ENABLE_SIGN && (keydir || keyfile) &&
 			   !strncmp(node_name, FIT_SIG_NODENAME,
 				strlen(FIT_SIG_NODENAME))) {
 			ret = fit_image_process_sig(keydir, keyfile, keydest,
 				fit, image_name, noffset, data, size,
 				comment, require_keys, engine_id, cmdname,
-				algo_name);
+				algo_name, work);
 		}
 		if (ret < 0)
 			return ret;
@@ -664,6 +1032,89 @@ int fit_image_add_verification_data(const char *keydir, const char *keyfile,
 	return 0;
 }
 
+int fit_image_add_verification_data(const char *keydir, const char *keyfile,
+		void *keydest, void *fit, int image_noffset,
+		const char *comment, int require_keys, const char *engine_id,
+		const char *cmdname, const char* algo_name)
+{
+	return fit_image_add_verification_data_work(keydir, keyfile, keydest,
+			fit, image_noffset, comment, require_keys, engine_id,
+			cmdname, algo_name, NULL);
+}
+
+/**
+ * fit_verification_prepare() - set up hashing and signing of all images
+ *
+ * This creates a work item for each hash and signature node, in the order in
+ * which fit_image_add_verification_data_work() visits them.
+ *
+ * @keydir:	Directory containing keys (or NULL)
+ * @keyfile:	Filename of private key (or NULL)
+ * @fit:	Pointer to the FIT format image header
+ * @images_noffset: Offset of the images node
+ * @require_keys: Mark all keys as 'required'
+ * @engine_id:	Engine to use for signing
+ * @algo_name:	Algorithm name, or NULL if to be read from FIT
+ * @work:	Work list to add the items to
+ * Return: 0 on success, -ve on error
+ */
+static int fit_verification_prepare(const char *keydir, const char *keyfile,
+				    void *fit, int images_noffset,
+				    int require_keys, const char *engine_id,
+				    const char *algo_name,
+				    struct fit_work_list *work)
+{
+	int image_noffset, noffset;
+
+	for (image_noffset = fdt_first_subnode(fit, images_noffset);
+	     image_noffset >= 0;
+	     image_noffset = fdt_next_subnode(fit, image_noffset)) {
+		const char *image_name;
+		const void *data;
+		size_t size;
+
+		/* Errors are reported when the results are written */
+		if (fit_image_get_data(fit, image_noffset, &data, &size))
+			return 0;
+		image_name = fit_get_name(fit, image_noffset, NULL);
+
+		for (noffset = fdt_first_subnode(fit, image_noffset);
+		     noffset >= 0;
+		     noffset = fdt_next_subnode(fit, noffset)) {
+			const char *node_name;
+			struct fit_work *item;
+
+			node_name = fit_get_name(fit, noffset, NULL);
+			if (!strncmp(node_name, FIT_HASH_NODENAME,
+				     strlen(FIT_HASH_NODENAME))) {
+				item = fit_work_add(work, FIT_WORK_HASH, data,
+						    size);
+				if (!item)
+					return -ENOMEM;
+				if (fit_image_hash_get_algo(fit, noffset,
+							    &item->algo))
+					item->ret = -ENOENT;
+			} else if (IMAGE_ENABLE_SIGN && (keydir || keyfile) &&
+				   !engine_id &&
+				   !strncmp(node_name, FIT_SIG_NODENAME,
+					    strlen(FIT_SIG_NODENAME))) {
+				item = fit_work_add(work, FIT_WORK_SIG, data,
+						    size);
+				if (!item)
+					return -ENOMEM;
+				if (fit_image_setup_sig(&item->sign_info,
+						keydir, keyfile, fit,
+						image_name, noffset,
+						require_keys ? "image" : NULL,
+						engine_id, algo_name))
+					item->ret = -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
 struct strlist {
 	int count;
 	char **strings;
@@ -1227,11 +1678,12 @@ int fit_pre_load_data(const char *keydir, void *keydest, void *fit)
 
 int fit_cipher_data(const char *keydir, void *keydest, void *fit,
 		    const char *comment, int require_keys,
-		    const char *engine_id, const char *cmdname)
+		    const char *engine_id, const char *cmdname, int jobs)
 {
+	struct fit_work_list work, *workp = NULL;
 	int images_noffset;
 	int noffset;
-	int ret;
+	int ret = 0;
 
 	/* Find images parent node offset */
 	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
@@ -1241,6 +1693,16 @@ int fit_cipher_data(const char *keydir, void *keydest, void *fit,
 		return images_noffset;
 	}
 
+	/* Encrypt the images in parallel, if requested */
+	if (jobs > 1) {
+		workp = &work;
+		fit_work_init(workp);
+		ret = fit_cipher_prepare(keydir, fit, images_noffset, workp);
+		if (ret)
+			goto out;
+		fit_work_run(workp, jobs);
+	}
+
 	/* Process its subnodes, print out component images details */
 	for (noffset = fdt_first_subnode(fit, images_noffset);
 	     noffset >= 0;
@@ -1249,26 +1711,29 @@ int fit_cipher_data(const char *keydir, void *keydest, void *fit,
 		 * Direct child node of the images parent node,
 		 * i.e. component image node.
 		 */
-		ret = fit_image_cipher_data(keydir, keydest,
-					    fit, noffset, comment,
-					    require_keys, engine_id,
-					    cmdname);
+		ret = fit_image_cipher_data_work(keydir, keydest, fit,
+						 noffset, cmdname, workp);
 		if (ret)
-			return ret;
+			break;
 	}
 
-	return 0;
+out:
+	if (workp)
+		fit_work_free(workp);
+
+	return ret;
 }
 
 int fit_add_verification_data(const char *keydir, const char *keyfile,
 			      void *keydest, void *fit, const char *comment,
 			      int require_keys, const char *engine_id,
 			      const char *cmdname, const char *algo_name,
-			      struct image_summary *summary)
+			      struct image_summary *summary, int jobs)
 {
+	struct fit_work_list work, *workp = NULL;
 	int images_noffset, confs_noffset;
 	int noffset;
-	int ret;
+	int ret = 0;
 
 	/* Find images parent node offset */
 	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
@@ -1278,20 +1743,33 @@ int fit_add_verification_data(const char *keydir, const char *keyfile,
 		return images_noffset;
 	}
 
+	/* Hash and sign the images in parallel, if requested */
+	if (jobs > 1) {
+		workp = &work;
+		fit_work_init(workp);
+		ret = fit_verification_prepare(keydir, keyfile, fit,
+					       images_noffset, require_keys,
+					       engine_id, algo_name, workp);
+		if (!ret)
+			fit_work_run(workp, jobs);
+	}
+
 	/* Process its subnodes, print out component images details */
 	for (noffset = fdt_first_subnode(fit, images_noffset);
-	     noffset >= 0;
+	     !ret && noffset >= 0;
 	     noffset = fdt_next_subnode(fit, noffset)) {
 		/*
 		 * Direct child node of the images parent node,
 		 * i.e. component image node.
 		 */
-		ret = fit_image_add_verification_data(keydir, keyfile, keydest,
-				fit, noffset, comment, require_keys, engine_id,
-				cmdname, algo_name);
-		if (ret)
-			return ret;
+		ret = fit_image_add_verification_data_work(keydir, keyfile,
+				keydest, fit, noffset, comment, require_keys,
+				engine_id, cmdname, algo_name, workp);
 	}
+	if (workp)
+		fit_work_free(workp);
+	if (ret)
+		return ret;
 
 	/* If there are no keys, we can't sign configurations */
 	if (!IMAGE_ENABLE_SIGN || !(keydir || keyfile))
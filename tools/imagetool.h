@@ -91,6 +91,7 @@ struct image_tool_params {
 	const char *engine_id;	/* Engine to use for signing */
 	bool reset_timestamp;	/* Reset the timestamp on an existing image */
 	struct image_summary summary;	/* results of signing process */
+	int jobs;		/* Threads for hashing/signing, 0/1 = serial */
 };
 
 /*
@@ -22,6 +22,9 @@
 
 #define MAX_LINE_LEN 500
 
+/* Number of CPUs which can be represented in a trace record */
+#define MAX_CPUS	((FUNCF_CPU_MASK >> FUNCF_CPU_SHIFT) + 1)
+
 enum {
 	FUNCF_TRACE	= 1 << 0,	/* Include this function in trace */
 };
@@ -34,8 +37,55 @@ struct func_info {
 	unsigned flags;
 	/* the section this function is in */
 	struct objsection_info *objsection;
+
+	/* Timing information, calculated from the trace records */
+	unsigned long calls;		/* Number of completed calls */
+	unsigned long long incl_us;	/* Time including called functions */
+	unsigned long long excl_us;	/* Time spent in this function only */
+	int active;			/* Number of calls in progress */
+};
+
+/*
+ * A node in the calling-context tree, which has a node for each distinct
+ * stack of (included) functions seen in the trace. This is used to produce
+ * flame graphs.
+ */
+struct flame_node {
+	struct func_info *func;		/* Function, NULL for the root */
+	struct flame_node *parent;
+	struct flame_node *child;	/* First function called from here */
+	struct flame_node *sibling;	/* Next function called from parent */
+	unsigned long long excl_us;	/* Time spent in this context only */
+	unsigned long count;		/* Number of calls in this context */
+};
+
+/* A function call in progress, while replaying the trace */
+struct stack_frame {
+	struct func_info *func;		/* NULL if the entry was not traced */
+	struct flame_node *node;	/* Context, NULL if not included */
+	unsigned long long start;	/* Timestamp of entry */
+	unsigned long long child_us;	/* Time spent in called functions */
+};
+
+/* The call stack of a CPU, while replaying the trace */
+struct cpu_stack {
+	struct stack_frame *frames;
+	int alloced;		/* Number of frames allocated */
+	int sp;			/* Number of frames in use */
+	int base;		/* Lowest call depth seen on this CPU */
+	int used;		/* True if this CPU appears in the trace */
 };
 
+/**
+ * typedef call_done_t - called for each completed function call
+ *
+ * @frame:	Frame of the function call
+ * @cpu:	CPU which made the call
+ * @end:	Timestamp of the function exit
+ */
+typedef void (*call_done_t)(const struct stack_frame *frame, int cpu,
+			    unsigned long long end);
+
 enum trace_line_type {
 	TRACE_LINE_INCLUDE,
 	TRACE_LINE_EXCLUDE,
@@ -55,6 +105,8 @@ struct func_info *func_list;
 int func_count;
 struct trace_call *call_list;
 int call_count;
+struct flame_node flame_root;
+struct cpu_stack cpu_stacks[MAX_CPUS];
 int verbose;	/* Verbosity level 0=none, 1=warn, 2=notice, 3=info, 4=debug */
 unsigned long text_offset;		/* text address of first function */
 
@@ -85,6 +137,9 @@ static void usage(void)
 		"\n"
 		"Commands\n"
 		"   dump-ftrace\t\tDump out textual data in ftrace format\n"
+		"   dump-chrome\t\tDump out Chrome/Perfetto trace-event JSON\n"
+		"   dump-flamegraph\tDump out folded stacks for flamegraph.pl\n"
+		"   dump-func-times\tDump out call count and time per function\n"
 		"\n"
 		"Options:\n"
 		"   -m <map>\tSpecify Systen.map file\n"
@@ -501,7 +556,7 @@ static int make_ftrace(void)
 		"#              | |      |          |         |\n");
 	for (i = 0, call = call_list; i < call_count; i++, call++) {
 		struct func_info *func = find_func_by_offset(call->func);
-		ulong time = call->flags & FUNCF_TIMESTAMP_MASK;
+		unsigned long long time = call->timestamp;
 
 		if (TRACE_CALL_TYPE(call) != FUNCF_ENTRY &&
 		    TRACE_CALL_TYPE(call) != FUNCF_EXIT)
@@ -520,8 +575,8 @@ static int make_ftrace(void)
 			continue;
 		}
 
-		printf("%16s-%-5d [01] %lu.%06lu: ", "uboot", 1,
-		       time / 1000000, time % 1000000);
+		printf("%16s-%-5d [%02u] %llu.%06llu: ", "uboot", 1,
+		       TRACE_CALL_CPU(call), time / 1000000, time % 1000000);
 
 		out_func(call->func, 0, " <- ");
 		out_func(call->caller, 1, "\n");
@@ -532,6 +587,392 @@ static int make_ftrace(void)
 	return 0;
 }
 
+/**
+ * nearest_frame() - find the closest caller which is included in the trace
+ *
+ * @cs:		CPU stack to search
+ * @idx:	Index of the frame whose caller is wanted
+ * Return: caller's frame, or NULL if there is none
+ */
+static struct stack_frame *nearest_frame(struct cpu_stack *cs, int idx)
+{
+	while (--idx >= 0) {
+		struct stack_frame *frame = &cs->frames[idx];
+
+		if (frame->node)
+			return frame;
+	}
+
+	return NULL;
+}
+
+/**
+ * flame_child() - find or add the context for a call
+ *
+ * @parent:	Context of the caller
+ * @func:	Function being called
+ * Return: context of the call
+ */
+static struct flame_node *flame_child(struct flame_node *parent,
+				      struct func_info *func)
+{
+	struct flame_node *node;
+
+	for (node = parent->child; node; node = node->sibling) {
+		if (node->func == func)
+			return node;
+	}
+	node = calloc(1, sizeof(*node));
+	if (!node) {
+		error("Cannot allocate flame node\n");
+		exit(EXIT_FAILURE);
+	}
+	node->func = func;
+	node->parent = parent;
+	node->sibling = parent->child;
+	parent->child = node;
+
+	return node;
+}
+
+/**
+ * close_frame() - account for a function call which has completed
+ *
+ * The time spent in a function which is excluded from the trace is
+ * attributed to its closest included caller.
+ *
+ * @cs:		CPU stack containing the frame
+ * @cpu:	CPU number
+ * @idx:	Index of the frame to close
+ * @end:	Timestamp of the function exit
+ * @done:	Function to call for each included call, or NULL
+ */
+static void close_frame(struct cpu_stack *cs, int cpu, int idx,
+			unsigned long long end, call_done_t done)
+{
+	struct stack_frame *frame = &cs->frames[idx];
+	struct func_info *func = frame->func;
+	struct stack_frame *caller;
+	unsigned long long incl, excl;
+
+	if (!func)
+		return;
+	incl = end > frame->start ? end - frame->start : 0;
+
+	/* Count recursive calls only once in the inclusive time */
+	if (!--func->active)
+		func->incl_us += incl;
+	if (!frame->node)
+		return;
+
+	excl = incl > frame->child_us ? incl - frame->child_us : 0;
+	func->excl_us += excl;
+	func->calls++;
+	frame->node->excl_us += excl;
+	caller = nearest_frame(cs, idx);
+	if (caller)
+		caller->child_us += incl;
+	if (done)
+		done(frame, cpu, end);
+}
+
+/**
+ * enter_frame() - start a new function call
+ *
+ * Any calls deeper than the new one are missing their exit records, so they
+ * are closed first.
+ *
+ * @cs:		CPU stack for the call
+ * @cpu:	CPU number
+ * @idx:	Index of the new frame
+ * @func:	Function being called
+ * @start:	Timestamp of the function entry
+ * @done:	Function to call for each included call, or NULL
+ */
+static void enter_frame(struct cpu_stack *cs, int cpu, int idx,
+			struct func_info *func, unsigned long long start,
+			call_done_t done)
+{
+	struct stack_frame *frame, *caller;
+
+	while (cs->sp > idx)
+		close_frame(cs, cpu, --cs->sp, start, done);
+	if (idx >= cs->alloced) {
+		cs->alloced = idx + 64;
+		cs->frames = realloc(cs->frames,
+				     cs->alloced * sizeof(*cs->frames));
+		if (!cs->frames) {
+			error("Cannot allocate call stack\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	/* Calls whose entry is missing get an empty frame */
+	while (cs->sp < idx)
+		memset(&cs->frames[cs->sp++], '\0', sizeof(*frame));
+
+	frame = &cs->frames[cs->sp++];
+	frame->func = func;
+	frame->node = NULL;
+	frame->start = start;
+	frame->child_us = 0;
+	func->active++;
+	if (func->flags & FUNCF_TRACE) {
+		caller = nearest_frame(cs, idx);
+		frame->node = flame_child(caller ? caller->node : &flame_root,
+					  func);
+		frame->node->count++;
+	}
+}
+
+static void free_flame_children(struct flame_node *parent)
+{
+	struct flame_node *node, *next;
+
+	for (node = parent->child; node; node = next) {
+		next = node->sibling;
+		free_flame_children(node);
+		free(node);
+	}
+	parent->child = NULL;
+}
+
+/* Drop the results of any previous replay */
+static void reset_replay(void)
+{
+	int i;
+
+	for (i = 0; i < func_count; i++) {
+		func_list[i].calls = 0;
+		func_list[i].incl_us = 0;
+		func_list[i].excl_us = 0;
+		func_list[i].active = 0;
+	}
+	free_flame_children(&flame_root);
+	for (i = 0; i < MAX_CPUS; i++) {
+		cpu_stacks[i].sp = 0;
+		cpu_stacks[i].base = 0;
+		cpu_stacks[i].used = 0;
+	}
+}
+
+/**
+ * replay_calls() - work out the time spent in each function call
+ *
+ * This rebuilds the call stack of each CPU from the entry and exit records,
+ * using the call depth stored in each record to cope with records that are
+ * missing, e.g. due to the trace-depth limit or trace-buffer overflow.
+ *
+ * Calls which are still in progress at the end of the trace are treated as
+ * ending with the last record.
+ *
+ * @done:	Function to call for each included call, or NULL
+ * Return: 0 if OK, -1 on error
+ */
+static int replay_calls(call_done_t done)
+{
+	unsigned long long last = 0;
+	struct trace_call *call;
+	int missing_count = 0, unmatched_count = 0;
+	int i, cpu;
+
+	reset_replay();
+
+	/* Work out the lowest call depth on each CPU */
+	for (i = 0, call = call_list; i < call_count; i++, call++) {
+		struct cpu_stack *cs = &cpu_stacks[TRACE_CALL_CPU(call)];
+		int depth = TRACE_CALL_DEPTH(call);
+
+		if (TRACE_CALL_TYPE(call) != FUNCF_ENTRY &&
+		    TRACE_CALL_TYPE(call) != FUNCF_EXIT)
+			continue;
+		if (!cs->used || depth < cs->base)
+			cs->base = depth;
+		cs->used = 1;
+	}
+
+	for (i = 0, call = call_list; i < call_count; i++, call++) {
+		struct func_info *func = find_func_by_offset(call->func);
+		struct cpu_stack *cs;
+		int idx;
+
+		if (TRACE_CALL_TYPE(call) != FUNCF_ENTRY &&
+		    TRACE_CALL_TYPE(call) != FUNCF_EXIT)
+			continue;
+		if (!func) {
+			missing_count++;
+			continue;
+		}
+		cpu = TRACE_CALL_CPU(call);
+		cs = &cpu_stacks[cpu];
+		idx = TRACE_CALL_DEPTH(call) - cs->base;
+		last = call->timestamp;
+
+		if (TRACE_CALL_TYPE(call) == FUNCF_ENTRY) {
+			enter_frame(cs, cpu, idx, func, call->timestamp, done);
+			continue;
+		}
+
+		/* Ignore exits from calls which started before the trace */
+		if (idx >= cs->sp || cs->frames[idx].func != func) {
+			unmatched_count++;
+			continue;
+		}
+		while (cs->sp > idx)
+			close_frame(cs, cpu, --cs->sp, call->timestamp, done);
+	}
+
+	for (cpu = 0; cpu < MAX_CPUS; cpu++) {
+		struct cpu_stack *cs = &cpu_stacks[cpu];
+
+		while (cs->sp)
+			close_frame(cs, cpu, --cs->sp, last, done);
+	}
+	info("replay: %d functions not found, %d unmatched exits\n",
+	     missing_count, unmatched_count);
+
+	return 0;
+}
+
+static int chrome_events;
+
+static void chrome_call_done(const struct stack_frame *frame, int cpu,
+			     unsigned long long end)
+{
+	printf("%s\n{\"name\":\"%s\",\"cat\":\"func\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":1,\"tid\":%d}",
+	       chrome_events++ ? "," : "", frame->func->name, frame->start,
+	       end - frame->start, cpu);
+}
+
+/*
+ * Write the trace in the Chrome trace-event format, which can be loaded into
+ * chrome://tracing or https://ui.perfetto.dev
+ *
+ * Each function call is a complete ('X') event, with one thread per CPU. The
+ * start time and duration are in microseconds, as the format expects
+ */
+static int make_chrome(void)
+{
+	int cpu, ret;
+
+	printf("{\"traceEvents\":[");
+	printf("\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"U-Boot\"}}");
+	chrome_events = 1;
+	ret = replay_calls(chrome_call_done);
+	for (cpu = 0; cpu < MAX_CPUS; cpu++) {
+		if (!cpu_stacks[cpu].used)
+			continue;
+		printf(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"CPU %d\"}}",
+		       cpu, cpu);
+	}
+	printf("\n]}\n");
+
+	return ret;
+}
+
+static void out_flame_node(struct flame_node *node, const char **stack,
+			   int depth)
+{
+	struct flame_node *child;
+	int i;
+
+	if (node->func) {
+		stack[depth++] = node->func->name;
+		if (node->excl_us) {
+			for (i = 0; i < depth; i++)
+				printf("%s%s", i ? ";" : "", stack[i]);
+			printf(" %llu\n", node->excl_us);
+		}
+	}
+	for (child = node->child; child; child = child->sibling)
+		out_flame_node(child, stack, depth);
+}
+
+static int flame_depth(struct flame_node *node)
+{
+	struct flame_node *child;
+	int max = 0;
+
+	for (child = node->child; child; child = child->sibling)
+		max = MAX(max, flame_depth(child));
+
+	return max + 1;
+}
+
+/*
+ * Write the trace as folded stacks, one line per distinct call stack with
+ * the time in microseconds spent in the innermost function, e.g.
+ *
+ *    board_init_r;initr_dm;dm_init_and_scan 1234
+ *
+ * This can be turned into a flame graph with flamegraph.pl
+ */
+static int make_flamegraph(void)
+{
+	const char **stack;
+	int ret;
+
+	ret = replay_calls(NULL);
+	if (ret)
+		return ret;
+	stack = calloc(flame_depth(&flame_root), sizeof(*stack));
+	if (!stack) {
+		error("Cannot allocate stack\n");
+		return -1;
+	}
+	out_flame_node(&flame_root, stack, 0);
+	free(stack);
+
+	return 0;
+}
+
+static int h_cmp_excl(const void *v1, const void *v2)
+{
+	const struct func_info *f1 = *(struct func_info **)v1;
+	const struct func_info *f2 = *(struct func_info **)v2;
+
+	if (f1->excl_us != f2->excl_us)
+		return f1->excl_us < f2->excl_us ? 1 : -1;
+
+	return strcmp(f1->name, f2->name);
+}
+
+/*
+ * Write the number of calls and the inclusive and exclusive time of each
+ * called function, with the functions taking the most time first
+ */
+static int make_func_times(void)
+{
+	struct func_info **funcs;
+	int i, count, ret;
+
+	ret = replay_calls(NULL);
+	if (ret)
+		return ret;
+	funcs = calloc(func_count, sizeof(*funcs));
+	if (!funcs) {
+		error("Cannot allocate function list\n");
+		return -1;
+	}
+	for (i = count = 0; i < func_count; i++) {
+		if (func_list[i].calls)
+			funcs[count++] = &func_list[i];
+	}
+	qsort(funcs, count, sizeof(*funcs), h_cmp_excl);
+
+	printf("%10s %14s %14s  %s\n", "Calls", "Inclusive us", "Exclusive us",
+	       "Function");
+	for (i = 0; i < count; i++) {
+		struct func_info *func = funcs[i];
+
+		printf("%10lu %14llu %14llu  %s\n", func->calls, func->incl_us,
+		       func->excl_us, func->name);
+	}
+	free(funcs);
+
+	return 0;
+}
+
 static int prof_tool(int argc, char *const argv[],
 		     const char *prof_fname, const char *map_fname,
 		     const char *trace_config_fname)
@@ -552,6 +993,12 @@ static int prof_tool(int argc, char *const argv[],
 
 		if (0 == strcmp(cmd, "dump-ftrace"))
 			err = make_ftrace();
+		else if (0 == strcmp(cmd, "dump-chrome"))
+			err = make_chrome();
+		else if (0 == strcmp(cmd, "dump-flamegraph"))
+			err = make_flamegraph();
+		else if (0 == strcmp(cmd, "dump-func-times"))
+			err = make_func_times();
 		else
 			warn("Unknown command '%s'\n", cmd);
 	}